@@ -0,0 +1,181 @@
+//=============================================================================
+//
+//   File : mkiconatlas.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+//
+// Packs the small icons in the atlas loaded by KviIconAtlas
+// (see src/kvirc/kernel/KviIconAtlas.h for the file format).
+//
+// Usage: mkiconatlas <output file> <icon.png|directory> [<icon.png|directory> ...]
+//
+// A directory stands for all the .png files it contains: this keeps the
+// command line short (the Windows shell limits it to 8191 characters).
+//
+// Themes can use it to build the kcs_atlas.kvia of their own icons.
+//
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// the atlas is packed in rows (shelves) of this width
+#define ATLAS_WIDTH 512
+
+struct Icon
+{
+	QByteArray szName;
+	QImage img;
+	int x;
+	int y;
+};
+
+static void append_u32(QByteArray & out, quint32 u)
+{
+	out.append((const char *)&u, 4);
+}
+
+int main(int argc, char ** argv)
+{
+	if(argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <output file> <icon.png|directory> [<icon.png|directory> ...]\n", argv[0]);
+		return 1;
+	}
+
+	QStringList files;
+	for(int i = 2; i < argc; i++)
+	{
+		QString szArg = QString::fromLocal8Bit(argv[i]);
+		if(QFileInfo(szArg).isDir())
+		{
+			QDir dir(szArg);
+			for(auto & szName : dir.entryList(QStringList("*.png"), QDir::Files, QDir::Name))
+				files.append(dir.filePath(szName));
+		}
+		else
+		{
+			files.append(szArg);
+		}
+	}
+
+	std::vector<Icon> icons;
+	for(auto & szFile : files)
+	{
+		QImage img(szFile);
+		if(img.isNull())
+		{
+			fprintf(stderr, "Can't load %s\n", szFile.toLocal8Bit().data());
+			return 1;
+		}
+		if(img.width() > ATLAS_WIDTH)
+		{
+			fprintf(stderr, "%s is too big\n", szFile.toLocal8Bit().data());
+			return 1;
+		}
+		icons.push_back({ QFileInfo(szFile).fileName().toUtf8(), img.convertToFormat(QImage::Format_ARGB32_Premultiplied), 0, 0 });
+	}
+
+	// shelf packing, tallest first
+	std::vector<Icon *> order;
+	for(auto & i : icons)
+		order.push_back(&i);
+	std::stable_sort(order.begin(), order.end(), [](Icon * a, Icon * b) { return a->img.height() > b->img.height(); });
+
+	int x = 0;
+	int y = 0;
+	int iShelfHeight = 0;
+	for(auto i : order)
+	{
+		if((x + i->img.width()) > ATLAS_WIDTH)
+		{
+			x = 0;
+			y += iShelfHeight;
+			iShelfHeight = 0;
+		}
+		i->x = x;
+		i->y = y;
+		x += i->img.width();
+		iShelfHeight = std::max(iShelfHeight, i->img.height());
+	}
+
+	QImage atlas(ATLAS_WIDTH, std::max(y + iShelfHeight, 1), QImage::Format_ARGB32_Premultiplied);
+	atlas.fill(Qt::transparent);
+	// plain copies: no paint device (and no QGuiApplication) needed
+	for(auto & i : icons)
+	{
+		for(int row = 0; row < i.img.height(); row++)
+			memcpy(atlas.scanLine(i.y + row) + i.x * 4, i.img.constScanLine(row), i.img.width() * 4);
+	}
+
+	QByteArray out;
+	out.append("KVIA", 4);
+	append_u32(out, 0x01020304); // byte order mark
+	append_u32(out, 1);          // version
+	append_u32(out, atlas.width());
+	append_u32(out, atlas.height());
+	append_u32(out, icons.size());
+	int iPixelOffsetPos = out.size();
+	append_u32(out, 0); // pixel offset, set below
+
+	for(auto & i : icons)
+	{
+		append_u32(out, i.x);
+		append_u32(out, i.y);
+		append_u32(out, i.img.width());
+		append_u32(out, i.img.height());
+		append_u32(out, i.szName.size());
+		out.append(i.szName);
+		while(out.size() % 4)
+			out.append('\0');
+	}
+
+	// align the pixels to 16 bytes
+	while(out.size() % 16)
+		out.append('\0');
+	quint32 uPixelOffset = out.size();
+	memcpy(out.data() + iPixelOffsetPos, &uPixelOffset, 4);
+
+	for(int row = 0; row < atlas.height(); row++)
+		out.append((const char *)atlas.constScanLine(row), atlas.width() * 4);
+
+	QFile f(QString::fromLocal8Bit(argv[1]));
+	if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate) || (f.write(out) != out.size()))
+	{
+		fprintf(stderr, "Can't write %s\n", argv[1]);
+		return 1;
+	}
+	f.close();
+
+	printf("Packed %d icons in a %dx%d atlas\n", (int)icons.size(), atlas.width(), atlas.height());
+	return 0;
+}
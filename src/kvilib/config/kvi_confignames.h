@@ -52,6 +52,7 @@
 * \def KVI_CONFIGFILE_TEXTICONS Defines texticons.kvc
 * \def KVI_CONFIGFILE_REGCHANDB Defines regchan.kvc
 * \def KVI_CONFIGFILE_INPUTHISTORY Defines inputhistory.kvc
+* \def KVI_CONFIGFILE_INPUTHISTORYJOURNAL Defines inputhistory.journal
 * \def KVI_CONFIGFILE_AVATARCACHE Defines avatarcache.kvc
 * \def KVI_CONFIGFILE_USERACTIONS Defines useractions.kvc
 * \def KVI_CONFIGFILE_SCRIPTADDONS Defines scriptaddons.kvc
@@ -81,6 +82,7 @@
 #define KVI_CONFIGFILE_TEXTICONS "texticons" KVI_FILEEXTENSION_CONFIG
 #define KVI_CONFIGFILE_REGCHANDB "regchan" KVI_FILEEXTENSION_CONFIG
 #define KVI_CONFIGFILE_INPUTHISTORY "inputhistory" KVI_FILEEXTENSION_CONFIG
+#define KVI_CONFIGFILE_INPUTHISTORYJOURNAL "inputhistory.journal"
 #define KVI_CONFIGFILE_AVATARCACHE "avatarcache" KVI_FILEEXTENSION_CONFIG
 #define KVI_CONFIGFILE_USERACTIONS "useractions" KVI_FILEEXTENSION_CONFIG
 #define KVI_CONFIGFILE_SCRIPTADDONS "scriptaddons" KVI_FILEEXTENSION_CONFIG
@@ -342,7 +342,7 @@
 		[b]Ctrl+Alt+E:[/b] Insert the 'icon' control code and pops up the icon list box[br]
 		[b]UpArrow:[/b] Move backward in the command history and in the history popup[br]
 		[b]DownArrow:[/b] Move forward in the command history and in the history popup[br]
-		[b]Ctrl+PageUp:[/b] Open the history popup[br]
+		[b]Ctrl+PageUp:[/b] Open the history popup (only the entries containing the text already typed, if any)[br]
 		[b]LeftArrow:[/b] Move the cursor to the left :)[br]
 		[b]RightArrow:[/b] Move the cursor to the right[br]
 		[b]Shift+LeftArrow:[/b] Move the selection to the left[br]
@@ -0,0 +1,86 @@
+//=============================================================================
+//
+//   File : KviBloomFilter.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include "KviBloomFilter.h"
+
+#include <QHash>
+
+// With 10 bits per string and 5 probes the false positive rate is about 1%
+#define KVI_BLOOMFILTER_BITS_PER_KEY 10
+#define KVI_BLOOMFILTER_PROBES 5
+
+KviBloomFilter::KviBloomFilter()
+{
+	reset(0);
+}
+
+void KviBloomFilter::reset(unsigned int uExpectedCount)
+{
+	kvi_u32_t uBits = 64;
+	while((uBits < (uExpectedCount * KVI_BLOOMFILTER_BITS_PER_KEY)) && (uBits < 0x80000000))
+		uBits <<= 1;
+
+	m_Bits.assign(uBits / 64, 0);
+	m_uMask = uBits - 1;
+	m_uCount = 0;
+}
+
+// double hashing: the probes are h1, h1 + h2, h1 + 2 * h2...
+// h2 is odd so the probes never collapse on a single bit
+static inline void kvi_bloomfilter_hashes(const QString & szKey, kvi_u32_t & h1, kvi_u32_t & h2)
+{
+	h1 = qHash(szKey, 0x9e3779b9);
+	h2 = qHash(szKey, 0x85ebca6b) | 1;
+}
+
+void KviBloomFilter::insert(const QString & szKey)
+{
+	kvi_u32_t h1, h2;
+	kvi_bloomfilter_hashes(szKey, h1, h2);
+
+	for(int i = 0; i < KVI_BLOOMFILTER_PROBES; i++)
+	{
+		kvi_u32_t uBit = (h1 + i * h2) & m_uMask;
+		m_Bits[uBit >> 6] |= ((kvi_u64_t)1) << (uBit & 63);
+	}
+	m_uCount++;
+}
+
+bool KviBloomFilter::mayContain(const QString & szKey) const
+{
+	if(m_uCount == 0)
+		return false;
+
+	kvi_u32_t h1, h2;
+	kvi_bloomfilter_hashes(szKey, h1, h2);
+
+	for(int i = 0; i < KVI_BLOOMFILTER_PROBES; i++)
+	{
+		kvi_u32_t uBit = (h1 + i * h2) & m_uMask;
+		if(!(m_Bits[uBit >> 6] & (((kvi_u64_t)1) << (uBit & 63))))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,90 @@
+#ifndef _KVI_BLOOMFILTER_H_
+#define _KVI_BLOOMFILTER_H_
+//=============================================================================
+//
+//   File : KviBloomFilter.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+
+/**
+* \file KviBloomFilter.h
+* \author The KVIrc Development Team
+* \brief A Bloom filter of strings
+*/
+
+#include "kvi_settings.h"
+#include "kvi_inttypes.h"
+
+#include <QString>
+
+#include <vector>
+
+/**
+* \class KviBloomFilter
+* \brief A set of strings that can tell for sure that a string is NOT in it
+*
+* mayContain() never fails for an inserted string, but it may succeed for
+* a string that has not been inserted (about 1% of the times when the filter
+* has been sized for the number of inserted strings). The strings can't be
+* removed: the filter is rebuilt from scratch instead.
+*/
+class KVILIB_API KviBloomFilter
+{
+public:
+	KviBloomFilter();
+
+protected:
+	std::vector<kvi_u64_t> m_Bits;
+	kvi_u32_t m_uMask; // number of bits - 1
+	unsigned int m_uCount;
+
+public:
+	/**
+	* \brief Empties the filter and sizes it for the given number of strings
+	* \param uExpectedCount The number of strings that will be inserted
+	* \return void
+	*/
+	void reset(unsigned int uExpectedCount);
+
+	/**
+	* \brief Inserts a string in the filter
+	* \param szKey The string
+	* \return void
+	*/
+	void insert(const QString & szKey);
+
+	/**
+	* \brief Returns false if the string has surely not been inserted
+	* \param szKey The string
+	* \return bool
+	*/
+	bool mayContain(const QString & szKey) const;
+
+	/**
+	* \brief Returns the number of inserted strings
+	* \return unsigned int
+	*/
+	unsigned int count() const { return m_uCount; };
+};
+
+#endif //!_KVI_BLOOMFILTER_H_
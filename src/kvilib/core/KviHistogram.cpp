@@ -0,0 +1,140 @@
+//=============================================================================
+//
+//   File : KviHistogram.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include "KviHistogram.h"
+
+static inline unsigned int kvi_histogram_log2(kvi_u64_t uValue)
+{
+#if defined(__GNUC__)
+	return 63 - __builtin_clzll(uValue);
+#else
+	unsigned int uLog = 0;
+	while(uValue >>= 1)
+		uLog++;
+	return uLog;
+#endif
+}
+
+KviHistogram::KviHistogram()
+{
+	reset();
+}
+
+unsigned int KviHistogram::bucketIndex(kvi_u64_t uValue)
+{
+	if(uValue < KVI_HISTOGRAM_SUB_BUCKETS)
+		return (unsigned int)uValue;
+	unsigned int uShift = kvi_histogram_log2(uValue) - KVI_HISTOGRAM_SUB_BUCKET_BITS;
+	// the top bit is implicit: uValue >> uShift is in [SUB_BUCKETS, 2 * SUB_BUCKETS)
+	return KVI_HISTOGRAM_SUB_BUCKETS * (uShift + 1) + (unsigned int)((uValue >> uShift) - KVI_HISTOGRAM_SUB_BUCKETS);
+}
+
+kvi_u64_t KviHistogram::bucketLow(unsigned int uIndex)
+{
+	if(uIndex < KVI_HISTOGRAM_SUB_BUCKETS)
+		return uIndex;
+	unsigned int uShift = (uIndex / KVI_HISTOGRAM_SUB_BUCKETS) - 1;
+	return ((kvi_u64_t)(KVI_HISTOGRAM_SUB_BUCKETS + (uIndex % KVI_HISTOGRAM_SUB_BUCKETS))) << uShift;
+}
+
+kvi_u64_t KviHistogram::bucketHigh(unsigned int uIndex)
+{
+	if(uIndex < KVI_HISTOGRAM_SUB_BUCKETS)
+		return uIndex;
+	unsigned int uShift = (uIndex / KVI_HISTOGRAM_SUB_BUCKETS) - 1;
+	return bucketLow(uIndex) + ((((kvi_u64_t)1) << uShift) - 1);
+}
+
+void KviHistogram::record(kvi_u64_t uValue)
+{
+	m_uBuckets[bucketIndex(uValue)].fetch_add(1, std::memory_order_relaxed);
+	m_uCount.fetch_add(1, std::memory_order_relaxed);
+	m_uSum.fetch_add(uValue, std::memory_order_relaxed);
+
+	kvi_u64_t uMax = m_uMax.load(std::memory_order_relaxed);
+	while((uValue > uMax) && !m_uMax.compare_exchange_weak(uMax, uValue, std::memory_order_relaxed))
+	{
+	}
+}
+
+void KviHistogram::reset()
+{
+	for(auto & b : m_uBuckets)
+		b.store(0, std::memory_order_relaxed);
+	m_uCount.store(0, std::memory_order_relaxed);
+	m_uSum.store(0, std::memory_order_relaxed);
+	m_uMax.store(0, std::memory_order_relaxed);
+}
+
+double KviHistogram::mean() const
+{
+	kvi_u64_t uCount = count();
+	if(uCount == 0)
+		return 0.0;
+	return (double)sum() / (double)uCount;
+}
+
+kvi_u64_t KviHistogram::percentile(double dPercentile) const
+{
+	// the buckets may be updated meanwhile: use their own total
+	kvi_u64_t uTotal = 0;
+	for(auto & b : m_uBuckets)
+		uTotal += b.load(std::memory_order_relaxed);
+	if(uTotal == 0)
+		return 0;
+
+	if(dPercentile < 0.0)
+		dPercentile = 0.0;
+	if(dPercentile > 100.0)
+		dPercentile = 100.0;
+
+	kvi_u64_t uRank = (kvi_u64_t)((dPercentile / 100.0) * (double)uTotal + 0.5);
+	if(uRank < 1)
+		uRank = 1;
+
+	kvi_u64_t uSeen = 0;
+	for(unsigned int i = 0; i < KVI_HISTOGRAM_BUCKETS; i++)
+	{
+		uSeen += m_uBuckets[i].load(std::memory_order_relaxed);
+		if(uSeen >= uRank)
+		{
+			kvi_u64_t uHigh = bucketHigh(i);
+			kvi_u64_t uMax = max();
+			return (uHigh > uMax) ? uMax : uHigh;
+		}
+	}
+	return max();
+}
+
+void KviHistogram::buckets(std::vector<Bucket> & lBuckets) const
+{
+	lBuckets.clear();
+	for(unsigned int i = 0; i < KVI_HISTOGRAM_BUCKETS; i++)
+	{
+		kvi_u64_t uCount = m_uBuckets[i].load(std::memory_order_relaxed);
+		if(uCount)
+			lBuckets.push_back({ bucketLow(i), bucketHigh(i), uCount });
+	}
+}
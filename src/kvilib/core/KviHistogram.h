@@ -0,0 +1,120 @@
+#ifndef _KVI_HISTOGRAM_H_
+#define _KVI_HISTOGRAM_H_
+//=============================================================================
+//
+//   File : KviHistogram.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+/**
+* \file KviHistogram.h
+* \author The KVIrc Development Team
+* \brief A bounded memory histogram with logarithmic buckets
+*/
+
+#include "kvi_settings.h"
+#include "kvi_inttypes.h"
+
+#include <atomic>
+#include <vector>
+
+// Each power of two is split in 2^KVI_HISTOGRAM_SUB_BUCKET_BITS buckets:
+// the values are recorded with a relative error below 12.5%
+#define KVI_HISTOGRAM_SUB_BUCKET_BITS 3
+#define KVI_HISTOGRAM_SUB_BUCKETS (1 << KVI_HISTOGRAM_SUB_BUCKET_BITS)
+#define KVI_HISTOGRAM_BUCKETS (KVI_HISTOGRAM_SUB_BUCKETS * (65 - KVI_HISTOGRAM_SUB_BUCKET_BITS))
+
+/**
+* \class KviHistogram
+* \brief A HDR style histogram of unsigned 64 bit values
+*
+* The values below KVI_HISTOGRAM_SUB_BUCKETS are counted exactly, the others
+* fall in log-linear buckets so the memory used is fixed (about 4 KiB)
+* whatever the range of the values.
+* The counters are atomic: record() can be called from any thread
+* without locking and is just a few instructions.
+*/
+class KVILIB_API KviHistogram
+{
+public:
+	/**
+	* \struct Bucket
+	* \brief A non empty bucket, as returned by buckets()
+	*/
+	struct Bucket
+	{
+		kvi_u64_t uLow;   /**< The lowest value of the bucket */
+		kvi_u64_t uHigh;  /**< The highest value of the bucket */
+		kvi_u64_t uCount; /**< The number of values recorded in the bucket */
+	};
+
+public:
+	KviHistogram();
+	KviHistogram(const KviHistogram &) = delete;
+	KviHistogram & operator=(const KviHistogram &) = delete;
+
+protected:
+	std::atomic<kvi_u64_t> m_uBuckets[KVI_HISTOGRAM_BUCKETS];
+	std::atomic<kvi_u64_t> m_uCount;
+	std::atomic<kvi_u64_t> m_uSum;
+	std::atomic<kvi_u64_t> m_uMax;
+
+public:
+	/**
+	* \brief Records a value
+	* \param uValue The value
+	* \return void
+	*/
+	void record(kvi_u64_t uValue);
+
+	/**
+	* \brief Forgets all the recorded values
+	* \return void
+	*/
+	void reset();
+
+	kvi_u64_t count() const { return m_uCount.load(std::memory_order_relaxed); }
+	kvi_u64_t sum() const { return m_uSum.load(std::memory_order_relaxed); }
+	kvi_u64_t max() const { return m_uMax.load(std::memory_order_relaxed); }
+	double mean() const;
+
+	/**
+	* \brief Returns the value below which the given percentage of the values fall
+	* \param dPercentile The percentage, between 0 and 100
+	* \return kvi_u64_t
+	*/
+	kvi_u64_t percentile(double dPercentile) const;
+
+	/**
+	* \brief Fills the list with the non empty buckets, ordered by value
+	* \param lBuckets The list to fill
+	* \return void
+	*/
+	void buckets(std::vector<Bucket> & lBuckets) const;
+
+protected:
+	static unsigned int bucketIndex(kvi_u64_t uValue);
+	static kvi_u64_t bucketLow(unsigned int uIndex);
+	static kvi_u64_t bucketHigh(unsigned int uIndex);
+};
+
+#endif //!_KVI_HISTOGRAM_H_
@@ -0,0 +1,186 @@
+//=============================================================================
+//
+//   File : KviKeywordMatcher.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include "KviKeywordMatcher.h"
+
+#include <QByteArray>
+#include <QChar>
+
+#include <algorithm>
+#include <cctype>
+#include <deque>
+
+// the state 0 is the root: edge() returns 0 when there is no edge
+// (no edge leads back to the root so it's not ambiguous)
+
+KviKeywordMatcher::KviKeywordMatcher()
+    : m_eCaseMode(CaseSensitive)
+{
+	m_States.resize(1);
+	m_States[0].uFail = 0;
+	m_States[0].iOutput = -1;
+}
+
+ushort KviKeywordMatcher::fold(ushort c) const
+{
+	switch(m_eCaseMode)
+	{
+		case CaseInsensitive:
+			// covers both the QString::contains() folding and the QRegExp one
+			return QChar(c).toLower().toCaseFolded().unicode();
+		case Latin1CaseInsensitive:
+			return (c < 256) ? (ushort)tolower(c) : c;
+		default:
+			return c;
+	}
+}
+
+unsigned int KviKeywordMatcher::edge(unsigned int uState, ushort c) const
+{
+	const std::vector<std::pair<ushort, unsigned int>> & edges = m_States[uState].edges;
+	auto it = std::lower_bound(edges.begin(), edges.end(), std::make_pair(c, 0u));
+	if((it == edges.end()) || (it->first != c))
+		return 0;
+	return it->second;
+}
+
+unsigned int KviKeywordMatcher::step(unsigned int uState, ushort c) const
+{
+	for(;;)
+	{
+		unsigned int uNext = edge(uState, c);
+		if(uNext || !uState)
+			return uNext;
+		uState = m_States[uState].uFail;
+	}
+}
+
+void KviKeywordMatcher::setKeywords(const QStringList & lKeywords, CaseMode eCaseMode)
+{
+	if((eCaseMode == m_eCaseMode) && (lKeywords == m_lKeywords))
+		return;
+
+	m_lKeywords = lKeywords;
+	m_eCaseMode = eCaseMode;
+
+	m_States.resize(1);
+	m_States[0].edges.clear();
+
+	// the trie
+	for(int i = 0; i < m_lKeywords.count(); i++)
+	{
+		const QString szKeyword = (m_eCaseMode == Latin1CaseInsensitive) ? QString::fromLatin1(m_lKeywords.at(i).toLatin1()) : m_lKeywords.at(i);
+		if(szKeyword.isEmpty())
+			continue;
+
+		unsigned int uState = 0;
+		for(auto & ch : szKeyword)
+		{
+			ushort c = fold(ch.unicode());
+			unsigned int uNext = edge(uState, c);
+			if(!uNext)
+			{
+				uNext = m_States.size();
+				m_States.emplace_back();
+				m_States.back().uFail = 0;
+				m_States.back().iOutput = -1;
+
+				std::vector<std::pair<ushort, unsigned int>> & edges = m_States[uState].edges;
+				edges.insert(std::lower_bound(edges.begin(), edges.end(), std::make_pair(c, 0u)), std::make_pair(c, uNext));
+			}
+			uState = uNext;
+		}
+
+		if(m_States[uState].iOutput == -1)
+			m_States[uState].iOutput = i;
+	}
+
+	// the failure links, breadth first so the shorter suffixes are ready
+	std::deque<unsigned int> queue;
+	for(auto & e : m_States[0].edges)
+		queue.push_back(e.second);
+
+	while(!queue.empty())
+	{
+		unsigned int uState = queue.front();
+		queue.pop_front();
+
+		for(auto & e : m_States[uState].edges)
+		{
+			unsigned int uChild = e.second;
+			unsigned int uFail = (uState == 0) ? 0 : step(m_States[uState].uFail, e.first);
+			m_States[uChild].uFail = uFail;
+
+			// a keyword that ends in the suffix ends here too
+			int iSuffixOutput = m_States[uFail].iOutput;
+			if((iSuffixOutput != -1) && ((m_States[uChild].iOutput == -1) || (iSuffixOutput < m_States[uChild].iOutput)))
+				m_States[uChild].iOutput = iSuffixOutput;
+
+			queue.push_back(uChild);
+		}
+	}
+}
+
+int KviKeywordMatcher::find(const QString & szText) const
+{
+	if(isEmpty())
+		return -1;
+
+	int iFound = -1;
+	unsigned int uState = 0;
+	for(auto & ch : szText)
+	{
+		uState = step(uState, fold(ch.unicode()));
+		int iOutput = m_States[uState].iOutput;
+		if((iOutput != -1) && ((iFound == -1) || (iOutput < iFound)))
+		{
+			iFound = iOutput;
+			if(iFound == 0)
+				break; // can't get any lower
+		}
+	}
+	return iFound;
+}
+
+int KviKeywordMatcher::find(const char * pcText, int iLen) const
+{
+	if(isEmpty())
+		return -1;
+
+	int iFound = -1;
+	unsigned int uState = 0;
+	for(int i = 0; i < iLen; i++)
+	{
+		uState = step(uState, fold((unsigned char)pcText[i]));
+		int iOutput = m_States[uState].iOutput;
+		if((iOutput != -1) && ((iFound == -1) || (iOutput < iFound)))
+		{
+			iFound = iOutput;
+			if(iFound == 0)
+				break; // can't get any lower
+		}
+	}
+	return iFound;
+}
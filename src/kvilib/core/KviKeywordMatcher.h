@@ -0,0 +1,124 @@
+#ifndef _KVI_KEYWORDMATCHER_H_
+#define _KVI_KEYWORDMATCHER_H_
+//=============================================================================
+//
+//   File : KviKeywordMatcher.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+
+/**
+* \file KviKeywordMatcher.h
+* \author The KVIrc Development Team
+* \brief A multi keyword substring matcher
+*/
+
+#include "kvi_settings.h"
+
+#include <QString>
+#include <QStringList>
+
+#include <utility>
+#include <vector>
+
+/**
+* \class KviKeywordMatcher
+* \brief Finds which of a set of keywords occur in a text
+*
+* The keywords are compiled in an Aho-Corasick automaton: a text is scanned
+* once, whatever the number of keywords, instead of once per keyword.
+* The empty keywords never match.
+*/
+class KVILIB_API KviKeywordMatcher
+{
+public:
+	/**
+	* \enum CaseMode
+	*/
+	enum CaseMode
+	{
+		CaseSensitive,        /**< The keywords match exactly */
+		CaseInsensitive,      /**< The keywords match ignoring the case of the unicode characters */
+		Latin1CaseInsensitive /**< The keywords are Latin-1 encoded and matched against 8 bit data with tolower() */
+	};
+
+public:
+	KviKeywordMatcher();
+
+protected:
+	struct State
+	{
+		std::vector<std::pair<ushort, unsigned int>> edges; // sorted by character
+		unsigned int uFail;                                  // the longest proper suffix that is a state
+		int iOutput;                                         // the lowest keyword index ending here, -1 if none
+	};
+
+	std::vector<State> m_States;
+	QStringList m_lKeywords;
+	CaseMode m_eCaseMode;
+
+public:
+	/**
+	* \brief Compiles the keywords
+	*
+	* Does nothing if the keywords and the case mode haven't changed
+	* (this check is cheap when the list is shared with the previous one).
+	* \param lKeywords The keywords
+	* \param eCaseMode How the case is handled
+	* \return void
+	*/
+	void setKeywords(const QStringList & lKeywords, CaseMode eCaseMode);
+
+	/**
+	* \brief Returns the compiled keywords
+	* \return const QStringList &
+	*/
+	const QStringList & keywords() const { return m_lKeywords; };
+
+	/**
+	* \brief Returns true if there are no keywords that may match
+	* \return bool
+	*/
+	bool isEmpty() const { return m_States.size() < 2; };
+
+	/**
+	* \brief Returns the index of the first keyword of the list found in the text
+	* \param szText The text
+	* \return int -1 if none is found
+	*/
+	int find(const QString & szText) const;
+
+	/**
+	* \brief Returns the index of the first keyword of the list found in the 8 bit text
+	* \param pcText The text
+	* \param iLen The length of the text
+	* \return int -1 if none is found
+	*/
+	int find(const char * pcText, int iLen) const;
+
+protected:
+	ushort fold(ushort c) const;
+	unsigned int edge(unsigned int uState, ushort c) const;
+	unsigned int step(unsigned int uState, ushort c) const;
+};
+
+#endif //!_KVI_KEYWORDMATCHER_H_
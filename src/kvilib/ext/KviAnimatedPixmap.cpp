@@ -25,12 +25,14 @@
 #include "KviAnimatedPixmap.h"
 
 #include <QImageReader>
+#include <QMetaMethod>
 
 KviAnimatedPixmap::KviAnimatedPixmap(QString fileName, int iWidth, int iHeight)
     : QObject(),
       m_szFileName(fileName),
       m_uCurrentFrameNumber(0),
-      m_iStarted(0)
+      m_iStarted(0),
+      m_bParked(false)
 {
 	m_pFrameData = KviAnimatedPixmapCache::load(fileName, iWidth, iHeight);
 }
@@ -40,7 +42,8 @@ KviAnimatedPixmap::KviAnimatedPixmap(const KviAnimatedPixmap & source)
       m_szFileName(source.m_szFileName),
       m_pFrameData(source.m_pFrameData),
       m_uCurrentFrameNumber(source.m_uCurrentFrameNumber),
-      m_iStarted(0)
+      m_iStarted(0),
+      m_bParked(false)
 {
 	m_pFrameData->refs++;
 }
@@ -63,6 +66,14 @@ void KviAnimatedPixmap::start()
 
 	m_uCurrentFrameNumber = 0;
 
+	if(!hasObservers())
+	{
+		// will be scheduled by connectNotify()
+		m_bParked = true;
+		return;
+	}
+
+	m_bParked = false;
 	KviAnimatedPixmapCache::scheduleFrameChange(m_pFrameData->at(m_uCurrentFrameNumber).delay, this);
 }
 
@@ -88,12 +99,39 @@ void KviAnimatedPixmap::nextFrame(bool bEmitSignalAndScheduleNext)
 	if(!bEmitSignalAndScheduleNext)
 		return;
 
+	if(!hasObservers())
+	{
+		// nobody is showing us: stop ticking until someone connects again
+		m_bParked = true;
+		return;
+	}
+
 	if(m_iStarted)
 		emit frameChanged();
 
 	KviAnimatedPixmapCache::scheduleFrameChange(m_pFrameData->at(m_uCurrentFrameNumber).delay, this);
 }
 
+bool KviAnimatedPixmap::hasObservers() const
+{
+	static const QMetaMethod frameChangedSignal = QMetaMethod::fromSignal(&KviAnimatedPixmap::frameChanged);
+	return isSignalConnected(frameChangedSignal);
+}
+
+void KviAnimatedPixmap::connectNotify(const QMetaMethod & signal)
+{
+	if(!m_bParked)
+		return;
+	if(signal != QMetaMethod::fromSignal(&KviAnimatedPixmap::frameChanged))
+		return;
+
+	m_bParked = false;
+	if((m_iStarted < 1) || (m_pFrameData->count() < 2))
+		return;
+
+	KviAnimatedPixmapCache::scheduleFrameChange(m_pFrameData->at(m_uCurrentFrameNumber).delay, this);
+}
+
 void KviAnimatedPixmap::resize(QSize newSize, Qt::AspectRatioMode ratioMode)
 {
 	QSize curSize(size());
@@ -101,3 +139,19 @@ void KviAnimatedPixmap::resize(QSize newSize, Qt::AspectRatioMode ratioMode)
 
 	m_pFrameData = KviAnimatedPixmapCache::resize(m_pFrameData, curSize);
 }
+
+void KviAnimatedPixmap::preloadResize(QSize newSize, Qt::AspectRatioMode ratioMode)
+{
+	QSize curSize(size());
+	curSize.scale(newSize, ratioMode);
+
+	KviAnimatedPixmapCache::preloadResize(m_pFrameData, curSize);
+}
+
+bool KviAnimatedPixmap::isResizeReady(QSize newSize, Qt::AspectRatioMode ratioMode)
+{
+	QSize curSize(size());
+	curSize.scale(newSize, ratioMode);
+
+	return KviAnimatedPixmapCache::isResizeReady(m_pFrameData, curSize);
+}
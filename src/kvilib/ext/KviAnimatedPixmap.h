@@ -75,6 +75,7 @@ protected:
 
 	uint m_uCurrentFrameNumber;
 	int m_iStarted;
+	bool m_bParked; // started but not scheduled since nobody is listening to frameChanged()
 
 public:
 	/*
@@ -160,11 +161,31 @@ public:
 	 */
 	void resize(QSize newSize, Qt::AspectRatioMode ratioMode);
 
+	/*
+	 * Starts scaling the frames for a later resize() with the same
+	 * parameters on a worker thread.
+	 */
+	void preloadResize(QSize newSize, Qt::AspectRatioMode ratioMode);
+
+	/*
+	 * Returns true if resize() with these parameters would be cheap.
+	 */
+	bool isResizeReady(QSize newSize, Qt::AspectRatioMode ratioMode);
+
 	/*
 	 * Called when the frame changes
 	 */
 	void nextFrame(bool bEmitSignalAndScheduleNext);
 
+protected:
+	/*
+	 * Returns true if someone is connected to frameChanged().
+	 * Animations that nobody looks at are not scheduled at all.
+	 */
+	bool hasObservers() const;
+
+	void connectNotify(const QMetaMethod & signal) override;
+
 signals:
 
 	/*
@@ -25,23 +25,127 @@
 #include "KviAnimatedPixmapCache.h"
 #include "KviTimeUtils.h"
 
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
 #include <QImageReader>
 #include <QImage>
+#include <QRunnable>
+#include <QThread>
+
+#include <functional>
 
 #define FRAME_DELAY 100
+#define WHEEL_SLOTS KVI_ANIMATEDPIXMAPCACHE_WHEEL_SLOTS
 
 KviAnimatedPixmapCache * KviAnimatedPixmapCache::m_pInstance = nullptr;
 static QPixmap * g_pDummyPixmap = nullptr;
 
+static inline QString decode_job_key(const QString & szFile, int iWidth, int iHeight)
+{
+	return QString("%1|%2x%3").arg(szFile).arg(iWidth).arg(iHeight);
+}
+
+static inline QString resize_job_prefix(const QByteArray & hash)
+{
+	return QString("%1|=").arg(QString::fromLatin1(hash.toHex()));
+}
+
+static inline QString resize_job_key(const QByteArray & hash, const QSize & size)
+{
+	return QString("%1%2x%3").arg(resize_job_prefix(hash)).arg(size.width()).arg(size.height());
+}
+
+static inline uint frame_bytes(const QSize & size)
+{
+	// 32 bits per pixel is what we end up with for nearly all the animated images
+	return (uint)(size.width() * size.height() * 4);
+}
+
+void KviAnimatedPixmapCache::DecodeJob::decode()
+{
+	// this may run in a worker thread: use only QImage here, never QPixmap
+	QFileInfo inf(file);
+	QFile f(file);
+	QByteArray data;
+	if(f.open(QIODevice::ReadOnly))
+	{
+		// stat before reading: if the file changes meanwhile the stamp won't match the next time
+		stamp.size = inf.size();
+		stamp.modified = inf.lastModified().toMSecsSinceEpoch();
+		data = f.readAll();
+		f.close();
+		stamp.hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+	}
+
+	// the suffix is just a hint, the format is detected from the contents anyway
+	QBuffer device(&data);
+	QImageReader reader(&device, inf.suffix().toLatin1());
+	size = reader.size();
+
+	while(reader.canRead())
+	{
+		uint delay = reader.nextImageDelay();
+		QImage buffer;
+		reader.read(&buffer);
+		if(!buffer.isNull())
+		{
+			if(target.isValid())
+				frames.append(buffer.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+			else if(height && width)
+				frames.append(buffer.scaled(width, height, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+			else
+				frames.append(buffer);
+			delays.append(delay);
+		}
+	}
+}
+
+class KviAnimatedPixmapDecodeRunnable : public QRunnable
+{
+public:
+	KviAnimatedPixmapDecodeRunnable(std::function<void()> fnRun)
+	    : m_fnRun(std::move(fnRun))
+	{
+		setAutoDelete(true);
+	}
+
+	void run() override
+	{
+		m_fnRun();
+	}
+
+private:
+	std::function<void()> m_fnRun;
+};
+
 KviAnimatedPixmapCache::KviAnimatedPixmapCache()
+    : m_uRetainedBytes(0), m_uTotalBytes(0), m_iCurrentTick(0), m_uScheduledFrames(0), m_uNextGeneration(1)
 {
 	m_pInstance = this;
+	// decoding is mostly I/O and inflate: don't steal all the cores from the GUI
+	m_decodePool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
 	m_animationTimer.setInterval(FRAME_DELAY);
 	connect(&m_animationTimer, SIGNAL(timeout()), this, SLOT(timeoutEvent()));
+	m_decodeExpiryTimer.setInterval(KVI_ANIMATEDPIXMAPCACHE_PENDING_DECODE_TTL / 2);
+	connect(&m_decodeExpiryTimer, SIGNAL(timeout()), this, SLOT(expireDecodes()));
 }
 
 KviAnimatedPixmapCache::~KviAnimatedPixmapCache()
 {
+	m_decodePool.clear();
+	m_decodePool.waitForDone();
+	m_hPendingDecodes.clear();
+
+	for(auto d : m_lRetained)
+	{
+		m_hCache.remove(d->hash, d);
+		destroyData(d);
+	}
+	m_lRetained.clear();
+
 	if(g_pDummyPixmap)
 	{
 		delete g_pDummyPixmap;
@@ -65,43 +169,274 @@ void KviAnimatedPixmapCache::done()
 	m_pInstance = nullptr;
 }
 
-KviAnimatedPixmapCache::Data * KviAnimatedPixmapCache::internalLoad(const QString & szFile, int iWidth, int iHeight)
+bool KviAnimatedPixmapCache::fileStamp(const QString & szFileName, FileStamp & stamp)
 {
-	m_cacheMutex.lock();
-	Data * newData = nullptr;
+	if(!m_pInstance)
+		return false;
+
+	QByteArray hash;
+	m_pInstance->m_cacheMutex.lock();
+	bool bKnown = m_pInstance->cachedHash(szFileName, hash);
+	if(bKnown)
+		stamp = m_pInstance->m_hFileStamps.value(szFileName);
+	m_pInstance->m_cacheMutex.unlock();
+	return bKnown;
+}
 
-	QMultiHash<QString, Data *>::iterator i = m_hCache.find(szFile);
-	while(i != m_hCache.end() && i.key() == szFile && !newData)
+void KviAnimatedPixmapCache::setFileStamp(const QString & szFileName, const FileStamp & stamp)
+{
+	if(!m_pInstance || stamp.hash.isEmpty())
+		return;
+
+	m_pInstance->m_cacheMutex.lock();
+	// what we have seen in this session is more recent
+	if(!m_pInstance->m_hFileStamps.contains(szFileName))
+		m_pInstance->m_hFileStamps.insert(szFileName, stamp);
+	m_pInstance->m_cacheMutex.unlock();
+}
+
+bool KviAnimatedPixmapCache::cachedHash(const QString & szFile, QByteArray & hash)
+{
+	// must be called with m_cacheMutex locked
+	QHash<QString, FileStamp>::iterator it = m_hFileStamps.find(szFile);
+	if(it == m_hFileStamps.end())
+		return false;
+
+	QFileInfo inf(szFile);
+	if(!inf.exists() || (inf.size() != it.value().size) || (inf.lastModified().toMSecsSinceEpoch() != it.value().modified))
+	{
+		// changed on disk: we'll need to read it again
+		m_hFileStamps.erase(it);
+		return false;
+	}
+
+	hash = it.value().hash;
+	return true;
+}
+
+KviAnimatedPixmapCache::Data * KviAnimatedPixmapCache::findData(const QByteArray & hash, const QSize & size, bool bResized)
+{
+	// must be called with m_cacheMutex locked
+	QMultiHash<QByteArray, Data *>::iterator i = m_hCache.find(hash);
+	while(i != m_hCache.end() && i.key() == hash)
 	{
-		if(!i.value()->resized)
-			newData = i.value();
+		if(bResized ? (i.value()->size == size) : !i.value()->resized)
+			return i.value();
 		++i;
 	}
+	return nullptr;
+}
+
+void KviAnimatedPixmapCache::reviveData(Data * data)
+{
+	// must be called with m_cacheMutex locked
+	if(data->refs != 0)
+		return;
+	m_lRetained.removeOne(data);
+	m_uRetainedBytes -= data->bytes;
+}
+
+void KviAnimatedPixmapCache::startDecode(const QString & szKey, std::shared_ptr<DecodeJob> job)
+{
+	m_decodeMutex.lock();
+	if(m_hPendingDecodes.contains(szKey))
+	{
+		m_decodeMutex.unlock();
+		return;
+	}
+	// the avatar may have been replaced or its owner gone before anybody loaded it
+	if(m_hPendingDecodes.count() >= KVI_ANIMATEDPIXMAPCACHE_MAX_PENDING_DECODES)
+		dropOldestDecode();
+	m_hPendingDecodes.insert(szKey, job);
+	m_decodeMutex.unlock();
+
+	m_decodePool.start(new KviAnimatedPixmapDecodeRunnable([this, job]() {
+		m_decodeMutex.lock();
+		if(job->state != DecodeJob::Queued)
+		{
+			// already claimed by load() or resize()
+			m_decodeMutex.unlock();
+			return;
+		}
+		job->state = DecodeJob::Running;
+		m_decodeMutex.unlock();
+
+		job->decode();
+
+		m_decodeMutex.lock();
+		job->state = DecodeJob::Done;
+		job->finished = KviTimeUtils::getCurrentTimeMills();
+		m_decodeFinished.wakeAll();
+		m_decodeMutex.unlock();
+
+		// the timer lives in the GUI thread
+		QMetaObject::invokeMethod(this, "startDecodeExpiry", Qt::QueuedConnection);
+		if(job->target.isValid())
+			QMetaObject::invokeMethod(this, "preloadFinished", Qt::QueuedConnection);
+	}));
+}
+
+void KviAnimatedPixmapCache::dropOldestDecode()
+{
+	// must be called with m_decodeMutex locked.
+	// The queued and running jobs are left alone: they'll expire once done.
+	QHash<QString, std::shared_ptr<DecodeJob>>::iterator oldest = m_hPendingDecodes.end();
+	for(QHash<QString, std::shared_ptr<DecodeJob>>::iterator it = m_hPendingDecodes.begin(); it != m_hPendingDecodes.end(); ++it)
+	{
+		if(it.value()->state != DecodeJob::Done)
+			continue;
+		if((oldest == m_hPendingDecodes.end()) || (it.value()->finished < oldest.value()->finished))
+			oldest = it;
+	}
+	if(oldest != m_hPendingDecodes.end())
+		m_hPendingDecodes.erase(oldest);
+}
+
+void KviAnimatedPixmapCache::startDecodeExpiry()
+{
+	if(!m_decodeExpiryTimer.isActive())
+		m_decodeExpiryTimer.start();
+}
+
+void KviAnimatedPixmapCache::expireDecodes()
+{
+	long long now = KviTimeUtils::getCurrentTimeMills();
+
+	m_decodeMutex.lock();
+	QHash<QString, std::shared_ptr<DecodeJob>>::iterator it = m_hPendingDecodes.begin();
+	while(it != m_hPendingDecodes.end())
+	{
+		if((it.value()->state == DecodeJob::Done) && ((now - it.value()->finished) >= KVI_ANIMATEDPIXMAPCACHE_PENDING_DECODE_TTL))
+			it = m_hPendingDecodes.erase(it);
+		else
+			++it;
+	}
+	bool bEmpty = m_hPendingDecodes.isEmpty();
+	m_decodeMutex.unlock();
+
+	// the running jobs restart it when they're done
+	if(bEmpty)
+		m_decodeExpiryTimer.stop();
+}
+
+std::shared_ptr<KviAnimatedPixmapCache::DecodeJob> KviAnimatedPixmapCache::claimDecode(const QString & szKey)
+{
+	std::shared_ptr<DecodeJob> job;
+
+	m_decodeMutex.lock();
+	job = m_hPendingDecodes.take(szKey);
+	if(job && (job->state == DecodeJob::Queued))
+	{
+		// the worker didn't pick it up yet: we'll decode it ourselves
+		job->state = DecodeJob::Running;
+		m_decodeMutex.unlock();
+		job->decode();
+		return job;
+	}
+
+	if(job)
+	{
+		while(job->state != DecodeJob::Done)
+			m_decodeFinished.wait(&m_decodeMutex);
+	}
+	m_decodeMutex.unlock();
+	return job;
+}
+
+void KviAnimatedPixmapCache::internalPreload(const QString & szFile, int iWidth, int iHeight)
+{
+	QByteArray hash;
+
+	m_cacheMutex.lock();
+	bool bCached = cachedHash(szFile, hash) && findData(hash, QSize(), false);
+	m_cacheMutex.unlock();
+
+	if(bCached)
+		return;
+
+	startDecode(decode_job_key(szFile, iWidth, iHeight), std::make_shared<DecodeJob>(szFile, iWidth, iHeight));
+}
+
+void KviAnimatedPixmapCache::internalPreloadResize(Data * data, const QSize & size)
+{
+	if(!data || data->hash.isEmpty() || !size.isValid())
+		return;
+
+	m_cacheMutex.lock();
+	bool bCached = findData(data->hash, size, true);
+	m_cacheMutex.unlock();
+
+	if(bCached)
+		return;
+
+	// decode the file again in the worker: the frames we have are QPixmaps
+	startDecode(resize_job_key(data->hash, size), std::make_shared<DecodeJob>(data->file, 0, 0, size));
+}
+
+bool KviAnimatedPixmapCache::internalIsResizeReady(Data * data, const QSize & size)
+{
+	// nothing preloadResize() could do for these
+	if(!data || data->hash.isEmpty() || !size.isValid())
+		return true;
+
+	m_cacheMutex.lock();
+	bool bReady = findData(data->hash, size, true);
+	m_cacheMutex.unlock();
+
+	if(bReady)
+		return true;
+
+	m_decodeMutex.lock();
+	QHash<QString, std::shared_ptr<DecodeJob>>::iterator it = m_hPendingDecodes.find(resize_job_key(data->hash, size));
+	bReady = (it != m_hPendingDecodes.end()) && (it.value()->state == DecodeJob::Done);
+	m_decodeMutex.unlock();
+	return bReady;
+}
+
+KviAnimatedPixmapCache::Data * KviAnimatedPixmapCache::internalLoad(const QString & szFile, int iWidth, int iHeight)
+{
+	m_cacheMutex.lock();
+	Data * newData = nullptr;
+
+	// a file we have already seen: no need to read it
+	QByteArray hash;
+	if(cachedHash(szFile, hash))
+		newData = findData(hash, QSize(), false);
 
 	if(!newData)
 	{
-		newData = new Data(szFile);
-		QImageReader reader(szFile);
-		newData->size = reader.size();
+		std::shared_ptr<DecodeJob> job = claimDecode(decode_job_key(szFile, iWidth, iHeight));
 
-		QImage buffer;
-		QPixmap * framePixmap;
-		while(reader.canRead())
+		if(!job)
 		{
-			uint delay = reader.nextImageDelay();
-			reader.read(&buffer);
-			if(!buffer.isNull())
+			job = std::make_shared<DecodeJob>(szFile, iWidth, iHeight);
+			job->decode();
+		}
+
+		if(!job->stamp.hash.isEmpty())
+			m_hFileStamps.insert(szFile, job->stamp);
+
+		// the same contents might have been loaded from another file
+		newData = findData(job->stamp.hash, QSize(), false);
+		if(!newData)
+		{
+			newData = new Data(szFile, job->stamp.hash);
+			newData->size = job->size;
+
+			for(int f = 0; f < job->frames.count(); f++)
 			{
-				if(iHeight && iWidth)
-					framePixmap = new QPixmap(QPixmap::fromImage(buffer).scaled(iWidth, iHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-				else
-					framePixmap = new QPixmap(QPixmap::fromImage(buffer));
-				newData->append(FrameInfo(framePixmap, delay));
+				const QImage & img = job->frames.at(f);
+				newData->append(FrameInfo(new QPixmap(QPixmap::fromImage(img)), job->delays.at(f)));
+				newData->bytes += frame_bytes(img.size());
 			}
+			m_hCache.insert(newData->hash, newData);
+			m_uTotalBytes += newData->bytes;
 		}
-		m_hCache.insert(szFile, newData);
 	}
+
+	reviveData(newData);
 	newData->refs++;
+	trimRetained();
 
 	m_cacheMutex.unlock();
 
@@ -114,27 +449,42 @@ KviAnimatedPixmapCache::Data * KviAnimatedPixmapCache::internalResize(Data * dat
 
 	bool hasToBeResized = false;
 
-	Data * newData = nullptr;
-	QMultiHash<QString, Data *>::iterator i = m_hCache.find(data->file);
-	while(i != m_hCache.end() && i.key() == data->file && !newData)
+	Data * newData = findData(data->hash, size, true);
+
+	if(newData)
 	{
-		if(i.value()->size == size)
-		{
-			newData = i.value();
-		}
-		++i;
+		reviveData(newData);
 	}
-
-	if(!newData)
+	else
 	{
-		newData = new Data(*data);
-		newData->size = size;
-		m_hCache.insert(newData->file, newData);
-		hasToBeResized = true;
+		std::shared_ptr<DecodeJob> job = claimDecode(resize_job_key(data->hash, size));
+
+		if(job && (job->stamp.hash == data->hash) && (job->frames.count() == data->count()))
+		{
+			// scaled by preloadResize()
+			newData = new Data(data->file, data->hash);
+			newData->size = size;
+			for(int f = 0; f < job->frames.count(); f++)
+			{
+				const QImage & img = job->frames.at(f);
+				newData->append(FrameInfo(new QPixmap(QPixmap::fromImage(img)), job->delays.at(f)));
+				newData->bytes += frame_bytes(img.size());
+			}
+		}
+		else
+		{
+			newData = new Data(*data);
+			newData->size = size;
+			newData->bytes = frame_bytes(size) * newData->count();
+			hasToBeResized = true;
+		}
 		newData->resized = true;
+		m_hCache.insert(newData->hash, newData);
+		m_uTotalBytes += newData->bytes;
 	}
 
 	newData->refs++;
+	trimRetained();
 
 	m_cacheMutex.unlock();
 
@@ -161,26 +511,114 @@ void KviAnimatedPixmapCache::internalFree(Data * data)
 	data->refs--;
 	if(data->refs == 0)
 	{
-		m_hCache.remove(data->file, data);
-		for(int i = 0; i < data->count(); i++)
+		// keep it around: the same emoticon or avatar is likely to come back soon
+		m_lRetained.append(data);
+		m_uRetainedBytes += data->bytes;
+		trimRetained();
+	}
+	m_cacheMutex.unlock();
+}
+
+void KviAnimatedPixmapCache::trimRetained()
+{
+	// must be called with m_cacheMutex locked
+	if(m_uTotalBytes > KVI_ANIMATEDPIXMAPCACHE_BUDGET_BYTES)
+	{
+		// over budget: the scaled variants go first, they can be rebuilt without touching the disk
+		QList<Data *>::iterator it = m_lRetained.begin();
+		while((it != m_lRetained.end()) && (m_uTotalBytes > KVI_ANIMATEDPIXMAPCACHE_BUDGET_BYTES))
 		{
-			delete data->operator[](i).pixmap;
+			Data * data = *it;
+			if(!data->resized)
+			{
+				++it;
+				continue;
+			}
+			it = m_lRetained.erase(it);
+			m_uRetainedBytes -= data->bytes;
+			m_hCache.remove(data->hash, data);
+			destroyData(data);
 		}
-		delete data;
 	}
-	m_cacheMutex.unlock();
+
+	while(!m_lRetained.isEmpty() && ((m_uRetainedBytes > KVI_ANIMATEDPIXMAPCACHE_RETAINED_BYTES) || (m_uTotalBytes > KVI_ANIMATEDPIXMAPCACHE_BUDGET_BYTES)))
+	{
+		Data * data = m_lRetained.takeFirst();
+		m_uRetainedBytes -= data->bytes;
+		m_hCache.remove(data->hash, data);
+		destroyData(data);
+	}
+}
+
+void KviAnimatedPixmapCache::destroyData(Data * data)
+{
+	// must be called with m_cacheMutex locked, after removing data from m_hCache
+	if(!data->hash.isEmpty() && !m_hCache.contains(data->hash))
+	{
+		// nobody can claim the scaled frames of these contents anymore
+		QString szPrefix = resize_job_prefix(data->hash);
+		m_decodeMutex.lock();
+		QHash<QString, std::shared_ptr<DecodeJob>>::iterator it = m_hPendingDecodes.begin();
+		while(it != m_hPendingDecodes.end())
+		{
+			if(it.key().startsWith(szPrefix))
+				it = m_hPendingDecodes.erase(it);
+			else
+				++it;
+		}
+		m_decodeMutex.unlock();
+	}
+
+	m_uTotalBytes -= data->bytes;
+	for(int i = 0; i < data->count(); i++)
+	{
+		delete data->operator[](i).pixmap;
+	}
+	delete data;
+}
+
+void KviAnimatedPixmapCache::wheelInsert(const ScheduledFrame & frame)
+{
+	// must be called with m_timerMutex locked
+	long long iTick = frame.tick < m_iCurrentTick ? m_iCurrentTick : frame.tick;
+	long long iDiff = iTick - m_iCurrentTick;
+
+	if(iDiff < WHEEL_SLOTS)
+	{
+		m_aWheel[0][iTick % WHEEL_SLOTS].push_back(frame);
+	}
+	else
+	{
+		// very long delays are parked in the last reachable slot and cascaded again from there
+		if(iDiff >= (WHEEL_SLOTS * WHEEL_SLOTS))
+			iTick = m_iCurrentTick + (WHEEL_SLOTS * WHEEL_SLOTS) - 1;
+		m_aWheel[1][(iTick / WHEEL_SLOTS) % WHEEL_SLOTS].push_back(frame);
+	}
+
+	m_uScheduledFrames++;
 }
 
 void KviAnimatedPixmapCache::internalScheduleFrameChange(uint delay, KviAnimatedPixmapInterface * receiver)
 {
-	//qDebug("Adding %i - %i",(uint)KviTimeUtils::getCurrentTimeMills()+delay,receiver);
 	m_timerMutex.lock();
-	long long when = KviTimeUtils::getCurrentTimeMills() + delay;
+	long long now = KviTimeUtils::getCurrentTimeMills();
 
-	m_timerData.insert(when, receiver);
+	QHash<KviAnimatedPixmapInterface *, unsigned long long>::iterator it = m_hReceiverGenerations.find(receiver);
+	if(it == m_hReceiverGenerations.end())
+		it = m_hReceiverGenerations.insert(receiver, m_uNextGeneration++);
 
 	if(!m_animationTimer.isActive())
+	{
+		// the wheel is empty: make it start from now
+		m_iCurrentTick = now / FRAME_DELAY;
 		m_animationTimer.start();
+	}
+
+	ScheduledFrame frame;
+	frame.receiver = receiver;
+	frame.generation = it.value();
+	frame.tick = (now + delay) / FRAME_DELAY;
+	wheelInsert(frame);
 
 	m_timerMutex.unlock();
 }
@@ -188,57 +626,103 @@ void KviAnimatedPixmapCache::internalScheduleFrameChange(uint delay, KviAnimated
 void KviAnimatedPixmapCache::timeoutEvent()
 {
 	/*
-	* We are adding 15msecs to the current time. This MAY lead to the situation,
-	* when the current frame will be painted a bit earlier, then I should.
-	* But we are just playing animated gifs, not a HDTV video. So it should be OK.
-	*
-	* But it makes good speedup if there will be event, scheduled in such order:
-	* 1 event  at time X
-	* 3 events at time X+2msec
-	* 2 events at time X+6msec
-	* 1 event  at time X+8msec
-	* 1 event  at time X+9msec
-	* 1 event  at time X+12msec
-	* ...
-	*
-	* Such situation is possible if we will have lots of smiles with almost the same
-	* frame delays.
+	* We are processing all the frames due up to one FRAME_DELAY in the future.
+	* This MAY lead to the situation, when the current frame will be painted a bit
+	* earlier, then I should. But we are just playing animated gifs, not a HDTV video.
 	*
-	* So it will not emit additional 5 events.
+	* Frames are kept in a two level timing wheel with FRAME_DELAY sized ticks,
+	* so scheduling and expiring a frame costs O(1) regardless of the number of
+	* animations on screen. All the changes that fall in the same tick are
+	* coalesced: each receiver gets a single signal, even if it was scheduled
+	* several times.
 	*/
-	long long now = KviTimeUtils::getCurrentTimeMills() + FRAME_DELAY;
+	long long iTargetTick = (KviTimeUtils::getCurrentTimeMills() + FRAME_DELAY) / FRAME_DELAY;
 
-	//m_timerMutex.lock();
+	std::vector<ScheduledFrame> due;
+	QHash<KviAnimatedPixmapInterface *, int> hSteps;
+	std::vector<std::pair<KviAnimatedPixmapInterface *, unsigned long long>> receivers;
 
-	QMultiMap<long long, KviAnimatedPixmapInterface *>::iterator i = m_timerData.begin();
+	m_timerMutex.lock();
 
-	QList<KviAnimatedPixmapInterface *> processed;
-	while(i != m_timerData.end() && i.key() <= now)
+	if((iTargetTick < m_iCurrentTick - 1) || ((iTargetTick - m_iCurrentTick) >= (WHEEL_SLOTS * WHEEL_SLOTS)))
 	{
-		if(processed.contains(i.value()))
+		// the clock jumped (suspend, manual adjustment...): just fire everything and restart from now
+		for(auto & level : m_aWheel)
 		{
-			// increase the frame index but do not emit the signals as we'll be emitting it later
-			i.value()->nextFrame(false);
+			for(auto & slot : level)
+			{
+				due.insert(due.end(), slot.begin(), slot.end());
+				slot.clear();
+			}
 		}
-		else
+		m_uScheduledFrames = 0;
+		m_iCurrentTick = iTargetTick + 1;
+	}
+	else
+	{
+		while(m_iCurrentTick <= iTargetTick)
 		{
-			// we'll be emitting the signal later
-			processed.append(i.value());
+			if((m_iCurrentTick % WHEEL_SLOTS) == 0)
+			{
+				// entered a new level 0 revolution: cascade the matching level 1 slot
+				std::vector<ScheduledFrame> cascade;
+				cascade.swap(m_aWheel[1][(m_iCurrentTick / WHEEL_SLOTS) % WHEEL_SLOTS]);
+				m_uScheduledFrames -= cascade.size();
+				for(auto & f : cascade)
+					wheelInsert(f);
+			}
+
+			std::vector<ScheduledFrame> & slot = m_aWheel[0][m_iCurrentTick % WHEEL_SLOTS];
+			m_uScheduledFrames -= slot.size();
+			due.insert(due.end(), slot.begin(), slot.end());
+			slot.clear();
+
+			m_iCurrentTick++;
 		}
+	}
+
+	for(auto & f : due)
+	{
+		// skip the frames of receivers that have been deleted in the meantime
+		QHash<KviAnimatedPixmapInterface *, unsigned long long>::iterator it = m_hReceiverGenerations.find(f.receiver);
+		if((it == m_hReceiverGenerations.end()) || (it.value() != f.generation))
+			continue;
 
-		i = m_timerData.erase(i);
+		QHash<KviAnimatedPixmapInterface *, int>::iterator step = hSteps.find(f.receiver);
+		if(step == hSteps.end())
+		{
+			hSteps.insert(f.receiver, 1);
+			receivers.emplace_back(f.receiver, f.generation);
+		}
+		else
+		{
+			step.value()++;
+		}
 	}
 
-	for(auto i : processed)
+	m_timerMutex.unlock();
+
+	for(auto & r : receivers)
 	{
+		// a previous receiver might have deleted this one while handling its signal
+		m_timerMutex.lock();
+		QHash<KviAnimatedPixmapInterface *, unsigned long long>::iterator it = m_hReceiverGenerations.find(r.first);
+		bool bAlive = (it != m_hReceiverGenerations.end()) && (it.value() == r.second);
+		m_timerMutex.unlock();
+		if(!bAlive)
+			continue;
+
+		// increase the frame index for the coalesced changes without emitting the signals
+		for(int i = hSteps.value(r.first) - 1; i > 0; i--)
+			r.first->nextFrame(false);
 		// increase the frame index and emit the signal
-		i->nextFrame(true);
+		r.first->nextFrame(true);
 	}
 
-	// m_timerMutex.unlock();
-
-	if(m_timerData.empty())
+	m_timerMutex.lock();
+	if(m_uScheduledFrames == 0)
 		m_animationTimer.stop();
+	m_timerMutex.unlock();
 }
 
 QPixmap * KviAnimatedPixmapCache::dummyPixmap()
@@ -251,21 +735,8 @@ QPixmap * KviAnimatedPixmapCache::dummyPixmap()
 void KviAnimatedPixmapCache::internalNotifyDelete(
     KviAnimatedPixmapInterface * receiver)
 {
+	// the entries still in the wheel are dropped lazily when they expire
 	m_timerMutex.lock();
-
-	QMultiMap<long long, KviAnimatedPixmapInterface *>::iterator i = m_timerData.begin();
-
-	while(i != m_timerData.end())
-	{
-		if(i.value() == receiver)
-		{
-			i = m_timerData.erase(i);
-		}
-		else
-		{
-			++i;
-		}
-	}
-
+	m_hReceiverGenerations.remove(receiver);
 	m_timerMutex.unlock();
 }
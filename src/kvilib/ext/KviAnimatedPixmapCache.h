@@ -27,12 +27,31 @@
 #include "kvi_settings.h"
 #include "KviAnimatedPixmapInterface.h"
 
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QList>
 #include <QMultiHash>
-#include <QMultiMap>
 #include <QMutex>
 #include <QObject>
 #include <QPixmap>
+#include <QThreadPool>
 #include <QTimer>
+#include <QWaitCondition>
+
+#include <memory>
+#include <vector>
+
+// number of slots in each level of the frame scheduler wheel
+#define KVI_ANIMATEDPIXMAPCACHE_WHEEL_SLOTS 64
+// unreferenced frame data kept around for reuse (bytes)
+#define KVI_ANIMATEDPIXMAPCACHE_RETAINED_BYTES (8 * 1024 * 1024)
+// all the frame data, referenced or not: above this the retained data goes first (bytes)
+#define KVI_ANIMATEDPIXMAPCACHE_BUDGET_BYTES (64 * 1024 * 1024)
+// decoded frames that no load() or resize() has claimed are dropped after this time (msecs)
+#define KVI_ANIMATEDPIXMAPCACHE_PENDING_DECODE_TTL 60000
+// ...or earlier, oldest first, when more than this number are waiting
+#define KVI_ANIMATEDPIXMAPCACHE_MAX_PENDING_DECODES 64
 
 class KVILIB_API KviAnimatedPixmapCache : public QObject
 {
@@ -77,20 +96,26 @@ public:
 	 *
 	 * It adds references counter and
 	 * mutex, to provide thread-safety.
+	 *
+	 * The data is shared by content: two files with the same
+	 * bytes (the same avatar received twice, for instance)
+	 * end up in the same Data.
 	 */
 	class Data : public QList<FrameInfo>
 	{
 	public:
-		uint refs;    //references count
-		QSize size;   //size of the pixmaps
-		QString file; //just to speedup the cache
+		uint refs;      //references count
+		QSize size;     //size of the pixmaps
+		QString file;   //the file the frames have been decoded from
+		QByteArray hash; //content hash of the file: the cache key
 		bool resized;
+		uint bytes;     //approximate memory used by the frames
 
-		Data(QString szFile) : QList<FrameInfo>(), refs(0), file(szFile), resized(false)
+		Data(QString szFile, QByteArray baHash) : QList<FrameInfo>(), refs(0), file(szFile), hash(baHash), resized(false), bytes(0)
 		{
 		}
 
-		Data(Data & other) : QList<FrameInfo>(other), refs(0), file(other.file), resized(false)
+		Data(Data & other) : QList<FrameInfo>(other), refs(0), file(other.file), hash(other.hash), resized(false), bytes(other.bytes)
 		{
 			for(int i = 0; i < count(); i++)
 			{
@@ -99,6 +124,17 @@ public:
 		}
 	};
 
+	/*
+	 * What we know about a file: its content hash and the size
+	 * and modification time it had when the hash was computed.
+	 */
+	struct FileStamp
+	{
+		QByteArray hash;
+		qint64 size;
+		qint64 modified;
+	};
+
 protected:
 	//
 	// This class is a singleton.
@@ -108,11 +144,78 @@ protected:
 	virtual ~KviAnimatedPixmapCache();
 
 protected:
+	/*
+	 * The decoded (but not yet converted to pixmaps) frames of a file.
+	 * Filled by a worker thread when preload() or preloadResize() is used.
+	 * When target is valid the frames are scaled to exactly that size.
+	 */
+	class DecodeJob
+	{
+	public:
+		enum State
+		{
+			Queued,
+			Running,
+			Done
+		};
+
+		QString file;
+		int width;
+		int height;
+		QSize target;
+		State state;
+		QSize size;
+		FileStamp stamp; // filled by decode()
+		QList<QImage> frames;
+		QList<uint> delays;
+		long long finished; // when the state became Done (msecs)
+
+		DecodeJob(const QString & szFile, int iWidth, int iHeight, const QSize & targetSize = QSize())
+		    : file(szFile), width(iWidth), height(iHeight), target(targetSize), state(Queued), finished(0)
+		{
+			stamp.size = -1;
+			stamp.modified = -1;
+		}
+
+		void decode();
+	};
+
+	/*
+	 * An entry of the frame scheduler.
+	 * The generation allows dropping entries of deleted receivers lazily.
+	 */
+	struct ScheduledFrame
+	{
+		KviAnimatedPixmapInterface * receiver;
+		unsigned long long generation;
+		long long tick;
+	};
+
 	mutable QMutex m_cacheMutex;
 	mutable QMutex m_timerMutex;
 
-	QMultiHash<QString, Data *> m_hCache;
-	QMultiMap<long long, KviAnimatedPixmapInterface *> m_timerData;
+	QMultiHash<QByteArray, Data *> m_hCache;
+	// the content hashes of the files we have seen
+	QHash<QString, FileStamp> m_hFileStamps;
+	// unreferenced data kept for reuse, least recently used first
+	QList<Data *> m_lRetained;
+	uint m_uRetainedBytes;
+	// all the data, referenced or not
+	quint64 m_uTotalBytes;
+	// decodes started by preload() or preloadResize() and not yet claimed by load() or resize()
+	QHash<QString, std::shared_ptr<DecodeJob>> m_hPendingDecodes;
+	QMutex m_decodeMutex;
+	QWaitCondition m_decodeFinished;
+	QThreadPool m_decodePool;
+	// drops the unclaimed decodes
+	QTimer m_decodeExpiryTimer;
+
+	// two level timing wheel: level 0 has one slot per tick, level 1 one slot per level 0 revolution
+	std::vector<ScheduledFrame> m_aWheel[2][KVI_ANIMATEDPIXMAPCACHE_WHEEL_SLOTS];
+	long long m_iCurrentTick;
+	uint m_uScheduledFrames;
+	QHash<KviAnimatedPixmapInterface *, unsigned long long> m_hReceiverGenerations;
+	unsigned long long m_uNextGeneration;
 	QTimer m_animationTimer;
 
 	static KviAnimatedPixmapCache * m_pInstance;
@@ -121,16 +224,37 @@ protected:
 	Data * internalLoad(const QString & szFile, int iWidth = 0, int iHeight = 0);
 	Data * internalResize(Data * data, const QSize & size);
 	void internalFree(Data * data);
+	void internalPreload(const QString & szFile, int iWidth, int iHeight);
+	void internalPreloadResize(Data * data, const QSize & size);
+	bool internalIsResizeReady(Data * data, const QSize & size);
+	void startDecode(const QString & szKey, std::shared_ptr<DecodeJob> job);
+	std::shared_ptr<DecodeJob> claimDecode(const QString & szKey);
+	void dropOldestDecode();
+	Data * findData(const QByteArray & hash, const QSize & size, bool bResized);
+	bool cachedHash(const QString & szFile, QByteArray & hash);
+	void reviveData(Data * data);
+	void destroyData(Data * data);
+	void trimRetained();
 
 	void internalScheduleFrameChange(uint delay, KviAnimatedPixmapInterface * receiver);
 	void internalNotifyDelete(KviAnimatedPixmapInterface * receiver);
+	void wheelInsert(const ScheduledFrame & frame);
 
 protected slots:
 	virtual void timeoutEvent();
+	void startDecodeExpiry();
+	void expireDecodes();
+
+signals:
+	/*
+	 * Emitted in the GUI thread when a preloadResize() job has finished
+	 */
+	void preloadFinished();
 
 public:
 	static void init();
 	static void done();
+	static KviAnimatedPixmapCache * instance() { return m_pInstance; }
 
 	static void scheduleFrameChange(uint delay, KviAnimatedPixmapInterface * receiver)
 	{
@@ -142,11 +266,51 @@ public:
 		return m_pInstance->internalLoad(szFileName, iWidth, iHeight);
 	}
 
+	/*
+	 * Starts decoding szFileName on a worker thread.
+	 * A later load() with the same parameters picks up the decoded frames
+	 * (waiting for the decoder if it's still running).
+	 */
+	static void preload(const QString & szFileName, int iWidth = 0, int iHeight = 0)
+	{
+		m_pInstance->internalPreload(szFileName, iWidth, iHeight);
+	}
+
 	static Data * resize(Data * data, const QSize & size)
 	{
 		return m_pInstance->internalResize(data, size);
 	}
 
+	/*
+	 * Starts scaling the frames of data to size on a worker thread.
+	 * A later resize() with the same parameters picks up the scaled frames.
+	 * preloadFinished() is emitted when the worker is done.
+	 */
+	static void preloadResize(Data * data, const QSize & size)
+	{
+		m_pInstance->internalPreloadResize(data, size);
+	}
+
+	/*
+	 * Returns true if resize() can return without decoding or scaling anything
+	 */
+	static bool isResizeReady(Data * data, const QSize & size)
+	{
+		return m_pInstance->internalIsResizeReady(data, size);
+	}
+
+	/*
+	 * The content hash of the file as last seen by the cache.
+	 * Returns false if the file has never been loaded or has changed since.
+	 */
+	static bool fileStamp(const QString & szFileName, FileStamp & stamp);
+
+	/*
+	 * Tells the cache the content hash of a file (as saved by a previous session).
+	 * It is trusted only as long as the size and the modification time match.
+	 */
+	static void setFileStamp(const QString & szFileName, const FileStamp & stamp);
+
 	static void free(Data * data)
 	{
 		m_pInstance->internalFree(data);
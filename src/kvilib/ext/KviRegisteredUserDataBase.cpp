@@ -123,6 +123,7 @@ KVILIB_API KviRegisteredUserDataBase * g_pRegisteredUserDataBase = nullptr;
 //
 
 KviRegisteredUserDataBase::KviRegisteredUserDataBase()
+    : m_bWildMaskFiltersDirty(false)
 {
 	m_pUserDict = new KviPointerHashTable<QString, KviRegisteredUser>(31, false); // do not copy keys
 	m_pUserDict->setAutoDelete(true);
@@ -264,6 +265,8 @@ KviRegisteredUser * KviRegisteredUserDataBase::addMask(KviRegisteredUser * u, Kv
 		return nullptr; // ops...already there ?
 	}
 	append_mask_to_list(l, u, mask);
+	if(l == m_pWildMaskList)
+		m_bWildMaskFiltersDirty = true;
 	return nullptr;
 }
 
@@ -271,6 +274,7 @@ void KviRegisteredUserDataBase::copyFrom(KviRegisteredUserDataBase * db)
 {
 	m_pUserDict->clear();
 	m_pWildMaskList->clear();
+	m_bWildMaskFiltersDirty = true;
 	m_pMaskDict->clear();
 	m_pGroupDict->clear();
 	emit(databaseCleared());
@@ -367,6 +371,7 @@ bool KviRegisteredUserDataBase::removeMaskByPointer(KviIrcMask * mask)
 				emit(userChanged(mask->nick()));
 				m->user()->removeMask(mask);   // this one deletes m->mask()
 				m_pWildMaskList->removeRef(m); // this one deletes m
+				m_bWildMaskFiltersDirty = true;
 				return true;
 			}
 		}
@@ -421,6 +426,17 @@ KviRegisteredUserMask * KviRegisteredUserDataBase::findMatchingMask(const QStrin
 		}
 	}
 	// not found....lookup the wild ones
+	updateWildMaskFilters();
+	if(!m_wildHostFilter.mayContain(host.toLower()) && !m_wildUserFilter.mayContain(user.toLower()))
+	{
+		// only the masks with a wild host and username may match
+		for(auto & m : m_unfilteredWildMasks)
+		{
+			if(m->mask()->matchesFixed(nick, user, host))
+				return m;
+		}
+		return nullptr;
+	}
 	for(KviRegisteredUserMask * m = m_pWildMaskList->first(); m; m = m_pWildMaskList->next())
 	{
 		if(m->mask()->matchesFixed(nick, user, host))
@@ -429,6 +445,45 @@ KviRegisteredUserMask * KviRegisteredUserDataBase::findMatchingMask(const QStrin
 	return nullptr; // no match at all
 }
 
+static inline bool kvi_reguserdb_isFixed(const QString & szMaskPart)
+{
+	return !(szMaskPart.contains('*') || szMaskPart.contains('?'));
+}
+
+void KviRegisteredUserDataBase::updateWildMaskFilters()
+{
+	if(!m_bWildMaskFiltersDirty)
+		return;
+	m_bWildMaskFiltersDirty = false;
+
+	m_wildHostFilter.reset(m_pWildMaskList->count());
+	m_wildUserFilter.reset(m_pWildMaskList->count());
+	m_unfilteredWildMasks.clear();
+
+	// a mask matches only if its fixed parts are equal (ignoring the case)
+	for(KviRegisteredUserMask * m = m_pWildMaskList->first(); m; m = m_pWildMaskList->next())
+	{
+		if(kvi_reguserdb_isFixed(m->mask()->host()))
+			m_wildHostFilter.insert(m->mask()->host().toLower());
+		else if(kvi_reguserdb_isFixed(m->mask()->user()))
+			m_wildUserFilter.insert(m->mask()->user().toLower());
+		else
+			m_unfilteredWildMasks.push_back(m);
+	}
+}
+
+bool KviRegisteredUserDataBase::mayMatch(const QString & nick, const QString & user, const QString & host)
+{
+	if(nick.isEmpty())
+		return false;
+	if(m_pMaskDict->find(nick))
+		return true;
+	updateWildMaskFilters();
+	if(!m_unfilteredWildMasks.empty())
+		return true;
+	return m_wildHostFilter.mayContain(host.toLower()) || m_wildUserFilter.mayContain(user.toLower());
+}
+
 KviRegisteredUser * KviRegisteredUserDataBase::findUserWithMask(const KviIrcMask & mask)
 {
 	KviRegisteredUserMask * m = findExactMask(mask);
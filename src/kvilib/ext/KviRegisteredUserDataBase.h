@@ -33,6 +33,7 @@
 #include "kvi_settings.h"
 #include "kvi_debug.h"
 
+#include "KviBloomFilter.h"
 #include "KviPointerHashTable.h"
 #include "KviRegisteredUserGroup.h"
 #include "KviRegisteredUserMask.h"
@@ -40,6 +41,8 @@
 
 #include <QObject>
 
+#include <vector>
+
 class KviIrcMask;
 class QString;
 
@@ -51,6 +54,11 @@ class QString;
 //    m_pMaskDict contains lists of non wild-nick KviRegisteredUserMask that point to users
 //    m_pWildMaskList is a list of wild-nick KviRegisteredUserMask that point to users
 //
+//    Matching a wild-nick mask is expensive (and most senders match none), so the
+//    fixed hosts (or usernames) of the wild-nick masks are kept in Bloom filters:
+//    when the sender's host and username aren't there only the masks with a wild
+//    host and username need to be checked.
+//
 
 class KVILIB_API KviRegisteredUserDataBase : public QObject
 {
@@ -64,6 +72,12 @@ private:
 	KviPointerHashTable<QString, KviRegisteredUserMaskList> * m_pMaskDict; // owns the objects, copies the keys
 	KviRegisteredUserMaskList * m_pWildMaskList;                           // owns the objects
 	KviPointerHashTable<QString, KviRegisteredUserGroup> * m_pGroupDict;
+	KviBloomFilter m_wildHostFilter;                              // the fixed hosts of the wild-nick masks, lowercase
+	KviBloomFilter m_wildUserFilter;                              // the fixed usernames of the other wild-nick masks, lowercase
+	std::vector<KviRegisteredUserMask *> m_unfilteredWildMasks;  // the wild-nick masks with a wild host and username, in order
+	bool m_bWildMaskFiltersDirty;
+
+	void updateWildMaskFilters();
 
 public:
 	void copyFrom(KviRegisteredUserDataBase * db);
@@ -81,6 +95,8 @@ public:
 	KviRegisteredUser * findUserWithMask(const KviIrcMask & mask);
 	KviRegisteredUserMask * findExactMask(const KviIrcMask & mask);
 	KviRegisteredUserMask * findMatchingMask(const QString & nick, const QString & user, const QString & host);
+	// false if no mask can match: a few hash probes, no wildcard matching
+	bool mayMatch(const QString & nick, const QString & user, const QString & host);
 	//Only used in few places (actually one) of the code, but lot of times;perfect for inlining...
 	//bool isIgnoredUser(const char * nick,const char * user,const char * host);
 	void load(const QString & filename);
@@ -0,0 +1,506 @@
+//=============================================================================
+//
+//   File : KviLogFrames.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviLogFrames.h"
+
+#ifdef COMPILE_ZLIB_SUPPORT
+
+#include <QFile>
+
+#include <zlib.h>
+
+#include <cstring>
+
+// gzip header of the index member: FEXTRA flag, no time, unknown OS
+static const unsigned char g_indexHeader[10] = { 0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff };
+// an empty final deflate block, then the CRC32 and the size of the (empty) content
+static const unsigned char g_indexTrailer[10] = { 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+// header + XLEN + subfield id and length + "KVIX" and size + trailer
+#define KVI_LOGFRAMES_INDEX_OVERHEAD (10 + 2 + 4 + 8 + 10)
+#define KVI_LOGFRAMES_INDEX_ENTRY_SIZE 12
+
+static void append_le(QByteArray & buffer, kvi_u64_t uValue, int iBytes)
+{
+	for(int i = 0; i < iBytes; i++)
+	{
+		buffer.append((char)(uValue & 0xff));
+		uValue >>= 8;
+	}
+}
+
+static kvi_u64_t read_le(const char * pcData, int iBytes)
+{
+	kvi_u64_t uValue = 0;
+	for(int i = iBytes - 1; i >= 0; i--)
+		uValue = (uValue << 8) | (unsigned char)pcData[i];
+	return uValue;
+}
+
+static void add_frame(std::vector<KviLogFrame> & frames, kvi_u32_t uTime, kvi_u64_t uOffset)
+{
+	// a single entry covers consecutive frames of unknown time
+	if((uTime == 0) && !frames.empty() && (frames.back().uTime == 0))
+		return;
+
+	frames.push_back({ uTime, uOffset });
+
+	if(frames.size() > KVI_LOGFRAMES_MAX_FRAMES)
+	{
+		// drop every other entry: a frame without entry is read together with the previous one
+		std::size_t j = 0;
+		for(std::size_t i = 0; i < frames.size(); i += 2)
+			frames[j++] = frames[i];
+		frames.resize(j);
+	}
+}
+
+// Decompresses a sequence of gzip members. On return uGoodSize is the size
+// of the complete members and uLastTime the MTIME of the last member seen.
+// If pFrames is not null it is filled with the complete members.
+// Returns false if the data ends with a truncated or broken member: out
+// has all the text that could be decompressed.
+static bool inflate_members(const QByteArray & in, QByteArray & out, kvi_u64_t & uGoodSize, kvi_u32_t & uLastTime, std::vector<KviLogFrame> * pFrames)
+{
+	uGoodSize = 0;
+	uLastTime = 0;
+	if(in.isEmpty())
+		return true;
+
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	if(inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+		return false;
+
+	gz_header hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	inflateGetHeader(&zs, &hdr);
+
+	zs.next_in = (Bytef *)in.data();
+	zs.avail_in = in.size();
+
+	char cBuffer[16384];
+	bool bOk = false;
+
+	for(;;)
+	{
+		zs.next_out = (Bytef *)cBuffer;
+		zs.avail_out = sizeof(cBuffer);
+		int iRet = ::inflate(&zs, Z_NO_FLUSH);
+		out.append(cBuffer, sizeof(cBuffer) - zs.avail_out);
+		if(hdr.done == 1)
+			uLastTime = hdr.time;
+
+		if(iRet == Z_STREAM_END)
+		{
+			if(pFrames)
+				add_frame(*pFrames, hdr.time, uGoodSize);
+			uGoodSize = in.size() - zs.avail_in;
+			if(zs.avail_in == 0)
+			{
+				bOk = true;
+				break;
+			}
+			// the next member
+			inflateReset(&zs);
+			memset(&hdr, 0, sizeof(hdr));
+			inflateGetHeader(&zs, &hdr);
+			continue;
+		}
+
+		if(iRet == Z_OK)
+			continue;
+
+		// Z_BUF_ERROR: truncated, anything else: broken
+		break;
+	}
+
+	inflateEnd(&zs);
+	return bOk;
+}
+
+KviLogFrameWriter::KviLogFrameWriter(QFile * pFile)
+    : m_pFile(pFile), m_pStream(nullptr), m_uOffset(0), m_uFrameSize(0), m_bDirty(false)
+{
+	m_pHeader = new gz_header;
+}
+
+KviLogFrameWriter::~KviLogFrameWriter()
+{
+	if(m_pStream)
+	{
+		deflateEnd(m_pStream);
+		delete m_pStream;
+	}
+	delete m_pHeader;
+}
+
+bool KviLogFrameWriter::prepare()
+{
+	m_uOffset = m_pFile->size();
+	if(m_uOffset == 0)
+		return true;
+
+	kvi_u64_t uIndexOffset;
+	if(readIndex(m_pFile, m_Frames, uIndexOffset))
+	{
+		// new frames go in place of the index
+		if(!m_pFile->resize(uIndexOffset))
+			return false;
+		m_uOffset = uIndexOffset;
+		return m_pFile->seek(m_uOffset);
+	}
+
+	// an older log or a broken one: rebuild the index and find the end of the last complete member
+	if(!m_pFile->seek(0))
+		return false;
+	QByteArray data = m_pFile->readAll();
+	QByteArray text;
+	kvi_u64_t uGoodSize;
+	kvi_u32_t uLastTime;
+
+	if(inflate_members(data, text, uGoodSize, uLastTime, &m_Frames))
+	{
+		text.clear();
+	}
+	else if((data.size() >= (int)uGoodSize + 2) && ((unsigned char)data[(int)uGoodSize] == 0x1f) && ((unsigned char)data[(int)uGoodSize + 1] == 0x8b))
+	{
+		// a truncated member: drop it, its text is compressed again below
+		if(!m_pFile->resize(uGoodSize))
+			return false;
+		// keep only the text of the broken member
+		QByteArray good;
+		kvi_u64_t uDummySize;
+		kvi_u32_t uDummyTime;
+		inflate_members(data.left(uGoodSize), good, uDummySize, uDummyTime, nullptr);
+		text.remove(0, good.size());
+	}
+	else if(uGoodSize > 0)
+	{
+		// garbage after the last complete member: usually the zero filled
+		// blocks left by a power loss. The readers would stop there and never
+		// see what we append: drop it and keep the frames found before it.
+		if(!m_pFile->resize(uGoodSize))
+			return false;
+		text.clear();
+	}
+	else
+	{
+		// not gzip data at all: don't destroy it, just append after it
+		text.clear();
+		m_Frames.clear();
+		uGoodSize = data.size();
+	}
+
+	m_uOffset = uGoodSize;
+	if(!m_pFile->seek(m_uOffset))
+		return false;
+
+	if(!text.isEmpty())
+	{
+		if(!text.endsWith('\n'))
+			text.append('\n');
+		append(text, uLastTime);
+		finishFrame();
+	}
+	return true;
+}
+
+bool KviLogFrameWriter::beginFrame(kvi_u32_t uTime)
+{
+	m_pStream = new z_stream;
+	memset(m_pStream, 0, sizeof(z_stream));
+	// 16 + MAX_WBITS: gzip wrapper
+	if(deflateInit2(m_pStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		delete m_pStream;
+		m_pStream = nullptr;
+		return false;
+	}
+
+	// the frame time goes in the member header too, so the index can be rebuilt
+	memset(m_pHeader, 0, sizeof(gz_header));
+	m_pHeader->time = uTime;
+	m_pHeader->os = 255;
+	deflateSetHeader(m_pStream, m_pHeader);
+
+	m_uFrameSize = 0;
+	add_frame(m_Frames, uTime, m_uOffset);
+	return true;
+}
+
+void KviLogFrameWriter::deflate(const char * pcData, int iLen, int iFlush)
+{
+	m_pStream->next_in = (Bytef *)pcData;
+	m_pStream->avail_in = iLen;
+
+	int iRet;
+	do
+	{
+		int iOldSize = m_output.size();
+		m_output.resize(iOldSize + 16384);
+		m_pStream->next_out = (Bytef *)(m_output.data() + iOldSize);
+		m_pStream->avail_out = 16384;
+		iRet = ::deflate(m_pStream, iFlush);
+		int iProduced = 16384 - m_pStream->avail_out;
+		m_output.resize(iOldSize + iProduced);
+		m_uOffset += iProduced;
+	} while((m_pStream->avail_out == 0) && (iRet != Z_STREAM_END) && (iRet != Z_STREAM_ERROR));
+}
+
+void KviLogFrameWriter::append(const QByteArray & data, kvi_u32_t uTime)
+{
+	if(data.isEmpty())
+		return;
+	if(!m_pStream && !beginFrame(uTime))
+		return;
+
+	deflate(data.data(), data.size(), Z_NO_FLUSH);
+	m_bDirty = true;
+	m_uFrameSize += data.size();
+
+	if(m_uFrameSize >= KVI_LOGFRAMES_FRAME_SIZE)
+		finishFrame();
+}
+
+void KviLogFrameWriter::syncFlush()
+{
+	if(!m_pStream || !m_bDirty)
+		return;
+	deflate(nullptr, 0, Z_SYNC_FLUSH);
+	m_bDirty = false;
+}
+
+void KviLogFrameWriter::finishFrame()
+{
+	if(!m_pStream)
+		return;
+	deflate(nullptr, 0, Z_FINISH);
+	deflateEnd(m_pStream);
+	delete m_pStream;
+	m_pStream = nullptr;
+	m_bDirty = false;
+}
+
+void KviLogFrameWriter::finish()
+{
+	finishFrame();
+	if(!m_Frames.empty())
+		writeIndex();
+}
+
+void KviLogFrameWriter::writeIndex()
+{
+	int iFieldSize = KVI_LOGFRAMES_INDEX_ENTRY_SIZE * m_Frames.size() + 8;
+	kvi_u32_t uSize = KVI_LOGFRAMES_INDEX_OVERHEAD + KVI_LOGFRAMES_INDEX_ENTRY_SIZE * m_Frames.size();
+
+	m_output.append((const char *)g_indexHeader, sizeof(g_indexHeader));
+	append_le(m_output, iFieldSize + 4, 2); // XLEN
+	m_output.append("KX", 2);
+	append_le(m_output, iFieldSize, 2);
+	for(auto & f : m_Frames)
+	{
+		append_le(m_output, f.uTime, 4);
+		append_le(m_output, f.uOffset, 8);
+	}
+	m_output.append("KVIX", 4);
+	append_le(m_output, uSize, 4);
+	m_output.append((const char *)g_indexTrailer, sizeof(g_indexTrailer));
+
+	m_uOffset += uSize;
+}
+
+bool KviLogFrameWriter::readIndex(QFile * pFile, std::vector<KviLogFrame> & frames, kvi_u64_t & uIndexOffset)
+{
+	kvi_u64_t uFileSize = pFile->size();
+	if(uFileSize < KVI_LOGFRAMES_INDEX_OVERHEAD)
+		return false;
+
+	if(!pFile->seek(uFileSize - 18))
+		return false;
+	QByteArray tail = pFile->read(18);
+	if(tail.size() != 18)
+		return false;
+	if(memcmp(tail.data(), "KVIX", 4) != 0)
+		return false;
+	if(memcmp(tail.data() + 8, g_indexTrailer, sizeof(g_indexTrailer)) != 0)
+		return false;
+
+	kvi_u64_t uSize = read_le(tail.data() + 4, 4);
+	if((uSize < KVI_LOGFRAMES_INDEX_OVERHEAD) || (uSize > uFileSize))
+		return false;
+	if(((uSize - KVI_LOGFRAMES_INDEX_OVERHEAD) % KVI_LOGFRAMES_INDEX_ENTRY_SIZE) != 0)
+		return false;
+
+	uIndexOffset = uFileSize - uSize;
+	if(!pFile->seek(uIndexOffset))
+		return false;
+	QByteArray index = pFile->read(uSize);
+	if(index.size() != (int)uSize)
+		return false;
+
+	const char * p = index.data();
+	if(memcmp(p, g_indexHeader, 4) != 0)
+		return false;
+	kvi_u64_t uFieldSize = uSize - KVI_LOGFRAMES_INDEX_OVERHEAD + 8;
+	if(read_le(p + 10, 2) != uFieldSize + 4)
+		return false;
+	if((p[12] != 'K') || (p[13] != 'X') || (read_le(p + 14, 2) != uFieldSize))
+		return false;
+
+	std::size_t uCount = (uSize - KVI_LOGFRAMES_INDEX_OVERHEAD) / KVI_LOGFRAMES_INDEX_ENTRY_SIZE;
+	frames.clear();
+	frames.reserve(uCount);
+	p += 16;
+	for(std::size_t i = 0; i < uCount; i++)
+	{
+		KviLogFrame f;
+		f.uTime = read_le(p, 4);
+		f.uOffset = read_le(p + 4, 8);
+		p += KVI_LOGFRAMES_INDEX_ENTRY_SIZE;
+		if((f.uOffset >= uIndexOffset) || (!frames.empty() && (f.uOffset <= frames.back().uOffset)))
+		{
+			frames.clear();
+			return false;
+		}
+		frames.push_back(f);
+	}
+	return true;
+}
+
+bool KviLogFrameWriter::inflate(const QByteArray & in, QByteArray & out)
+{
+	kvi_u64_t uGoodSize;
+	kvi_u32_t uLastTime;
+	return inflate_members(in, out, uGoodSize, uLastTime, nullptr);
+}
+
+KviLogFrameReader::KviLogFrameReader(const QString & szFileName)
+    : m_uDataEnd(0)
+{
+	m_pFile = new QFile(szFileName);
+}
+
+KviLogFrameReader::~KviLogFrameReader()
+{
+	delete m_pFile;
+}
+
+bool KviLogFrameReader::open()
+{
+	if(!m_pFile->open(QIODevice::ReadOnly))
+		return false;
+
+	kvi_u64_t uIndexOffset;
+	if(KviLogFrameWriter::readIndex(m_pFile, m_Frames, uIndexOffset))
+		m_uDataEnd = uIndexOffset;
+	else
+		m_uDataEnd = m_pFile->size();
+	return true;
+}
+
+bool KviLogFrameReader::readAll(QByteArray & out)
+{
+	if(!m_pFile->seek(0))
+		return false;
+	QByteArray data = m_pFile->readAll();
+	// keep whatever could be recovered from a broken file
+	KviLogFrameWriter::inflate(data, out);
+	return true;
+}
+
+bool KviLogFrameReader::readFrames(QByteArray & out, std::size_t uFirst, std::size_t uLast)
+{
+	kvi_u64_t uStart = m_Frames[uFirst].uOffset;
+	kvi_u64_t uEnd = (uLast < m_Frames.size()) ? m_Frames[uLast].uOffset : m_uDataEnd;
+
+	if(!m_pFile->seek(uStart))
+		return false;
+	QByteArray data = m_pFile->read(uEnd - uStart);
+	if(data.size() != (int)(uEnd - uStart))
+		return false;
+
+	QByteArray text;
+	if(!KviLogFrameWriter::inflate(data, text))
+		return false;
+	out.append(text);
+	return true;
+}
+
+bool KviLogFrameReader::readRange(QByteArray & out, kvi_u32_t uFrom, kvi_u32_t uTo)
+{
+	if(!isIndexed())
+		return readAll(out);
+
+	// the frame i covers the lines written from its time to the time of the frame i + 1
+	std::size_t uFirst = m_Frames.size();
+	std::size_t uLast = 0;
+	for(std::size_t i = 0; i < m_Frames.size(); i++)
+	{
+		if(m_Frames[i].uTime > uTo)
+			continue;
+		if(((i + 1) < m_Frames.size()) && (m_Frames[i + 1].uTime != 0) && (m_Frames[i + 1].uTime < uFrom))
+			continue;
+		if(uFirst == m_Frames.size())
+			uFirst = i;
+		uLast = i + 1;
+	}
+
+	if(uFirst == m_Frames.size())
+		return true; // nothing in range
+
+	if(readFrames(out, uFirst, uLast))
+		return true;
+
+	// the index doesn't match the data
+	out.clear();
+	return readAll(out);
+}
+
+bool KviLogFrameReader::readLastLines(QByteArray & out, unsigned int uLines)
+{
+	if(!isIndexed())
+		return readAll(out);
+
+	QByteArray text;
+	std::size_t uFirst = m_Frames.size();
+	while(uFirst > 0)
+	{
+		uFirst--;
+		QByteArray chunk;
+		if(!readFrames(chunk, uFirst, uFirst + 1))
+		{
+			out.clear();
+			return readAll(out);
+		}
+		chunk.append(text);
+		text = chunk;
+		if((unsigned int)text.count('\n') > uLines)
+			break;
+	}
+	out.append(text);
+	return true;
+}
+
+#endif // COMPILE_ZLIB_SUPPORT
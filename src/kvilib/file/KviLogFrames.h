@@ -0,0 +1,253 @@
+#ifndef _KVI_LOGFRAMES_H_
+#define _KVI_LOGFRAMES_H_
+//=============================================================================
+//
+//   File : KviLogFrames.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviLogFrames.h
+* \brief The compressed log file format
+*
+* A compressed log is a sequence of gzip members (RFC 1952): gunzip,
+* zcat and gzread() see the concatenation of their contents, so the
+* files stay readable by any tool (and by the older KVIrc versions).
+*
+* The text is compressed as it is written and a new member (a "frame")
+* is started every KVI_LOGFRAMES_FRAME_SIZE bytes of text, so each frame
+* can be decompressed on its own. The MTIME field of the member header
+* is the time of the first line in the frame.
+*
+* When the log is closed an index member is appended: it has an empty
+* content and carries, in a gzip extra field with the 'K','X' id, one
+* entry per frame made of the time of the first line in the frame
+* (32 bit, seconds since the epoch, 0 if unknown) and the frame offset
+* in the file (64 bit). The field ends with "KVIX" and the size of the
+* index member (32 bit), so the index can be found from the end of the
+* file. All the numbers are little endian.
+*
+* Logging again to the same file strips the index and writes it back
+* when done. A file without index (written by an older version, or
+* left behind by a crash) is scanned once: the index is rebuilt from the
+* member headers and the file is truncated after the last complete member,
+* the text recovered from the broken one is compressed again. Anything
+* else after the last complete member (i.e. the zero filled blocks left
+* by a power loss) is dropped.
+*/
+
+#include "kvi_settings.h"
+#include "kvi_inttypes.h"
+
+#ifdef COMPILE_ZLIB_SUPPORT
+
+#include <QByteArray>
+#include <QString>
+
+#include <vector>
+
+class QFile;
+struct z_stream_s;
+struct gz_header_s;
+
+#define KVI_LOGFRAMES_FRAME_SIZE (64 * 1024)
+#define KVI_LOGFRAMES_MAX_FRAMES 4096
+
+struct KviLogFrame
+{
+	kvi_u32_t uTime;   // of the first line, 0 if unknown
+	kvi_u64_t uOffset; // of the gzip member
+};
+
+/**
+* \class KviLogFrameWriter
+* \brief Compresses a log in frames
+*
+* The compressed data is accumulated in output(): the caller writes it
+* to the file and clears the buffer.
+*/
+class KVILIB_API KviLogFrameWriter
+{
+public:
+	/**
+	* \brief Constructs the frame writer
+	* \param pFile The log file, opened for reading and writing. It isn't owned
+	* \return KviLogFrameWriter
+	*/
+	KviLogFrameWriter(QFile * pFile);
+
+	/**
+	* \brief Destroys the frame writer. The current frame is lost if finish() hasn't been called
+	*/
+	~KviLogFrameWriter();
+
+private:
+	QFile * m_pFile;
+	z_stream_s * m_pStream; // the current frame, nullptr if none
+	gz_header_s * m_pHeader;
+	QByteArray m_output;
+	kvi_u64_t m_uOffset;    // file size, including the data still in m_output
+	kvi_u64_t m_uFrameSize; // uncompressed data in the current frame
+	bool m_bDirty;          // data deflated since the last flush
+	std::vector<KviLogFrame> m_Frames;
+
+public:
+	/**
+	* \brief Strips the index from an existing file or repairs it and moves to its end
+	* \return bool
+	*/
+	bool prepare();
+
+	/**
+	* \brief Compresses a chunk of text
+	* \param data The text
+	* \param uTime The time of the text, in seconds since the epoch
+	* \return void
+	*/
+	void append(const QByteArray & data, kvi_u32_t uTime);
+
+	/**
+	* \brief Makes all the text appended so far decompressible, without ending the frame
+	* \return void
+	*/
+	void syncFlush();
+
+	/**
+	* \brief Ends the current frame
+	* \return void
+	*/
+	void finishFrame();
+
+	/**
+	* \brief Ends the current frame and writes the index
+	* \return void
+	*/
+	void finish();
+
+	/**
+	* \brief Returns true if some text hasn't been flushed yet
+	* \return bool
+	*/
+	bool isDirty() const { return m_bDirty; };
+
+	/**
+	* \brief Returns the compressed data to be written to the file
+	* \return QByteArray &
+	*/
+	QByteArray & output() { return m_output; };
+
+	/**
+	* \brief Reads the index of a compressed log
+	* \param pFile The log file, opened for reading
+	* \param frames The buffer where to save the index entries
+	* \param uIndexOffset The offset of the index member
+	* \return bool
+	*/
+	static bool readIndex(QFile * pFile, std::vector<KviLogFrame> & frames, kvi_u64_t & uIndexOffset);
+
+	/**
+	* \brief Decompresses a sequence of gzip members
+	* \param in The compressed data
+	* \param out The buffer where to append the text
+	* \return bool false if the data is truncated or broken (out has the text that could be recovered)
+	*/
+	static bool inflate(const QByteArray & in, QByteArray & out);
+
+private:
+	bool beginFrame(kvi_u32_t uTime);
+	void deflate(const char * pcData, int iLen, int iFlush);
+	void writeIndex();
+};
+
+/**
+* \class KviLogFrameReader
+* \brief Reads a compressed log, or the part of it that covers a time range
+*/
+class KVILIB_API KviLogFrameReader
+{
+public:
+	/**
+	* \brief Constructs the frame reader
+	* \param szFileName The name of the log file
+	* \return KviLogFrameReader
+	*/
+	KviLogFrameReader(const QString & szFileName);
+
+	/**
+	* \brief Destroys the frame reader
+	*/
+	~KviLogFrameReader();
+
+private:
+	QFile * m_pFile;
+	std::vector<KviLogFrame> m_Frames;
+	kvi_u64_t m_uDataEnd;
+
+public:
+	/**
+	* \brief Opens the file and loads the index, if any
+	* \return bool
+	*/
+	bool open();
+
+	/**
+	* \brief Returns true if the file has an index
+	* \return bool
+	*/
+	bool isIndexed() const { return !m_Frames.empty(); };
+
+	/**
+	* \brief Returns the frames listed in the index
+	* \return const std::vector<KviLogFrame> &
+	*/
+	const std::vector<KviLogFrame> & frames() const { return m_Frames; };
+
+	/**
+	* \brief Decompresses the whole log
+	* \param out The buffer where to save the text
+	* \return bool
+	*/
+	bool readAll(QByteArray & out);
+
+	/**
+	* \brief Decompresses only the frames that may contain lines written in the given time range
+	* \param out The buffer where to save the text
+	* \param uFrom The start of the range, in seconds since the epoch
+	* \param uTo The end of the range, in seconds since the epoch
+	* \return bool
+	*/
+	bool readRange(QByteArray & out, kvi_u32_t uFrom, kvi_u32_t uTo);
+
+	/**
+	* \brief Decompresses the frames at the end of the log, until at least uLines lines are found
+	* \param out The buffer where to save the text
+	* \param uLines The number of lines needed
+	* \return bool
+	*/
+	bool readLastLines(QByteArray & out, unsigned int uLines);
+
+private:
+	bool readFrames(QByteArray & out, std::size_t uFirst, std::size_t uLast);
+};
+
+#endif // COMPILE_ZLIB_SUPPORT
+
+#endif // _KVI_LOGFRAMES_H_
@@ -27,8 +27,14 @@
 
 #include <QApplication>
 #include <QByteArray>
+#include <QIODevice>
 #include <QLabel>
 #include <QProgressDialog>
+#include <QRunnable>
+
+#ifdef COMPILE_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
 
 //
 // A KVIrc Package File is basically a simple zip file with some additional meta-data.
@@ -95,11 +101,38 @@
 
 // Everything is stored in LITTLE ENDIAN byte order.
 
+//
+// The data fields are independent streams, so the heavy part of the work
+// (deflating while packing, inflating and writing the files while unpacking)
+// runs on a pool of worker threads. The thread that owns the engine only
+// walks the package sequentially and keeps the progress dialog alive
+// while it waits for the workers.
+//
+
 //
 // Da Base Engine
 //
 
+class KviPackageIOEngineWorker : public QRunnable
+{
+public:
+	KviPackageIOEngineWorker(std::function<void()> fnRun)
+	    : m_fnRun(std::move(fnRun))
+	{
+		setAutoDelete(true);
+	}
+
+	void run() override
+	{
+		m_fnRun();
+	}
+
+private:
+	std::function<void()> m_fnRun;
+};
+
 KviPackageIOEngine::KviPackageIOEngine()
+    : m_uRunningWorkers(0), m_bWorkersFailed(false), m_eWorkerError(NoError), m_iWorkersAborted(0), m_iWorkerProgress(0)
 {
 	m_pProgressDialog = nullptr;
 	m_pStringInfoFields = new KviPointerHashTable<QString, QString>();
@@ -110,6 +143,7 @@ KviPackageIOEngine::KviPackageIOEngine()
 
 KviPackageIOEngine::~KviPackageIOEngine()
 {
+	stopWorkers();
 	if(m_pProgressDialog)
 		delete m_pProgressDialog;
 	delete m_pStringInfoFields;
@@ -162,3 +196,272 @@ bool KviPackageIOEngine::readError()
 	setLastError(__tr2qs("File read error"));
 	return false;
 }
+
+QString KviPackageIOEngine::errorString(StreamError eError)
+{
+	switch(eError)
+	{
+		case NoError:
+		case Aborted:
+			break;
+		case ReadError:
+			return __tr2qs("File read error");
+		case WriteError:
+			return __tr2qs("File write error");
+		case OpenError:
+			return __tr2qs("Failed to open a source file for reading");
+		case CompressionInitError:
+			return __tr2qs("Compression library initialization error");
+		case CompressionError:
+			return __tr2qs("Compression library error");
+		case CorruptStream:
+			return __tr2qs("Error in compressed file stream");
+		case NoCompressionSupport:
+			return __tr2qs("The package contains compressed data but this executable does not support compression");
+	}
+	return QString();
+}
+
+void KviPackageIOEngine::startWorker(std::function<StreamError()> fnJob)
+{
+	m_workerMutex.lock();
+	m_uRunningWorkers++;
+	m_workerMutex.unlock();
+
+	m_workerPool.start(new KviPackageIOEngineWorker([this, fnJob]() {
+		StreamError eError = workersAborted() ? NoError : fnJob();
+
+		m_workerMutex.lock();
+		if((eError != NoError) && !m_bWorkersFailed && !workersAborted())
+		{
+			m_bWorkersFailed = true;
+			m_eWorkerError = eError;
+			m_iWorkersAborted.storeRelease(1);
+		}
+		m_uRunningWorkers--;
+		m_workerCondition.wakeAll();
+		m_workerMutex.unlock();
+	}));
+}
+
+bool KviPackageIOEngine::waitForWorkers(const std::function<bool()> & fnDone, const std::function<bool()> & fnProgress)
+{
+	for(;;)
+	{
+		m_workerMutex.lock();
+		if(!fnDone() && !m_bWorkersFailed && (m_uRunningWorkers > 0))
+			m_workerCondition.wait(&m_workerMutex, 100);
+		bool bDone = fnDone();
+		bool bFailed = m_bWorkersFailed;
+		StreamError eError = m_eWorkerError;
+		m_workerMutex.unlock();
+
+		if(bFailed)
+		{
+			stopWorkers();
+			if(eError != Aborted)
+				setLastError(errorString(eError));
+			return false;
+		}
+
+		if(!fnProgress())
+		{
+			stopWorkers();
+			return false; // aborted
+		}
+
+		if(bDone)
+			return true;
+	}
+}
+
+bool KviPackageIOEngine::waitForAllWorkers(const std::function<bool()> & fnProgress)
+{
+	return waitForWorkers([this]() { return m_uRunningWorkers == 0; }, fnProgress);
+}
+
+void KviPackageIOEngine::stopWorkers()
+{
+	m_iWorkersAborted.storeRelease(1);
+	// the queued jobs are dropped without running
+	m_workerPool.clear();
+	m_workerPool.waitForDone();
+
+	m_workerMutex.lock();
+	m_uRunningWorkers = 0;
+	m_bWorkersFailed = false;
+	m_eWorkerError = NoError;
+	m_workerMutex.unlock();
+
+	m_iWorkerProgress.storeRelease(0);
+	m_iWorkersAborted.storeRelease(0);
+}
+
+#define BUFFER_SIZE 32768
+
+KviPackageIOEngine::StreamError KviPackageIOEngine::deflateStream(QIODevice * pSource, QIODevice * pDest, const std::function<bool(qint64)> & fnProgress)
+{
+#ifdef COMPILE_ZLIB_SUPPORT
+	unsigned char ibuffer[BUFFER_SIZE];
+	unsigned char obuffer[BUFFER_SIZE];
+
+	z_stream zstr;
+	zstr.zalloc = Z_NULL;
+	zstr.zfree = Z_NULL;
+	zstr.opaque = Z_NULL;
+
+	if(deflateInit(&zstr, 9) != Z_OK)
+		return CompressionInitError;
+
+	qint64 iTotalIn = 0;
+	int iFlush = Z_NO_FLUSH;
+	do
+	{
+		qint64 iReaded = pSource->read((char *)ibuffer, BUFFER_SIZE);
+		if(iReaded < 0)
+		{
+			deflateEnd(&zstr);
+			return ReadError;
+		}
+		iTotalIn += iReaded;
+		iFlush = pSource->atEnd() ? Z_FINISH : Z_NO_FLUSH;
+
+		zstr.next_in = ibuffer;
+		zstr.avail_in = iReaded;
+
+		// drain the output until deflate() has room to spare
+		do
+		{
+			zstr.next_out = obuffer;
+			zstr.avail_out = BUFFER_SIZE;
+
+			if(deflate(&zstr, iFlush) == Z_STREAM_ERROR)
+			{
+				deflateEnd(&zstr);
+				return CompressionError;
+			}
+
+			int iCompressed = BUFFER_SIZE - zstr.avail_out;
+			if((iCompressed > 0) && (pDest->write((char *)obuffer, iCompressed) != iCompressed))
+			{
+				deflateEnd(&zstr);
+				return WriteError;
+			}
+		} while(zstr.avail_out == 0);
+
+		if(!fnProgress(iTotalIn))
+		{
+			deflateEnd(&zstr);
+			return Aborted;
+		}
+	} while(iFlush != Z_FINISH);
+
+	deflateEnd(&zstr);
+	return NoError;
+#else
+	Q_UNUSED(pSource);
+	Q_UNUSED(pDest);
+	Q_UNUSED(fnProgress);
+	return CompressionInitError;
+#endif
+}
+
+KviPackageIOEngine::StreamError KviPackageIOEngine::inflateStream(QIODevice * pSource, kvi_u32_t uSize, QIODevice * pDest, const std::function<bool(qint64)> & fnProgress)
+{
+#ifdef COMPILE_ZLIB_SUPPORT
+	unsigned char ibuffer[BUFFER_SIZE];
+	unsigned char obuffer[BUFFER_SIZE];
+
+	z_stream zstr;
+	zstr.zalloc = Z_NULL;
+	zstr.zfree = Z_NULL;
+	zstr.opaque = Z_NULL;
+	zstr.next_in = Z_NULL;
+	zstr.avail_in = 0;
+
+	if(inflateInit(&zstr) != Z_OK)
+		return CompressionInitError;
+
+	kvi_u32_t uRemaining = uSize;
+	int ret = Z_OK;
+	while(ret != Z_STREAM_END)
+	{
+		if(zstr.avail_in == 0)
+		{
+			if(uRemaining == 0)
+			{
+				// the stream is truncated
+				inflateEnd(&zstr);
+				return CorruptStream;
+			}
+
+			qint64 iReaded = pSource->read((char *)ibuffer, qMin<kvi_u32_t>(uRemaining, BUFFER_SIZE));
+			if(iReaded <= 0)
+			{
+				inflateEnd(&zstr);
+				return ReadError;
+			}
+			uRemaining -= iReaded;
+
+			zstr.next_in = ibuffer;
+			zstr.avail_in = iReaded;
+		}
+
+		zstr.next_out = obuffer;
+		zstr.avail_out = BUFFER_SIZE;
+
+		ret = inflate(&zstr, Z_NO_FLUSH);
+		if((ret != Z_OK) && (ret != Z_STREAM_END))
+		{
+			inflateEnd(&zstr);
+			return CorruptStream;
+		}
+
+		int iDecompressed = BUFFER_SIZE - zstr.avail_out;
+		if((iDecompressed > 0) && (pDest->write((char *)obuffer, iDecompressed) != iDecompressed))
+		{
+			inflateEnd(&zstr);
+			return WriteError;
+		}
+
+		if(!fnProgress(uSize - uRemaining))
+		{
+			inflateEnd(&zstr);
+			return Aborted;
+		}
+	}
+
+	inflateEnd(&zstr);
+	return NoError;
+#else
+	Q_UNUSED(pSource);
+	Q_UNUSED(uSize);
+	Q_UNUSED(pDest);
+	Q_UNUSED(fnProgress);
+	return NoCompressionSupport;
+#endif
+}
+
+KviPackageIOEngine::StreamError KviPackageIOEngine::copyStream(QIODevice * pSource, kvi_u32_t uSize, QIODevice * pDest, const std::function<bool(qint64)> & fnProgress)
+{
+	unsigned char buffer[BUFFER_SIZE];
+
+	kvi_u32_t uRemaining = uSize;
+	while(uRemaining > 0)
+	{
+		qint64 iReaded = pSource->read((char *)buffer, qMin<kvi_u32_t>(uRemaining, BUFFER_SIZE));
+		if(iReaded < 0)
+			return ReadError;
+		if(iReaded == 0)
+			break; // the file is shorter than expected
+		uRemaining -= iReaded;
+
+		if(pDest->write((char *)buffer, iReaded) != iReaded)
+			return WriteError;
+
+		if(!fnProgress(uSize - uRemaining))
+			return Aborted;
+	}
+
+	return NoError;
+}
@@ -31,12 +31,20 @@
 */
 
 #include "kvi_settings.h"
+#include "kvi_inttypes.h"
 
 #include "KviPointerHashTable.h"
 
+#include <QAtomicInteger>
+#include <QMutex>
 #include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <functional>
 
 class QByteArray;
+class QIODevice;
 class QProgressDialog;
 class QLabel;
 
@@ -63,12 +71,39 @@ public:
 	*/
 	virtual ~KviPackageIOEngine();
 
+	/**
+	* \brief The result of the stream helpers and of the worker jobs
+	*
+	* The worker threads report these codes and the waiting thread translates
+	* them with errorString(): the message catalogues are not thread safe.
+	*/
+	enum StreamError
+	{
+		NoError,
+		Aborted, // stopped by the progress callback, there is no message
+		ReadError,
+		WriteError,
+		OpenError,
+		CompressionInitError,
+		CompressionError,
+		CorruptStream,
+		NoCompressionSupport
+	};
+
 private:
 	QString m_szLastError;
 	KviPointerHashTable<QString, QString> * m_pStringInfoFields;
 	KviPointerHashTable<QString, QByteArray> * m_pBinaryInfoFields;
 	QProgressDialog * m_pProgressDialog;
 	QLabel * m_pProgressDialogLabel = nullptr;
+	QThreadPool m_workerPool;
+	QMutex m_workerMutex;
+	QWaitCondition m_workerCondition;
+	unsigned int m_uRunningWorkers;
+	bool m_bWorkersFailed;
+	StreamError m_eWorkerError;
+	QAtomicInt m_iWorkersAborted;
+	QAtomicInteger<qint64> m_iWorkerProgress;
 
 public:
 	/**
@@ -133,6 +168,116 @@ protected:
 	* \return bool
 	*/
 	bool readError();
+
+	/**
+	* \brief Returns the translated message of an error
+	*
+	* Call it from the thread that owns the engine only.
+	* \param eError The error
+	* \return QString
+	*/
+	static QString errorString(StreamError eError);
+
+	/**
+	* \brief Runs a job on the worker pool
+	*
+	* The job returns an error code if it fails: the other jobs are then
+	* told to abort and the next wait fails with the message of the error.
+	* The job must not use the translation functions.
+	* Everything the job touches must outlive the job: the users
+	* call stopWorkers() before their data goes away.
+	* \param fnJob The job
+	* \return void
+	*/
+	void startWorker(std::function<StreamError()> fnJob);
+
+	/**
+	* \brief Waits for a condition set by the workers
+	*
+	* The condition is checked with the worker mutex held. While waiting
+	* fnProgress is called every now and then (it usually calls updateProgress()
+	* which keeps the user interface alive). If a worker fails or fnProgress
+	* returns false the running workers are stopped and false is returned.
+	* \param fnDone The condition
+	* \param fnProgress The progress callback
+	* \return bool
+	*/
+	bool waitForWorkers(const std::function<bool()> & fnDone, const std::function<bool()> & fnProgress);
+
+	/**
+	* \brief Waits for all the running workers
+	*
+	* This is a shortcut to waitForWorkers()
+	* \param fnProgress The progress callback
+	* \return bool
+	*/
+	bool waitForAllWorkers(const std::function<bool()> & fnProgress);
+
+	/**
+	* \brief Aborts the queued and running workers and waits for them
+	* \return void
+	*/
+	void stopWorkers();
+
+	/**
+	* \brief Returns true if the workers have been told to abort
+	*
+	* The jobs check it between the chunks of data.
+	* \return bool
+	*/
+	bool workersAborted() const { return m_iWorkersAborted.loadAcquire(); };
+
+	/**
+	* \brief Adds to the progress counter of the workers
+	* \param iBytes The number of bytes processed
+	* \return void
+	*/
+	void addWorkerProgress(qint64 iBytes) { m_iWorkerProgress.fetchAndAddRelaxed(iBytes); };
+
+	/**
+	* \brief Returns the progress counter of the workers
+	* \return qint64
+	*/
+	qint64 workerProgress() const { return m_iWorkerProgress.loadAcquire(); };
+
+	/**
+	* \brief Deflates a stream
+	*
+	* Reads pSource up to its end. fnProgress is called after each chunk with the number
+	* of bytes read so far and stops the operation by returning false (Aborted is returned then).
+	* It can run in a worker thread.
+	* \param pSource The uncompressed data
+	* \param pDest The device the compressed data is written to
+	* \param fnProgress The progress callback
+	* \return StreamError
+	*/
+	static StreamError deflateStream(QIODevice * pSource, QIODevice * pDest, const std::function<bool(qint64)> & fnProgress);
+
+	/**
+	* \brief Inflates a stream
+	*
+	* Reads at most uSize bytes from pSource.
+	* See deflateStream() for the progress callback.
+	* \param pSource The compressed data
+	* \param uSize The length of the compressed data
+	* \param pDest The device the uncompressed data is written to
+	* \param fnProgress The progress callback
+	* \return StreamError
+	*/
+	static StreamError inflateStream(QIODevice * pSource, kvi_u32_t uSize, QIODevice * pDest, const std::function<bool(qint64)> & fnProgress);
+
+	/**
+	* \brief Copies a stream
+	*
+	* Copies at most uSize bytes from pSource.
+	* See deflateStream() for the progress callback.
+	* \param pSource The source device
+	* \param uSize The length of the data
+	* \param pDest The target device
+	* \param fnProgress The progress callback
+	* \return StreamError
+	*/
+	static StreamError copyStream(QIODevice * pSource, kvi_u32_t uSize, QIODevice * pDest, const std::function<bool(qint64)> & fnProgress);
 };
 
 #endif //_KviPackageIOEngine_h_
@@ -30,16 +30,12 @@
 
 #include <QString>
 
-#ifdef COMPILE_ZLIB_SUPPORT
-#include <zlib.h>
-#endif
-
 //
 // See KviPackageIOEngine.cpp for the description of the KVIrc package file
 //
 
 KviPackageReader::KviPackageReader()
-    : KviPackageIOEngine()
+    : KviPackageIOEngine(), m_uScheduledBytes(0)
 {
 }
 
@@ -138,9 +134,7 @@ bool KviPackageReader::readHeader(const QString & szLocalFileName)
 	return readHeaderInternal(&f, szLocalFileName);
 }
 
-#define BUFFER_SIZE 32768
-
-bool KviPackageReader::unpackFile(KviFile * pFile, const QString & szUnpackPath)
+bool KviPackageReader::unpackFile(KviFile * pFile, const QString & szLocalFileName, const QString & szUnpackPath)
 {
 	// Flags
 	kvi_u32_t uFlags;
@@ -182,15 +176,8 @@ bool KviPackageReader::unpackFile(KviFile * pFile, const QString & szUnpackPath)
 		}
 	}
 
-	KviFile dest(szFileName);
-	if(!dest.open(QFile::WriteOnly | QFile::Truncate))
-	{
-		setLastError(__tr2qs("Failed to open a source file for reading"));
-		return false;
-	}
-
 	QString szProgressText = QString(__tr2qs("Unpacking file %1")).arg(szFileName);
-	if(!updateProgress(pFile->pos(), szProgressText))
+	if(!updateProgress(pFile->pos() - m_uScheduledBytes + workerProgress(), szProgressText))
 		return false; // aborted
 
 	// Size
@@ -198,178 +185,46 @@ bool KviPackageReader::unpackFile(KviFile * pFile, const QString & szUnpackPath)
 	if(!pFile->load(uSize))
 		return readError();
 
-// FilePayload
-#ifdef COMPILE_ZLIB_SUPPORT
-	if(uFlags & KVI_PACKAGE_DATAFIELD_FLAG_FILE_DEFLATE)
+	// FilePayload: a worker reads it through its own handle, we just skip it
+	kvi_file_offset_t uPayloadOffset = pFile->pos();
+	if((uPayloadOffset + uSize) > (kvi_file_offset_t)pFile->size())
 	{
-		//qDebug ("loading compressed data");
-		int iRemainingSize = uSize;
-		unsigned char ibuffer[BUFFER_SIZE];
-		unsigned char obuffer[BUFFER_SIZE];
-
-		int iToRead = iRemainingSize;
-		if(iToRead > BUFFER_SIZE)
-			iToRead = BUFFER_SIZE;
-		int iReaded = pFile->read((char *)ibuffer, iToRead);
-		iRemainingSize -= iReaded;
-
-		z_stream zstr;
-		zstr.zalloc = Z_NULL;
-		zstr.zfree = Z_NULL;
-		zstr.opaque = Z_NULL;
-		zstr.next_in = ibuffer;
-		zstr.avail_in = iReaded;
-		zstr.next_out = obuffer;
-		zstr.avail_out = BUFFER_SIZE;
-
-		if(inflateInit(&zstr) != Z_OK)
-		{
-			setLastError(__tr2qs("Compression library initialization error"));
-			return false;
-		}
-
-		while((iReaded > 0) && (iRemainingSize > 0))
-		{
-			zstr.next_out = obuffer;
-			zstr.avail_out = BUFFER_SIZE;
-
-			if(inflate(&zstr, Z_NO_FLUSH) != Z_OK)
-			{
-				setLastError(__tr2qs("Compression library error"));
-				return false;
-			}
-
-			if(zstr.avail_out < BUFFER_SIZE)
-			{
-				int iDecompressed = zstr.next_out - obuffer;
-				if(dest.write((char *)obuffer, iDecompressed) != iDecompressed)
-				{
-					inflateEnd(&zstr);
-					return writeError();
-				}
-			}
-
-			if(zstr.avail_in < BUFFER_SIZE)
-			{
-				int iDataToRead = BUFFER_SIZE - zstr.avail_in;
-				if(iDataToRead < BUFFER_SIZE)
-				{
-					if(ibuffer != zstr.next_in)
-					{
-						// hum, there is still some data in the buffer to be readed
-						// and it is not at the beginning...move it to the beginning of ibuffer
-						memmove(ibuffer, zstr.next_in, zstr.avail_in);
-					}
-				}
-
-				if(iDataToRead > iRemainingSize)
-					iDataToRead = iRemainingSize;
-
-				iReaded = pFile->read((char *)(ibuffer + zstr.avail_in), iDataToRead);
-				if(iReaded < 0)
-				{
-					inflateEnd(&zstr);
-					return readError();
-				}
-
-				iRemainingSize -= iReaded;
-				zstr.avail_in += iReaded;
-				zstr.next_in = ibuffer;
-
-				if((zstr.total_in % 2000000) == 0)
-				{
-					QString szTmp = QString(" (%1 of %2 bytes)").arg(zstr.total_in, uSize);
-					QString szPrg = szProgressText + szTmp;
-					if(!updateProgress(pFile->pos(), szPrg))
-						return false; // aborted
-				}
-			}
-		}
-		// flush pending output
-		zstr.next_out = obuffer;
-		zstr.avail_out = BUFFER_SIZE;
-
-		int ret;
-
-		do
-		{
-			ret = inflate(&zstr, Z_FINISH);
-
-			if((ret == Z_OK) || (ret == Z_STREAM_END) || (ret == Z_BUF_ERROR))
-			{
-				if(zstr.avail_out < BUFFER_SIZE)
-				{
-					int iDecompressed = zstr.next_out - obuffer;
-					if(dest.write((char *)obuffer, iDecompressed) != iDecompressed)
-					{
-						inflateEnd(&zstr);
-						return writeError();
-					}
-				}
-				else
-				{
-					//THIS HAPPENS FOR ZERO SIZE FILES
-					qDebug("Hum... internal, rEWq (ret = %d) (avail_out = %d)", ret, zstr.avail_out);
-
-					inflateEnd(&zstr);
-					setLastError(__tr2qs("Compression library internal error"));
-					return false;
-				}
-				zstr.next_out = obuffer;
-				zstr.avail_out = BUFFER_SIZE;
-			}
-
-		} while((ret == Z_OK) || (ret == Z_BUF_ERROR));
-
-		inflateEnd(&zstr);
-
-		if(ret != Z_STREAM_END)
-		{
-			setLastError(__tr2qs("Error in compressed file stream"));
-			return false;
-		}
+		setLastError(__tr2qs("Invalid data field: the package is probably corrupt"));
+		return false;
 	}
-	else
-	{
-#endif
-		//qDebug("Load uncompressed data");
-		unsigned char buffer[BUFFER_SIZE];
-		int iTotalFileSize = 0;
-		int iRemainingData = uSize;
-		int iToRead = iRemainingData;
-		if(iToRead > BUFFER_SIZE)
-			iToRead = BUFFER_SIZE;
-		int iReaded = 1;
-		//qDebug("iReaded %i and iToRead %i and index %i",iReaded,iToRead,pFile->pos());
-		while((iReaded > 0) && (iToRead > 0))
-		{
-			iReaded = pFile->read((char *)buffer, iToRead);
-			if(iReaded > 0)
-			{
-				iTotalFileSize += iReaded;
-				iRemainingData -= iReaded;
+	if(!pFile->seek(uPayloadOffset + uSize))
+		return readError();
+	m_uScheduledBytes += uSize;
 
-				if((iTotalFileSize % 3000000) == 0)
-				{
-					QString szTmp = QString(" (%1 of %2 bytes)").arg(iTotalFileSize).arg(uSize);
-					QString szPrg = szProgressText + szTmp;
-					if(!updateProgress(pFile->pos(), szPrg))
-						return false; // aborted
-				}
-				//qDebug("write file with size %i and name %s",iReaded,dest.fileName().toUtf8().data());
-				if(dest.write((char *)buffer, iReaded) != iReaded)
-					return writeError();
-			}
-			//qDebug("Remains %i", iRemainingData);
-			iToRead = iRemainingData;
-			if(iToRead > BUFFER_SIZE)
-				iToRead = BUFFER_SIZE;
-		}
-//qDebug("finish to read %i and index %i",iReaded,pFile->pos());
-#ifdef COMPILE_ZLIB_SUPPORT
+	// a file that shows up twice is overwritten: let the previous write finish first
+	if(m_UnpackedFileNames.contains(szFileName))
+	{
+		if(!waitForAllWorkers([this, pFile, &szProgressText]() { return updateProgress(pFile->pos() - m_uScheduledBytes + workerProgress(), szProgressText); }))
+			return false;
 	}
-#endif
-	dest.close();
+	m_UnpackedFileNames.insert(szFileName);
+
+	startWorker([this, szLocalFileName, szFileName, uFlags, uPayloadOffset, uSize]() {
+		KviFile source(szLocalFileName);
+		if(!source.open(QFile::ReadOnly) || !source.seek(uPayloadOffset))
+			return ReadError;
+
+		KviFile dest(szFileName);
+		if(!dest.open(QFile::WriteOnly | QFile::Truncate))
+			return OpenError;
+
+		qint64 iReported = 0;
+		auto fnProgress = [this, &iReported](qint64 iDone) {
+			addWorkerProgress(iDone - iReported);
+			iReported = iDone;
+			return !workersAborted();
+		};
+
+		StreamError eError = (uFlags & KVI_PACKAGE_DATAFIELD_FLAG_FILE_DEFLATE) ? inflateStream(&source, uSize, &dest, fnProgress) : copyStream(&source, uSize, &dest, fnProgress);
+		// the skipped tail of the field, if any
+		addWorkerProgress(uSize - iReported);
+		return eError;
+	});
 
 	return true;
 }
@@ -385,7 +240,15 @@ bool KviPackageReader::getStringInfoField(const QString & szName, QString & szBu
 
 bool KviPackageReader::unpack(const QString & szLocalFileName, const QString & szUnpackPath, kvi_u32_t uUnpackFlags)
 {
+	m_uScheduledBytes = 0;
+	m_UnpackedFileNames.clear();
+
 	bool bRet = unpackInternal(szLocalFileName, szUnpackPath, uUnpackFlags);
+
+	// the workers may still be busy if we have failed
+	stopWorkers();
+	m_UnpackedFileNames.clear();
+
 	hideProgressDialog();
 	return bRet;
 }
@@ -428,7 +291,7 @@ bool KviPackageReader::unpackInternal(const QString & szLocalFileName, const QSt
 		switch(uDataFieldType)
 		{
 			case KVI_PACKAGE_DATAFIELD_TYPE_FILE:
-				if(!unpackFile(&f, szUnpackPath))
+				if(!unpackFile(&f, szLocalFileName, szUnpackPath))
 					return false;
 				break;
 			default:
@@ -438,5 +301,6 @@ bool KviPackageReader::unpackInternal(const QString & szLocalFileName, const QSt
 		}
 	}
 
-	return true;
+	// the files are written by the workers
+	return waitForAllWorkers([this, &f]() { return updateProgress(f.pos() - m_uScheduledBytes + workerProgress(), __tr2qs("Reading package data")); });
 }
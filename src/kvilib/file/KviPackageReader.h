@@ -33,6 +33,8 @@
 #include "kvi_settings.h"
 #include "KviPackageIOEngine.h"
 
+#include <QSet>
+
 class KviFile;
 class QString;
 
@@ -44,6 +46,11 @@ class QString;
 */
 class KVILIB_API KviPackageReader : public KviPackageIOEngine
 {
+private:
+	// the payload bytes handed to the workers
+	kvi_u64_t m_uScheduledBytes;
+	QSet<QString> m_UnpackedFileNames;
+
 public:
 	/**
 	* \brief Creates the package reader object
@@ -108,12 +115,14 @@ private:
 	/**
 	* \brief Unpack the KVIrc package file
 	*
-	* This is the real unpack() function.
+	* This is the real unpack() function. It reads the header of the data field
+	* and leaves the payload to a worker that streams it to the target file.
 	* \param pFile The source file package
+	* \param szLocalFileName The source package
 	* \param szUnpackPath The path where to unpack the package
 	* \return bool
 	*/
-	bool unpackFile(KviFile * pFile, const QString & szUnpackPath);
+	bool unpackFile(KviFile * pFile, const QString & szLocalFileName, const QString & szUnpackPath);
 
 	/**
 	* \brief Read the header of the package
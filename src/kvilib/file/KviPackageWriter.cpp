@@ -29,13 +29,14 @@
 #include "KviPointerList.h"
 #include "kvi_inttypes.h"
 
+#include <QAtomicInt>
+#include <QBuffer>
 #include <QByteArray>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QString>
 
-#ifdef COMPILE_ZLIB_SUPPORT
-#include <zlib.h>
-#endif
+#include <vector>
 
 //
 // See KviPackageIOEngine.cpp for the description of the KVIrc package file
@@ -51,6 +52,16 @@ public:
 	bool m_bFileAllowCompression;
 	QString m_szFileLocalName;
 	QString m_szFileTargetName;
+	kvi_u64_t m_uFileSize;
+	// the deflate worker state for the File KviPackageWriterDataFieldType
+	enum JobState
+	{
+		JobNone,
+		JobRunning,
+		JobDone
+	};
+	QAtomicInt m_iJobState;
+	QByteArray m_Payload;
 };
 
 class KviPackageWriterPrivate
@@ -106,6 +117,8 @@ bool KviPackageWriter::addFileInternal(const QFileInfo * fi, const QString & szL
 	f->m_bFileAllowCompression = !(uAddFileFlags & NoCompression);
 	f->m_szFileLocalName = szLocalFileName;
 	f->m_szFileTargetName = szTargetFileName;
+	f->m_uFileSize = fi->size();
+	f->m_iJobState.storeRelease(KviPackageWriterDataField::JobNone);
 	m_p->pDataFields->append(f);
 
 	return true;
@@ -158,7 +171,45 @@ bool KviPackageWriter::addDirectory(const QString & szLocalDirectoryName, const
 	return true;
 }
 
-#define BUFFER_SIZE 32768
+// The files up to this size are deflated on the worker pool and their compressed
+// payload waits in memory until it's written: the bigger ones are streamed
+// straight into the package by packFile().
+#define KVI_PACKAGE_WRITER_MAX_BUFFERED_FILE_SIZE (16 * 1024 * 1024)
+// The deflate workers stop running ahead of the writer when this many bytes
+// of source files are waiting to be written.
+#define KVI_PACKAGE_WRITER_MAX_BUFFERED_BYTES (64 * 1024 * 1024)
+
+bool KviPackageWriter::canDeflateInWorker(KviPackageWriterDataField * pDataField)
+{
+#ifdef COMPILE_ZLIB_SUPPORT
+	if(pDataField->m_uType != KVI_PACKAGE_DATAFIELD_TYPE_FILE)
+		return false;
+	if(!pDataField->m_bFileAllowCompression)
+		return false;
+	return (pDataField->m_uFileSize > 64) && (pDataField->m_uFileSize <= KVI_PACKAGE_WRITER_MAX_BUFFERED_FILE_SIZE);
+#else
+	Q_UNUSED(pDataField);
+	return false;
+#endif
+}
+
+void KviPackageWriter::startDeflate(KviPackageWriterDataField * pDataField)
+{
+	pDataField->m_iJobState.storeRelease(KviPackageWriterDataField::JobRunning);
+
+	startWorker([this, pDataField]() {
+		StreamError eError = OpenError;
+		KviFile source(pDataField->m_szFileLocalName);
+		if(source.open(QFile::ReadOnly))
+		{
+			QBuffer payload(&(pDataField->m_Payload));
+			payload.open(QIODevice::WriteOnly);
+			eError = deflateStream(&source, &payload, [this](qint64) { return !workersAborted(); });
+		}
+		pDataField->m_iJobState.storeRelease(KviPackageWriterDataField::JobDone);
+		return eError;
+	});
+}
 
 bool KviPackageWriter::packFile(KviFile * pFile, KviPackageWriterDataField * pDataField)
 {
@@ -166,6 +217,32 @@ bool KviPackageWriter::packFile(KviFile * pFile, KviPackageWriterDataField * pDa
 	if(!updateProgress(m_p->iCurrentProgress, szProgressText))
 		return false; // aborted
 
+	QByteArray szTargetFileName = pDataField->m_szFileTargetName.toUtf8();
+	pDataField->m_uWrittenFieldLength = 4 + 4 + 4 + szTargetFileName.length(); // sizeof(flags + uncompressed size + path len + path)
+
+	if(pDataField->m_iJobState.loadAcquire() != KviPackageWriterDataField::JobNone)
+	{
+		// deflated by a worker: wait for the payload
+		if(!waitForWorkers(
+		       [pDataField]() { return pDataField->m_iJobState.loadAcquire() == KviPackageWriterDataField::JobDone; },
+		       [this, &szProgressText]() { return updateProgress(m_p->iCurrentProgress, szProgressText); }))
+			return false;
+
+		kvi_u32_t uFlags = KVI_PACKAGE_DATAFIELD_FLAG_FILE_DEFLATE;
+		if(!pFile->save(uFlags))
+			return writeError();
+		// Path
+		if(!pFile->save(szTargetFileName))
+			return writeError();
+		// Size and FilePayload
+		if(!pFile->save(pDataField->m_Payload))
+			return writeError();
+
+		pDataField->m_uWrittenFieldLength += pDataField->m_Payload.size();
+		pDataField->m_Payload = QByteArray();
+		return true;
+	}
+
 	KviFile source(pDataField->m_szFileLocalName);
 	if(!source.open(QFile::ReadOnly))
 	{
@@ -186,8 +263,6 @@ bool KviPackageWriter::packFile(KviFile * pFile, KviPackageWriterDataField * pDa
 	if(!pFile->save(uFlags))
 		return writeError();
 
-	QByteArray szTargetFileName = pDataField->m_szFileTargetName.toUtf8();
-
 	// Path
 	if(!pFile->save(szTargetFileName))
 		return writeError();
@@ -198,164 +273,40 @@ bool KviPackageWriter::packFile(KviFile * pFile, KviPackageWriterDataField * pDa
 	if(!pFile->save(uSize))
 		return writeError();
 
-	pDataField->m_uWrittenFieldLength = 4 + 4 + 4 + szTargetFileName.length(); // sizeof(flags + uncompressed size + path len + path)
-
-// FilePayload
-#ifdef COMPILE_ZLIB_SUPPORT
-	if(uFlags & KVI_PACKAGE_DATAFIELD_FLAG_FILE_DEFLATE)
+	QElapsedTimer progressTimer;
+	progressTimer.start();
+	auto fnProgress = [this, &szProgressText, &progressTimer, uSize](qint64 iDone) {
+		if(progressTimer.elapsed() < 100)
+			return true;
+		progressTimer.restart();
+		QString szTmp = QString(" (%1 of %2 bytes)").arg(iDone).arg(uSize);
+		return updateProgress(m_p->iCurrentProgress, szProgressText + szTmp);
+	};
+
+	// FilePayload
+	kvi_file_offset_t savedPayloadOffset = pFile->pos();
+	StreamError eError = (uFlags & KVI_PACKAGE_DATAFIELD_FLAG_FILE_DEFLATE) ? deflateStream(&source, pFile, fnProgress) : copyStream(&source, uSize, pFile, fnProgress);
+	if(eError != NoError)
 	{
-		unsigned char ibuffer[BUFFER_SIZE];
-		unsigned char obuffer[BUFFER_SIZE];
-
-		kvi_i32_t iReaded = source.read((char *)ibuffer, BUFFER_SIZE);
-		if(iReaded < 0)
-			return readError();
-
-		z_stream zstr;
-		zstr.zalloc = Z_NULL;
-		zstr.zfree = Z_NULL;
-		zstr.opaque = Z_NULL;
-		zstr.next_in = ibuffer;
-		zstr.avail_in = iReaded;
-		zstr.next_out = obuffer;
-		zstr.avail_out = BUFFER_SIZE;
-
-		if(deflateInit(&zstr, 9) != Z_OK)
-		{
-			setLastError(__tr2qs("Compression library initialization error"));
-			return false;
-		}
-
-		while(iReaded > 0)
-		{
-			zstr.next_out = obuffer;
-			zstr.avail_out = BUFFER_SIZE;
-
-			if(deflate(&zstr, Z_NO_FLUSH) != Z_OK)
-			{
-				setLastError(__tr2qs("Compression library error"));
-				return false;
-			}
-
-			if(zstr.avail_out < BUFFER_SIZE)
-			{
-				int iCompressed = zstr.next_out - obuffer;
-				pDataField->m_uWrittenFieldLength += iCompressed;
-				if(pFile->write((char *)obuffer, iCompressed) != iCompressed)
-				{
-					deflateEnd(&zstr);
-					return writeError();
-				}
-			}
-
-			if(zstr.avail_in < BUFFER_SIZE)
-			{
-				int iDataToRead = BUFFER_SIZE - zstr.avail_in;
-				if(iDataToRead < BUFFER_SIZE)
-				{
-					if(ibuffer != zstr.next_in)
-					{
-						// hum, there is still some data in the buffer to be readed
-						// and it is not at the beginning...move it to the beginning of ibuffer
-						memmove(ibuffer, zstr.next_in, zstr.avail_in);
-					}
-				}
-				iReaded = source.read((char *)(ibuffer + zstr.avail_in), iDataToRead);
-				if(iReaded < 0)
-				{
-					deflateEnd(&zstr);
-					return readError();
-				}
-				zstr.avail_in += iReaded;
-				zstr.next_in = ibuffer;
-
-				if((zstr.total_in % 2000000) == 0)
-				{
-					QString szTmp = QString(" (%1 of %2 bytes)").arg(zstr.total_in, uSize);
-					QString szPrg = szProgressText + szTmp;
-					if(!updateProgress(m_p->iCurrentProgress, szPrg))
-						return false; // aborted
-				}
-			}
-		}
-		// flush pending output
-		zstr.next_out = obuffer;
-		zstr.avail_out = BUFFER_SIZE;
-
-		int ret;
-		do
-		{
-			ret = deflate(&zstr, Z_FINISH);
-
-			if((ret == Z_OK) || (ret == Z_STREAM_END))
-			{
-				if(zstr.avail_out < BUFFER_SIZE)
-				{
-					int iCompressed = zstr.next_out - obuffer;
-					pDataField->m_uWrittenFieldLength += iCompressed;
-					if(pFile->write((char *)obuffer, iCompressed) != iCompressed)
-					{
-						deflateEnd(&zstr);
-						return writeError();
-					}
-				}
-				else
-				{
-					deflateEnd(&zstr);
-					setLastError(__tr2qs("Compression library internal error"));
-					return false;
-				}
+		if(eError != Aborted)
+			setLastError(errorString(eError));
+		return false;
+	}
 
-				zstr.next_out = obuffer;
-				zstr.avail_out = BUFFER_SIZE;
-			}
+	source.close();
 
-		} while(ret == Z_OK);
+	kvi_file_offset_t here = pFile->pos();
+	pDataField->m_uWrittenFieldLength += here - savedPayloadOffset;
 
+	if(uFlags & KVI_PACKAGE_DATAFIELD_FLAG_FILE_DEFLATE)
+	{
 		// store the compressed data size
-		kvi_file_offset_t here = pFile->pos();
+		uSize = here - savedPayloadOffset;
 		pFile->seek(savedSizeOffset);
-		uSize = zstr.total_out;
-
-		deflateEnd(&zstr);
 		if(!pFile->save(uSize))
 			return writeError();
-
-		if(ret != Z_STREAM_END)
-		{
-			setLastError(__tr2qs("Error while compressing a file stream"));
-			return false;
-		}
-
 		pFile->seek(here);
 	}
-	else
-	{
-#endif
-		unsigned char buffer[BUFFER_SIZE];
-		int iTotalFileSize = 0;
-		kvi_i32_t iReaded = source.read((char *)buffer, BUFFER_SIZE);
-		if(iReaded < 0)
-			return readError();
-		while(iReaded > 0)
-		{
-			iTotalFileSize += iReaded;
-			if((iTotalFileSize % 1000000) == 0)
-			{
-				QString szTmp = QString(" (%1 of %2 bytes)").arg(iTotalFileSize, uSize);
-				QString szPrg = szProgressText + szTmp;
-				if(!updateProgress(m_p->iCurrentProgress, szPrg))
-					return false; // aborted
-			}
-			pDataField->m_uWrittenFieldLength += iReaded;
-			if(pFile->write((char *)buffer, iReaded) != iReaded)
-				return writeError();
-			iReaded = source.read((char *)buffer, BUFFER_SIZE);
-		}
-#ifdef COMPILE_ZLIB_SUPPORT
-	}
-#endif
-	source.close();
 
 	return true;
 }
@@ -371,6 +322,14 @@ bool KviPackageWriter::pack(const QString & szFileName, kvi_u32_t uPackFlags)
 
 	bool bRet = packInternal(szFileName, uPackFlags);
 
+	// the workers may still be busy if we have failed
+	stopWorkers();
+	for(KviPackageWriterDataField * pDataField = m_p->pDataFields->first(); pDataField; pDataField = m_p->pDataFields->next())
+	{
+		pDataField->m_iJobState.storeRelease(KviPackageWriterDataField::JobNone);
+		pDataField->m_Payload = QByteArray();
+	}
+
 	hideProgressDialog();
 	return bRet;
 }
@@ -448,9 +407,27 @@ bool KviPackageWriter::packInternal(const QString & szFileName, kvi_u32_t)
 		return false; // aborted
 
 	// write PackageData
-	int iIdx = 0;
+	// The deflate workers run ahead of the loop below: the fields are
+	// still written in the order they have been added.
+	std::vector<KviPackageWriterDataField *> dataFields;
 	for(KviPackageWriterDataField * pDataField = m_p->pDataFields->first(); pDataField; pDataField = m_p->pDataFields->next())
+		dataFields.push_back(pDataField);
+
+	std::size_t uNextToDeflate = 0;
+	kvi_u64_t uBufferedBytes = 0;
+
+	int iIdx = 0;
+	for(KviPackageWriterDataField * pDataField : dataFields)
 	{
+		while((uNextToDeflate < dataFields.size()) && (uBufferedBytes < KVI_PACKAGE_WRITER_MAX_BUFFERED_BYTES))
+		{
+			KviPackageWriterDataField * pNext = dataFields[uNextToDeflate++];
+			if(!canDeflateInWorker(pNext))
+				continue;
+			uBufferedBytes += pNext->m_uFileSize;
+			startDeflate(pNext);
+		}
+
 		kvi_u32_t uKviPackageWriterDataFieldType = pDataField->m_uType;
 		if(!f.save(uKviPackageWriterDataFieldType))
 			return writeError();
@@ -480,6 +457,9 @@ bool KviPackageWriter::packInternal(const QString & szFileName, kvi_u32_t)
 			return writeError();
 
 		f.seek(savedEndOffset);
+
+		if(canDeflateInWorker(pDataField))
+			uBufferedBytes -= pDataField->m_uFileSize;
 		iIdx++;
 	}
 
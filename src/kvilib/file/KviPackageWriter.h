@@ -158,6 +158,22 @@ private:
 	*/
 	bool packFile(KviFile * pFile, KviPackageWriterDataField * pDataField);
 
+	/**
+	* \brief Returns true if the data field can be deflated on the worker pool
+	* \param pDataField The data field for the package
+	* \return bool
+	*/
+	bool canDeflateInWorker(KviPackageWriterDataField * pDataField);
+
+	/**
+	* \brief Deflates the file of the data field on the worker pool
+	*
+	* packFile() waits for the compressed payload and writes it.
+	* \param pDataField The data field for the package
+	* \return void
+	*/
+	void startDeflate(KviPackageWriterDataField * pDataField);
+
 	/**
 	* \brief Adds a file to the package.
 	*
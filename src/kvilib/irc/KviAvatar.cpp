@@ -134,3 +134,17 @@ KviAnimatedPixmap * KviAvatar::forSize(const QSize & size)
 	m_scaledPixmapsCache.insert(size, scaledPixmap);
 	return scaledPixmap;
 }
+
+bool KviAvatar::isReadyForSize(const QSize & size)
+{
+	if(m_scaledPixmapsCache.contains(size))
+		return true;
+	return m_pPixmap->isResizeReady(size, Qt::KeepAspectRatio);
+}
+
+void KviAvatar::preloadSize(const QSize & size)
+{
+	if(m_scaledPixmapsCache.contains(size))
+		return;
+	m_pPixmap->preloadResize(size, Qt::KeepAspectRatio);
+}
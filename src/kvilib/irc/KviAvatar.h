@@ -163,6 +163,23 @@ public:
 	*/
 	KviAnimatedPixmap * forSize(unsigned int uWidth, unsigned int uHeight) { return forSize(QSize(uWidth, uHeight)); }
 
+	/**
+	* \brief Returns true if forSize() can return without decoding or scaling.
+	* \param size The size of the avatar
+	* \return bool
+	*/
+	bool isReadyForSize(const QSize & size);
+
+	/**
+	* \brief Starts scaling the avatar to the requested size in background.
+	*
+	* The frames are shared with all the avatars with the same contents.
+	* A later forSize() with the same size picks them up.
+	* \param size The size of the avatar
+	* \return void
+	*/
+	void preloadSize(const QSize & size);
+
 	/**
 	* \brief Returns the string that uniquely identifies this avatar.
 	*
@@ -73,7 +73,7 @@ KviAvatarCache::~KviAvatarCache()
 	delete m_pAvatarDict;
 }
 
-void KviAvatarCache::replace(const QString & szIdString, const KviIrcMask & mask, const QString & szNetwork)
+void KviAvatarCache::replace(const QString & szIdString, const KviIrcMask & mask, const QString & szNetwork, const QString & szLocalPath)
 {
 	QString szKey;
 
@@ -84,6 +84,8 @@ void KviAvatarCache::replace(const QString & szIdString, const KviIrcMask & mask
 	KviAvatarCacheEntry * e = new KviAvatarCacheEntry;
 	e->szIdString = szIdString;
 	e->tLastAccess = kvi_unixTime();
+	if(!szLocalPath.isEmpty() && KviAnimatedPixmapCache::fileStamp(szLocalPath, e->stamp))
+		e->szLocalPath = szLocalPath;
 
 	m_pAvatarDict->replace(szKey, e);
 
@@ -145,6 +147,17 @@ void KviAvatarCache::load(const QString & szFileName)
 				KviAvatarCacheEntry * e = new KviAvatarCacheEntry;
 				e->tLastAccess = tLastAccess;
 				e->szIdString = szIdString;
+
+				e->szLocalPath = cfg.readEntry("LocalPath", "");
+				if(!e->szLocalPath.isEmpty())
+				{
+					e->stamp.hash = QByteArray::fromHex(cfg.readEntry("Hash", "").toLatin1());
+					e->stamp.size = cfg.readEntry("Size", "-1").toLongLong();
+					e->stamp.modified = cfg.readEntry("Modified", "-1").toLongLong();
+					// the pixmap cache checks size and modification time before trusting it
+					KviAnimatedPixmapCache::setFileStamp(e->szLocalPath, e->stamp);
+				}
+
 				m_pAvatarDict->replace(it.currentKey(), e);
 				cnt++;
 				if(cnt >= MAX_AVATARS_IN_CACHE)
@@ -169,6 +182,13 @@ void KviAvatarCache::save(const QString & szFileName)
 			cfg.setGroup(it.currentKey());
 			cfg.writeEntry("Avatar", e->szIdString);
 			cfg.writeEntry("LastAccess", ((unsigned int)(e->tLastAccess)));
+			if(!e->szLocalPath.isEmpty())
+			{
+				cfg.writeEntry("LocalPath", e->szLocalPath);
+				cfg.writeEntry("Hash", QString::fromLatin1(e->stamp.hash.toHex()));
+				cfg.writeEntry("Size", QString::number(e->stamp.size));
+				cfg.writeEntry("Modified", QString::number(e->stamp.modified));
+			}
 		}
 		++it;
 	}
@@ -33,6 +33,7 @@
 #include "kvi_settings.h"
 #include "KviTimeUtils.h"
 #include "KviPointerHashTable.h"
+#include "KviAnimatedPixmapCache.h"
 
 #include <QString>
 
@@ -47,6 +48,8 @@ struct KviAvatarCacheEntry
 {
 	QString szIdString;     /**< The id of the avatar */
 	kvi_time_t tLastAccess; /**< The time the avatar was last accessed */
+	QString szLocalPath;    /**< The local file of the avatar */
+	KviAnimatedPixmapCache::FileStamp stamp; /**< The content hash of the local file */
 };
 
 /**
@@ -97,9 +100,11 @@ public:
 	* \param szIdString The id of the avatar
 	* \param mask The mask of the user
 	* \param szNetwork The network where the user is on
+	* \param szLocalPath The local file of the avatar, if it's known to the pixmap cache
+	* its content hash is saved too, so the next session can share it without reading the file
 	* \return void
 	*/
-	void replace(const QString & szIdString, const KviIrcMask & mask, const QString & szNetwork);
+	void replace(const QString & szIdString, const KviIrcMask & mask, const QString & szNetwork, const QString & szLocalPath = QString());
 
 	/**
 	* \brief Remove an avatar from the cache
@@ -28,8 +28,10 @@
 #include "KviRegisteredUserDataBase.h"
 #include "KviStringConversion.h"
 
+#include <algorithm>
+
 KviIrcUserDataBase::KviIrcUserDataBase()
-    : QObject()
+    : QObject(), m_uRegisteredUserLookups(0), m_uRegisteredUserFastRejects(0)
 {
 	// we expect a maximum of ~4000 users (= ~16 KB array on a 32 bit machine)
 	// ...after that we will loose in performance
@@ -82,7 +84,7 @@ KviRegisteredUser * KviIrcUserDataBase::registeredUser(const QString & szNick, c
 		return nullptr;
 	KviIrcUserEntry * pEntry = find(szNick);
 	if(!pEntry)
-		return g_pRegisteredUserDataBase->findMatchingUser(szNick, szUser, szHost);
+		return findMatchingUser(szNick, szUser, szHost);
 
 	KviRegisteredUser * pUser = nullptr;
 
@@ -97,7 +99,7 @@ KviRegisteredUser * KviIrcUserDataBase::registeredUser(const QString & szNick, c
 		//user renamed or it is a first loockup
 		if(pEntry->hasHost() && pEntry->hasUser())
 		{
-			pUser = g_pRegisteredUserDataBase->findMatchingUser(szNick, pEntry->user(), pEntry->host());
+			pUser = findMatchingUser(szNick, pEntry->user(), pEntry->host());
 			if(pUser)
 			{
 				pEntry->m_szLastRegisteredMatchNick = szNick;
@@ -120,6 +122,24 @@ KviRegisteredUser * KviIrcUserDataBase::registeredUser(const QString & szNick, c
 	return pUser;
 }
 
+KviRegisteredUser * KviIrcUserDataBase::findMatchingUser(const QString & szNick, const QString & szUser, const QString & szHost)
+{
+	m_uRegisteredUserLookups++;
+	// most of the users aren't registered: don't match all the masks for them
+	if(!g_pRegisteredUserDataBase->mayMatch(szNick, szUser, szHost))
+	{
+		m_uRegisteredUserFastRejects++;
+		return nullptr;
+	}
+	return g_pRegisteredUserDataBase->findMatchingUser(szNick, szUser, szHost);
+}
+
+void KviIrcUserDataBase::resetLookupCounters()
+{
+	m_uRegisteredUserLookups = 0;
+	m_uRegisteredUserFastRejects = 0;
+}
+
 KviRegisteredUser * KviIrcUserDataBase::registeredUser(const QString & szNick)
 {
 	if(szNick.isEmpty())
@@ -137,7 +157,7 @@ void KviIrcUserDataBase::clear()
 	m_pDict->setAutoDelete(true);
 }
 
-KviIrcUserEntry * KviIrcUserDataBase::insertUser(const QString & szNick, const QString & szUser, const QString & szHost)
+KviIrcUserEntry * KviIrcUserDataBase::insertUser(const QString & szNick, const QString & szUser, const QString & szHost, KviWindow * pWnd)
 {
 	KviIrcUserEntry * pEntry = m_pDict->find(szNick);
 	if(pEntry)
@@ -154,11 +174,20 @@ KviIrcUserEntry * KviIrcUserDataBase::insertUser(const QString & szNick, const Q
 		pEntry = new KviIrcUserEntry(szUser, szHost);
 		m_pDict->insert(szNick, pEntry);
 	}
+	if(pWnd)
+		pEntry->m_pWindowList.push_back(pWnd);
 	return pEntry;
 }
 
-bool KviIrcUserDataBase::removeUser(const QString & szNick, KviIrcUserEntry * pEntry)
+bool KviIrcUserDataBase::removeUser(const QString & szNick, KviIrcUserEntry * pEntry, KviWindow * pWnd)
 {
+	if(pWnd)
+	{
+		// a user is in a few windows at most: a linear search is fine
+		auto it = std::find(pEntry->m_pWindowList.begin(), pEntry->m_pWindowList.end(), pWnd);
+		if(it != pEntry->m_pWindowList.end())
+			pEntry->m_pWindowList.erase(it);
+	}
 	pEntry->m_nRefs--;
 	if(pEntry->m_nRefs == 0)
 	{
@@ -31,6 +31,7 @@
 */
 
 #include "kvi_settings.h"
+#include "kvi_inttypes.h"
 #include "KviIrcUserEntry.h"
 #include "KviPointerHashTable.h"
 
@@ -60,6 +61,8 @@ public:
 
 private:
 	KviPointerHashTable<QString, KviIrcUserEntry> * m_pDict;
+	kvi_u64_t m_uRegisteredUserLookups;
+	kvi_u64_t m_uRegisteredUserFastRejects;
 
 public:
 	/**
@@ -73,9 +76,10 @@ public:
 	* \param szNick The nickname of the user
 	* \param szUser The username of the user
 	* \param szHost The hostname of the user
+	* \param pWnd The window whose user list the user is being added to, if any
 	* \return KviIrcUserEntry *
 	*/
-	KviIrcUserEntry * insertUser(const QString & szNick, const QString & szUser, const QString & szHost);
+	KviIrcUserEntry * insertUser(const QString & szNick, const QString & szUser, const QString & szHost, KviWindow * pWnd = nullptr);
 
 	/**
 	* \brief Searches for a user in the database
@@ -88,9 +92,10 @@ public:
 	* \brief Decrements the user reference count and if it reaches 0 then deletes the user from the database
 	* \param szNick The nickname of the user
 	* \param pEntry The entry of the user
+	* \param pWnd The window whose user list the user is being removed from, if any
 	* \return true if the reference count reached 0 and false otherwise (so true if the user was completely deleted from the db)
 	*/
-	bool removeUser(const QString & szNick, KviIrcUserEntry * pEntry);
+	bool removeUser(const QString & szNick, KviIrcUserEntry * pEntry, KviWindow * pWnd = nullptr);
 
 	/**
 	* \brief Returns the database dictionary
@@ -133,6 +138,36 @@ public:
 	* \return void
 	*/
 	void setupConnectionWithReguserDb();
+
+	/**
+	* \brief Returns the number of registered user lookups that missed the cache of the entries
+	* \return kvi_u64_t
+	*/
+	kvi_u64_t registeredUserLookups() const { return m_uRegisteredUserLookups; };
+
+	/**
+	* \brief Returns the number of these lookups that have been rejected by KviRegisteredUserDataBase::mayMatch()
+	*
+	* They didn't need any mask matching.
+	* \return kvi_u64_t
+	*/
+	kvi_u64_t registeredUserFastRejects() const { return m_uRegisteredUserFastRejects; };
+
+	/**
+	* \brief Resets the lookup counters
+	* \return void
+	*/
+	void resetLookupCounters();
+
+protected:
+	/**
+	* \brief Looks up the registered user in the global database
+	* \param szNick The nickname of the user
+	* \param szUser The username of the user
+	* \param szHost The hostname of the user
+	* \return KviRegisteredUser *
+	*/
+	KviRegisteredUser * findMatchingUser(const QString & szNick, const QString & szUser, const QString & szHost);
 protected slots:
 	/**
 	* \brief Slot called when a registered user is changed or removed
@@ -36,6 +36,9 @@
 #include "KviAvatar.h"
 
 #include <memory>
+#include <vector>
+
+class KviWindow;
 
 /**
 * \class KviIrcUserEntry
@@ -109,6 +112,9 @@ protected:
 	int m_iSmartNickColor;
 	QString m_szAccountName;
 
+	// the windows whose user list contains this user
+	std::vector<KviWindow *> m_pWindowList;
+
 public:
 	/**
 	* \brief Returns the ircview smart nick color of the user
@@ -345,6 +351,17 @@ public:
 	* \return bool
 	*/
 	bool hasAccountName() { return (!m_szAccountName.isEmpty()); };
+
+	/**
+	* \brief Returns the windows (channels and queries) whose user list contains the user
+	*
+	* This is the membership index of the connection: it is maintained
+	* by KviIrcUserDataBase::insertUser() and KviIrcUserDataBase::removeUser()
+	* and lets QUIT, NICK and friends touch only the windows of the user.
+	* The elements are borrowed and never null.
+	* \return const std::vector<KviWindow *> &
+	*/
+	const std::vector<KviWindow *> & windowList() const { return m_pWindowList; };
 };
 
 #endif // _KVI_IRCUSER_ENTRY_H_
@@ -42,6 +42,7 @@
 #include <QByteArray>
 #include <QDir>
 #include <QLocale>
+#include <QMutex>
 #include <QString>
 #include <QTextCodec>
 #include <QtGlobal>
@@ -52,6 +53,8 @@ static KviTranslator * g_pTranslator = nullptr;
 static KviPointerHashTable<const char *, KviMessageCatalogue> * g_pCatalogueDict = nullptr;
 static QTextCodec * g_pUtf8TextCodec = nullptr;
 static QString g_szDefaultLocalePath; // FIXME: Convert this to a search path list
+static QMutex g_contextMutex;
+static std::vector<QByteArray> g_contextNames; // by context id
 
 //
 // The following code was extracted and adapted from gutf8.c
@@ -701,6 +704,12 @@ KviMessageCatalogue * KviLocale::loadCatalogue(const QString & szName, const QSt
 bool KviLocale::unloadCatalogue(const QString & szName)
 {
 	//qDebug("Unloading catalogue: %s",szName.toUtf8().data());
+	KviMessageCatalogue * pCatalogue = g_pCatalogueDict->find(szName.toUtf8().data());
+	for(auto & c : m_Catalogues)
+	{
+		if(c == pCatalogue)
+			c = nullptr;
+	}
 	return g_pCatalogueDict->remove(szName.toUtf8().data());
 }
 
@@ -760,3 +769,40 @@ const QString & KviLocale::translateToQString(const char * pcText, const char *
 	}
 	return pCatalogue->translateToQString(pcText);
 }
+
+unsigned int KviLocale::internContext(const char * pcContext)
+{
+	// a handful of contexts: a linear search is fine
+	QMutexLocker locker(&g_contextMutex);
+	for(unsigned int i = 0; i < g_contextNames.size(); i++)
+	{
+		if(g_contextNames[i] == pcContext)
+			return i;
+	}
+	g_contextNames.push_back(QByteArray(pcContext));
+	return g_contextNames.size() - 1;
+}
+
+KviMessageCatalogue * KviLocale::contextCatalogue(unsigned int uContextId)
+{
+	g_contextMutex.lock();
+	QByteArray szContext = g_contextNames[uContextId];
+	g_contextMutex.unlock();
+
+	KviMessageCatalogue * pCatalogue = g_pCatalogueDict->find(szContext.data());
+	if(!pCatalogue)
+	{
+		pCatalogue = loadCatalogue(QString::fromUtf8(szContext), g_szDefaultLocalePath);
+		if(!pCatalogue)
+		{
+			// Fake it....
+			pCatalogue = new KviMessageCatalogue();
+			g_pCatalogueDict->insert(szContext.data(), pCatalogue);
+		}
+	}
+
+	if(uContextId >= m_Catalogues.size())
+		m_Catalogues.resize(uContextId + 1, nullptr);
+	m_Catalogues[uContextId] = pCatalogue;
+	return pCatalogue;
+}
@@ -35,6 +35,8 @@
 #include "KviHeapObject.h"
 #include "KviMessageCatalogue.h"
 
+#include <vector>
+
 class KviCString;
 class QApplication;
 class QString;
@@ -94,6 +96,7 @@ public:
 
 protected:
 	QApplication * m_pApp;
+	std::vector<KviMessageCatalogue *> m_Catalogues; // by context id
 
 private:
 	static KviLocale * m_pSelf;
@@ -211,6 +214,31 @@ public:
 	* \return const QString &
 	*/
 	const QString & translateToQString(const char * pcText, const char * pcContext);
+
+	/**
+	* \brief Translates the message with the given id from the given context
+	*
+	* This is what __tr2qs_ctx() uses
+	* \param uId The id returned by KviMessageCatalogue::internId()
+	* \param uContextId The id returned by internContext()
+	* \return const QString &
+	*/
+	const QString & translateToQString(unsigned int uId, unsigned int uContextId)
+	{
+		if((uContextId < m_Catalogues.size()) && m_Catalogues[uContextId])
+			return m_Catalogues[uContextId]->translateToQString(uId);
+		return contextCatalogue(uContextId)->translateToQString(uId);
+	}
+
+	/**
+	* \brief Returns the dense id of the given context (catalogue name)
+	* \param pcContext The context
+	* \return unsigned int
+	*/
+	static unsigned int internContext(const char * pcContext);
+
+protected:
+	KviMessageCatalogue * contextCatalogue(unsigned int uContextId);
 };
 
 #ifndef _KVI_LOCALE_CPP_
@@ -220,14 +248,25 @@ extern KVILIB_API KviMessageCatalogue * g_pMainCatalogue;
 #define __tr(text) g_pMainCatalogue->translate(text)
 #define __tr_no_lookup(text) text
 #define __tr_no_xgettext(text) g_pMainCatalogue->translate(text)
-#define __tr2qs(text) g_pMainCatalogue->translateToQString(text)
+// The call sites resolve their message to an id once and keep it in a
+// static variable: the dynamic strings must use the _no_xgettext variants.
+#define __tr2qs(text)                                                         \
+	([]() -> const QString & {                                                \
+		static const unsigned int uTrId = KviMessageCatalogue::internId(text); \
+		return g_pMainCatalogue->translateToQString(uTrId);                   \
+	}())
 #define __tr2qs_no_lookup(text) text
 #define __tr2qs_no_xgettext(text) g_pMainCatalogue->translateToQString(text)
 
 #define __tr_ctx(text, context) KviLocale::instance()->translate(text, context)
 #define __tr_no_lookup_ctx(text, context) text
 #define __tr_no_xgettext_ctx(text, context) KviLocale::instance()->translate(text, context)
-#define __tr2qs_ctx(text, context) KviLocale::instance()->translateToQString(text, context)
+#define __tr2qs_ctx(text, context)                                                  \
+	([]() -> const QString & {                                                      \
+		static const unsigned int uTrId = KviMessageCatalogue::internId(text);       \
+		static const unsigned int uTrContextId = KviLocale::internContext(context); \
+		return KviLocale::instance()->translateToQString(uTrId, uTrContextId);      \
+	}())
 #define __tr2qs_ctx_no_xgettext(text, context) KviLocale::instance()->translateToQString(text, context)
 
 #endif //_KVI_LOCALE_H_
@@ -58,10 +58,13 @@
 #include "KviPointerHashTable.h"
 #include "KviTranslationEntry.h"
 
+#include <QMutex>
 #include <QString>
 #include <QTextCodec>
 
 #include <cstdio>
+#include <string>
+#include <unordered_map>
 
 // The magic number of the GNU message catalog format.
 #define KVI_LOCALE_MAGIC 0x950412de
@@ -117,6 +120,11 @@ static int somePrimeNumbers[90] = {
 	2903, 3121, 3329, 3331, 3767, 4127, 5051, 6089, 7039, 9973
 };
 
+// the message ids: each id is the index of its text in g_internedTexts
+static QMutex g_internMutex;
+static std::unordered_map<std::string, unsigned int> g_internedIds;
+static std::vector<const char *> g_internedTexts; // point to the keys of g_internedIds
+
 int kvi_getFirstBiggerPrime(int iNumber)
 {
 	for(int somePrimeNumber : somePrimeNumbers)
@@ -248,6 +256,8 @@ bool KviMessageCatalogue::load(const QString & szName)
 		delete m_pMessages;
 	m_pMessages = new KviPointerHashTable<const char *, KviTranslationEntry>(iDictSize, true, false); // dictSize, case sensitive, don't copy keys
 	m_pMessages->setAutoDelete(true);
+	m_Entries.clear();
+	m_Translations.clear();
 
 	KviCString szHeader;
 
@@ -276,6 +286,11 @@ bool KviMessageCatalogue::load(const QString & szName)
 		}
 
 		m_pMessages->insert(e->m_szKey.ptr(), e);
+
+		unsigned int uId = internId(e->m_szKey.ptr());
+		if(uId >= m_Entries.size())
+			m_Entries.resize(uId + 1, nullptr);
+		m_Entries[uId] = e;
 	}
 
 	KviMemory::free(pcBuffer);
@@ -337,3 +352,46 @@ const QString & KviMessageCatalogue::translateToQString(const char * pcText)
 	pAux->m_pTranslation = new QString(m_pTextCodec->toUnicode(pAux->m_szEncodedTranslation.ptr()));
 	return *(pAux->m_pTranslation);
 }
+
+unsigned int KviMessageCatalogue::internId(const char * pcText)
+{
+	QMutexLocker locker(&g_internMutex);
+	auto it = g_internedIds.emplace(pcText, (unsigned int)g_internedTexts.size());
+	if(it.second)
+		g_internedTexts.push_back(it.first->first.c_str());
+	return it.first->second;
+}
+
+const QString & KviMessageCatalogue::resolve(unsigned int uId)
+{
+	KviTranslationEntry * pAux = (uId < m_Entries.size()) ? m_Entries[uId] : nullptr;
+	if(!pAux)
+	{
+		const char * pcText;
+		unsigned int uCount;
+		g_internMutex.lock();
+		pcText = g_internedTexts[uId];
+		uCount = g_internedTexts.size();
+		g_internMutex.unlock();
+
+		// not in the catalogue: same as translateToQString(pcText)
+		pAux = m_pMessages->find(pcText);
+		if(!pAux)
+		{
+			pAux = new KviTranslationEntry(pcText);
+			m_pMessages->insert(pAux->m_szKey.ptr(), pAux);
+		}
+		// make room for the ids that are already known
+		if(uCount > m_Translations.size())
+			m_Translations.resize(uCount, nullptr);
+	}
+	else if(uId >= m_Translations.size())
+	{
+		m_Translations.resize(uId + 1, nullptr);
+	}
+
+	if(!pAux->m_pTranslation)
+		pAux->m_pTranslation = new QString(m_pTextCodec->toUnicode(pAux->m_szEncodedTranslation.ptr()));
+	m_Translations[uId] = pAux->m_pTranslation;
+	return *(pAux->m_pTranslation);
+}
@@ -29,6 +29,8 @@
 #include "kvi_settings.h"
 #include "KviHeapObject.h"
 
+#include <vector>
+
 template <typename A, typename B>
 class KviPointerHashTable;
 
@@ -60,6 +62,8 @@ public:
 protected:
 	KviPointerHashTable<const char *, KviTranslationEntry> * m_pMessages;
 	QTextCodec * m_pTextCodec;
+	std::vector<KviTranslationEntry *> m_Entries;   // by message id, filled at load time
+	std::vector<const QString *> m_Translations; // by message id, filled on the first lookup
 
 public:
 	/**
@@ -82,6 +86,35 @@ public:
 	* \return const QString &
 	*/
 	const QString & translateToQString(const char * pcText);
+
+	/**
+	* \brief Translates the string with the given id
+	*
+	* This is what __tr2qs() uses: after the first lookup of a message
+	* the translation is a single array access.
+	* \param uId The id returned by internId()
+	* \return const QString &
+	*/
+	const QString & translateToQString(unsigned int uId)
+	{
+		if((uId < m_Translations.size()) && m_Translations[uId])
+			return *(m_Translations[uId]);
+		return resolve(uId);
+	}
+
+	/**
+	* \brief Returns the dense id of the given message
+	*
+	* The ids are shared by all the catalogues: the keys of a catalogue
+	* are interned when it's loaded, the other messages when they're first seen.
+	* The __tr2qs() call sites keep the id in a static variable.
+	* \param pcText The text to translate
+	* \return unsigned int
+	*/
+	static unsigned int internId(const char * pcText);
+
+protected:
+	const QString & resolve(unsigned int uId);
 };
 
 #endif //_KVIMESSAGECATALOGUE_H_
@@ -28,8 +28,12 @@
 #include "KviQString.h"
 
 #include <QApplication>
+#include <QDateTime>
+#include <QMutexLocker>
 
+#include <algorithm>
 #include <cerrno>
+#include <cstring>
 
 #if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
 #include <winsock2.h>
@@ -72,10 +76,10 @@ void KviDnsResolverResult::appendAddress(const QString & addr)
 	m_pIpAddressList.push_back(addr);
 }
 
-KviDnsResolverThread::KviDnsResolverThread(KviDnsResolver * pDns)
+KviDnsResolverThread::KviDnsResolverThread(KviDnsResolverPool * pPool)
     : QThread()
 {
-	m_pParentDns = pDns;
+	m_pPool = pPool;
 }
 
 KviDnsResolverThread::~KviDnsResolverThread()
@@ -138,44 +142,54 @@ KviError::Code KviDnsResolverThread::translateDnsError(int iErr)
 	return KviError::DNSQueryFailed;
 }
 
-void KviDnsResolverThread::postDnsError(KviDnsResolverResult * pDns, KviError::Code error)
+void KviDnsResolverThread::run()
 {
-	pDns->setError(error);
+	KviDnsResolverPool::Job job;
+	while(m_pPool->takeJob(job))
+	{
+		if(!m_pPool->m_resolverFunction)
+		{
+			m_pPool->jobDone(job, resolve(job.szQuery, job.eType));
+			continue;
+		}
 
-	KviDnsResolverThreadEvent * pEvent = new KviDnsResolverThreadEvent(pDns);
-	QApplication::postEvent(m_pParentDns, pEvent);
+		KviDnsResolverResult * pResult = new KviDnsResolverResult();
+		pResult->setQuery(job.szQuery);
+		m_pPool->m_resolverFunction(pResult, job.eType);
+		m_pPool->jobDone(job, pResult);
+	}
 }
 
-void KviDnsResolverThread::run()
+KviDnsResolverResult * KviDnsResolverThread::resolve(const QString & szQuery, KviDnsResolver::QueryType queryType)
 {
 	KviDnsResolverResult * dns = new KviDnsResolverResult();
 
-	dns->setQuery(m_szQuery);
+	dns->setQuery(szQuery);
 
-	if(m_szQuery.isEmpty())
+	if(szQuery.isEmpty())
 	{
-		postDnsError(dns, KviError::NoHostToResolve);
-		return;
+		dns->setError(KviError::NoHostToResolve);
+		return dns;
 	}
 
 #ifndef COMPILE_IPV6_SUPPORT
-	if(m_queryType != KviDnsResolver::IPv4)
+	if(queryType != KviDnsResolver::IPv4)
 	{
-		if(m_queryType == KviDnsResolver::IPv6)
+		if(queryType == KviDnsResolver::IPv6)
 		{
-			postDnsError(dns, KviError::NoIPv6Support);
-			return;
+			dns->setError(KviError::NoIPv6Support);
+			return dns;
 		}
-		m_queryType = KviDnsResolver::IPv4;
+		queryType = KviDnsResolver::IPv4;
 	}
 #endif
 
 #if(defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)) && !defined(COMPILE_IPV6_SUPPORT)
 
-	if(m_queryType == KviDnsResolver::IPv6)
+	if(queryType == KviDnsResolver::IPv6)
 	{
-		postDnsError(dns, KviError::NoIPv6Support);
-		return;
+		dns->setError(KviError::NoIPv6Support);
+		return dns;
 	}
 
 	// gethostbyaddr and gethostbyname are thread-safe on Windoze
@@ -184,13 +198,13 @@ void KviDnsResolverThread::run()
 
 	// DIE DIE!....I hope that this stuff will disappear sooner or later :)
 
-	if(KviNetUtils::stringIpToBinaryIp(m_szQuery, &inAddr))
+	if(KviNetUtils::stringIpToBinaryIp(szQuery, &inAddr))
 	{
 		pHostEntry = gethostbyaddr((const char *)&inAddr, sizeof(inAddr), AF_INET);
 	}
 	else
 	{
-		pHostEntry = gethostbyname(m_szQuery.toUtf8().data());
+		pHostEntry = gethostbyname(szQuery.toUtf8().data());
 	}
 
 	if(!pHostEntry)
@@ -249,11 +263,11 @@ void KviDnsResolverThread::run()
 	bool bIsIPv6Ip = false;
 #endif
 
-	bool bIsIPv4Ip = KviNetUtils::stringIpToBinaryIp(m_szQuery, (struct in_addr *)&(ipv4Addr.sin_addr));
+	bool bIsIPv4Ip = KviNetUtils::stringIpToBinaryIp(szQuery, (struct in_addr *)&(ipv4Addr.sin_addr));
 
 #ifdef COMPILE_IPV6_SUPPORT
 	if(!bIsIPv4Ip)
-		bIsIPv6Ip = KviNetUtils::stringIpToBinaryIp_V6(m_szQuery, (struct in6_addr *)&(ipv6Addr.sin6_addr));
+		bIsIPv6Ip = KviNetUtils::stringIpToBinaryIp_V6(szQuery, (struct in6_addr *)&(ipv6Addr.sin6_addr));
 #endif
 
 
@@ -290,7 +304,7 @@ void KviDnsResolverThread::run()
 		else
 		{
 			dns->appendHostname(retname);
-			dns->appendAddress(m_szQuery);
+			dns->appendAddress(szQuery);
 		}
 	}
 	else
@@ -300,7 +314,7 @@ void KviDnsResolverThread::run()
 		struct addrinfo hints;
 		hints.ai_flags = 0; //AI_CANONNAME; <-- for IPV6 it makes cannoname to point to the IP address!
 #ifdef COMPILE_IPV6_SUPPORT
-		hints.ai_family = (m_queryType == KviDnsResolver::IPv6) ? PF_INET6 : ((m_queryType == KviDnsResolver::IPv4) ? PF_INET : PF_UNSPEC);
+		hints.ai_family = (queryType == KviDnsResolver::IPv6) ? PF_INET6 : ((queryType == KviDnsResolver::IPv4) ? PF_INET : PF_UNSPEC);
 #else
 		hints.ai_family = PF_INET;
 #endif
@@ -311,7 +325,7 @@ void KviDnsResolverThread::run()
 		hints.ai_addr = nullptr;
 		hints.ai_next = nullptr;
 
-		retVal = getaddrinfo(m_szQuery.toUtf8().data(), nullptr, &hints, &pRet);
+		retVal = getaddrinfo(szQuery.toUtf8().data(), nullptr, &hints, &pRet);
 
 		if(retVal != 0)
 		{
@@ -323,7 +337,7 @@ void KviDnsResolverThread::run()
 		}
 		else
 		{
-			dns->appendHostname(pRet->ai_canonname ? QString::fromUtf8(pRet->ai_canonname) : m_szQuery);
+			dns->appendHostname(pRet->ai_canonname ? QString::fromUtf8(pRet->ai_canonname) : szQuery);
 			QString szIp;
 #ifdef COMPILE_IPV6_SUPPORT
 			if(pRet->ai_family == PF_INET6)
@@ -369,26 +383,267 @@ void KviDnsResolverThread::run()
 
 #endif // !COMPILE_ON_WINDOWS
 
-	KviDnsResolverThreadEvent * pEvent = new KviDnsResolverThreadEvent(dns);
-	QApplication::postEvent(m_pParentDns, pEvent);
+	return dns;
+}
+
+// the number of the worker threads
+#define KVI_DNS_RESOLVER_POOL_THREADS 4
+// how long the successful lookups are cached (msecs)
+#define KVI_DNS_RESOLVER_POSITIVE_TTL 300000
+// how long the failed lookups are cached (msecs)
+#define KVI_DNS_RESOLVER_NEGATIVE_TTL 30000
+// the cache is purged when it grows over this size
+#define KVI_DNS_RESOLVER_MAX_CACHE_ENTRIES 512
+
+KviDnsResolverPool * KviDnsResolverPool::m_pInstance = nullptr;
+
+KviDnsResolverPool::KviDnsResolverPool()
+    : QObject()
+{
+	m_uIdleThreads = 0;
+	m_bTerminating = false;
+	memset(&m_Statistics, 0, sizeof(m_Statistics));
+	m_iPositiveTtl = KVI_DNS_RESOLVER_POSITIVE_TTL;
+	m_iNegativeTtl = KVI_DNS_RESOLVER_NEGATIVE_TTL;
+}
+
+KviDnsResolverPool::~KviDnsResolverPool()
+{
+	clearCache();
+}
+
+void KviDnsResolverPool::init()
+{
+	if(m_pInstance)
+		return;
+	m_pInstance = new KviDnsResolverPool();
+}
+
+void KviDnsResolverPool::done()
+{
+	if(!m_pInstance)
+		return;
+
+	KviDnsResolverPool * pPool = m_pInstance;
+	m_pInstance = nullptr;
+
+	pPool->m_Mutex.lock();
+	pPool->m_bTerminating = true;
+	pPool->m_JobQueue.clear();
+	pPool->m_JobAvailable.wakeAll();
+	pPool->m_Mutex.unlock();
+
+	bool bAllStopped = true;
+	for(auto t : pPool->m_pThreadList)
+	{
+		// a worker might be stuck in the system resolver
+		if(!t->wait(30000))
+		{
+			qDebug("Failed to wait for a slave DNS thread: leaking it");
+			bAllStopped = false;
+			continue;
+		}
+		delete t;
+	}
+
+	// the stuck threads will still touch the pool when they return
+	if(bAllStopped)
+		delete pPool;
+}
+
+void KviDnsResolverPool::clearCache()
+{
+	for(auto & e : m_hCache)
+		delete e.pResult;
+	m_hCache.clear();
+}
+
+void KviDnsResolverPool::setCacheTimeouts(qint64 iPositiveTtl, qint64 iNegativeTtl)
+{
+	m_iPositiveTtl = iPositiveTtl;
+	m_iNegativeTtl = iNegativeTtl;
+}
+
+void KviDnsResolverPool::purgeCache(qint64 iNow)
+{
+	QHash<QString, CacheEntry>::iterator it = m_hCache.begin();
+	while(it != m_hCache.end())
+	{
+		if(it->iExpireTime <= iNow)
+		{
+			delete it->pResult;
+			it = m_hCache.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	// still full of live entries: start over
+	if(m_hCache.count() >= KVI_DNS_RESOLVER_MAX_CACHE_ENTRIES)
+		clearCache();
+}
+
+void KviDnsResolverPool::post(KviDnsResolver * pDns, const KviDnsResolverResult * pResult, const QString & szQuery)
+{
+	// each resolver owns its own copy, delivered asynchronously as before
+	KviDnsResolverResult * pCopy = new KviDnsResolverResult(*pResult);
+	pCopy->setQuery(szQuery);
+	QApplication::postEvent(pDns, new KviDnsResolverThreadEvent(pCopy));
+}
+
+bool KviDnsResolverPool::lookup(KviDnsResolver * pDns, const QString & szQuery, KviDnsResolver::QueryType type)
+{
+	m_Statistics.uLookups++;
+
+	QString szKey = QString("%1:%2").arg((int)type).arg(szQuery.toLower());
+	qint64 iNow = QDateTime::currentMSecsSinceEpoch();
+
+	QHash<QString, CacheEntry>::iterator it = m_hCache.find(szKey);
+	if(it != m_hCache.end())
+	{
+		if(it->iExpireTime > iNow)
+		{
+			m_Statistics.uCacheHits++;
+			if(it->pResult->error() != KviError::Success)
+				m_Statistics.uNegativeHits++;
+			post(pDns, it->pResult, szQuery);
+			return true;
+		}
+		delete it->pResult;
+		m_hCache.erase(it);
+	}
+
+	QHash<QString, PendingLookup>::iterator p = m_hPending.find(szKey);
+	if(p != m_hPending.end())
+	{
+		m_Statistics.uSharedLookups++;
+		p->pWaiterList.push_back(pDns);
+		return true;
+	}
+
+	PendingLookup & l = m_hPending[szKey];
+	l.pWaiterList.push_back(pDns);
+	l.iStartTime = iNow;
+
+	m_Statistics.uResolverCalls++;
+
+	m_Mutex.lock();
+	m_JobQueue.push_back({ szQuery, type, szKey });
+	bool bSpawn = (m_uIdleThreads < m_JobQueue.size()) && (m_pThreadList.size() < KVI_DNS_RESOLVER_POOL_THREADS);
+	m_JobAvailable.wakeOne();
+	m_Mutex.unlock();
+
+	if(bSpawn)
+	{
+		KviDnsResolverThread * t = new KviDnsResolverThread(this);
+		m_pThreadList.push_back(t);
+		t->start();
+	}
+	return true;
+}
+
+void KviDnsResolverPool::cancel(KviDnsResolver * pDns)
+{
+	// the resolver call itself can't be interrupted: its result will be cached anyway
+	for(auto & l : m_hPending)
+	{
+		auto it = std::find(l.pWaiterList.begin(), l.pWaiterList.end(), pDns);
+		if(it != l.pWaiterList.end())
+		{
+			l.pWaiterList.erase(it);
+			return;
+		}
+	}
+}
+
+bool KviDnsResolverPool::takeJob(Job & job)
+{
+	QMutexLocker locker(&m_Mutex);
+	while(m_JobQueue.empty())
+	{
+		if(m_bTerminating)
+			return false;
+		m_uIdleThreads++;
+		m_JobAvailable.wait(&m_Mutex);
+		m_uIdleThreads--;
+	}
+	if(m_bTerminating)
+		return false;
+	job = m_JobQueue.front();
+	m_JobQueue.pop_front();
+	return true;
+}
+
+void KviDnsResolverPool::jobDone(const Job & job, KviDnsResolverResult * pResult)
+{
+	QMutexLocker locker(&m_Mutex);
+	if(m_bTerminating)
+	{
+		delete pResult;
+		return;
+	}
+	QApplication::postEvent(this, new KviDnsResolverThreadEvent(pResult, job.szKey));
+}
+
+bool KviDnsResolverPool::event(QEvent * e)
+{
+	if(e->type() != QEvent::User)
+		return QObject::event(e);
+
+	KviDnsResolverThreadEvent * pEvent = dynamic_cast<KviDnsResolverThreadEvent *>(e);
+	if(!pEvent)
+		return QObject::event(e);
+
+	KviDnsResolverResult * pResult = pEvent->releaseResult();
+	qint64 iNow = QDateTime::currentMSecsSinceEpoch();
+
+	QHash<QString, PendingLookup>::iterator p = m_hPending.find(pEvent->key());
+	if(p != m_hPending.end())
+	{
+		kvi_u64_t uLatency = (p->iStartTime < iNow) ? (iNow - p->iStartTime) : 0;
+		m_Statistics.uCompletedCalls++;
+		m_Statistics.uTotalLatency += uLatency;
+		if(uLatency > m_Statistics.uMaxLatency)
+			m_Statistics.uMaxLatency = uLatency;
+
+		for(auto pDns : p->pWaiterList)
+			post(pDns, pResult, pDns->m_szPendingQuery);
+		m_hPending.erase(p);
+	}
+
+	switch(pResult->error())
+	{
+		case KviError::DNSTemporaneousFault:
+		case KviError::NoHostToResolve:
+		case KviError::NoIPv6Support:
+		case KviError::DNSInternalErrorOutOfMemory:
+			// not an answer about the host
+			delete pResult;
+			break;
+		default:
+			if(m_hCache.count() >= KVI_DNS_RESOLVER_MAX_CACHE_ENTRIES)
+				purgeCache(iNow);
+			m_hCache.insert(pEvent->key(), { pResult, iNow + ((pResult->error() == KviError::Success) ? m_iPositiveTtl : m_iNegativeTtl) });
+			break;
+	}
+
+	return true;
 }
 
 KviDnsResolver::KviDnsResolver()
     : QObject()
 {
-	m_pSlaveThread = new KviDnsResolverThread(this);
 	m_pDnsResult = new KviDnsResolverResult();
 	m_state = Idle;
 }
 
 KviDnsResolver::~KviDnsResolver()
 {
-	if(m_pSlaveThread)
-	{
-		if(!m_pSlaveThread->wait(30000))
-			qDebug("Failed to wait for the slave DNS thread: we're probably going to crash!");
-		delete m_pSlaveThread; // will eventually terminate it (but it will also block us!!!)
-	}
+	// the worker threads don't know about us: just stop waiting
+	if((m_state == Busy) && KviDnsResolverPool::instance())
+		KviDnsResolverPool::instance()->cancel(this);
 
 	delete m_pDnsResult;
 }
@@ -402,8 +657,11 @@ bool KviDnsResolver::lookup(const QString & szQuery, QueryType type)
 {
 	if(m_state == Busy)
 		return false;
-	m_pSlaveThread->setQuery(szQuery.trimmed(), type);
-	m_pSlaveThread->start();
+	if(!KviDnsResolverPool::instance())
+		return false;
+	m_szPendingQuery = szQuery.trimmed();
+	if(!KviDnsResolverPool::instance()->lookup(this, m_szPendingQuery, type))
+		return false;
 	m_state = Busy;
 	return true;
 }
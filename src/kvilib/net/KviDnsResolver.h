@@ -33,11 +33,13 @@
 #include <vector>
 
 class KviDnsResolverThread;
+class KviDnsResolverPool;
 
 class KVILIB_API KviDnsResolverResult : public KviHeapObject
 {
 	friend class KviDnsResolver;
 	friend class KviDnsResolverThread;
+	friend class KviDnsResolverPool;
 
 protected:
 	KviDnsResolverResult();
@@ -69,7 +71,8 @@ public:
 		return m_szQuery;
 	}
 
-protected:
+public:
+	// used by the resolver functions (see KviDnsResolverPool::setResolverFunction())
 	void setError(KviError::Code eError)
 	{
 		m_eError = eError;
@@ -90,6 +93,8 @@ class KVILIB_API KviDnsResolver : public QObject, public KviHeapObject
 {
 	Q_OBJECT
 	Q_PROPERTY(bool blockingDelete READ isRunning)
+	friend class KviDnsResolverPool;
+
 public:
 	KviDnsResolver();
 	~KviDnsResolver();
@@ -110,8 +115,8 @@ public:
 	};
 
 protected:
-	KviDnsResolverThread * m_pSlaveThread;
 	KviDnsResolverResult * m_pDnsResult;
+	QString m_szPendingQuery;
 	State m_state;
 
 public:
@@ -151,18 +156,26 @@ signals:
 //
 
 #include <QEvent>
+#include <QHash>
+#include <QMutex>
 #include <QThread>
+#include <QWaitCondition>
 
 #include "kvi_debug.h"
+#include "kvi_inttypes.h"
+
+#include <deque>
+#include <functional>
 
 class KviDnsResolverThreadEvent : public QEvent
 {
 private:
 	KviDnsResolverResult * m_pResult;
+	QString m_szKey;
 
 public:
-	KviDnsResolverThreadEvent(KviDnsResolverResult * pResult)
-	    : QEvent(QEvent::User), m_pResult(pResult)
+	KviDnsResolverThreadEvent(KviDnsResolverResult * pResult, const QString & szKey = QString())
+	    : QEvent(QEvent::User), m_pResult(pResult), m_szKey(szKey)
 	{
 		KVI_ASSERT(pResult);
 	}
@@ -179,32 +192,137 @@ public:
 		m_pResult = nullptr;
 		return pResult;
 	}
+
+	// the pool key of the lookup (empty for results posted to a KviDnsResolver)
+	const QString & key() const
+	{
+		return m_szKey;
+	}
 };
 
+//
+// The lookups of all the KviDnsResolver objects are served by a small
+// set of worker threads owned by KviDnsResolverPool.
+//
+// Concurrent lookups of the same query share a single resolver call
+// and the results are kept in a cache for a while so reconnects, DCC
+// and script lookups don't hit the system resolver again.
+// getaddrinfo() doesn't tell us the TTL of the records so a fixed one
+// is used: longer for the successful lookups, shorter for the negative
+// answers. Temporary failures are never cached.
+//
+// The pool lives in the GUI thread: the workers post their results
+// to it and it forwards a copy to each waiting KviDnsResolver.
+//
+// The system resolver can be replaced by a resolver function: the tests
+// use a stub one to check the sharing, the cache and the statistics.
+//
+
 class KviDnsResolverThread : public QThread
 {
-	friend class KviDnsResolver;
+	friend class KviDnsResolverPool;
 
 protected:
-	KviDnsResolverThread(KviDnsResolver * pDns);
+	KviDnsResolverThread(KviDnsResolverPool * pPool);
 	~KviDnsResolverThread();
 
 protected:
-	QString m_szQuery;
-	KviDnsResolver::QueryType m_queryType = KviDnsResolver::Any;
-	KviDnsResolver * m_pParentDns;
+	KviDnsResolverPool * m_pPool;
+
+protected:
+	void run() override;
+	KviDnsResolverResult * resolve(const QString & szQuery, KviDnsResolver::QueryType queryType);
+	KviError::Code translateDnsError(int iErr);
+};
+
+class KVILIB_API KviDnsResolverPool : public QObject
+{
+	friend class KviDnsResolver;
+	friend class KviDnsResolverThread;
 
 public:
-	void setQuery(const QString & szQuery, KviDnsResolver::QueryType type)
+	struct Statistics
 	{
-		m_szQuery = szQuery;
-		m_queryType = type;
+		kvi_u64_t uLookups;         // total lookups requested
+		kvi_u64_t uCacheHits;       // served from the cache (including the negative entries)
+		kvi_u64_t uNegativeHits;    // served from the negative cache entries
+		kvi_u64_t uSharedLookups;   // attached to a lookup already in progress
+		kvi_u64_t uResolverCalls;   // actually passed to the system resolver
+		kvi_u64_t uCompletedCalls;  // resolver calls that have returned
+		kvi_u64_t uTotalLatency;    // sum of the resolver call latencies (msecs)
+		kvi_u64_t uMaxLatency;      // slowest resolver call (msecs)
 	};
 
+	// fills the result (its query is already set), called by the worker threads
+	typedef std::function<void(KviDnsResolverResult * pResult, KviDnsResolver::QueryType eType)> ResolverFunction;
+
 protected:
-	void run() override;
-	KviError::Code translateDnsError(int iErr);
-	void postDnsError(KviDnsResolverResult * pDns, KviError::Code error);
+	KviDnsResolverPool();
+	~KviDnsResolverPool();
+
+protected:
+	struct Job
+	{
+		QString szQuery;
+		KviDnsResolver::QueryType eType;
+		QString szKey;
+	};
+
+	struct PendingLookup
+	{
+		std::vector<KviDnsResolver *> pWaiterList;
+		qint64 iStartTime;
+	};
+
+	struct CacheEntry
+	{
+		KviDnsResolverResult * pResult;
+		qint64 iExpireTime;
+	};
+
+	static KviDnsResolverPool * m_pInstance;
+
+	// shared with the worker threads
+	QMutex m_Mutex;
+	QWaitCondition m_JobAvailable;
+	std::deque<Job> m_JobQueue;
+	unsigned int m_uIdleThreads;
+	bool m_bTerminating;
+	ResolverFunction m_resolverFunction;
+
+	// GUI thread only
+	std::vector<KviDnsResolverThread *> m_pThreadList;
+	QHash<QString, PendingLookup> m_hPending;
+	QHash<QString, CacheEntry> m_hCache;
+	Statistics m_Statistics;
+	qint64 m_iPositiveTtl;
+	qint64 m_iNegativeTtl;
+
+public:
+	static void init();
+	static void done();
+	static KviDnsResolverPool * instance() { return m_pInstance; };
+
+	const Statistics & statistics() const { return m_Statistics; };
+	unsigned int cacheSize() const { return m_hCache.count(); };
+	void clearCache();
+
+	// replaces the system resolver: set it before the first lookup
+	void setResolverFunction(const ResolverFunction & f) { m_resolverFunction = f; };
+	// how long the successful and the failed lookups are cached (msecs)
+	void setCacheTimeouts(qint64 iPositiveTtl, qint64 iNegativeTtl);
+
+protected:
+	bool lookup(KviDnsResolver * pDns, const QString & szQuery, KviDnsResolver::QueryType type);
+	void cancel(KviDnsResolver * pDns);
+	void purgeCache(qint64 iNow);
+	void post(KviDnsResolver * pDns, const KviDnsResolverResult * pResult, const QString & szQuery);
+
+	// called by the worker threads
+	bool takeJob(Job & job);
+	void jobDone(const Job & job, KviDnsResolverResult * pResult);
+
+	bool event(QEvent * e) override;
 };
 
 #endif //_KVI_DNS_H_
@@ -0,0 +1,225 @@
+//=============================================================================
+//
+//   File : KviDnsResolverTest.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+//
+// kvirc-dnstest: the DNS resolver pool test (run by ctest).
+//
+// The system resolver is replaced by a stub one that answers a few
+// fixed names, so the test doesn't need the network. It checks that
+// concurrent lookups of the same name share a resolver call, that the
+// successful and the failed answers are cached until their TTL expires,
+// that the temporary failures are not cached and that the statistics
+// count all of it.
+//
+
+#include "KviDnsResolver.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QThread>
+#include <QTimer>
+
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+// the stub answers immediately: this is only a safety net
+#define DNS_TEST_TIMEOUT 10000
+
+#define DNS_TEST_ADDRESS "192.0.2.1"
+#define DNS_TEST_ADDRESS6 "2001:db8::1"
+
+static int g_iFailures = 0;
+static std::atomic<int> g_iResolverCalls(0);
+
+static void check(bool bOk, const char * pcWhat)
+{
+	if(bOk)
+		return;
+	fprintf(stderr, "FAIL: %s\n", pcWhat);
+	g_iFailures++;
+}
+
+// runs in the worker threads
+static void stub_resolve(KviDnsResolverResult * pResult, KviDnsResolver::QueryType eType)
+{
+	g_iResolverCalls++;
+
+	QString szQuery = pResult->query().toLower();
+	if(szQuery == "good.example")
+	{
+		pResult->appendHostname(szQuery);
+		pResult->appendAddress((eType == KviDnsResolver::IPv6) ? DNS_TEST_ADDRESS6 : DNS_TEST_ADDRESS);
+	}
+	else if(szQuery == "flaky.example")
+	{
+		pResult->setError(KviError::DNSTemporaneousFault);
+	}
+	else
+	{
+		pResult->setError(KviError::DNSNoName);
+	}
+}
+
+// starts the lookups and waits for all of them to complete
+static bool lookup_all(const std::vector<KviDnsResolver *> & dnsList, const QString & szQuery, KviDnsResolver::QueryType eType = KviDnsResolver::IPv4)
+{
+	QEventLoop loop;
+	size_t uDone = 0;
+	bool bTimedOut = false;
+
+	std::vector<QMetaObject::Connection> connections;
+	for(auto pDns : dnsList)
+	{
+		connections.push_back(QObject::connect(pDns, &KviDnsResolver::lookupDone, [&](KviDnsResolver *) {
+			if(++uDone == dnsList.size())
+				loop.quit();
+		}));
+	}
+
+	bool bStarted = true;
+	for(auto pDns : dnsList)
+		bStarted = pDns->lookup(szQuery, eType) && bStarted;
+
+	if(bStarted)
+	{
+		QTimer::singleShot(DNS_TEST_TIMEOUT, &loop, [&]() {
+			bTimedOut = true;
+			loop.quit();
+		});
+		loop.exec();
+	}
+
+	for(auto & c : connections)
+		QObject::disconnect(c);
+	return bStarted && !bTimedOut && (uDone == dnsList.size());
+}
+
+static bool lookup_one(KviDnsResolver & dns, const QString & szQuery, KviDnsResolver::QueryType eType = KviDnsResolver::IPv4)
+{
+	return lookup_all({ &dns }, szQuery, eType);
+}
+
+int main(int argc, char ** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	KviDnsResolverPool::init();
+	KviDnsResolverPool * pPool = KviDnsResolverPool::instance();
+	pPool->setResolverFunction(stub_resolve);
+
+	// the concurrent lookups share a single resolver call
+	{
+		KviDnsResolver a, b, c;
+		check(lookup_all({ &a, &b, &c }, "good.example"), "the concurrent lookups complete");
+		// the results reach the resolvers in the same event loop pass
+		check(g_iResolverCalls == 1, "the concurrent lookups share a resolver call");
+		check(a.state() == KviDnsResolver::Success && b.state() == KviDnsResolver::Success && c.state() == KviDnsResolver::Success, "all the concurrent lookups succeed");
+		check(a.firstIpAddress() == DNS_TEST_ADDRESS && c.firstIpAddress() == DNS_TEST_ADDRESS, "all the concurrent lookups get the address");
+
+		const KviDnsResolverPool::Statistics & s = pPool->statistics();
+		check(s.uLookups == 3, "the statistics count the concurrent lookups");
+		check(s.uSharedLookups == 2, "the statistics count the shared lookups");
+		check(s.uResolverCalls == 1 && s.uCompletedCalls == 1, "the statistics count one resolver call");
+		check(s.uCacheHits == 0, "nothing is served from the cache yet");
+	}
+
+	// the names are case insensitive, the query is kept as given
+	{
+		KviDnsResolver dns;
+		check(lookup_one(dns, "GOOD.Example"), "the cached lookup completes");
+		check(g_iResolverCalls == 1, "a cached answer doesn't call the resolver");
+		check(dns.state() == KviDnsResolver::Success && dns.firstIpAddress() == DNS_TEST_ADDRESS, "the cached answer is delivered");
+		check(dns.query() == "GOOD.Example", "the cached answer keeps the query of the lookup");
+		check(pPool->statistics().uCacheHits == 1 && pPool->statistics().uNegativeHits == 0, "the statistics count the cache hit");
+
+		// another query type is another lookup
+		check(lookup_one(dns, "good.example", KviDnsResolver::IPv6), "the IPv6 lookup completes");
+		check(g_iResolverCalls == 2, "the query types are cached separately");
+		check(dns.firstIpAddress() == DNS_TEST_ADDRESS6, "the IPv6 lookup gets its own answer");
+	}
+
+	// the negative answers are cached too
+	{
+		KviDnsResolver dns;
+		check(lookup_one(dns, "missing.example"), "the failed lookup completes");
+		check(dns.state() == KviDnsResolver::Failure && dns.error() == KviError::DNSNoName, "the failed lookup reports the error");
+		check(lookup_one(dns, "missing.example"), "the second failed lookup completes");
+		check(dns.state() == KviDnsResolver::Failure && dns.error() == KviError::DNSNoName, "the cached failure reports the error");
+		check(g_iResolverCalls == 3, "a cached failure doesn't call the resolver");
+		check(pPool->statistics().uCacheHits == 2 && pPool->statistics().uNegativeHits == 1, "the statistics count the negative hit");
+	}
+
+	// the temporary failures are not
+	{
+		KviDnsResolver dns;
+		unsigned int uCacheSize = pPool->cacheSize();
+		check(lookup_one(dns, "flaky.example") && lookup_one(dns, "flaky.example"), "the temporary failures complete");
+		check(dns.error() == KviError::DNSTemporaneousFault, "the temporary failure is reported");
+		check(g_iResolverCalls == 5, "a temporary failure is looked up again");
+		check(pPool->cacheSize() == uCacheSize, "a temporary failure isn't cached");
+	}
+
+	// the entries expire
+	{
+		pPool->clearCache();
+		check(pPool->cacheSize() == 0, "the cache can be cleared");
+		pPool->setCacheTimeouts(600, 200);
+
+		KviDnsResolver dns;
+		int iCalls = g_iResolverCalls;
+		check(lookup_one(dns, "good.example") && lookup_one(dns, "missing.example"), "the lookups complete");
+		check(lookup_one(dns, "good.example") && lookup_one(dns, "missing.example"), "the cached lookups complete");
+		check(g_iResolverCalls == iCalls + 2, "the answers are cached within their TTL");
+
+		QThread::msleep(300);
+		check(lookup_one(dns, "good.example"), "the positive lookup completes");
+		check(g_iResolverCalls == iCalls + 2, "the positive answer outlives the negative TTL");
+		check(lookup_one(dns, "missing.example"), "the expired negative lookup completes");
+		check(g_iResolverCalls == iCalls + 3, "the negative answer expires");
+
+		QThread::msleep(400);
+		check(lookup_one(dns, "good.example"), "the expired positive lookup completes");
+		check(g_iResolverCalls == iCalls + 4, "the positive answer expires");
+		check(dns.state() == KviDnsResolver::Success, "the expired positive lookup succeeds again");
+	}
+
+	const KviDnsResolverPool::Statistics & s = pPool->statistics();
+	check(s.uResolverCalls == (kvi_u64_t)g_iResolverCalls && s.uCompletedCalls == s.uResolverCalls, "the statistics count all the resolver calls");
+	check(s.uLookups == s.uCacheHits + s.uSharedLookups + s.uResolverCalls, "every lookup is a hit, a shared lookup or a resolver call");
+	printf("%u lookups: %u cache hits (%u negative), %u shared, %u resolver calls\n",
+	    (unsigned int)s.uLookups, (unsigned int)s.uCacheHits, (unsigned int)s.uNegativeHits,
+	    (unsigned int)s.uSharedLookups, (unsigned int)s.uResolverCalls);
+
+	KviDnsResolverPool::done();
+
+	if(g_iFailures)
+	{
+		fprintf(stderr, "%d checks failed\n", g_iFailures);
+		return 1;
+	}
+	printf("All the checks passed\n");
+	return 0;
+}
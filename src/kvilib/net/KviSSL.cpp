@@ -37,6 +37,7 @@
 #include <openssl/dh.h>
 
 #include <cstdio>
+#include <map>
 
 #if !(defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW))
 // linux, mac
@@ -46,6 +47,23 @@
 static bool g_bSSLInitialized = false;
 static KviMutex * g_pSSLMutex = nullptr;
 
+// the contexts are shared by all the connections (created on demand)
+static SSL_CTX * g_pSSLClientCtx = nullptr;
+static SSL_CTX * g_pSSLServerCtx = nullptr;
+
+// the client sessions to resume, by KviSSL::sessionKey()
+#define KVI_SSL_MAX_CACHED_SESSIONS 64
+struct KviSSLCachedSession
+{
+	SSL_SESSION * pSession;
+	kvi_u64_t uLastUse; // the least recently used one is evicted first
+};
+static std::map<QString, KviSSLCachedSession> g_SSLSessionCache;
+static kvi_u64_t g_uSSLSessionClock = 0;
+
+static unsigned int g_uSSLHandshakes = 0;
+static unsigned int g_uSSLResumedHandshakes = 0;
+
 static inline void my_ssl_lock()
 {
 	g_pSSLMutex->lock();
@@ -247,6 +265,17 @@ void KviSSL::globalDestroy()
 {
 	if(!g_pSSLMutex)
 		return;
+	clearSessionCache();
+	if(g_pSSLClientCtx)
+	{
+		SSL_CTX_free(g_pSSLClientCtx);
+		g_pSSLClientCtx = nullptr;
+	}
+	if(g_pSSLServerCtx)
+	{
+		SSL_CTX_free(g_pSSLServerCtx);
+		g_pSSLServerCtx = nullptr;
+	}
 	if(dh_512)
 		DH_free(dh_512);
 	if(dh_1024)
@@ -286,11 +315,32 @@ void KviSSL::globalSSLDestroy()
 	my_ssl_unlock();
 }
 
+void KviSSL::clearSessionCache()
+{
+	my_ssl_lock();
+	for(auto & it : g_SSLSessionCache)
+		SSL_SESSION_free(it.second.pSession);
+	g_SSLSessionCache.clear();
+	my_ssl_unlock();
+}
+
+unsigned int KviSSL::handshakeCount()
+{
+	return g_uSSLHandshakes;
+}
+
+unsigned int KviSSL::resumedHandshakeCount()
+{
+	return g_uSSLResumedHandshakes;
+}
+
 KviSSL::KviSSL()
 {
 	globalSSLInit();
 	m_pSSL = nullptr;
 	m_pSSLCtx = nullptr;
+	m_eMethod = Client;
+	m_iHandshakeTime = -1;
 }
 
 KviSSL::~KviSSL()
@@ -341,11 +391,7 @@ void KviSSL::shutdown()
 		SSL_free(m_pSSL);
 		m_pSSL = nullptr;
 	}
-	if(m_pSSLCtx)
-	{
-		SSL_CTX_free(m_pSSLCtx);
-		m_pSSLCtx = nullptr;
-	}
+	m_pSSLCtx = nullptr;
 }
 
 /**
@@ -360,26 +406,88 @@ int verify_clientCallback(int, X509_STORE_CTX *)
 	return 1;
 }
 
-bool KviSSL::initContext(Method m)
+/**
+ * Called by OpenSSL when a client session is established: with TLS 1.3
+ * this happens after the handshake, when the server sends its tickets.
+ * Returning 1 means that we keep the reference to the session.
+ */
+static int ssl_new_session_callback(SSL * ssl, SSL_SESSION * pSession)
 {
-	if(m_pSSL)
-		return false;
-	m_pSSLCtx = SSL_CTX_new(m == Client ? SSLv23_client_method() : SSLv23_server_method());
-	if(!m_pSSLCtx)
-		return false;
+	KviSSL * s = (KviSSL *)SSL_get_app_data(ssl);
+	if(!s || s->sessionKey().isEmpty())
+		return 0;
+
+	my_ssl_lock();
+	std::map<QString, KviSSLCachedSession>::iterator it = g_SSLSessionCache.find(s->sessionKey());
+	if(it != g_SSLSessionCache.end())
+	{
+		SSL_SESSION_free(it->second.pSession);
+		it->second.pSession = pSession;
+		it->second.uLastUse = ++g_uSSLSessionClock;
+	}
+	else
+	{
+		if(g_SSLSessionCache.size() >= KVI_SSL_MAX_CACHED_SESSIONS)
+		{
+			std::map<QString, KviSSLCachedSession>::iterator oldest = g_SSLSessionCache.begin();
+			for(it = g_SSLSessionCache.begin(); it != g_SSLSessionCache.end(); ++it)
+			{
+				if(it->second.uLastUse < oldest->second.uLastUse)
+					oldest = it;
+			}
+			SSL_SESSION_free(oldest->second.pSession);
+			g_SSLSessionCache.erase(oldest);
+		}
+		g_SSLSessionCache[s->sessionKey()] = { pSession, ++g_uSSLSessionClock };
+	}
+	my_ssl_unlock();
+	return 1;
+}
+
+static SSL_CTX * ssl_create_context(KviSSL::Method m)
+{
+	SSL_CTX * pCtx = SSL_CTX_new(m == KviSSL::Client ? SSLv23_client_method() : SSLv23_server_method());
+	if(!pCtx)
+		return nullptr;
 
-	if(m == Server)
+	if(m == KviSSL::Server)
 	{
 		// we have to request the peer certificate, else only the client can see the peer identity, not the server
-		SSL_CTX_set_verify(m_pSSLCtx, SSL_VERIFY_PEER, verify_clientCallback);
+		SSL_CTX_set_verify(pCtx, SSL_VERIFY_PEER, verify_clientCallback);
+		// needed to resume the sessions when the peer certificate is requested
+		SSL_CTX_set_session_id_context(pCtx, (const unsigned char *)"KVIrc", 5);
+	}
+	else
+	{
+		// we keep the client sessions by host, not by session id
+		SSL_CTX_set_session_cache_mode(pCtx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_sess_set_new_cb(pCtx, ssl_new_session_callback);
 	}
 
 	// we want all ciphers to be available here, except insecure ones, orderer by strength;
 	// ADH are moved to the end since they are less secure, but they don't need a certificate
 	// (so we can use secure dcc without a cert)
 	// NOTE: see bug ticket #155
-	SSL_CTX_set_cipher_list(m_pSSLCtx, "ALL:!eNULL:!EXP:!SSLv2:+ADH@STRENGTH");
-	SSL_CTX_set_tmp_dh_callback(m_pSSLCtx, my_ugly_dh_callback);
+	SSL_CTX_set_cipher_list(pCtx, "ALL:!eNULL:!EXP:!SSLv2:+ADH@STRENGTH");
+	SSL_CTX_set_tmp_dh_callback(pCtx, my_ugly_dh_callback);
+	return pCtx;
+}
+
+bool KviSSL::initContext(Method m)
+{
+	if(m_pSSL)
+		return false;
+
+	my_ssl_lock();
+	SSL_CTX ** ppCtx = (m == Client) ? &g_pSSLClientCtx : &g_pSSLServerCtx;
+	if(!*ppCtx)
+		*ppCtx = ssl_create_context(m);
+	m_pSSLCtx = *ppCtx;
+	my_ssl_unlock();
+
+	if(!m_pSSLCtx)
+		return false;
+	m_eMethod = m;
 	return true;
 }
 
@@ -390,11 +498,51 @@ bool KviSSL::initSocket(kvi_socket_t fd)
 	m_pSSL = SSL_new(m_pSSLCtx);
 	if(!m_pSSL)
 		return false;
+	SSL_set_app_data(m_pSSL, this);
 	if(!SSL_set_fd(m_pSSL, fd))
 		return false;
 	return true;
 }
 
+static QString ssl_client_identity(SSL * pSSL)
+{
+	// the fingerprint of the certificate we present to the server
+	X509 * x509 = SSL_get_certificate(pSSL);
+	if(!x509)
+		return QString("none");
+	unsigned char bufferData[EVP_MAX_MD_SIZE];
+	unsigned int bufferLen = 0;
+	if(!X509_digest(x509, EVP_sha256(), bufferData, &bufferLen))
+		return QString("unknown");
+	return QString::fromLatin1(QByteArray((const char *)bufferData, bufferLen).toHex());
+}
+
+void KviSSL::setSessionKey(const QString & szKey)
+{
+	m_szSessionKey = szKey;
+	if(!m_pSSL || (m_eMethod != Client) || szKey.isEmpty())
+		return;
+
+	// a resumed session carries the client identity it was created with
+	// (CertFP, SASL EXTERNAL...): never resume it with another certificate
+	m_szSessionKey += QChar('|');
+	m_szSessionKey += ssl_client_identity(m_pSSL);
+
+	my_ssl_lock();
+	std::map<QString, KviSSLCachedSession>::iterator it = g_SSLSessionCache.find(m_szSessionKey);
+	if(it != g_SSLSessionCache.end())
+	{
+		SSL_set_session(m_pSSL, it->second.pSession);
+		it->second.uLastUse = ++g_uSSLSessionClock;
+	}
+	my_ssl_unlock();
+}
+
+bool KviSSL::sessionReused()
+{
+	return m_pSSL && SSL_session_reused(m_pSSL);
+}
+
 static int cb(char * buf, int size, int, void * u)
 {
 	KviCString * p = (KviCString *)u;
@@ -408,7 +556,7 @@ static int cb(char * buf, int size, int, void * u)
 
 KviSSL::Result KviSSL::useCertificateFile(QString cert, QString pass)
 {
-	if(!m_pSSLCtx)
+	if(!m_pSSL)
 		return NotInitialized;
 	m_szPass = pass.toUtf8().data();
 	if(m_szPass.len() < 4)
@@ -426,7 +574,7 @@ KviSSL::Result KviSSL::useCertificateFile(QString cert, QString pass)
 	//qDebug("READING CERTIFICATE %s",cert.Utf8().data());
 	if(PEM_read_X509(f, &x509, cb, &m_szPass))
 	{
-		if(!SSL_CTX_use_certificate(m_pSSLCtx, x509))
+		if(!SSL_use_certificate(m_pSSL, x509))
 		{
 			X509_free(x509);
 			fclose(f);
@@ -441,7 +589,7 @@ KviSSL::Result KviSSL::useCertificateFile(QString cert, QString pass)
 
 KviSSL::Result KviSSL::usePrivateKeyFile(QString key, QString pass)
 {
-	if(!m_pSSLCtx)
+	if(!m_pSSL)
 		return NotInitialized;
 	m_szPass = pass.toUtf8().data();
 	if(m_szPass.len() < 4)
@@ -460,7 +608,7 @@ KviSSL::Result KviSSL::usePrivateKeyFile(QString key, QString pass)
 	//qDebug("READING KEY %s",key.toUtf8().data());
 	if(PEM_read_PrivateKey(f, &k, cb, &m_szPass))
 	{
-		if(!SSL_CTX_use_PrivateKey(m_pSSLCtx, k))
+		if(!SSL_use_PrivateKey(m_pSSL, k))
 		{
 			EVP_PKEY_free(k);
 			fclose(f);
@@ -494,6 +642,8 @@ KviSSL::Result KviSSL::connect()
 {
 	if(!m_pSSL)
 		return NotInitialized;
+	if(!m_HandshakeTimer.isValid())
+		m_HandshakeTimer.start();
 	int ret = SSL_connect(m_pSSL);
 	return connectOrAcceptError(ret);
 }
@@ -502,6 +652,8 @@ KviSSL::Result KviSSL::accept()
 {
 	if(!m_pSSL)
 		return NotInitialized;
+	if(!m_HandshakeTimer.isValid())
+		m_HandshakeTimer.start();
 	int ret = SSL_accept(m_pSSL);
 	return connectOrAcceptError(ret);
 }
@@ -511,6 +663,15 @@ KviSSL::Result KviSSL::connectOrAcceptError(int ret)
 	switch(SSL_get_error(m_pSSL, ret))
 	{
 		case SSL_ERROR_NONE:
+			if(m_iHandshakeTime < 0)
+			{
+				m_iHandshakeTime = m_HandshakeTimer.isValid() ? (int)m_HandshakeTimer.elapsed() : 0;
+				my_ssl_lock();
+				g_uSSLHandshakes++;
+				if(SSL_session_reused(m_pSSL))
+					g_uSSLResumedHandshakes++;
+				my_ssl_unlock();
+			}
 			return Success;
 			break;
 		case SSL_ERROR_WANT_READ:
@@ -621,7 +782,10 @@ KviSSLCipherInfo * KviSSL::getCurrentCipherInfo()
 #endif
 	if(!c)
 		return nullptr;
-	return new KviSSLCipherInfo(c, m_pSSL);
+	KviSSLCipherInfo * pInfo = new KviSSLCipherInfo(c, m_pSSL);
+	pInfo->m_bSessionReused = SSL_session_reused(m_pSSL);
+	pInfo->m_iHandshakeTime = m_iHandshakeTime;
+	return pInfo;
 }
 
 KviSSLCertificate::KviSSLCertificate(X509 * x509)
@@ -920,6 +1084,8 @@ KviSSLCipherInfo::KviSSLCipherInfo(SSL_CIPHER * c, SSL * s)
 	m_szName = SSL_CIPHER_get_name(c);
 	char buf[1024];
 	m_szDescription = SSL_CIPHER_description(c, buf, 1024);
+	m_bSessionReused = false;
+	m_iHandshakeTime = -1;
 }
 
 KviSSLCipherInfo::~KviSSLCipherInfo()
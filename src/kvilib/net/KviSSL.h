@@ -41,6 +41,9 @@
 
 #include <openssl/ssl.h>
 
+#include <QElapsedTimer>
+#include <QString>
+
 class KVILIB_API KviSSLCertificate
 {
 public:
@@ -114,6 +117,8 @@ public:
 
 class KVILIB_API KviSSLCipherInfo
 {
+	friend class KviSSL;
+
 public:
 #if OPENSSL_VERSION_NUMBER >= 0x10000000L
 	KviSSLCipherInfo(const SSL_CIPHER * c, const SSL * s);
@@ -128,6 +133,8 @@ protected:
 	int m_iNumBitsUsed;
 	KviCString m_szName;
 	KviCString m_szDescription;
+	bool m_bSessionReused;
+	int m_iHandshakeTime;
 
 public:
 	const char * name() { return m_szName.ptr(); };
@@ -135,6 +142,10 @@ public:
 	int bits() { return m_iNumBits; };
 	int bitsUsed() { return m_iNumBitsUsed; };
 	const char * version() { return m_szVersion.ptr(); };
+	// true if the handshake has resumed a previous session
+	bool sessionReused() { return m_bSessionReused; };
+	// the handshake duration in msecs (-1 if unknown)
+	int handshakeTime() { return m_iHandshakeTime; };
 #ifdef COMPILE_ON_WINDOWS
 	// On windows we need to override new and delete operators
 	// to ensure that always the right new/delete pair is called for an object instance
@@ -179,9 +190,15 @@ public:
 
 public:
 	SSL * m_pSSL;
-	SSL_CTX * m_pSSLCtx;
+	SSL_CTX * m_pSSLCtx; // shared by all the objects with the same method: not owned
 	KviCString m_szPass;
 
+protected:
+	Method m_eMethod;
+	QString m_szSessionKey;
+	QElapsedTimer m_HandshakeTimer;
+	int m_iHandshakeTime;
+
 public:
 	static void globalInit();
 	static void globalDestroy();
@@ -204,8 +221,22 @@ public:
 	KviSSLCertificate * getPeerCertificate();
 	KviSSLCertificate * getLocalCertificate();
 	KviSSLCipherInfo * getCurrentCipherInfo();
+	// these must be called after initSocket() since the context is shared
 	KviSSL::Result useCertificateFile(QString cert, QString pass);
 	KviSSL::Result usePrivateKeyFile(QString key, QString pass);
+	// The client sessions are cached by this key (usually host:port) plus the
+	// fingerprint of the client certificate: the next connection with the same
+	// key and certificate attempts to resume the session.
+	// Must be called after initSocket() and useCertificateFile().
+	void setSessionKey(const QString & szKey);
+	const QString & sessionKey() const { return m_szSessionKey; };
+	bool sessionReused();
+	// the duration of the last completed handshake in msecs (-1 if not completed)
+	int handshakeTime() const { return m_iHandshakeTime; };
+	// global handshake counters
+	static unsigned int handshakeCount();
+	static unsigned int resumedHandshakeCount();
+	static void clearSessionCache();
 #ifdef COMPILE_ON_WINDOWS
 	// On windows we need to override new and delete operators
 	// to ensure that always the right new/delete pair is called for an object instance
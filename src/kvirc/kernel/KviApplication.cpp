@@ -74,12 +74,15 @@
 #include "KviIrcView.h"
 #include "KviEnvironment.h"
 #include "KviAnimatedPixmapCache.h"
+#include "KviDnsResolver.h"
+#include "KviLogWriter.h"
 #include "KviKvs.h"
 #include "KviKvsScript.h"
 #include "KviKvsPopupManager.h"
 #include "KviKvsKernel.h"
 #include "KviKvsObjectController.h"
 #include "KviKvsEventTriggers.h"
+#include "KviKvsProfiler.h"
 #include "kvi_sourcesdate.h"
 #include "KviPointerHashTable.h"
 #include "KviQueryWindow.h"
@@ -213,6 +216,7 @@ KviApplication::KviApplication(int & argc, char ** argv)
 	g_pApp = this;
 	m_szConfigFile = QString();
 	m_bCreateConfig = false;
+	m_bProfileStartup = false;
 	m_bUpdateGuiPending = false;
 	m_pRecentChannelDict = nullptr;
 #ifndef COMPILE_NO_IPC
@@ -247,6 +251,9 @@ void KviApplication::setup()
 	// on each other and we must activate them in the right order.
 	// Don't move stuff around unless you really know what you're doing.
 
+	if(m_bProfileStartup)
+		KviKvsProfiler::startupBegin();
+
 	// Initialize the random number generator
 	::srand(::time(nullptr));
 
@@ -275,7 +282,10 @@ void KviApplication::setup()
 	loadDirectories();
 	KviStringConversion::init(m_szGlobalKvircDir, m_szLocalKvircDir);
 
-	g_pIconManager = new KviIconManager();
+	{
+		KviKvsProfilerScope scope("startup", QString::fromLatin1("iconManager"));
+		g_pIconManager = new KviIconManager();
+	}
 
 	// add KVIrc common dirs to QT searchpath
 	QString szPath;
@@ -328,12 +338,16 @@ void KviApplication::setup()
 		KviUserIdentityManager::instance()->load(szTmp);
 
 	KviAnimatedPixmapCache::init();
+	KviDnsResolverPool::init();
 
 	// Load the remaining configuration
 	// Note that loadOptions() assumes that the current progress is 12 and
 	// will bump it up to 45 in small steps
 	loadOptions();
 
+	// The window logs are written by a background thread
+	KviLogWriter::init();
+
 	// set the global font if needed
 	updateApplicationFont();
 
@@ -427,8 +441,10 @@ void KviApplication::setup()
 		KviAvatarCache::instance()->load(szTmp);
 
 	KviInputHistory::init();
-	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_INPUTHISTORY))
+	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_INPUTHISTORYJOURNAL))
 		KviInputHistory::instance()->load(szTmp);
+	else if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_INPUTHISTORY))
+		KviInputHistory::instance()->loadLegacy(szTmp); // saved by an older version
 
 	KviDefaultScriptManager::init();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_DEFAULTSCRIPT))
@@ -592,6 +608,9 @@ KviApplication::~KviApplication()
 #endif
 	m_PendingAvatarChanges.clear();
 	KviAnimatedPixmapCache::done();
+	KviDnsResolverPool::done();
+	// after the windows are dead: this flushes and closes the logs still open
+	KviLogWriter::done();
 // Kill the thread manager.... all the slave threads should have been already terminated ...
 #ifdef COMPILE_SSL_SUPPORT
 	KviSSL::globalDestroy();
@@ -1411,7 +1430,7 @@ void KviApplication::saveInputHistory()
 	if(KVI_OPTION_BOOL(KviOption_boolEnableInputHistory))
 	{
 		QString szTmp;
-		getLocalKvircDirectory(szTmp, Config, KVI_CONFIGFILE_INPUTHISTORY);
+		getLocalKvircDirectory(szTmp, Config, KVI_CONFIGFILE_INPUTHISTORYJOURNAL);
 		KviInputHistory::instance()->save(szTmp);
 	}
 }
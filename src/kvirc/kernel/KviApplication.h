@@ -149,6 +149,7 @@ public:
 	QString m_szConfigFile; // setup
 	bool m_bCreateConfig;   // setup
 	QString m_szExecAfterStartup;
+	bool m_bProfileStartup; // setup
 
 protected:
 #ifdef COMPILE_KDE_SUPPORT
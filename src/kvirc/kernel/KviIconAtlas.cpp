@@ -0,0 +1,127 @@
+//=============================================================================
+//
+//   File : KviIconAtlas.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include "KviIconAtlas.h"
+#include "kvi_inttypes.h"
+
+#include <QFileInfo>
+#include <QImage>
+
+#include <cstring>
+
+#define KVI_ICONATLAS_BYTE_ORDER_MARK 0x01020304
+#define KVI_ICONATLAS_VERSION 1
+// magic, byte order mark, version, width, height, count, pixel offset
+#define KVI_ICONATLAS_HEADER_SIZE 28
+
+static kvi_u32_t read_u32(const uchar * p)
+{
+	kvi_u32_t u;
+	memcpy(&u, p, 4);
+	return u;
+}
+
+KviIconAtlas::KviIconAtlas()
+    = default;
+
+KviIconAtlas::~KviIconAtlas()
+{
+	// the pixmap may still reference the mapped memory
+	m_pixmap = QPixmap();
+	m_file.close();
+}
+
+bool KviIconAtlas::load(const QString & szFileName)
+{
+	m_file.setFileName(szFileName);
+	if(!m_file.open(QIODevice::ReadOnly))
+		return false;
+
+	qint64 iSize = m_file.size();
+	if(iSize < KVI_ICONATLAS_HEADER_SIZE)
+		return false;
+
+	const uchar * pData = m_file.map(0, iSize);
+	if(!pData)
+	{
+		m_buffer = m_file.readAll();
+		m_file.close();
+		if(m_buffer.size() != iSize)
+			return false;
+		pData = (const uchar *)m_buffer.constData();
+	}
+
+	if(memcmp(pData, "KVIA", 4) != 0)
+		return false;
+	if(read_u32(pData + 4) != KVI_ICONATLAS_BYTE_ORDER_MARK)
+		return false;
+	if(read_u32(pData + 8) != KVI_ICONATLAS_VERSION)
+		return false;
+
+	kvi_u32_t uWidth = read_u32(pData + 12);
+	kvi_u32_t uHeight = read_u32(pData + 16);
+	kvi_u32_t uCount = read_u32(pData + 20);
+	kvi_u32_t uPixels = read_u32(pData + 24);
+
+	if((uWidth == 0) || (uHeight == 0) || (uWidth > 16384) || (uHeight > 16384))
+		return false;
+	if((uPixels % 4) || (((qint64)uPixels + (qint64)uWidth * uHeight * 4) > iSize))
+		return false;
+
+	const uchar * p = pData + KVI_ICONATLAS_HEADER_SIZE;
+	const uchar * e = pData + uPixels;
+	QRect atlas(0, 0, uWidth, uHeight);
+	for(kvi_u32_t i = 0; i < uCount; i++)
+	{
+		if((e - p) < 20)
+			return false;
+		QRect r(read_u32(p), read_u32(p + 4), read_u32(p + 8), read_u32(p + 12));
+		kvi_u32_t uLen = read_u32(p + 16);
+		p += 20;
+		if((kvi_u32_t)(e - p) < uLen)
+			return false;
+		if(!atlas.contains(r))
+			return false;
+		m_icons.insert(QString::fromUtf8((const char *)p, uLen), r);
+		p += (uLen + 3) & ~3;
+	}
+
+	// no copy here: the image points to the mapped file
+	QImage img(pData + uPixels, uWidth, uHeight, uWidth * 4, QImage::Format_ARGB32_Premultiplied);
+	m_pixmap = QPixmap::fromImage(img);
+	if(m_pixmap.isNull())
+		return false;
+
+	m_szDirectory = QFileInfo(szFileName).absolutePath();
+	return true;
+}
+
+QPixmap * KviIconAtlas::pixmap(const QString & szName) const
+{
+	auto it = m_icons.find(szName);
+	if(it == m_icons.end())
+		return nullptr;
+	return new QPixmap(m_pixmap.copy(it.value()));
+}
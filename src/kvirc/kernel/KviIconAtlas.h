@@ -0,0 +1,81 @@
+#ifndef _KVI_ICONATLAS_H_
+#define _KVI_ICONATLAS_H_
+//=============================================================================
+//
+//   File : KviIconAtlas.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include "kvi_settings.h"
+
+#include <QFile>
+#include <QHash>
+#include <QPixmap>
+#include <QRect>
+#include <QString>
+
+#define KVI_SMALLICONS_ATLAS_FILE "kcs_atlas.kvia"
+
+//
+// The small icons packed in a single image.
+//
+// The atlas is built from the PNG files by admin/mkiconatlas.cpp when KVIrc
+// is compiled and it's installed next to the icons. An icon theme can ship
+// its own kcs_atlas.kvia in its small icons directory.
+//
+// The file stores the pixels already decoded, so loading it costs one
+// memory map instead of a file open and a PNG decode for each icon.
+// All the integers are 32 bit in the byte order of the machine
+// that built the file:
+//
+//   "KVIA", 0x01020304 (byte order mark), version (1),
+//   width, height, icon count, offset of the pixels,
+//   for each icon: x, y, width, height, name length, name (padded to 4 bytes),
+//   the pixels: width * height 32 bit premultiplied ARGB values, row by row.
+//
+// The name of each icon is the name of its file (for example "kcs_op.png").
+//
+
+class KVIRC_API KviIconAtlas
+{
+public:
+	KviIconAtlas();
+	~KviIconAtlas();
+
+protected:
+	QFile m_file;        // kept open while it's mapped
+	QByteArray m_buffer; // used only if the file can't be mapped
+	QPixmap m_pixmap;
+	QHash<QString, QRect> m_icons;
+	QString m_szDirectory;
+
+public:
+	// false if the file is missing, broken or built on a machine with a different byte order
+	bool load(const QString & szFileName);
+	// the directory containing the atlas file
+	const QString & directory() const { return m_szDirectory; };
+	bool contains(const QString & szName) const { return m_icons.contains(szName); };
+	// a new pixmap with the given icon or nullptr if it's not in the atlas
+	QPixmap * pixmap(const QString & szName) const;
+};
+
+#endif //_KVI_ICONATLAS_H_
@@ -25,6 +25,7 @@
 #define _KVI_ICONMANAGER_CPP_
 
 #include "KviIconManager.h"
+#include "KviIconAtlas.h"
 #include "KviApplication.h"
 #include "kvi_settings.h"
 #include "kvi_defaults.h"
@@ -37,6 +38,7 @@
 #include <QDir>
 #include <QDrag>
 #include <QEvent>
+#include <QFileInfo>
 #include <QIcon>
 #include <QLabel>
 #include <QLayout>
@@ -566,6 +568,7 @@ KviIconManager::~KviIconManager()
 	delete m_pCachedImages;
 	if(m_pIconNames)
 		delete m_pIconNames;
+	unloadAtlases();
 }
 
 void KviIconManager::initQResourceBackend()
@@ -1946,6 +1949,65 @@ void KviIconManager::reloadImages()
 			delete m_smallIcon;
 		m_smallIcon = nullptr;
 	}
+	unloadAtlases();
+}
+
+void KviIconManager::loadAtlases()
+{
+	m_bAtlasesLoaded = true;
+
+	QString szBuffer;
+
+	if(!KVI_OPTION_STRING(KviOption_stringIconThemeSubdir).isEmpty())
+	{
+		// the same places looked up by KviApplication::findSmallIcon()
+		QString szTmp = KVI_OPTION_STRING(KviOption_stringIconThemeSubdir);
+		szTmp.append(KVI_PATH_SEPARATOR_CHAR);
+		szTmp.append(KVI_SMALLICONS_SUBDIRECTORY);
+		szTmp.append(KVI_PATH_SEPARATOR_CHAR);
+		szTmp.append(KVI_SMALLICONS_ATLAS_FILE);
+
+		g_pApp->getLocalKvircDirectory(szBuffer, KviApplication::Themes, szTmp);
+		if(!KviFileUtils::fileExists(szBuffer))
+			g_pApp->getGlobalKvircDirectory(szBuffer, KviApplication::Themes, szTmp);
+		if(KviFileUtils::fileExists(szBuffer))
+		{
+			m_pThemeAtlas = new KviIconAtlas();
+			if(!m_pThemeAtlas->load(szBuffer))
+			{
+				qDebug("Can't load the icon atlas %s", szBuffer.toUtf8().data());
+				delete m_pThemeAtlas;
+				m_pThemeAtlas = nullptr;
+			}
+		}
+	}
+
+	g_pApp->getGlobalKvircDirectory(szBuffer, KviApplication::SmallIcons, KVI_SMALLICONS_ATLAS_FILE);
+	if(KviFileUtils::fileExists(szBuffer))
+	{
+		m_pBuiltinAtlas = new KviIconAtlas();
+		if(!m_pBuiltinAtlas->load(szBuffer))
+		{
+			qDebug("Can't load the icon atlas %s", szBuffer.toUtf8().data());
+			delete m_pBuiltinAtlas;
+			m_pBuiltinAtlas = nullptr;
+		}
+	}
+}
+
+void KviIconManager::unloadAtlases()
+{
+	if(m_pThemeAtlas)
+	{
+		delete m_pThemeAtlas;
+		m_pThemeAtlas = nullptr;
+	}
+	if(m_pBuiltinAtlas)
+	{
+		delete m_pBuiltinAtlas;
+		m_pBuiltinAtlas = nullptr;
+	}
+	m_bAtlasesLoaded = false;
 }
 
 QPixmap * KviIconManager::loadSmallIcon(int iIdx)
@@ -1959,7 +2021,27 @@ QPixmap * KviIconManager::loadSmallIcon(int iIdx)
 	//KviQString::sprintf(szPath,KVI_SMALLICONS_PREFIX "%s.png",g_szIconNames[iIdx]);
 	QString szBuffer;
 
+	if(!m_bAtlasesLoaded)
+		loadAtlases();
+
+	// the theme atlas overrides everything
+	if(m_pThemeAtlas)
+	{
+		m_smallIcons[iIdx] = m_pThemeAtlas->pixmap(szPath);
+		if(m_smallIcons[iIdx])
+			return m_smallIcons[iIdx];
+	}
+
 	g_pApp->findSmallIcon(szBuffer, szPath);
+
+	// the builtin atlas is used only if the icon hasn't been replaced by another file
+	if(m_pBuiltinAtlas && (QFileInfo(szBuffer).absolutePath() == m_pBuiltinAtlas->directory()))
+	{
+		m_smallIcons[iIdx] = m_pBuiltinAtlas->pixmap(szPath);
+		if(m_smallIcons[iIdx])
+			return m_smallIcons[iIdx];
+	}
+
 	m_smallIcons[iIdx] = new QPixmap(szBuffer);
 
 	return m_smallIcons[iIdx];
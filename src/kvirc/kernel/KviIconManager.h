@@ -83,6 +83,7 @@
 #define KVI_REFRESH_IMAGE_NAME "kvi_icon_refresh.png"
 
 class KVIRC_API KviIconWidget;
+class KviIconAtlas;
 
 /**
 * \class KviCachedPixmap
@@ -529,6 +530,9 @@ private:
 	KviIconWidget * m_pIconWidget = nullptr;
 	KviPointerHashTable<QString, KviCachedPixmap> * m_pCachedImages = nullptr;
 	KviPointerHashTable<QString, int> * m_pIconNames = nullptr;
+	KviIconAtlas * m_pThemeAtlas = nullptr;   // shipped with the icon theme
+	KviIconAtlas * m_pBuiltinAtlas = nullptr; // installed with the builtin icons
+	bool m_bAtlasesLoaded = false;
 	unsigned int m_uCacheTotalSize = 0;
 	unsigned int m_uCacheMaxSize = 1024 * 1024; // 1 MiB
 
@@ -684,6 +688,18 @@ protected:
 	*/
 	QPixmap * loadSmallIcon(int iIdx);
 
+	/**
+	* \brief Loads the atlases of the small icons of the theme and of the builtin ones
+	* \return void
+	*/
+	void loadAtlases();
+
+	/**
+	* \brief Forgets the atlases (the icon theme has changed)
+	* \return void
+	*/
+	void unloadAtlases();
+
 	/**
 	* \brief Initializes the Qt resource backend
 	* \return void
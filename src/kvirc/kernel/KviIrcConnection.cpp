@@ -66,6 +66,7 @@
 #include "KviSASL.h"
 #include "KviNickColors.h"
 #include "KviIrcNetwork.h"
+#include "KviIrcUserDataBase.h"
 
 #include <QTimer>
 #include <QTextCodec>
@@ -87,9 +88,10 @@ KviIrcConnection::KviIrcConnection(KviIrcContext * pContext, KviIrcConnectionTar
 	m_pServerInfo = new KviIrcConnectionServerInfo();
 	m_pStateData = new KviIrcConnectionStateData();
 	m_pAntiCtcpFloodData = new KviIrcConnectionAntiCtcpFloodData();
-	m_pNetsplitDetectorData = new KviIrcConnectionNetsplitDetectorData();
+	m_pNetsplitDetectorData = new KviIrcConnectionNetsplitDetectorData(this);
 	m_pAsyncWhoisData = new KviIrcConnectionAsyncWhoisData();
 	m_pStatistics = std::make_unique<KviIrcConnectionStatistics>();
+	m_pStatistics->setUserDataBase(m_pUserDataBase);
 	m_pRequestQueue = new KviIrcConnectionRequestQueue();
 	setupSrvCodec();
 	setupTextCodec();
@@ -540,6 +542,9 @@ void KviIrcConnection::linkTerminated()
 	}
 	m_eState = Idle;
 
+	// apply the coalesced QUITs and JOINs while the channels are still there
+	m_pNetsplitDetectorData->flush();
+
 	delete m_pNotifyListManager;
 	m_pNotifyListManager = nullptr;
 
@@ -566,38 +571,44 @@ void KviIrcConnection::linkAttemptFailed(int iError)
 
 KviChannelWindow * KviIrcConnection::findChannel(const QString & szName)
 {
-	for(auto & c : m_pChannelList)
+	return m_ChannelDict.value(m_pServerInfo->foldCase(szName), nullptr);
+}
+
+std::vector<KviChannelWindow *> KviIrcConnection::channelsOf(const QString & szNick)
+{
+	std::vector<KviChannelWindow *> list;
+	KviIrcUserEntry * e = m_pUserDataBase->find(szNick);
+	if(!e)
+		return list;
+	for(auto & w : e->windowList())
 	{
-		if(KviQString::equalCI(szName, c->windowName()))
-			return c;
+		if(w->type() == KviWindow::Channel)
+			list.push_back((KviChannelWindow *)w);
 	}
-	return nullptr;
+	return list;
 }
 
 int KviIrcConnection::getCommonChannels(const QString & szNick, QString & szChansBuffer, bool bAddEscapeSequences)
 {
 	int iCount = 0;
-	for(auto & c : m_pChannelList)
+	for(auto & c : channelsOf(szNick))
 	{
-		if(c->isOn(szNick))
-		{
-			if(!szChansBuffer.isEmpty())
-				szChansBuffer.append(", ");
+		if(!szChansBuffer.isEmpty())
+			szChansBuffer.append(", ");
 
-			char uFlag = c->getUserFlag(szNick);
-			if(uFlag)
-			{
-				KviQString::appendFormatted(szChansBuffer, bAddEscapeSequences ? "%c\r!c\r%Q\r" : "%c%Q", uFlag, &(c->windowName()));
-			}
+		char uFlag = c->getUserFlag(szNick);
+		if(uFlag)
+		{
+			KviQString::appendFormatted(szChansBuffer, bAddEscapeSequences ? "%c\r!c\r%Q\r" : "%c%Q", uFlag, &(c->windowName()));
+		}
+		else
+		{
+			if(bAddEscapeSequences)
+				KviQString::appendFormatted(szChansBuffer, "\r!c\r%Q\r", &(c->windowName()));
 			else
-			{
-				if(bAddEscapeSequences)
-					KviQString::appendFormatted(szChansBuffer, "\r!c\r%Q\r", &(c->windowName()));
-				else
-					szChansBuffer.append(c->windowName());
-			}
-			iCount++;
+				szChansBuffer.append(c->windowName());
 		}
+		iCount++;
 	}
 	return iCount;
 }
@@ -698,17 +709,42 @@ KviQueryWindow * KviIrcConnection::createQuery(const QString & szNick, CreateQue
 
 KviQueryWindow * KviIrcConnection::findQuery(const QString & szName)
 {
-	for(auto & q : m_pQueryList)
+	return m_QueryDict.value(m_pServerInfo->foldCase(szName), nullptr);
+}
+
+// The dictionaries map each folded name to the first window in the list with
+// that name: that's what the linear lookups used to find.
+
+template<typename T>
+static void dict_insert_window(QHash<QString, T *> & dict, T * w, const QString & szKey)
+{
+	if(!dict.contains(szKey))
+		dict.insert(szKey, w);
+}
+
+template<typename T>
+static void dict_remove_window(QHash<QString, T *> & dict, const std::vector<T *> & list, T * w, const QString & szKey, KviIrcConnectionServerInfo * pServerInfo)
+{
+	// Another window with an equivalent name might have been shadowed by this one
+	// (i.e. after a query target nick change): it gets the key back then.
+	typename QHash<QString, T *>::iterator it = dict.find(szKey);
+	if((it == dict.end()) || (it.value() != w))
+		return;
+	dict.erase(it);
+	for(auto & o : list)
 	{
-		if(KviQString::equalCI(szName, q->windowName()))
-			return q;
+		if((o != w) && (pServerInfo->foldCase(o->windowName()) == szKey))
+		{
+			dict.insert(szKey, o);
+			return;
+		}
 	}
-	return nullptr;
 }
 
 void KviIrcConnection::registerChannel(KviChannelWindow * c)
 {
 	m_pChannelList.push_back(c);
+	dict_insert_window(m_ChannelDict, c, m_pServerInfo->foldCase(c->windowName()));
 	if(KVI_OPTION_BOOL(KviOption_boolLogChannelHistory))
 		g_pApp->addRecentChannel(c->windowName(), m_pServerInfo->networkName());
 	emit(channelRegistered(c));
@@ -718,6 +754,7 @@ void KviIrcConnection::registerChannel(KviChannelWindow * c)
 void KviIrcConnection::unregisterChannel(KviChannelWindow * c)
 {
 	m_pChannelList.erase(std::remove(m_pChannelList.begin(), m_pChannelList.end(), c), m_pChannelList.end());
+	dict_remove_window(m_ChannelDict, m_pChannelList, c, m_pServerInfo->foldCase(c->windowName()), m_pServerInfo);
 	requestQueue()->dequeueChannel(c);
 	emit(channelUnregistered(c));
 	emit(chanListChanged());
@@ -726,11 +763,36 @@ void KviIrcConnection::unregisterChannel(KviChannelWindow * c)
 void KviIrcConnection::registerQuery(KviQueryWindow * q)
 {
 	m_pQueryList.push_back(q);
+	dict_insert_window(m_QueryDict, q, m_pServerInfo->foldCase(q->windowName()));
 }
 
 void KviIrcConnection::unregisterQuery(KviQueryWindow * q)
 {
 	m_pQueryList.erase(std::remove(m_pQueryList.begin(), m_pQueryList.end(), q), m_pQueryList.end());
+	dict_remove_window(m_QueryDict, m_pQueryList, q, m_pServerInfo->foldCase(q->windowName()), m_pServerInfo);
+}
+
+void KviIrcConnection::queryRenamed(KviQueryWindow * q, const QString & szOldName)
+{
+	if(std::find(m_pQueryList.begin(), m_pQueryList.end(), q) == m_pQueryList.end())
+		return; // dead query
+	QString szOldKey = m_pServerInfo->foldCase(szOldName);
+	QString szNewKey = m_pServerInfo->foldCase(q->windowName());
+	if(szOldKey == szNewKey)
+		return;
+	dict_remove_window(m_QueryDict, m_pQueryList, q, szOldKey, m_pServerInfo);
+	dict_insert_window(m_QueryDict, q, szNewKey);
+}
+
+void KviIrcConnection::caseMappingChanged()
+{
+	// all the keys change
+	m_ChannelDict.clear();
+	for(auto & c : m_pChannelList)
+		dict_insert_window(m_ChannelDict, c, m_pServerInfo->foldCase(c->windowName()));
+	m_QueryDict.clear();
+	for(auto & q : m_pQueryList)
+		dict_insert_window(m_QueryDict, q, m_pServerInfo->foldCase(q->windowName()));
 }
 
 void KviIrcConnection::keepChannelsOpenAfterDisconnect()
@@ -1933,10 +1995,7 @@ void KviIrcConnection::incomingMessage(const char * pcMessage)
 		if(m->incomingMessage(pcMessage))
 			return;
 	}
-	// set the last message time
-	m_pStatistics->setLastMessageTime(kvi_unixTime());
-	// and pass it to the server parser for processing
-	g_pServerParser->parseMessage(pcMessage, this);
+	incomingMessageNoFilter(pcMessage);
 }
 
 void KviIrcConnection::incomingMessageNoFilter(const char * pcMessage)
@@ -1944,7 +2003,15 @@ void KviIrcConnection::incomingMessageNoFilter(const char * pcMessage)
 	// set the last message time
 	m_pStatistics->setLastMessageTime(kvi_unixTime());
 	// and pass it to the server parser for processing
+	if(!KVI_OPTION_BOOL(KviOption_boolEnableConnectionTelemetry))
+	{
+		g_pServerParser->parseMessage(pcMessage, this);
+		return;
+	}
+
+	kvi_u64_t uStart = KviIrcConnectionStatistics::telemetryClock();
 	g_pServerParser->parseMessage(pcMessage, this);
+	m_pStatistics->messageDispatched(pcMessage, KviIrcConnectionStatistics::telemetryClock() - uStart);
 }
 
 void KviIrcConnection::heartbeat(kvi_time_t tNow)
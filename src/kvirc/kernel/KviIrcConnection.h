@@ -35,6 +35,7 @@
 #include "KviTimeUtils.h"
 
 #include <QByteArray>
+#include <QHash>
 #include <QObject>
 #include <QStringList>
 
@@ -164,6 +165,10 @@ private:
 	std::vector<KviChannelWindow *> m_pChannelList; // elements are borrowed and never null
 	std::vector<KviQueryWindow *> m_pQueryList;     // elements are borrowed and never null
 
+	// The same windows keyed by their name folded with the server CASEMAPPING (see findChannel())
+	QHash<QString, KviChannelWindow *> m_ChannelDict; // values are borrowed and never null
+	QHash<QString, KviQueryWindow *> m_QueryDict;     // values are borrowed and never null
+
 	KviIrcUserDataBase * m_pUserDataBase; // owned, never null
 
 	KviNotifyListManager * m_pNotifyListManager = nullptr; // owned, see restartNotifyList()
@@ -405,6 +410,18 @@ public:
 	*/
 	KviChannelWindow * findChannel(const QString & szName);
 
+	/**
+	* \brief Returns the channels that the specified user is on
+	*
+	* The lookup goes through the membership index kept in the user
+	* database so it doesn't probe the user list of every channel.
+	* The returned list is a copy: it can be safely walked while
+	* parting the user from the channels.
+	* \param szNick The nickname of the user
+	* \return std::vector<KviChannelWindow *>
+	*/
+	std::vector<KviChannelWindow *> channelsOf(const QString & szNick);
+
 	/**
 	* \brief Returns a list of channels bound to the current connection
 	*
@@ -540,6 +557,11 @@ public:
 	///
 	void unregisterQuery(KviQueryWindow * q);
 
+	///
+	/// This is called by KviQueryWindow when its target changes nickname, you shouldn't need to use it.
+	///
+	void queryRenamed(KviQueryWindow * q, const QString & szOldName);
+
 	/**
 	* \brief Marks all the currently open queries as DEAD
 	*
@@ -814,6 +836,12 @@ protected:
 	*/
 	void serverInfoReceived(const QString & szServerName, const QString & szUserModes, const QString & szChanModes);
 
+	/**
+	* \brief Called when the CASEMAPPING token of RPL_ISUPPORT (005) changes the server info
+	* \return void
+	*/
+	void caseMappingChanged();
+
 	/**
 	* \brief Called when AUTHENTICATE answer is received
 	* \return void
@@ -23,9 +23,347 @@
 //=============================================================================
 
 #include "KviIrcConnectionNetsplitDetectorData.h"
+#include "KviIrcConnection.h"
+#include "KviIrcConnectionServerInfo.h"
+#include "KviIrcUserDataBase.h"
+#include "KviChannelWindow.h"
+#include "KviQueryWindow.h"
+#include "KviConsoleWindow.h"
+#include "KviUserListView.h"
+#include "KviKvsEventTriggers.h"
+#include "KviOptions.h"
+#include "KviLocale.h"
+#include "kvi_out.h"
 
-KviIrcConnectionNetsplitDetectorData::KviIrcConnectionNetsplitDetectorData()
-    = default;
+#include <map>
+
+// how long the QUITs and JOINs of a netsplit are buffered (msecs)
+#define KVI_NETSPLIT_COALESCE_WINDOW 1000
+// how long after a split the JOINs of the split users are considered part of a netjoin (secs)
+#define KVI_NETSPLIT_NETJOIN_TIMEOUT 900
+// how many nicknames are listed in a summary line
+#define KVI_NETSPLIT_MAX_LISTED_NICKS 50
+
+namespace
+{
+	// the nickname list of a summary line
+	QString summaryNickList(const QStringList & lNicks)
+	{
+		QString szList;
+		int iListed = 0;
+		for(auto & szNick : lNicks)
+		{
+			if(iListed == KVI_NETSPLIT_MAX_LISTED_NICKS)
+				break;
+			if(iListed > 0)
+				szList.append(", ");
+			szList.append(QString("\r!n\r%1\r").arg(szNick));
+			iListed++;
+		}
+		if(lNicks.count() > iListed)
+			szList.append(__tr2qs(" and %1 more").arg(lNicks.count() - iListed));
+		return szList;
+	}
+}
+
+KviIrcConnectionNetsplitDetectorData::KviIrcConnectionNetsplitDetectorData(KviIrcConnection * pConnection)
+    : QObject(), m_pConnection(pConnection)
+{
+	m_timer.setSingleShot(true);
+	connect(&m_timer, SIGNAL(timeout()), this, SLOT(timerShot()));
+}
 
 KviIrcConnectionNetsplitDetectorData::~KviIrcConnectionNetsplitDetectorData()
-    = default;
+{
+	// the channels are already gone: the buffered messages are dropped
+	m_timer.stop();
+}
+
+QString KviIrcConnectionNetsplitDetectorData::nickKey(const QString & szNick) const
+{
+	return m_pConnection->serverInfo()->foldCase(szNick);
+}
+
+bool KviIrcConnectionNetsplitDetectorData::isPending(const QString & szNick) const
+{
+	return m_hPendingNicks.contains(nickKey(szNick));
+}
+
+bool KviIrcConnectionNetsplitDetectorData::isNetjoin(const QString & szNick)
+{
+	QHash<QString, kvi_time_t>::iterator it = m_hSplitNicks.find(nickKey(szNick));
+	if(it == m_hSplitNicks.end())
+		return false;
+	if((kvi_unixTime() - it.value()) < KVI_NETSPLIT_NETJOIN_TIMEOUT)
+		return true;
+	m_hSplitNicks.erase(it);
+	return false;
+}
+
+void KviIrcConnectionNetsplitDetectorData::queueQuit(const QString & szNick, const QString & szUser, const QString & szHost, const QString & szReason)
+{
+	// a JOIN of this user is buffered: keep the order
+	if(isPending(szNick))
+		flush();
+
+	m_PendingQuits.push_back({ szNick, szUser, szHost, szReason });
+	m_hPendingNicks[nickKey(szNick)]++;
+	schedule();
+}
+
+void KviIrcConnectionNetsplitDetectorData::queueJoin(const QString & szChan, const QString & szNick, const QString & szUser, const QString & szHost, int iFlags, const QString & szAccount, const QString & szReal)
+{
+	// a QUIT of this user is buffered: keep the order
+	QString szKey = nickKey(szNick);
+	if(m_hPendingNicks.contains(szKey))
+	{
+		for(auto & q : m_PendingQuits)
+		{
+			if(nickKey(q.szNick) == szKey)
+			{
+				flush();
+				break;
+			}
+		}
+	}
+
+	m_PendingJoins.push_back({ szChan, szNick, szUser, szHost, szAccount, szReal, iFlags });
+	m_hPendingNicks[szKey]++;
+	schedule();
+}
+
+void KviIrcConnectionNetsplitDetectorData::schedule()
+{
+	// not restarted by the following messages: a long storm is applied in slices
+	if(!m_timer.isActive())
+		m_timer.start(KVI_NETSPLIT_COALESCE_WINDOW);
+}
+
+void KviIrcConnectionNetsplitDetectorData::timerShot()
+{
+	flush();
+}
+
+void KviIrcConnectionNetsplitDetectorData::flush()
+{
+	m_timer.stop();
+	if(m_hPendingNicks.isEmpty())
+		return;
+	m_hPendingNicks.clear();
+
+	flushQuits();
+	flushJoins();
+}
+
+void KviIrcConnectionNetsplitDetectorData::flushQuits()
+{
+	if(m_PendingQuits.empty())
+		return;
+
+	// the events may end up here again
+	std::vector<PendingQuit> lQuits;
+	lQuits.swap(m_PendingQuits);
+
+	struct Summary
+	{
+		KviChannelWindow * pChan;
+		QString szChan;
+		QString szReason;
+		QStringList lNicks;
+	};
+	std::vector<Summary> lSummaries;
+	std::map<std::pair<KviChannelWindow *, QString>, size_t> hSummaries;
+
+	KviConsoleWindow * pConsole = m_pConnection->console();
+	kvi_time_t tNow = kvi_unixTime();
+	bool bEvents = KVI_OPTION_BOOL(KviOption_boolNetsplitPerUserEvents) && KviKvsEventManager::instance()->hasAppHandlers(KviEvent_OnQuit);
+
+	for(auto & q : lQuits)
+	{
+		bool bHalt = false;
+
+		if(bEvents)
+		{
+			QString szChanList;
+			for(auto & c : m_pConnection->channelsOf(q.szNick))
+			{
+				if(!szChanList.isEmpty())
+					szChanList.append(',');
+				szChanList.append(c->windowName());
+			}
+
+			KviKvsVariantList vList;
+			vList.append(q.szNick);
+			vList.append(q.szUser);
+			vList.append(q.szHost);
+			vList.append(q.szReason);
+			vList.append(szChanList);
+
+			bHalt = KviKvsEventManager::instance()->trigger(KviEvent_OnQuit, pConsole, &vList);
+		}
+
+		for(auto & c : m_pConnection->channelsOf(q.szNick))
+		{
+			std::pair<KviChannelWindow *, QString> key(c, q.szReason);
+			auto it = hSummaries.find(key);
+			if(it == hSummaries.end())
+			{
+				c->enableUserListUpdates(false);
+				it = hSummaries.insert(std::make_pair(key, lSummaries.size())).first;
+				lSummaries.push_back({ c, c->windowName(), q.szReason, QStringList() });
+			}
+			if(c->part(q.szNick) && !bHalt)
+				lSummaries[it->second].lNicks.append(q.szNick);
+		}
+
+		if(!bHalt)
+		{
+			KviQueryWindow * pQuery = m_pConnection->findQuery(q.szNick);
+			if(pQuery)
+			{
+				QString szQuitMsg = q.szReason;
+				szQuitMsg.prepend("NETSPLIT ");
+				pQuery->output(KVI_OUT_QUIT, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] has quit IRC: %Q"),
+				    &(q.szNick), &(q.szUser), &(q.szHost), &szQuitMsg);
+			}
+		}
+
+		m_hSplitNicks.insert(nickKey(q.szNick), tNow);
+	}
+
+	for(auto & s : lSummaries)
+	{
+		// a script might have closed it
+		if(m_pConnection->findChannel(s.szChan) != s.pChan)
+			continue;
+		s.pChan->enableUserListUpdates(true);
+
+		if(s.lNicks.isEmpty())
+			continue;
+
+		if(s.lNicks.count() == 1)
+		{
+			QString szQuitMsg = s.szReason;
+			szQuitMsg.prepend("NETSPLIT ");
+			s.pChan->output(KVI_OUT_QUIT, __tr2qs("\r!n\r%Q\r has quit IRC: %Q"), &(s.lNicks.first()), &szQuitMsg);
+			continue;
+		}
+
+		QString szList = summaryNickList(s.lNicks);
+		s.pChan->output(KVI_OUT_QUITSPLIT, __tr2qs("Netsplit %Q: %d users have quit \r!c\r%Q\r: %Q"),
+		    &(s.szReason), s.lNicks.count(), &(s.szChan), &szList);
+	}
+
+	// forget the old splits
+	if(m_hSplitNicks.count() > 4 * (int)lQuits.size())
+	{
+		QHash<QString, kvi_time_t>::iterator it = m_hSplitNicks.begin();
+		while(it != m_hSplitNicks.end())
+		{
+			if((tNow - it.value()) >= KVI_NETSPLIT_NETJOIN_TIMEOUT)
+				it = m_hSplitNicks.erase(it);
+			else
+				++it;
+		}
+	}
+}
+
+void KviIrcConnectionNetsplitDetectorData::flushJoins()
+{
+	if(m_PendingJoins.empty())
+		return;
+
+	std::vector<PendingJoin> lJoins;
+	lJoins.swap(m_PendingJoins);
+
+	struct Summary
+	{
+		KviChannelWindow * pChan;
+		QString szChan;
+		QStringList lNicks;
+	};
+	std::vector<Summary> lSummaries;
+	std::map<KviChannelWindow *, size_t> hSummaries;
+
+	KviConsoleWindow * pConsole = m_pConnection->console();
+	bool bEvents = KVI_OPTION_BOOL(KviOption_boolNetsplitPerUserEvents);
+
+	for(auto & j : lJoins)
+	{
+		// the channel might have been closed in the meantime
+		KviChannelWindow * pChan = m_pConnection->findChannel(j.szChan);
+		if(!pChan)
+			continue;
+
+		auto it = hSummaries.find(pChan);
+		if(it == hSummaries.end())
+		{
+			pChan->enableUserListUpdates(false);
+			it = hSummaries.insert(std::make_pair(pChan, lSummaries.size())).first;
+			lSummaries.push_back({ pChan, pChan->windowName(), QStringList() });
+		}
+
+		KviUserListEntry * pEntry = pChan->join(j.szNick, j.szUser, j.szHost, j.iFlags);
+		if(!(pEntry->globalData()->avatar()))
+			pConsole->checkDefaultAvatar(pEntry->globalData(), j.szNick, j.szUser, j.szHost);
+
+		if(!j.szAccount.isEmpty())
+		{
+			KviIrcUserEntry * e = m_pConnection->userDataBase()->find(j.szNick);
+			if(e)
+			{
+				if(j.szAccount == "*")
+					e->setAccountName("");
+				else
+					e->setAccountName(j.szAccount);
+				e->setRealName(j.szReal);
+			}
+		}
+
+		bool bHalt = false;
+		if(bEvents)
+			bHalt = KVS_TRIGGER_EVENT_3_HALTED(KviEvent_OnJoin, pChan, j.szNick, j.szUser, j.szHost);
+
+		if(!bHalt)
+			lSummaries[it->second].lNicks.append(j.szNick);
+
+		KviQueryWindow * pQuery = m_pConnection->findQuery(j.szNick);
+		if(pQuery)
+		{
+			if(KVI_OPTION_BOOL(KviOption_boolEnableQueryTracing))
+			{
+				QString szChans;
+				int iChans = m_pConnection->getCommonChannels(j.szNick, szChans);
+				pQuery->output(KVI_OUT_QUERYTRACE,
+				    __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] has just joined \r!c\r%Q\r"), &(j.szNick), &(j.szUser),
+				    &(j.szHost), &(j.szChan));
+				pQuery->notifyCommonChannels(j.szNick, j.szUser, j.szHost, iChans, szChans);
+			}
+			else
+			{
+				pQuery->updateLabelText();
+			}
+		}
+	}
+
+	for(auto & s : lSummaries)
+	{
+		if(m_pConnection->findChannel(s.szChan) != s.pChan)
+			continue;
+		s.pChan->enableUserListUpdates(true);
+
+		if(s.lNicks.isEmpty())
+			continue;
+
+		if(s.lNicks.count() == 1)
+		{
+			s.pChan->output(KVI_OUT_JOIN, __tr2qs("\r!n\r%Q\r has rejoined \r!c\r%Q\r after a netsplit"),
+			    &(s.lNicks.first()), &(s.szChan));
+			continue;
+		}
+
+		QString szList = summaryNickList(s.lNicks);
+		s.pChan->output(KVI_OUT_JOIN, __tr2qs("Netjoin: %d users have rejoined \r!c\r%Q\r: %Q"),
+		    s.lNicks.count(), &(s.szChan), &szList);
+	}
+}
@@ -27,23 +27,98 @@
 #include "kvi_settings.h"
 #include "KviTimeUtils.h"
 
+#include <QHash>
+#include <QObject>
 #include <QString>
+#include <QTimer>
 
-class KVIRC_API KviIrcConnectionNetsplitDetectorData
+#include <vector>
+
+class KviIrcConnection;
+
+//
+// Besides detecting the netsplit QUIT messages this class coalesces
+// the QUIT and JOIN storms that come with the netsplits and the netjoins.
+//
+// The QUITs with a netsplit reason and the JOINs of the users that have
+// recently split are buffered for a short window and then applied to the
+// channel user lists in a single batch (with the list updates disabled).
+// Each channel gets one summary line instead of one line per user.
+// The per-user OnQuit and OnJoin events are triggered only if
+// KviOption_boolNetsplitPerUserEvents is set.
+//
+// The buffered messages must be applied before anything else looks
+// at the user lists: the server parser calls flush() before any
+// message that isn't a QUIT or a JOIN and the QUIT and JOIN handlers
+// call it before processing any message that isn't coalesced.
+//
+
+class KVIRC_API KviIrcConnectionNetsplitDetectorData : public QObject
 {
+	Q_OBJECT
 public:
-	KviIrcConnectionNetsplitDetectorData();
+	KviIrcConnectionNetsplitDetectorData(KviIrcConnection * pConnection);
 	~KviIrcConnectionNetsplitDetectorData();
 
 protected:
+	struct PendingQuit
+	{
+		QString szNick;
+		QString szUser;
+		QString szHost;
+		QString szReason;
+	};
+
+	struct PendingJoin
+	{
+		QString szChan;
+		QString szNick;
+		QString szUser;
+		QString szHost;
+		QString szAccount;
+		QString szReal;
+		int iFlags;
+	};
+
+	KviIrcConnection * m_pConnection;
 	QString m_szLastNetsplitOnQuitReason;
 	kvi_time_t m_tLastNetsplitOnQuit = 0;
+	std::vector<PendingQuit> m_PendingQuits;
+	std::vector<PendingJoin> m_PendingJoins;
+	// folded nicknames of the buffered QUITs and JOINs
+	QHash<QString, int> m_hPendingNicks;
+	// folded nicknames of the users that have recently split, with the split time
+	QHash<QString, kvi_time_t> m_hSplitNicks;
+	QTimer m_timer;
 
 public:
 	const QString & lastNetsplitOnQuitReason() const { return m_szLastNetsplitOnQuitReason; }
 	void setLastNetsplitOnQuitReason(const QString & szReason) { m_szLastNetsplitOnQuitReason = szReason; }
 	kvi_time_t lastNetsplitOnQuitTime() const { return m_tLastNetsplitOnQuit; }
 	void setLastNetsplitOnQuitTime(kvi_time_t t) { m_tLastNetsplitOnQuit = t; }
+
+	bool hasPending() const { return !m_hPendingNicks.isEmpty(); }
+	// true if a QUIT or a JOIN of the user is buffered
+	bool isPending(const QString & szNick) const;
+	// true if the JOIN of the user should be coalesced as part of a netjoin
+	bool isNetjoin(const QString & szNick);
+
+	// buffer a QUIT with a netsplit reason
+	void queueQuit(const QString & szNick, const QString & szUser, const QString & szHost, const QString & szReason);
+	// buffer a JOIN of a user that has recently split
+	void queueJoin(const QString & szChan, const QString & szNick, const QString & szUser, const QString & szHost, int iFlags, const QString & szAccount, const QString & szReal);
+
+	// apply the buffered messages
+	void flush();
+
+protected:
+	// the nickname folded with the server CASEMAPPING
+	QString nickKey(const QString & szNick) const;
+	void schedule();
+	void flushQuits();
+	void flushJoins();
+protected slots:
+	void timerShot();
 };
 
 #endif //!_KVI_IRCCONNECTIONNETSPLITDETECTORDATA_H_
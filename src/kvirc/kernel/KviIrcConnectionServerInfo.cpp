@@ -232,6 +232,46 @@ kvi_u32_t KviIrcConnectionServerInfo::modeFlagFromModeChar(QChar c) const
 	return 0;
 }
 
+QString KviIrcConnectionServerInfo::foldCase(const QString & szName) const
+{
+	QString szFolded = szName;
+	QChar * p = szFolded.data();
+	QChar * e = p + szFolded.length();
+	for(; p < e; p++)
+	{
+		ushort c = p->unicode();
+		if(c >= 128)
+		{
+			*p = p->toLower();
+			continue;
+		}
+		if((c >= 'A') && (c <= 'Z'))
+		{
+			*p = QChar(c + ('a' - 'A'));
+			continue;
+		}
+		if(m_eCaseMapping == CaseMappingAscii)
+			continue;
+		switch(c)
+		{
+			case '[':
+				*p = QChar('{');
+				break;
+			case ']':
+				*p = QChar('}');
+				break;
+			case '\\':
+				*p = QChar('|');
+				break;
+			case '~':
+				if(m_eCaseMapping == CaseMappingRfc1459)
+					*p = QChar('^');
+				break;
+		}
+	}
+	return szFolded;
+}
+
 void KviIrcConnectionServerInfo::setServerVersion(const QString & version)
 {
 	if(m_pServInfo)
@@ -293,6 +293,15 @@ class KVIRC_API KviIrcConnectionServerInfo
 	friend class KviIrcServerParser;
 	friend class KviIrcConnection;
 
+public:
+	// the ISUPPORT CASEMAPPING values we know about
+	enum CaseMapping
+	{
+		CaseMappingAscii,        // A-Z are the uppercase of a-z
+		CaseMappingRfc1459,      // ascii plus []\~ being the uppercase of {}|^ (the default)
+		CaseMappingStrictRfc1459 // ascii plus []\ being the uppercase of {}|
+	};
+
 protected:
 	KviIrcConnectionServerInfo();
 	~KviIrcConnectionServerInfo();
@@ -324,6 +333,7 @@ private:
 	bool m_bSupportsCap = false;
 	QStringList m_lSupportedCaps;
 	bool m_bSupportsWhox = false; // supports WHOX
+	CaseMapping m_eCaseMapping = CaseMappingRfc1459;
 public:
 	char registerModeChar() const { return m_pServInfo ? m_pServInfo->getRegisterModeChar() : 0; }
 	const char * software() const { return m_pServInfo ? m_pServInfo->getSoftware() : 0; }
@@ -346,6 +356,12 @@ public:
 	bool supportsWatchList() const { return m_bSupportsWatchList; }
 	bool supportsCodePages() const { return m_bSupportsCodePages; }
 	bool supportsWhox() const { return m_bSupportsWhox; }
+	CaseMapping caseMapping() const { return m_eCaseMapping; }
+
+	// Returns the nickname or channel name folded to lowercase with the server CASEMAPPING:
+	// two names are equivalent on this server if and only if their folded forms are equal.
+	// Non ASCII characters are folded with the Unicode rules (the server CASEMAPPING doesn't cover them).
+	QString foldCase(const QString & szName) const;
 
 	int maxTopicLen() const { return m_iMaxTopicLen; }
 	int maxModeChanges() const { return m_iMaxModeChanges; }
@@ -381,6 +397,7 @@ protected:
 	void setMaxTopicLen(int iTopLen) { m_iMaxTopicLen = iTopLen; }
 	void setMaxModeChanges(int iModes) { m_iMaxModeChanges = iModes; }
 	void setSupportsWhox(bool bSupportsWhox) { m_bSupportsWhox = bSupportsWhox; }
+	void setCaseMapping(CaseMapping eCaseMapping) { m_eCaseMapping = eCaseMapping; }
 private:
 	void buildModePrefixTable();
 };
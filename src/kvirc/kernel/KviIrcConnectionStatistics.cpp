@@ -23,9 +23,146 @@
 //=============================================================================
 
 #include "KviIrcConnectionStatistics.h"
+#include "KviIrcUserDataBase.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <chrono>
 
 KviIrcConnectionStatistics::KviIrcConnectionStatistics()
-    = default;
+{
+	m_uTelemetryStart = telemetryClock();
+}
 
 KviIrcConnectionStatistics::~KviIrcConnectionStatistics()
     = default;
+
+kvi_u64_t KviIrcConnectionStatistics::telemetryClock()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void KviIrcConnectionStatistics::messageDispatched(const char * pcMessage, kvi_u64_t uUSecs)
+{
+	m_dispatchLatency.record(uUSecs);
+
+	// skip the message tags and the prefix
+	const char * p = pcMessage;
+	if(*p == '@')
+	{
+		while(*p && (*p != ' '))
+			p++;
+		while(*p == ' ')
+			p++;
+	}
+	if(*p == ':')
+	{
+		while(*p && (*p != ' '))
+			p++;
+		while(*p == ' ')
+			p++;
+	}
+	const char * pcBegin = p;
+	while(*p && (*p != ' '))
+		p++;
+	if(p == pcBegin)
+		return;
+
+	// a buggy or hostile server could send any number of distinct tokens:
+	// past the limit the new ones are counted together
+	std::string szCommand(pcBegin, p - pcBegin);
+	std::unordered_map<std::string, CommandTelemetry>::iterator it = m_hCommands.find(szCommand);
+	if(it == m_hCommands.end())
+	{
+		if(m_hCommands.size() >= KVI_IRCCONNECTIONSTATISTICS_MAX_COMMANDS)
+			szCommand = KVI_IRCCONNECTIONSTATISTICS_OTHER_COMMANDS;
+		it = m_hCommands.emplace(szCommand, CommandTelemetry()).first;
+	}
+	CommandTelemetry & t = it->second;
+	t.uCount++;
+	t.uTotalUSecs += uUSecs;
+	if(uUSecs > t.uMaxUSecs)
+		t.uMaxUSecs = uUSecs;
+}
+
+void KviIrcConnectionStatistics::resetTelemetry()
+{
+	m_readSize.reset();
+	m_dispatchLatency.reset();
+	m_sendQueueWait.reset();
+	m_lag.reset();
+	m_hCommands.clear();
+	for(unsigned int i = 0; i < FastPathCount; i++)
+	{
+		m_uFastPathChecks[i] = 0;
+		m_uFastPathRejects[i] = 0;
+	}
+	if(m_pUserDataBase)
+		m_pUserDataBase->resetLookupCounters();
+	m_uTelemetryStart = telemetryClock();
+}
+
+kvi_u64_t KviIrcConnectionStatistics::ignoreChecks() const
+{
+	return m_pUserDataBase ? m_pUserDataBase->registeredUserLookups() : 0;
+}
+
+kvi_u64_t KviIrcConnectionStatistics::ignoreRejects() const
+{
+	return m_pUserDataBase ? m_pUserDataBase->registeredUserFastRejects() : 0;
+}
+
+static QJsonObject histogram_to_json(const KviHistogram & h)
+{
+	QJsonObject o;
+	o.insert("count", (double)h.count());
+	o.insert("mean", h.mean());
+	o.insert("max", (double)h.max());
+	o.insert("p50", (double)h.percentile(50.0));
+	o.insert("p90", (double)h.percentile(90.0));
+	o.insert("p99", (double)h.percentile(99.0));
+	o.insert("p999", (double)h.percentile(99.9));
+
+	std::vector<KviHistogram::Bucket> lBuckets;
+	h.buckets(lBuckets);
+	QJsonArray a;
+	for(auto & b : lBuckets)
+		a.append(QJsonArray({ (double)b.uLow, (double)b.uHigh, (double)b.uCount }));
+	o.insert("buckets", a);
+	return o;
+}
+
+QByteArray KviIrcConnectionStatistics::telemetryJson() const
+{
+	kvi_u64_t uTime = telemetryTime();
+	double dSecs = (double)uTime / 1000000.0;
+
+	QJsonObject o;
+	o.insert("elapsed_usecs", (double)uTime);
+	o.insert("read_size_bytes", histogram_to_json(m_readSize));
+	o.insert("dispatch_latency_usecs", histogram_to_json(m_dispatchLatency));
+	o.insert("send_queue_wait_usecs", histogram_to_json(m_sendQueueWait));
+	o.insert("lag_msecs", histogram_to_json(m_lag));
+
+	QJsonObject c;
+	for(auto & it : m_hCommands)
+	{
+		QJsonObject e;
+		e.insert("count", (double)it.second.uCount);
+		e.insert("rate", (dSecs > 0.0) ? (double)it.second.uCount / dSecs : 0.0);
+		e.insert("dispatch_total_usecs", (double)it.second.uTotalUSecs);
+		e.insert("dispatch_max_usecs", (double)it.second.uMaxUSecs);
+		c.insert(QString::fromLatin1(it.first.c_str()), e);
+	}
+	o.insert("commands", c);
+
+	QJsonObject f;
+	f.insert("ignore", QJsonObject({ { "checks", (double)ignoreChecks() }, { "rejects", (double)ignoreRejects() } }));
+	f.insert("antispam", QJsonObject({ { "checks", (double)m_uFastPathChecks[FastPathAntiSpam] }, { "rejects", (double)m_uFastPathRejects[FastPathAntiSpam] } }));
+	f.insert("highlight", QJsonObject({ { "checks", (double)m_uFastPathChecks[FastPathHighlight] }, { "rejects", (double)m_uFastPathRejects[FastPathHighlight] } }));
+	o.insert("fastpath", f);
+
+	return QJsonDocument(o).toJson(QJsonDocument::Compact);
+}
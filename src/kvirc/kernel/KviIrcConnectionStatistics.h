@@ -25,13 +25,53 @@
 //=============================================================================
 
 #include "kvi_settings.h"
+#include "kvi_inttypes.h"
 #include "KviQString.h"
 #include "KviTimeUtils.h"
+#include "KviHistogram.h"
+
+#include <QByteArray>
+
+class KviIrcUserDataBase;
+
+#include <string>
+#include <unordered_map>
+
+// distinct commands counted by messageDispatched(), the numerics included
+#define KVI_IRCCONNECTIONSTATISTICS_MAX_COMMANDS 256
+// the bucket of the commands past the limit (never a valid command)
+#define KVI_IRCCONNECTIONSTATISTICS_OTHER_COMMANDS "*other*"
+
+//
+// The telemetry below is collected only when
+// KviOption_boolEnableConnectionTelemetry is set:
+// when it's not the cost is a single option check per event.
+//
+// The fast path counters are always collected: they tell how often the
+// message filters (ignore, anti-spam and highlighting) rejected a message
+// without running their full checks.
+//
 
 class KVIRC_API KviIrcConnectionStatistics
 {
 	friend class KviIrcConnection;
 
+public:
+	enum FastPath
+	{
+		FastPathAntiSpam,
+		FastPathHighlight,
+		FastPathCount
+	};
+
+	// the received messages of a command and the time spent dispatching them
+	struct CommandTelemetry
+	{
+		kvi_u64_t uCount = 0;
+		kvi_u64_t uTotalUSecs = 0;
+		kvi_u64_t uMaxUSecs = 0;
+	};
+
 public:
 	KviIrcConnectionStatistics();
 	~KviIrcConnectionStatistics();
@@ -39,12 +79,53 @@ public:
 protected:
 	kvi_time_t m_tConnectionStart = 0; // (valid only when Connected or LoggingIn)
 	kvi_time_t m_tLastMessage = 0;     // last message received from server
+
+	KviHistogram m_readSize;        // bytes per socket read
+	KviHistogram m_dispatchLatency; // usecs spent parsing and dispatching a message
+	KviHistogram m_sendQueueWait;   // usecs spent by a message in the send queue
+	KviHistogram m_lag;             // msecs, the raw lag meter samples
+	std::unordered_map<std::string, CommandTelemetry> m_hCommands;
+	kvi_u64_t m_uTelemetryStart; // telemetryClock() at the creation or the last reset
+	kvi_u64_t m_uFastPathChecks[FastPathCount] = {};
+	kvi_u64_t m_uFastPathRejects[FastPathCount] = {};
+	KviIrcUserDataBase * m_pUserDataBase = nullptr; // for its registered user lookup counters
 public:
 	kvi_time_t connectionStartTime() const { return m_tConnectionStart; }
 	kvi_time_t lastMessageTime() const { return m_tLastMessage; }
+
+	KviHistogram & readSize() { return m_readSize; }
+	KviHistogram & dispatchLatency() { return m_dispatchLatency; }
+	KviHistogram & sendQueueWait() { return m_sendQueueWait; }
+	KviHistogram & lag() { return m_lag; }
+	// the received messages and their dispatch time by command
+	const std::unordered_map<std::string, CommandTelemetry> & commands() const { return m_hCommands; }
+	// usecs since the telemetry started
+	kvi_u64_t telemetryTime() const { return telemetryClock() - m_uTelemetryStart; }
+
+	void fastPathChecked(FastPath eFastPath, bool bRejected)
+	{
+		m_uFastPathChecks[eFastPath]++;
+		if(bRejected)
+			m_uFastPathRejects[eFastPath]++;
+	}
+	kvi_u64_t fastPathChecks(FastPath eFastPath) const { return m_uFastPathChecks[eFastPath]; }
+	kvi_u64_t fastPathRejects(FastPath eFastPath) const { return m_uFastPathRejects[eFastPath]; }
+	// the registered user lookups (for the ignore checks) that missed the cache and how many were rejected by the filters
+	kvi_u64_t ignoreChecks() const;
+	kvi_u64_t ignoreRejects() const;
+
+	// counts the message and records its dispatch latency
+	void messageDispatched(const char * pcMessage, kvi_u64_t uUSecs);
+	void resetTelemetry();
+	QByteArray telemetryJson() const;
+
+	// a monotonic clock in usecs
+	static kvi_u64_t telemetryClock();
+
 protected:
 	void setLastMessageTime(kvi_time_t t) { m_tLastMessage = t; }
 	void setConnectionStartTime(kvi_time_t t) { m_tConnectionStart = t; }
+	void setUserDataBase(KviIrcUserDataBase * pUserDataBase) { m_pUserDataBase = pUserDataBase; }
 };
 
 #endif //!_KVI_IRCCONNECTIONSTATISTICS_H_
@@ -38,6 +38,7 @@
 #include "KviIrcLink.h"
 #include "KviIrcConnection.h"
 #include "KviDataBuffer.h"
+#include "KviIrcConnectionStatistics.h"
 
 #ifdef COMPILE_SSL_SUPPORT
 #include "KviSSLMaster.h"
@@ -528,7 +529,12 @@ void KviIrcSocket::enterSSLMode()
 {
 	Q_ASSERT(!m_pSSL); // Don't call this function twice in a session
 
-	m_pSSL = KviSSLMaster::allocSSL(m_pConsole, m_sock, KviSSL::Client);
+	// reconnects to the same server resume the previous TLS session
+	QString szSessionKey;
+	if(m_pIrcServer)
+		szSessionKey = QString("%1:%2").arg(m_pIrcServer->hostName()).arg(m_pIrcServer->port());
+
+	m_pSSL = KviSSLMaster::allocSSL(m_pConsole, m_sock, KviSSL::Client, nullptr, szSessionKey);
 	if(!m_pSSL)
 	{
 		raiseSSLError();
@@ -1513,6 +1519,9 @@ void KviIrcSocket::readData(int)
 
 	m_uReadBytes += iReadLength;
 
+	if(KVI_OPTION_BOOL(KviOption_boolEnableConnectionTelemetry))
+		m_pLink->connection()->statistics()->readSize().record(iReadLength);
+
 	// Shut up the socket notifier
 	// in case that we enter in a local loop somewhere
 	// while processing data...
@@ -1582,6 +1591,7 @@ void KviIrcSocket::queue_insertMessage(KviIrcSocketMsgEntry * pMsg)
 	KVI_ASSERT(pMsg);
 
 	pMsg->next_ptr = nullptr;
+	pMsg->uQueueTime = KVI_OPTION_BOOL(KviOption_boolEnableConnectionTelemetry) ? KviIrcConnectionStatistics::telemetryClock() : 0;
 
 	if(m_pSendQueueHead)
 	{
@@ -1714,6 +1724,8 @@ void KviIrcSocket::flushSendQueue()
 			// Successful send...remove this data buffer
 			m_uSentPackets++;
 			m_uSentBytes += iResult;
+			if(m_pSendQueueHead->uQueueTime && KVI_OPTION_BOOL(KviOption_boolEnableConnectionTelemetry))
+				m_pLink->connection()->statistics()->sendQueueWait().record(KviIrcConnectionStatistics::telemetryClock() - m_pSendQueueHead->uQueueTime);
 			//if(m_pConsole->hasMonitors())outgoingMessageNotifyMonitors((char *)(m_pSendQueueHead->pData->data()),result);
 			queue_removeMessage();
 			if(KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic))
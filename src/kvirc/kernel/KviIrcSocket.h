@@ -33,6 +33,7 @@
 #include "kvi_settings.h"
 #include "kvi_socket.h"
 #include "kvi_sockettype.h"
+#include "kvi_inttypes.h"
 #include "KviCString.h"
 #include "KviError.h"
 #include "KviPointerList.h"
@@ -62,6 +63,7 @@ struct KviIrcSocketMsgEntry
 {
 	KviDataBuffer * pData;
 	KviIrcSocketMsgEntry * next_ptr;
+	kvi_u64_t uQueueTime; // KviIrcConnectionStatistics::telemetryClock() or 0 if the telemetry is off
 };
 
 /**
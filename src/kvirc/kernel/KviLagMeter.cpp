@@ -33,6 +33,7 @@
 #include "KviTimeUtils.h"
 #include "KviIrcConnectionUserInfo.h"
 #include "KviIrcConnectionServerInfo.h"
+#include "KviIrcConnectionStatistics.h"
 #include "kvi_out.h"
 #include "KviLocale.h"
 
@@ -235,6 +236,9 @@ bool KviLagMeter::lagCheckComplete(const char * key)
 	else
 		uLag += ((tv.tv_usec - c->lUSecs) / 1000);
 
+	if(KVI_OPTION_BOOL(KviOption_boolEnableConnectionTelemetry))
+		m_pConnection->statistics()->lag().record(uLag);
+
 	// now check the reliability
 
 	if(m_uLastReliability > c->uReliability)
@@ -0,0 +1,658 @@
+//=============================================================================
+//
+//   File : KviLogWriter.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviLogWriter.h"
+#include "KviLogFrames.h"
+#include "KviOptions.h"
+
+#include <QFile>
+#include <QSemaphore>
+
+#include <cstring>
+
+#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
+#include <io.h>
+#else
+#include <errno.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// the producers stall when the queued data exceeds this size...
+#define KVI_LOGWRITER_HIGH_WATERMARK (8 * 1024 * 1024)
+// ...and drop the record if the writer doesn't catch up in this time (msecs)
+#define KVI_LOGWRITER_MAX_STALL 250
+// maximum number of records drained at once
+#define KVI_LOGWRITER_MAX_BATCH 4096
+// the compressed text is made readable at least this often (msecs)
+#define KVI_LOGWRITER_FRAME_SYNC_INTERVAL 1000
+
+#if defined(IOV_MAX) && (IOV_MAX < 256)
+#define KVI_LOGWRITER_MAX_IOV IOV_MAX
+#else
+#define KVI_LOGWRITER_MAX_IOV 256
+#endif
+
+struct KviLogWriter::File
+{
+	struct Chunk
+	{
+		QByteArray data;
+		kvi_u32_t uTime;
+	};
+
+	QFile * pFile;              // opened unbuffered
+	std::vector<Chunk> pending; // collected in the current batch
+	bool bDirty;                // written since the last sync
+#ifdef COMPILE_ZLIB_SUPPORT
+	KviLogFrameWriter * pFrames; // only for the compressed logs
+	bool bPrepared;
+#endif
+};
+
+KviLogWriter * KviLogWriter::m_pInstance = nullptr;
+
+KviLogWriter::KviLogWriter()
+    : QThread()
+{
+	m_Stub.pNext.store(nullptr);
+	m_pHead.store(&m_Stub);
+	m_pTail = &m_Stub;
+	m_uQueuedRecords.store(0);
+	m_uQueuedBytes.store(0);
+	m_iNextFileId.store(0);
+	m_uSyncPolicy.store(SyncNever);
+	m_bTerminating.store(false);
+	m_bWriterSleeping.store(false);
+	m_uStalledProducers.store(0);
+	memset(&m_Statistics, 0, sizeof(m_Statistics));
+}
+
+KviLogWriter::~KviLogWriter()
+{
+	// the thread has already drained the queue and closed the files
+	while(Record * r = pop())
+		delete r;
+}
+
+void KviLogWriter::init()
+{
+	if(m_pInstance)
+		return;
+	m_pInstance = new KviLogWriter();
+	m_pInstance->setSyncPolicy(KVI_OPTION_UINT(KviOption_uintLogSyncPolicy));
+	m_pInstance->start();
+}
+
+void KviLogWriter::done()
+{
+	if(!m_pInstance)
+		return;
+
+	KviLogWriter * pWriter = m_pInstance;
+	m_pInstance = nullptr;
+
+	pWriter->m_bTerminating.store(true);
+	pWriter->m_Mutex.lock();
+	pWriter->m_WorkAvailable.wakeAll();
+	pWriter->m_Mutex.unlock();
+
+	// this flushes everything that is still queued
+	pWriter->wait();
+	delete pWriter;
+}
+
+void KviLogWriter::setSyncPolicy(unsigned int uPolicy)
+{
+	m_uSyncPolicy.store(uPolicy > SyncAlways ? SyncAlways : uPolicy);
+}
+
+void KviLogWriter::statistics(Statistics & s)
+{
+	m_StatisticsMutex.lock();
+	s = m_Statistics;
+	m_StatisticsMutex.unlock();
+}
+
+//
+// The queue is the classic intrusive MPSC list: a producer swaps itself
+// in as the new head and then links the previous head to itself.
+// Between the two steps the list is temporarily "broken" and pop()
+// returns nothing: the writer just retries later.
+//
+
+void KviLogWriter::push(Record * r)
+{
+	r->pNext.store(nullptr, std::memory_order_relaxed);
+	Record * pPrev = m_pHead.exchange(r, std::memory_order_acq_rel);
+	pPrev->pNext.store(r, std::memory_order_release);
+}
+
+KviLogWriter::Record * KviLogWriter::pop()
+{
+	Record * pTail = m_pTail;
+	Record * pNext = pTail->pNext.load(std::memory_order_acquire);
+
+	if(pTail == &m_Stub)
+	{
+		if(!pNext)
+			return nullptr;
+		m_pTail = pNext;
+		pTail = pNext;
+		pNext = pNext->pNext.load(std::memory_order_acquire);
+	}
+
+	if(pNext)
+	{
+		m_pTail = pNext;
+		return pTail;
+	}
+
+	if(pTail != m_pHead.load(std::memory_order_acquire))
+		return nullptr; // a producer is in the middle of push()
+
+	push(&m_Stub);
+
+	pNext = pTail->pNext.load(std::memory_order_acquire);
+	if(pNext)
+	{
+		m_pTail = pNext;
+		return pTail;
+	}
+	return nullptr;
+}
+
+void KviLogWriter::post(Record * r)
+{
+	// counted before linking: the writer may see the count before the record, never the contrary
+	m_uQueuedRecords.fetch_add(1);
+	push(r);
+
+	if(m_bWriterSleeping.load())
+	{
+		m_Mutex.lock();
+		m_WorkAvailable.wakeOne();
+		m_Mutex.unlock();
+	}
+}
+
+void KviLogWriter::post(Operation eOperation, int iFile)
+{
+	Record * r = new Record;
+	r->eOperation = eOperation;
+	r->iFile = iFile;
+	post(r);
+}
+
+int KviLogWriter::open(const QString & szFileName, bool bCompressed)
+{
+	QSemaphore done;
+	bool bResult = false;
+
+	Record * r = new Record;
+	r->eOperation = Open;
+	r->iFile = m_iNextFileId.fetch_add(1);
+	r->szFileName = szFileName;
+	r->bCompressed = bCompressed;
+	r->pDone = &done;
+	r->pbResult = &bResult;
+
+	int iFile = r->iFile;
+	post(r);
+	done.acquire();
+
+	return bResult ? iFile : -1;
+}
+
+void KviLogWriter::write(int iFile, const QByteArray & data, kvi_u32_t uTime)
+{
+	kvi_u64_t uSize = data.size();
+
+	if(m_uQueuedBytes.load() + uSize > KVI_LOGWRITER_HIGH_WATERMARK)
+	{
+		// the writer is lagging behind: give it a chance to catch up
+		QElapsedTimer t;
+		t.start();
+
+		m_Mutex.lock();
+		m_uStalledProducers.fetch_add(1);
+		while(m_uQueuedBytes.load() + uSize > KVI_LOGWRITER_HIGH_WATERMARK)
+		{
+			qint64 iLeft = KVI_LOGWRITER_MAX_STALL - t.elapsed();
+			if(iLeft <= 0)
+				break;
+			m_QueueDrained.wait(&m_Mutex, iLeft);
+		}
+		m_uStalledProducers.fetch_sub(1);
+		m_Mutex.unlock();
+
+		bool bDrop = m_uQueuedBytes.load() + uSize > KVI_LOGWRITER_HIGH_WATERMARK;
+
+		m_StatisticsMutex.lock();
+		m_Statistics.uStalls++;
+		m_Statistics.uStallTime += t.nsecsElapsed() / 1000;
+		if(bDrop)
+		{
+			m_Statistics.uDroppedRecords++;
+			m_Statistics.uDroppedBytes += uSize;
+		}
+		m_StatisticsMutex.unlock();
+
+		if(bDrop)
+			return;
+	}
+
+	Record * r = new Record;
+	r->eOperation = Write;
+	r->iFile = iFile;
+	r->data = data;
+	r->uTime = uTime;
+	m_uQueuedBytes.fetch_add(uSize);
+	post(r);
+}
+
+void KviLogWriter::flush(int iFile)
+{
+	post(Flush, iFile);
+}
+
+void KviLogWriter::close(int iFile)
+{
+	post(Close, iFile);
+}
+
+void KviLogWriter::run()
+{
+	std::vector<int> touched;
+	m_FrameSyncTimer.start();
+
+	for(;;)
+	{
+		kvi_u64_t uQueuedBytes = m_uQueuedBytes.load();
+		unsigned int uBatch = 0;
+		kvi_u64_t uRecords = 0;
+
+		while(uBatch < KVI_LOGWRITER_MAX_BATCH)
+		{
+			Record * r = pop();
+			if(!r)
+				break;
+			m_uQueuedRecords.fetch_sub(1);
+			uBatch++;
+
+			File * f = nullptr;
+			auto it = m_Files.find(r->iFile);
+			if(it != m_Files.end())
+				f = it->second;
+
+			switch(r->eOperation)
+			{
+				case Open:
+				{
+					QFile * pFile = new QFile(r->szFileName);
+					QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Unbuffered;
+#ifdef COMPILE_ZLIB_SUPPORT
+					// the compressed files are scanned (and their index stripped) by KviLogFrameWriter::prepare()
+					if(r->bCompressed)
+						mode = QIODevice::ReadWrite | QIODevice::Unbuffered;
+#endif
+					if(pFile->exists() && !(mode & QIODevice::ReadOnly))
+						mode |= QIODevice::Append;
+					if(pFile->open(mode))
+					{
+						f = new File;
+						f->pFile = pFile;
+						f->bDirty = false;
+#ifdef COMPILE_ZLIB_SUPPORT
+						f->pFrames = r->bCompressed ? new KviLogFrameWriter(pFile) : nullptr;
+						f->bPrepared = false;
+#endif
+						m_Files[r->iFile] = f;
+						*(r->pbResult) = true;
+					}
+					else
+					{
+						delete pFile;
+					}
+					r->pDone->release();
+					// don't touch pDone and pbResult anymore: they live on the stack of open()
+				}
+				break;
+				case Write:
+					m_uQueuedBytes.fetch_sub(r->data.size());
+					if(f)
+					{
+						if(f->pending.empty())
+							touched.push_back(r->iFile);
+						f->pending.push_back({ std::move(r->data), r->uTime });
+						uRecords++;
+					}
+					break;
+				case Flush:
+					if(f)
+					{
+						commit(f);
+#ifdef COMPILE_ZLIB_SUPPORT
+						if(f->pFrames)
+						{
+							f->pFrames->finishFrame();
+							writeFrames(f);
+						}
+#endif
+						if(m_uSyncPolicy.load() != SyncNever)
+							sync(f);
+					}
+					break;
+				case Close:
+					if(f)
+					{
+						closeFile(f);
+						m_Files.erase(it);
+					}
+					break;
+			}
+
+			delete r;
+		}
+
+		// group commit
+		for(auto iFile : touched)
+		{
+			auto it = m_Files.find(iFile);
+			if(it == m_Files.end())
+				continue;
+			commit(it->second);
+			if(m_uSyncPolicy.load() == SyncAlways)
+				sync(it->second);
+		}
+		touched.clear();
+
+		if(m_FrameSyncTimer.elapsed() >= KVI_LOGWRITER_FRAME_SYNC_INTERVAL)
+			syncFrames();
+
+		if(uBatch)
+		{
+			m_StatisticsMutex.lock();
+			m_Statistics.uBatches++;
+			m_Statistics.uRecords += uRecords;
+			if(uBatch > m_Statistics.uMaxBatchRecords)
+				m_Statistics.uMaxBatchRecords = uBatch;
+			if(uQueuedBytes > m_Statistics.uMaxQueuedBytes)
+				m_Statistics.uMaxQueuedBytes = uQueuedBytes;
+			m_Statistics.uOpenFiles = m_Files.size();
+			m_StatisticsMutex.unlock();
+
+			if(m_uStalledProducers.load())
+			{
+				m_Mutex.lock();
+				m_QueueDrained.wakeAll();
+				m_Mutex.unlock();
+			}
+			continue;
+		}
+
+		if(m_uQueuedRecords.load())
+		{
+			// a producer is still linking its record
+			QThread::yieldCurrentThread();
+			continue;
+		}
+
+		if(m_bTerminating.load())
+			break;
+
+		// wake up in time to flush the compressed text
+		bool bFramesDirty = false;
+#ifdef COMPILE_ZLIB_SUPPORT
+		for(auto & it : m_Files)
+		{
+			if(it.second->pFrames && it.second->pFrames->isDirty())
+			{
+				bFramesDirty = true;
+				break;
+			}
+		}
+#endif
+
+		m_Mutex.lock();
+		m_bWriterSleeping.store(true);
+		// post() increments the counter before checking the flag: one of the two sides sees the other
+		if(!m_uQueuedRecords.load() && !m_bTerminating.load())
+		{
+			if(bFramesDirty)
+				m_WorkAvailable.wait(&m_Mutex, KVI_LOGWRITER_FRAME_SYNC_INTERVAL);
+			else
+				m_WorkAvailable.wait(&m_Mutex);
+		}
+		m_bWriterSleeping.store(false);
+		m_Mutex.unlock();
+	}
+
+	// the logs should have been closed by their views, but be safe
+	for(auto & it : m_Files)
+		closeFile(it.second);
+	m_Files.clear();
+}
+
+void KviLogWriter::closeFile(File * f)
+{
+	commit(f);
+#ifdef COMPILE_ZLIB_SUPPORT
+	if(f->pFrames)
+	{
+		// instant: the last frame is short and the index small
+		f->pFrames->finish();
+		writeFrames(f);
+		delete f->pFrames;
+	}
+#endif
+	if(m_uSyncPolicy.load() != SyncNever)
+		sync(f);
+	f->pFile->close();
+	delete f->pFile;
+	delete f;
+}
+
+void KviLogWriter::syncFrames()
+{
+#ifdef COMPILE_ZLIB_SUPPORT
+	for(auto & it : m_Files)
+	{
+		File * f = it.second;
+		if(f->pFrames && f->pFrames->isDirty())
+		{
+			f->pFrames->syncFlush();
+			writeFrames(f);
+		}
+	}
+#endif
+	m_FrameSyncTimer.restart();
+}
+
+void KviLogWriter::writeFrames(File * f)
+{
+#ifdef COMPILE_ZLIB_SUPPORT
+	QByteArray & output = f->pFrames->output();
+	if(output.isEmpty())
+		return;
+
+	bool bError = f->pFile->write(output) != output.size();
+	if(bError)
+		qDebug("WARNING: can't write to the log file.");
+
+	m_StatisticsMutex.lock();
+	m_Statistics.uWriteCalls++;
+	if(bError)
+		m_Statistics.uWriteErrors++;
+	else
+		m_Statistics.uBytes += output.size();
+	m_StatisticsMutex.unlock();
+
+	output.clear();
+	f->bDirty = true;
+#else
+	Q_UNUSED(f);
+#endif
+}
+
+void KviLogWriter::commit(File * f)
+{
+	if(f->pending.empty())
+		return;
+
+#ifdef COMPILE_ZLIB_SUPPORT
+	if(f->pFrames)
+	{
+		// the existing file is scanned (and repaired) only when the first line arrives
+		if(!f->bPrepared)
+		{
+			f->bPrepared = true;
+			if(!f->pFrames->prepare())
+			{
+				qDebug("WARNING: can't prepare the compressed log file.");
+				delete f->pFrames;
+				f->pFrames = nullptr;
+				f->pFile->close();
+			}
+		}
+
+		if(f->pFrames)
+		{
+			for(auto & c : f->pending)
+				f->pFrames->append(c.data, c.uTime);
+			if(m_uSyncPolicy.load() == SyncAlways)
+				f->pFrames->syncFlush();
+			f->pending.clear();
+			writeFrames(f);
+			return;
+		}
+	}
+#endif
+
+	kvi_u64_t uBytes = 0;
+	kvi_u64_t uCalls = 0;
+	kvi_u64_t uErrors = 0;
+
+	if(f->pFile->isOpen())
+	{
+#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
+		// no writev() here: just coalesce the records in a single write
+		QByteArray buffer;
+		int iSize = 0;
+		for(auto & c : f->pending)
+			iSize += c.data.size();
+		buffer.reserve(iSize);
+		for(auto & c : f->pending)
+			buffer.append(c.data);
+
+		uCalls++;
+		if(f->pFile->write(buffer) == -1)
+			uErrors++;
+		else
+			uBytes += buffer.size();
+#else
+		int fd = f->pFile->handle();
+		std::size_t i = 0;
+		struct iovec iov[KVI_LOGWRITER_MAX_IOV];
+
+		while(i < f->pending.size())
+		{
+			int iCount = 0;
+			while((iCount < KVI_LOGWRITER_MAX_IOV) && ((i + iCount) < f->pending.size()))
+			{
+				QByteArray & d = f->pending[i + iCount].data;
+				iov[iCount].iov_base = d.data();
+				iov[iCount].iov_len = d.size();
+				iCount++;
+			}
+			i += iCount;
+
+			// handle the short writes
+			int iFirst = 0;
+			while(iFirst < iCount)
+			{
+				ssize_t r = ::writev(fd, iov + iFirst, iCount - iFirst);
+				uCalls++;
+				if(r < 0)
+				{
+					if(errno == EINTR)
+						continue;
+					uErrors++;
+					break;
+				}
+				uBytes += r;
+				while((r > 0) && (iFirst < iCount))
+				{
+					if(((size_t)r) >= iov[iFirst].iov_len)
+					{
+						r -= iov[iFirst].iov_len;
+						iFirst++;
+					}
+					else
+					{
+						iov[iFirst].iov_base = ((char *)iov[iFirst].iov_base) + r;
+						iov[iFirst].iov_len -= r;
+						r = 0;
+					}
+				}
+			}
+		}
+#endif
+	}
+	else
+	{
+		// the compressed file couldn't be prepared
+		uErrors++;
+	}
+
+	if(uErrors)
+		qDebug("WARNING: can't write to the log file.");
+
+	f->pending.clear();
+	f->bDirty = true;
+
+	m_StatisticsMutex.lock();
+	m_Statistics.uBytes += uBytes;
+	m_Statistics.uWriteCalls += uCalls;
+	m_Statistics.uWriteErrors += uErrors;
+	m_StatisticsMutex.unlock();
+}
+
+void KviLogWriter::sync(File * f)
+{
+	if(!f->bDirty || !f->pFile->isOpen())
+		return;
+
+#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
+	_commit(f->pFile->handle());
+#else
+	::fsync(f->pFile->handle());
+#endif
+	f->bDirty = false;
+
+	m_StatisticsMutex.lock();
+	m_Statistics.uSyncs++;
+	m_StatisticsMutex.unlock();
+}
@@ -0,0 +1,177 @@
+#ifndef _KVI_LOGWRITER_H_
+#define _KVI_LOGWRITER_H_
+//=============================================================================
+//
+//   File : KviLogWriter.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "kvi_settings.h"
+#include "kvi_inttypes.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+class QSemaphore;
+
+//
+// The window logs are written by a single background thread.
+//
+// KviIrcView formats each log line exactly as it would end up in the file
+// and pushes it to a lock-free multi-producer queue: the GUI thread never
+// touches the disk while a log is open. The writer drains the queue in
+// batches, gathers the records of each file and commits them with a
+// single writev() call (group commit), then syncs the files as requested
+// by KviOption_uintLogSyncPolicy.
+//
+// The compressed logs are compressed as they are written, in the
+// framed format described in KviLogFrames.h.
+//
+// The control operations (flush and close) travel in the same queue,
+// so they're always ordered with the data.
+//
+// If the disk can't keep up, the producers stall for a while when the
+// queued data exceeds a high watermark and drop the record if the writer
+// still lags behind: both events are counted in the statistics.
+//
+
+class KVIRC_API KviLogWriter : public QThread
+{
+public:
+	enum SyncPolicy
+	{
+		SyncNever = 0,   // leave it to the operating system
+		SyncOnFlush = 1, // on flushLog() and when the log is closed
+		SyncAlways = 2   // after every batch
+	};
+
+	struct Statistics
+	{
+		kvi_u64_t uRecords;          // data records committed
+		kvi_u64_t uBytes;            // bytes written
+		kvi_u64_t uBatches;          // queue drains that found work
+		kvi_u64_t uWriteCalls;       // write system calls
+		kvi_u64_t uSyncs;            // fsync() calls
+		kvi_u64_t uMaxBatchRecords;  // largest batch seen
+		kvi_u64_t uMaxQueuedBytes;   // high water mark of the queue
+		kvi_u64_t uStalls;           // producers blocked by the backpressure
+		kvi_u64_t uStallTime;        // total time spent blocked (usecs)
+		kvi_u64_t uDroppedRecords;   // records dropped because the writer lagged behind
+		kvi_u64_t uDroppedBytes;
+		kvi_u64_t uWriteErrors;      // failed writes (the data is lost)
+		unsigned int uOpenFiles;
+	};
+
+protected:
+	KviLogWriter();
+	~KviLogWriter();
+
+protected:
+	enum Operation
+	{
+		Open,
+		Write,
+		Flush,
+		Close
+	};
+
+	struct Record
+	{
+		std::atomic<Record *> pNext;
+		Operation eOperation;
+		int iFile;
+		QByteArray data;
+		kvi_u32_t uTime;              // Write only: seconds since the epoch
+		bool bCompressed;             // Open only
+		QString szFileName;           // Open only
+		QSemaphore * pDone = nullptr; // Open only: released when the operation has been executed
+		bool * pbResult = nullptr;    // Open only
+	};
+
+	struct File;
+
+	static KviLogWriter * m_pInstance;
+
+	// the queue: producers push at m_pHead, the writer pops at m_pTail
+	std::atomic<Record *> m_pHead;
+	Record * m_pTail;
+	Record m_Stub;
+
+	std::atomic<unsigned int> m_uQueuedRecords;
+	std::atomic<kvi_u64_t> m_uQueuedBytes;
+	std::atomic<int> m_iNextFileId;
+	std::atomic<unsigned int> m_uSyncPolicy;
+	std::atomic<bool> m_bTerminating;
+
+	// used only for sleeping: the queue itself is lock free
+	QMutex m_Mutex;
+	std::atomic<bool> m_bWriterSleeping;
+	QWaitCondition m_WorkAvailable;
+	std::atomic<unsigned int> m_uStalledProducers;
+	QWaitCondition m_QueueDrained;
+
+	QMutex m_StatisticsMutex;
+	Statistics m_Statistics;
+
+	// owned by the writer thread
+	std::unordered_map<int, File *> m_Files;
+	QElapsedTimer m_FrameSyncTimer; // since the compressed frames have been flushed
+
+public:
+	static void init();
+	static void done();
+	static KviLogWriter * instance() { return m_pInstance; };
+
+	// opens (or creates) the file for appending: blocks until the writer
+	// has executed the operation and returns the file id or -1 on failure
+	int open(const QString & szFileName, bool bCompressed);
+	// queues a preformatted chunk of data, uTime is the time of the line
+	void write(int iFile, const QByteArray & data, kvi_u32_t uTime);
+	// ends the current compressed frame and syncs, depending on the policy
+	void flush(int iFile);
+	// the id is invalid after this call
+	void close(int iFile);
+
+	void setSyncPolicy(unsigned int uPolicy);
+	void statistics(Statistics & s);
+
+protected:
+	void run() override;
+	void push(Record * r);
+	Record * pop();
+	void post(Record * r);
+	void post(Operation eOperation, int iFile);
+	void commit(File * f);
+	void closeFile(File * f);
+	void writeFrames(File * f);
+	void syncFrames();
+	void sync(File * f);
+};
+
+#endif //_KVI_LOGWRITER_H_
@@ -64,6 +64,7 @@ struct ParseArgs
 	bool bForceNewSession;
 	bool bShowPopup;
 	bool bExecuteCommandAndClose;
+	bool bProfileStartup;
 	QString szExecCommand;
 	QString szExecRemoteCommand;
 };
@@ -137,6 +138,8 @@ int parseArgs(ParseArgs * a)
 			KviQString::appendFormatted(szMessage, "                 You can eventually use this switch more than once\n");
 			KviQString::appendFormatted(szMessage, "  -m           : If a KVIrc session is already running, show an informational\n");
 			KviQString::appendFormatted(szMessage, "                 popup dialog instead of writing to the console\n");
+			KviQString::appendFormatted(szMessage, "  -p           : Profile the startup and print the timings on the terminal\n");
+			KviQString::appendFormatted(szMessage, "                 (the full report is available with /profiler report)\n");
 			KviQString::appendFormatted(szMessage, "  [server]     : Connect to this server after startup\n");
 			KviQString::appendFormatted(szMessage, "  [port]       : Use this port for connection\n");
 			KviQString::appendFormatted(szMessage, "  [ircurl]     : URL in the following form:\n");
@@ -237,6 +240,12 @@ int parseArgs(ParseArgs * a)
 			continue;
 		}
 
+		if(kvi_strEqualCI("-p", p))
+		{
+			a->bProfileStartup = true;
+			continue;
+		}
+
 		if(kvi_strEqualCI("-session", p) || kvi_strEqualCI("-display", p) || kvi_strEqualCI("-name", p))
 		{
 			// Qt apps are supposed to handle the params to these switches, but we'll skip arg for now
@@ -352,6 +361,7 @@ int main(int argc, char ** argv)
 	a.bForceNewSession = false;
 	a.bShowPopup = false,
 	a.bExecuteCommandAndClose = false;
+	a.bProfileStartup = false;
 
 	int iRetCode = parseArgs(&a);
 
@@ -482,6 +492,7 @@ int main(int argc, char ** argv)
 	pTheApp->m_bCreateConfig = a.createFile;
 	pTheApp->m_szConfigFile = a.configFile;
 	pTheApp->m_szExecAfterStartup = a.szExecCommand;
+	pTheApp->m_bProfileStartup = a.bProfileStartup;
 	pTheApp->setup();
 
 	// YEAH!
@@ -37,6 +37,7 @@
 #include "KviIconManager.h"
 #include "KviInternalCommand.h"
 #include "KviLocale.h"
+#include "KviLogWriter.h"
 #include "KviMainWindow.h"
 #include "KviStringConversion.h"
 #include "KviTheme.h"
@@ -333,7 +334,10 @@ KviBoolOption g_boolOptionsTable[KVI_NUM_BOOL_OPTIONS] = {
 	BOOL_OPTION("MenuBarVisible", true, KviOption_sectFlagFrame | KviOption_resetUpdateGui),
 	BOOL_OPTION("WarnAboutHidingMenuBar", true, KviOption_sectFlagFrame),
 	BOOL_OPTION("WhoRepliesToActiveWindow", false, KviOption_sectFlagConnection),
-	BOOL_OPTION("DropConnectionOnSaslFailure", false, KviOption_sectFlagConnection)
+	BOOL_OPTION("DropConnectionOnSaslFailure", false, KviOption_sectFlagConnection),
+	BOOL_OPTION("CoalesceNetsplits", true, KviOption_sectFlagConnection),
+	BOOL_OPTION("NetsplitPerUserEvents", false, KviOption_sectFlagConnection),
+	BOOL_OPTION("EnableConnectionTelemetry", false, KviOption_sectFlagConnection)
 };
 
 // NOTICE: REUSE EQUIVALENT UNUSED KviOption_bool in KviOptions.h ENTRIES BEFORE ADDING NEW ENTRIES ABOVE
@@ -637,7 +641,9 @@ KviUIntOption g_uintOptionsTable[KVI_NUM_UINT_OPTIONS] = {
 	UINT_OPTION("ToolBarButtonStyle", 0, KviOption_groupTheme), // 0 = Qt::ToolButtonIconOnly
 	UINT_OPTION("MaximumBlowFishKeySize", 56, KviOption_sectFlagNone),
 	UINT_OPTION("CustomCursorWidth", 1, KviOption_resetUpdateGui),
-	UINT_OPTION("UserListMinimumWidth", 100, KviOption_sectFlagUserListView | KviOption_resetUpdateGui | KviOption_groupTheme)
+	UINT_OPTION("UserListMinimumWidth", 100, KviOption_sectFlagUserListView | KviOption_resetUpdateGui | KviOption_groupTheme),
+	UINT_OPTION("IrcViewMaxSpilledLines", 0, KviOption_sectFlagIrcView),
+	UINT_OPTION("LogSyncPolicy", 0, KviOption_sectFlagFrame | KviOption_resetUpdateLogWriter)
 };
 
 #define FONT_OPTION(_name, _face, _size, _flags) \
@@ -1324,6 +1330,9 @@ void KviApplication::optionResetUpdate(int flags)
 	if(flags & KviOption_resetRecentChannels)
 		g_pApp->buildRecentChannels();
 
+	if((flags & KviOption_resetUpdateLogWriter) && KviLogWriter::instance())
+		KviLogWriter::instance()->setSyncPolicy(KVI_OPTION_UINT(KviOption_uintLogSyncPolicy));
+
 	if(flags & KviOption_resetUpdateNotifier)
 		emit updateNotifier();
 }
@@ -355,10 +355,13 @@ DECLARE_OPTION_STRUCT(KviStringListOption, QStringList)
 #define KviOption_boolWarnAboutHidingMenuBar 262
 #define KviOption_boolWhoRepliesToActiveWindow 263                             /* irc::output */
 #define KviOption_boolDropConnectionOnSaslFailure 264                          /* connection::advanced */
+#define KviOption_boolCoalesceNetsplits 265                                    /* irc::output */
+#define KviOption_boolNetsplitPerUserEvents 266                                /* irc::output */
+#define KviOption_boolEnableConnectionTelemetry 267                            /* connection::advanced */
 
 // NOTICE: REUSE EQUIVALENT UNUSED BOOL_OPTION in KviOptions.cpp ENTRIES BEFORE ADDING NEW ENTRIES ABOVE
 
-#define KVI_NUM_BOOL_OPTIONS 265
+#define KVI_NUM_BOOL_OPTIONS 268
 
 #define KVI_STRING_OPTIONS_PREFIX "string"
 #define KVI_STRING_OPTIONS_PREFIX_LEN 6
@@ -597,8 +600,10 @@ DECLARE_OPTION_STRUCT(KviStringListOption, QStringList)
 #define KviOption_uintMaximumBlowFishKeySize 80
 #define KviOption_uintCustomCursorWidth 81                                    /* Interface */
 #define KviOption_uintUserListMinimumWidth 82
+#define KviOption_uintIrcViewMaxSpilledLines 83                               /* interface::features::components::ircview */
+#define KviOption_uintLogSyncPolicy 84                                        /* tools::logging */
 
-#define KVI_NUM_UINT_OPTIONS 83
+#define KVI_NUM_UINT_OPTIONS 85
 
 namespace KviIdentdOutputMode
 {
@@ -750,6 +755,7 @@ inline QColor getMircColor(unsigned int index)
 #define KviOption_resetReloadImages (1 << 23)
 #define KviOption_resetRestartLagMeter (1 << 24)
 #define KviOption_resetRecentChannels (1 << 25)
+#define KviOption_resetUpdateLogWriter (1 << 26)
 
 #define KviOption_resetMask (~(KviOption_sectMask | KviOption_groupMask))
 
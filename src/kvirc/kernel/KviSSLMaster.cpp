@@ -57,6 +57,10 @@ namespace KviSSLMaster
 		wnd->output(KVI_OUT_SSL, __tr2qs("[SSL]:  Cipher: %c%s"), KviControlCodes::Bold, c->name());
 		wnd->output(KVI_OUT_SSL, __tr2qs("[SSL]:  Version: %c%s"), KviControlCodes::Bold, c->version());
 		wnd->output(KVI_OUT_SSL, __tr2qs("[SSL]:  Bits: %c%d (%d used)"), KviControlCodes::Bold, c->bits(), c->bitsUsed());
+		if(c->handshakeTime() >= 0)
+			wnd->output(KVI_OUT_SSL, __tr2qs("[SSL]:  Handshake: %c%s%c in %d msecs"), KviControlCodes::Bold,
+			    c->sessionReused() ? __tr("session resumed") : __tr("full"), KviControlCodes::Bold, c->handshakeTime());
+		wnd->output(KVI_OUT_SSL, __tr2qs("[SSL]:  Resumed sessions: %c%u of %u handshakes"), KviControlCodes::Bold, KviSSL::resumedHandshakeCount(), KviSSL::handshakeCount());
 		//	wnd->output(KVI_OUT_SSL,__tr2qs("[SSL]:  Description: %c%s"),KviControlCodes::Bold,c->description());
 	}
 
@@ -112,10 +116,11 @@ namespace KviSSLMaster
 			wnd->outputNoFmt(KVI_OUT_SSL, __tr2qs("[SSL]: Can't find out the current cipher info"));
 	}
 
-	KVIRC_API KviSSL * allocSSL(KviWindow * wnd, kvi_socket_t sock, KviSSL::Method m, const char * contextString)
+	KVIRC_API KviSSL * allocSSL(KviWindow * wnd, kvi_socket_t sock, KviSSL::Method m, const char * contextString, const QString & szSessionKey)
 	{
 		KviSSL * s = new KviSSL();
-		if(!s->initContext(m))
+		// the context is shared: the certificates are set on the socket
+		if(!s->initContext(m) || !s->initSocket(sock))
 		{
 			delete s;
 			return nullptr;
@@ -177,11 +182,8 @@ namespace KviSSLMaster
 			}
 		}
 
-		if(!s->initSocket(sock))
-		{
-			delete s;
-			return nullptr;
-		}
+		// the key includes the certificate we have just loaded
+		s->setSessionKey(szSessionKey);
 
 		return s;
 	}
@@ -41,7 +41,8 @@ namespace KviSSLMaster
 
 	extern KVIRC_API void printSSLConnectionInfo(KviWindow * wnd, KviSSL * s);
 
-	extern KVIRC_API KviSSL * allocSSL(KviWindow * wnd, kvi_socket_t sock, KviSSL::Method m, const char * contextString = nullptr);
+	// szSessionKey identifies the peer (host:port) for the client session resumption
+	extern KVIRC_API KviSSL * allocSSL(KviWindow * wnd, kvi_socket_t sock, KviSSL::Method m, const char * contextString = nullptr, const QString & szSessionKey = QString());
 	extern KVIRC_API void freeSSL(KviSSL * s);
 
 	extern KVIRC_API bool getSSLCertInfo(KviSSLCertificate * pCert, QString szQuery, QString szOptionalParam, KviKvsVariant * pRetBuffer);
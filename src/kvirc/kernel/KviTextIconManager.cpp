@@ -246,6 +246,19 @@ int KviTextIconManager::load(const QString & szFileName, bool bMerge)
 
 		cfg.setGroup("TextIcons");
 
+		// start decoding the image based icons in the background
+		// while we're busy with the rest of the entries
+		for(auto & s : names)
+		{
+			if(cfg.readIntEntry(s, -1) > 0)
+				continue;
+			if(bMerge && m_pTextIconDict->find(s))
+				continue;
+			QString szRetPath;
+			if(g_pApp->findImage(szRetPath, cfg.readEntry(s)))
+				KviAnimatedPixmapCache::preload(szRetPath, 16, 16);
+		}
+
 		for(auto & s : names)
 		{
 			int iId = cfg.readIntEntry(s, -1);
@@ -31,6 +31,7 @@
 #include "KviKvsEventManager.h"
 #include "KviKvsScriptAddonManager.h"
 #include "KviKvsObjectController.h"
+#include "KviKvsProfiler.h"
 
 namespace KviKvs
 {
@@ -45,11 +46,13 @@ namespace KviKvs
 		KviKvsScriptAddonManager::init();
 		KviKvsTimerManager::init();
 		KviKvsDnsManager::init();
+		KviKvsProfiler::init();
 	}
 
 	void done()
 	{
 		//KviKvsScriptManager::done();
+		KviKvsProfiler::done();
 		KviKvsEventManager::done();
 		KviKvsPopupManager::done();
 		KviKvsAliasManager::done();
@@ -109,6 +109,7 @@ namespace KviKvsCoreSimpleCommands
 	KVSCSC(play);
 	KVSCSC(popup);
 	KVSCSC(privmsg);
+	KVSCSC(profiler);
 	KVSCSC(query);
 	KVSCSC(quit);
 	KVSCSC(raise);
@@ -44,6 +44,7 @@
 #include "KviKvsVariantList.h"
 #include "KviKvsScript.h"
 #include "KviKvsPopupManager.h"
+#include "KviKvsProfiler.h"
 
 #include <QCursor>
 #include <QProcess>
@@ -1014,6 +1015,123 @@ namespace KviKvsCoreSimpleCommands
 		return true;
 	}
 
+	/*
+		@doc: profiler
+		@type:
+			command
+		@title:
+			profiler
+		@syntax:
+			profiler [-s=<order:string>] [-n=<count:uint>] <operation:string> [filename:string]
+		@short:
+			Controls the script profiler
+		@switches:
+			!sw: -s=<order> | --sort=<order>
+			Sorts the report by [i]self[/i] (default), [i]total[/i], [i]calls[/i] or [i]allocs[/i]
+			!sw: -n=<count> | --count=<count>
+			Shows at most <count> entries in the report (default is 30, 0 means all)
+		@description:
+			Controls the built-in script profiler.[br]
+			When running, the profiler records the number of calls, the inclusive (total)
+			and exclusive (self) wall clock time and the number of variable allocations
+			of each event handler, alias, object function and timer callback.[br]
+			The entries are named [i]event::<event>::<handler>[/i], [i]alias::<name>[/i],
+			[i]object::<class>::<function>[/i] and [i]timer::<name>[/i].[br]
+			<operation> may be one of:[br]
+			[i]start[/i]: starts recording (the previous results are kept)[br]
+			[i]stop[/i]: stops recording[br]
+			[i]clear[/i]: discards the collected results[br]
+			[i]report[/i]: prints the collected results in the current window[br]
+			[i]dump[/i]: writes the collected call stacks to [filename] in the
+			"collapsed stack" format understood by the flamegraph tools (values are in microseconds)[br]
+			The profiler is stopped by default and has no measurable cost in that state.[br]
+			When KVIrc is started with the -p command line option the profiler runs from
+			the beginning of the startup to the first paint of the main window, then stops.
+			The [i]startup::firstPaint[/i] entry holds the whole startup time and
+			[i]startup::iconManager[/i] the time spent loading the icons; both are also
+			printed on the terminal. The scripts executed during the startup appear as children of
+			[i]startup::firstPaint[/i] in the dumped stacks.
+		@examples:
+			[example]
+				profiler start
+				[comment]# ... wait for the netsplit ...[/comment]
+				profiler stop
+				profiler -s=total -n=10 report
+				profiler dump /tmp/kvs.folded
+			[/example]
+	*/
+
+	KVSCSC(profiler)
+	{
+		QString szOperation, szFileName;
+		KVSCSC_PARAMETERS_BEGIN
+		KVSCSC_PARAMETER("operation", KVS_PT_NONEMPTYSTRING, 0, szOperation)
+		KVSCSC_PARAMETER("filename", KVS_PT_STRING, KVS_PF_OPTIONAL, szFileName)
+		KVSCSC_PARAMETERS_END
+
+		KviKvsProfiler * pProfiler = KviKvsProfiler::instance();
+
+		if(KviQString::equalCI(szOperation, "start"))
+		{
+			pProfiler->start();
+		}
+		else if(KviQString::equalCI(szOperation, "stop"))
+		{
+			pProfiler->stop();
+		}
+		else if(KviQString::equalCI(szOperation, "clear"))
+		{
+			pProfiler->clear();
+		}
+		else if(KviQString::equalCI(szOperation, "report"))
+		{
+			KviKvsProfiler::SortOrder eOrder = KviKvsProfiler::SortBySelfTime;
+			QString szOrder;
+			if(KVSCSC_pSwitches->getAsStringIfExisting('s', "sort", szOrder))
+			{
+				if(KviQString::equalCI(szOrder, "total"))
+					eOrder = KviKvsProfiler::SortByTotalTime;
+				else if(KviQString::equalCI(szOrder, "calls"))
+					eOrder = KviKvsProfiler::SortByCalls;
+				else if(KviQString::equalCI(szOrder, "allocs"))
+					eOrder = KviKvsProfiler::SortByAllocations;
+				else if(!KviQString::equalCI(szOrder, "self"))
+					KVSCSC_pContext->warning(__tr2qs_ctx("Invalid sort order '%Q': using self time", "kvs"), &szOrder);
+			}
+
+			kvs_int_t iCount = 30;
+			KviKvsVariant * pCount = KVSCSC_pSwitches->find('n', "count");
+			if(pCount)
+			{
+				if(!pCount->asInteger(iCount) || (iCount < 0))
+				{
+					KVSCSC_pContext->warning(__tr2qs_ctx("Invalid count value: using default", "kvs"));
+					iCount = 30;
+				}
+			}
+
+			pProfiler->report(KVSCSC_pWindow, eOrder, (unsigned int)iCount);
+		}
+		else if(KviQString::equalCI(szOperation, "dump"))
+		{
+			if(szFileName.isEmpty())
+			{
+				KVSCSC_pContext->error(__tr2qs_ctx("The dump operation requires a file name", "kvs"));
+				return false;
+			}
+			KviFileUtils::adjustFilePath(szFileName);
+			if(!pProfiler->dumpCollapsedStacks(szFileName))
+				KVSCSC_pContext->warning(__tr2qs_ctx("Failed to write the profile to '%Q'", "kvs"), &szFileName);
+		}
+		else
+		{
+			KVSCSC_pContext->error(__tr2qs_ctx("Unknown profiler operation '%Q'", "kvs"), &szOperation);
+			return false;
+		}
+
+		return true;
+	}
+
 	/*
 		@doc: query
 		@type:
@@ -0,0 +1,285 @@
+//=============================================================================
+//
+//   File : KviKvsProfiler.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviKvsProfiler.h"
+#include "KviWindow.h"
+#include "KviLocale.h"
+#include "kvi_out.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+
+#include <algorithm>
+
+// how often startupEnd() checks again if the startup frame can be closed (msecs)
+#define KVI_KVS_PROFILER_STARTUP_RETRY_DELAY 100
+
+KviKvsProfiler * KviKvsProfiler::m_pInstance = nullptr;
+bool KviKvsProfiler::m_bActive = false;
+bool KviKvsProfiler::m_bProfilingStartup = false;
+kvi_u64_t KviKvsProfiler::m_uAllocations = 0;
+
+KviKvsProfiler::KviKvsProfiler()
+{
+	m_pEntries = new KviPointerHashTable<QString, KviKvsProfilerEntry>(127, false);
+	m_pEntries->setAutoDelete(true);
+	m_pStacks = new KviPointerHashTable<QString, kvi_u64_t>(127, false);
+	m_pStacks->setAutoDelete(true);
+}
+
+KviKvsProfiler::~KviKvsProfiler()
+{
+	m_bActive = false;
+	delete m_pStacks;
+	delete m_pEntries;
+}
+
+void KviKvsProfiler::init()
+{
+	if(m_pInstance)
+		return;
+	m_pInstance = new KviKvsProfiler();
+}
+
+void KviKvsProfiler::done()
+{
+	if(!m_pInstance)
+		return;
+	delete m_pInstance;
+	m_pInstance = nullptr;
+}
+
+void KviKvsProfiler::startupBegin()
+{
+	init();
+	m_pInstance->start();
+	m_pInstance->enter(QString::fromLatin1("startup::firstPaint"));
+	m_bProfilingStartup = true;
+}
+
+void KviKvsProfiler::startupEnd()
+{
+	if(!m_bProfilingStartup)
+		return;
+	if(!m_pInstance || !m_bActive)
+	{
+		m_bProfilingStartup = false;
+		return;
+	}
+
+	// we normally run from the main event loop with only the startup frame open:
+	// a nested loop (i.e. a modal dialog shown by a script) still has scopes
+	// running, and those must be left by their owners. Try again later.
+	if(m_pInstance->m_Frames.size() != 1)
+	{
+		QTimer::singleShot(KVI_KVS_PROFILER_STARTUP_RETRY_DELAY, &KviKvsProfiler::startupEnd);
+		return;
+	}
+	m_pInstance->leave();
+	m_pInstance->stop();
+	m_bProfilingStartup = false;
+
+	KviPointerHashTableIterator<QString, KviKvsProfilerEntry> it(*(m_pInstance->m_pEntries));
+	while(KviKvsProfilerEntry * e = it.current())
+	{
+		if(e->name().startsWith(QLatin1String("startup::")))
+			qDebug("%s: %.2f ms", e->name().toUtf8().data(), e->totalNs() / 1000000.0);
+		++it;
+	}
+}
+
+void KviKvsProfiler::start()
+{
+	if(m_bActive)
+		return;
+	m_Clock.start();
+	m_iStartedNs = 0;
+	m_bActive = true;
+}
+
+void KviKvsProfiler::stop()
+{
+	if(!m_bActive)
+		return;
+	// close the frames that are still open (stop may be called from a profiled script)
+	while(!m_Frames.empty())
+		leave();
+	m_iRecordedNs += m_Clock.nsecsElapsed() - m_iStartedNs;
+	m_bActive = false;
+}
+
+void KviKvsProfiler::clear()
+{
+	m_Frames.clear();
+	m_pEntries->clear();
+	m_pStacks->clear();
+	m_iRecordedNs = 0;
+	if(m_bActive)
+		m_iStartedNs = m_Clock.nsecsElapsed();
+}
+
+kvi_u64_t KviKvsProfiler::recordedNs() const
+{
+	if(m_bActive)
+		return m_iRecordedNs + (m_Clock.nsecsElapsed() - m_iStartedNs);
+	return m_iRecordedNs;
+}
+
+void KviKvsProfiler::enter(const QString & szName)
+{
+	KviKvsProfilerEntry * e = m_pEntries->find(szName);
+	if(!e)
+	{
+		e = new KviKvsProfilerEntry(szName);
+		m_pEntries->replace(szName, e);
+	}
+
+	e->m_uCalls++;
+	e->m_uRecursion++;
+
+	Frame f;
+	f.pEntry = e;
+	f.iChildNs = 0;
+	f.uStartAllocations = m_uAllocations;
+
+	// the flamegraph tools use ';' as the frame separator
+	QString szFrame = szName;
+	szFrame.replace(QChar(';'), QChar(':'));
+	if(m_Frames.empty())
+		f.szStack = szFrame;
+	else
+		f.szStack = m_Frames.back().szStack + QChar(';') + szFrame;
+
+	// take the time as the last thing so we don't account our own overhead
+	f.iStartNs = m_Clock.nsecsElapsed();
+	m_Frames.push_back(std::move(f));
+}
+
+void KviKvsProfiler::leave()
+{
+	if(m_Frames.empty())
+		return; // cleared or stopped while this frame was running
+
+	qint64 iNow = m_Clock.nsecsElapsed();
+
+	Frame & f = m_Frames.back();
+	qint64 iElapsed = iNow - f.iStartNs;
+	qint64 iSelf = iElapsed - f.iChildNs;
+	if(iSelf < 0)
+		iSelf = 0;
+
+	KviKvsProfilerEntry * e = f.pEntry;
+	e->m_uSelfNs += iSelf;
+	e->m_uRecursion--;
+	// for recursive calls only the outermost frame contributes to the inclusive counters
+	if(e->m_uRecursion == 0)
+	{
+		e->m_uTotalNs += iElapsed;
+		e->m_uAllocations += m_uAllocations - f.uStartAllocations;
+	}
+
+	kvi_u64_t * pStackNs = m_pStacks->find(f.szStack);
+	if(pStackNs)
+		*pStackNs += iSelf;
+	else
+		m_pStacks->replace(f.szStack, new kvi_u64_t(iSelf));
+
+	m_Frames.pop_back();
+
+	if(!m_Frames.empty())
+		m_Frames.back().iChildNs += iElapsed;
+}
+
+void KviKvsProfiler::report(KviWindow * pWnd, SortOrder eOrder, unsigned int uMaxEntries)
+{
+	std::vector<KviKvsProfilerEntry *> lEntries;
+	lEntries.reserve(m_pEntries->count());
+
+	KviPointerHashTableIterator<QString, KviKvsProfilerEntry> it(*m_pEntries);
+	while(KviKvsProfilerEntry * e = it.current())
+	{
+		lEntries.push_back(e);
+		++it;
+	}
+
+	std::sort(lEntries.begin(), lEntries.end(), [eOrder](KviKvsProfilerEntry * a, KviKvsProfilerEntry * b) {
+		switch(eOrder)
+		{
+			case SortByTotalTime:
+				return a->totalNs() > b->totalNs();
+			case SortByCalls:
+				return a->calls() > b->calls();
+			case SortByAllocations:
+				return a->allocations() > b->allocations();
+			default:
+				return a->selfNs() > b->selfNs();
+		}
+	});
+
+	QString szRecordedMs = QString::number(recordedNs() / 1000000.0, 'f', 2);
+	pWnd->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Script profile: %u handlers, %Q ms recorded", "kvs"),
+	    (unsigned int)lEntries.size(), &szRecordedMs);
+
+	unsigned int uIdx = 0;
+	for(auto e : lEntries)
+	{
+		if(uMaxEntries && (uIdx >= uMaxEntries))
+			break;
+		uIdx++;
+
+		QString szLine = QString("%1 calls, total %2 ms, self %3 ms, avg %4 us, %5 allocs: %6")
+		                     .arg(e->calls())
+		                     .arg(e->totalNs() / 1000000.0, 0, 'f', 3)
+		                     .arg(e->selfNs() / 1000000.0, 0, 'f', 3)
+		                     .arg(e->calls() ? (e->totalNs() / 1000.0) / e->calls() : 0.0, 0, 'f', 1)
+		                     .arg(e->allocations())
+		                     .arg(e->name());
+		pWnd->outputNoFmt(KVI_OUT_SYSTEMMESSAGE, szLine);
+	}
+}
+
+bool KviKvsProfiler::dumpCollapsedStacks(const QString & szFileName)
+{
+	QFile f(szFileName);
+	if(!f.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+		return false;
+
+	QTextStream ts(&f);
+	ts.setCodec("UTF-8");
+
+	// one "frame;frame;frame <value>" line per distinct stack, value in microseconds
+	KviPointerHashTableIterator<QString, kvi_u64_t> it(*m_pStacks);
+	while(kvi_u64_t * pNs = it.current())
+	{
+		kvi_u64_t uUs = *pNs / 1000;
+		if(uUs > 0)
+			ts << it.currentKey() << ' ' << uUs << '\n';
+		++it;
+	}
+
+	ts.flush();
+	f.close();
+	return f.error() == QFile::NoError;
+}
@@ -0,0 +1,188 @@
+#ifndef _KVI_KVS_PROFILER_H_
+#define _KVI_KVS_PROFILER_H_
+//=============================================================================
+//
+//   File : KviKvsProfiler.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviKvsProfiler.h
+* \author The KVIrc Development Team
+* \brief Instrumenting profiler for event handlers, aliases, object functions and timers
+*
+* The profiler is disabled by default: in that state each instrumented
+* call site pays only for a test of a static boolean.
+* When enabled it records, per handler name, the number of calls,
+* the inclusive and exclusive (self) wall clock time and the number of
+* KviKvsVariant data allocations. It also keeps the self time of each
+* distinct call stack so the results can be exported in the "collapsed stack"
+* format understood by the flamegraph tools.
+*/
+
+#include "kvi_settings.h"
+#include "kvi_inttypes.h"
+#include "KviPointerHashTable.h"
+
+#include <QElapsedTimer>
+#include <QString>
+
+#include <vector>
+
+class KviWindow;
+
+/**
+* \class KviKvsProfilerEntry
+* \brief The statistics collected for a single profiled handler
+*/
+class KVIRC_API KviKvsProfilerEntry
+{
+	friend class KviKvsProfiler;
+
+public:
+	KviKvsProfilerEntry(const QString & szName)
+	    : m_szName(szName) {}
+
+protected:
+	QString m_szName;
+	kvi_u64_t m_uCalls = 0;
+	kvi_u64_t m_uTotalNs = 0;       // inclusive wall time
+	kvi_u64_t m_uSelfNs = 0;        // exclusive wall time
+	kvi_u64_t m_uAllocations = 0;   // inclusive variant data allocations
+	unsigned int m_uRecursion = 0;  // number of frames of this entry currently on the stack
+public:
+	const QString & name() const { return m_szName; };
+	kvi_u64_t calls() const { return m_uCalls; };
+	kvi_u64_t totalNs() const { return m_uTotalNs; };
+	kvi_u64_t selfNs() const { return m_uSelfNs; };
+	kvi_u64_t allocations() const { return m_uAllocations; };
+};
+
+class KVIRC_API KviKvsProfiler
+{
+protected: // it only can be created and destroyed by KviKvsProfiler::init()/done()
+	KviKvsProfiler();
+	~KviKvsProfiler();
+
+public:
+	enum SortOrder
+	{
+		SortBySelfTime,
+		SortByTotalTime,
+		SortByCalls,
+		SortByAllocations
+	};
+
+protected:
+	struct Frame
+	{
+		KviKvsProfilerEntry * pEntry;
+		qint64 iStartNs;
+		qint64 iChildNs;
+		kvi_u64_t uStartAllocations;
+		QString szStack; // the collapsed stack up to (and including) this frame
+	};
+
+	static KviKvsProfiler * m_pInstance;
+	static bool m_bActive;
+	static bool m_bProfilingStartup;
+	static kvi_u64_t m_uAllocations;
+
+	KviPointerHashTable<QString, KviKvsProfilerEntry> * m_pEntries;
+	KviPointerHashTable<QString, kvi_u64_t> * m_pStacks; // collapsed stack -> self ns
+	std::vector<Frame> m_Frames;
+	QElapsedTimer m_Clock;
+	qint64 m_iStartedNs = 0;
+	qint64 m_iRecordedNs = 0;
+
+public:
+	static KviKvsProfiler * instance() { return m_pInstance; };
+	static void init();
+	static void done();
+
+	// this is the only thing checked on the hot paths
+	static bool isActive() { return m_bActive; };
+	// called for every allocation of a KviKvsVariantData
+	static void countAllocation() { m_uAllocations++; };
+
+	// Startup profiling (kvirc -p): the profiler is started at the beginning of
+	// KviApplication::setup() and the whole startup is recorded in a
+	// "startup::firstPaint" frame that is closed right after the first paint of
+	// the main window (or as soon as no script is running anymore).
+	static void startupBegin();
+	static void startupEnd();
+	static bool isProfilingStartup() { return m_bProfilingStartup; };
+
+	void start();
+	void stop();
+	void clear();
+
+	void enter(const QString & szName);
+	void leave();
+
+	// the total time spent with the profiler running, in nanoseconds
+	kvi_u64_t recordedNs() const;
+	unsigned int entryCount() const { return m_pEntries->count(); };
+
+	void report(KviWindow * pWnd, SortOrder eOrder, unsigned int uMaxEntries);
+	bool dumpCollapsedStacks(const QString & szFileName);
+};
+
+/**
+* \class KviKvsProfilerScope
+* \brief Guard object that profiles the enclosing scope
+*
+* It does nothing (and doesn't even build the name) when the profiler
+* is not running. Pass the name components separately so the concatenation
+* is done only when needed.
+*/
+class KviKvsProfilerScope
+{
+public:
+	KviKvsProfilerScope(const char * szKind, const QString & szName)
+	{
+		if(!KviKvsProfiler::isActive())
+			return;
+		m_bEntered = true;
+		KviKvsProfiler::instance()->enter(QString::fromLatin1(szKind) + QString::fromLatin1("::") + szName);
+	}
+	KviKvsProfilerScope(const char * szKind, const QString & szClass, const QString & szName)
+	{
+		if(!KviKvsProfiler::isActive())
+			return;
+		m_bEntered = true;
+		KviKvsProfiler::instance()->enter(QString::fromLatin1(szKind) + QString::fromLatin1("::") + szClass + QString::fromLatin1("::") + szName);
+	}
+	~KviKvsProfilerScope()
+	{
+		// the profiler might have been stopped in the meantime: leave() handles that
+		if(m_bEntered)
+			KviKvsProfiler::instance()->leave();
+	}
+
+	KviKvsProfilerScope(const KviKvsProfilerScope &) = delete;
+	KviKvsProfilerScope & operator=(const KviKvsProfilerScope &) = delete;
+
+private:
+	bool m_bEntered = false;
+};
+
+#endif //!_KVI_KVS_PROFILER_H_
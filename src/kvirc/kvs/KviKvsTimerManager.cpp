@@ -27,6 +27,7 @@
 #include "KviKvsScript.h"
 #include "KviKvsVariantList.h"
 #include "KviKvsRunTimeContext.h"
+#include "KviKvsProfiler.h"
 
 #include "KviApplication.h"
 #include "KviWindow.h"
@@ -226,11 +227,15 @@ void KviKvsTimerManager::timerEvent(QTimerEvent * e)
 	KviKvsScript copy(*(t->callback()));
 
 	m_iCurrentTimer = t->id();
-	bool bRet = copy.run(t->window(),
-	    t->parameterList(),
-	    nullptr,
-	    KviKvsScript::PreserveParams,
-	    t->runTimeData());
+	bool bRet;
+	{
+		KviKvsProfilerScope prof("timer", t->name());
+		bRet = copy.run(t->window(),
+		    t->parameterList(),
+		    nullptr,
+		    KviKvsScript::PreserveParams,
+		    t->runTimeData());
+	}
 
 	m_iCurrentTimer = 0;
 
@@ -26,10 +26,18 @@
 #include "KviKvsArrayCast.h"
 #include "KviKvsHash.h"
 #include "KviKvsArray.h"
+#include "KviKvsProfiler.h"
 
 #include <cmath>
 #include <cinttypes>
 
+// all the variant data allocations pass through here so the script profiler can count them
+static inline KviKvsVariantData * allocateVariantData()
+{
+	KviKvsProfiler::countAllocation();
+	return new KviKvsVariantData;
+}
+
 int KviKvsVariantComparison::compareIntString(const KviKvsVariant * pV1, const KviKvsVariant * pV2)
 {
 	kvs_real_t dReal;
@@ -244,7 +252,7 @@ KviKvsVariant::KviKvsVariant()
 
 KviKvsVariant::KviKvsVariant(QString * pString, bool bEscape)
 {
-	m_pData = new KviKvsVariantData;
+	m_pData = allocateVariantData();
 	m_pData->m_eType = KviKvsVariantData::String;
 	m_pData->m_uRefs = 1;
 	m_pData->m_u.pString = pString;
@@ -254,7 +262,7 @@ KviKvsVariant::KviKvsVariant(QString * pString, bool bEscape)
 
 KviKvsVariant::KviKvsVariant(const QString & szString, bool bEscape)
 {
-	m_pData = new KviKvsVariantData;
+	m_pData = allocateVariantData();
 	m_pData->m_eType = KviKvsVariantData::String;
 	m_pData->m_uRefs = 1;
 	m_pData->m_u.pString = new QString(szString);
@@ -264,7 +272,7 @@ KviKvsVariant::KviKvsVariant(const QString & szString, bool bEscape)
 
 KviKvsVariant::KviKvsVariant(const char * pcString, bool bEscape)
 {
-	m_pData = new KviKvsVariantData;
+	m_pData = allocateVariantData();
 	m_pData->m_eType = KviKvsVariantData::String;
 	m_pData->m_uRefs = 1;
 	m_pData->m_u.pString = new QString(QString::fromUtf8(pcString));
@@ -274,7 +282,7 @@ KviKvsVariant::KviKvsVariant(const char * pcString, bool bEscape)
 
 KviKvsVariant::KviKvsVariant(KviKvsArray * pArray)
 {
-	m_pData = new KviKvsVariantData;
+	m_pData = allocateVariantData();
 	m_pData->m_eType = KviKvsVariantData::Array;
 	m_pData->m_uRefs = 1;
 	m_pData->m_u.pArray = pArray;
@@ -282,7 +290,7 @@ KviKvsVariant::KviKvsVariant(KviKvsArray * pArray)
 
 KviKvsVariant::KviKvsVariant(KviKvsHash * pHash)
 {
-	m_pData = new KviKvsVariantData;
+	m_pData = allocateVariantData();
 	m_pData->m_eType = KviKvsVariantData::Hash;
 	m_pData->m_uRefs = 1;
 	m_pData->m_u.pHash = pHash;
@@ -290,7 +298,7 @@ KviKvsVariant::KviKvsVariant(KviKvsHash * pHash)
 
 KviKvsVariant::KviKvsVariant(kvs_real_t * pReal)
 {
-	m_pData = new KviKvsVariantData;
+	m_pData = allocateVariantData();
 	m_pData->m_eType = KviKvsVariantData::Real;
 	m_pData->m_uRefs = 1;
 	m_pData->m_u.pReal = pReal;
@@ -298,7 +306,7 @@ KviKvsVariant::KviKvsVariant(kvs_real_t * pReal)
 
 KviKvsVariant::KviKvsVariant(kvs_real_t dReal)
 {
-	m_pData = new KviKvsVariantData;
+	m_pData = allocateVariantData();
 	m_pData->m_eType = KviKvsVariantData::Real;
 	m_pData->m_uRefs = 1;
 	m_pData->m_u.pReal = new kvs_real_t;
@@ -307,7 +315,7 @@ KviKvsVariant::KviKvsVariant(kvs_real_t dReal)
 
 KviKvsVariant::KviKvsVariant(bool bBoolean)
 {
-	m_pData = new KviKvsVariantData;
+	m_pData = allocateVariantData();
 	m_pData->m_eType = KviKvsVariantData::Boolean;
 	m_pData->m_uRefs = 1;
 	m_pData->m_u.bBoolean = bBoolean;
@@ -315,7 +323,7 @@ KviKvsVariant::KviKvsVariant(bool bBoolean)
 
 KviKvsVariant::KviKvsVariant(kvs_int_t iInt, bool)
 {
-	m_pData = new KviKvsVariantData;
+	m_pData = allocateVariantData();
 	m_pData->m_eType = KviKvsVariantData::Integer;
 	m_pData->m_uRefs = 1;
 	m_pData->m_u.iInt = iInt;
@@ -323,7 +331,7 @@ KviKvsVariant::KviKvsVariant(kvs_int_t iInt, bool)
 
 KviKvsVariant::KviKvsVariant(kvs_hobject_t hObject)
 {
-	m_pData = new KviKvsVariantData;
+	m_pData = allocateVariantData();
 	m_pData->m_eType = KviKvsVariantData::HObject;
 	m_pData->m_uRefs = 1;
 	m_pData->m_u.hObject = hObject;
@@ -375,7 +383,7 @@ KviKvsVariant::KviKvsVariant(const KviKvsVariant & variant)
 		if(m_pData->m_uRefs > 1)             \
 		{                                    \
 			m_pData->m_uRefs--;              \
-			m_pData = new KviKvsVariantData; \
+			m_pData = allocateVariantData(); \
 			m_pData->m_uRefs = 1;            \
 		}                                    \
 		else                                 \
@@ -385,7 +393,7 @@ KviKvsVariant::KviKvsVariant(const KviKvsVariant & variant)
 	}                                        \
 	else                                     \
 	{                                        \
-		m_pData = new KviKvsVariantData;     \
+		m_pData = allocateVariantData();     \
 		m_pData->m_uRefs = 1;                \
 	}
 
@@ -32,6 +32,7 @@
 #include "KviModule.h"
 #include "KviWindow.h"
 #include "KviKvsVariantList.h"
+#include "KviKvsProfiler.h"
 
 #include <QRegExp>
 
@@ -468,6 +469,7 @@ bool KviKvsEventManager::triggerHandlers(KviPointerList<KviKvsEventHandler> * pH
 					KviKvsScript * s = ((KviKvsScriptEventHandler *)h)->script();
 					KviKvsScript copy(*s);
 					KviKvsVariant retVal;
+					KviKvsProfilerScope prof("event", s->name());
 					int iRet = copy.run(pWnd, pParams, &retVal, KviKvsScript::PreserveParams);
 					if(!iRet)
 					{
@@ -491,6 +493,7 @@ bool KviKvsEventManager::triggerHandlers(KviPointerList<KviKvsEventHandler> * pH
 				KviKvsVariant retVal;
 				KviKvsRunTimeContext ctx(nullptr, pWnd, pParams, &retVal);
 				KviKvsModuleEventCall call(m, &ctx, pParams);
+				KviKvsProfilerScope prof("event", m->name());
 				if(!(*proc)(&call))
 					bGotHalt = true;
 			}
@@ -38,6 +38,7 @@
 #include "KviKvsObjectController.h"
 #include "KviKvsObjectFunctionCall.h"
 #include "KviKvsObjectFunctionHandlerImpl.h"
+#include "KviKvsProfiler.h"
 
 #include <QMetaObject>
 #include <QMetaProperty>
@@ -1768,6 +1769,7 @@ bool KviKvsObject::callFunction(
 
 	KviKvsObjectFunctionCall fc(pContext, pParams, pRetVal);
 
+	KviKvsProfilerScope prof("object", getClass()->name(), fncName);
 	return h->call(this, &fc);
 }
 
@@ -101,7 +101,7 @@ python.begin <python code> python.end
 				szErr += szInterpreterEnd;                                                                                \
 				szErr += " statement";                                                                                    \
                                                                                                                           \
-				error(KVSP_curCharPointer, __tr2qs_ctx(szErr.toUtf8().data(), "kvs"));                                    \
+				error(KVSP_curCharPointer, __tr2qs_ctx_no_xgettext(szErr.toUtf8().data(), "kvs"));                        \
 				return nullptr;                                                                                           \
 			}                                                                                                             \
 			pInterpreterEnd = KVSP_curCharPointer;                                                                        \
@@ -25,6 +25,7 @@
 #include "KviKvsTreeNodeAliasFunctionCall.h"
 #include "KviKvsVariantList.h"
 #include "KviKvsAliasManager.h"
+#include "KviKvsProfiler.h"
 #include "KviLocale.h"
 
 KviKvsTreeNodeAliasFunctionCall::KviKvsTreeNodeAliasFunctionCall(const QChar * pLocation, const QString & szAliasName, KviKvsTreeNodeDataList * pParams)
@@ -65,6 +66,7 @@ bool KviKvsTreeNodeAliasFunctionCall::evaluateReadOnly(KviKvsRunTimeContext * c,
 
 	KviKvsScript copy(*s); // quick reference
 
+	KviKvsProfilerScope prof("alias", m_szFunctionName);
 	if(!copy.run(c->window(), &l, pBuffer, KviKvsScript::PreserveParams))
 	{
 		c->error(this, __tr2qs_ctx("Error in inner alias function call '%Q', called from this context", "kvs"), &m_szFunctionName);
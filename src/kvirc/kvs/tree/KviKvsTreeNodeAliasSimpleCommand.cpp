@@ -26,6 +26,7 @@
 #include "KviKvsTreeNodeDataList.h"
 #include "KviKvsTreeNodeSwitchList.h"
 #include "KviKvsAliasManager.h"
+#include "KviKvsProfiler.h"
 #include "KviLocale.h"
 #include "KviOptions.h"
 #include "KviIrcContext.h"
@@ -111,6 +112,7 @@ bool KviKvsTreeNodeAliasSimpleCommand::execute(KviKvsRunTimeContext * c)
 	//        it would avoid the constructor call each time
 	KviKvsExtendedRunTimeData extData(&swl);
 
+	KviKvsProfilerScope prof("alias", m_szCmdName);
 	if(!copy.run(c->window(), &l, nullptr, KviKvsScript::PreserveParams, &extData))
 	{
 		c->error(this, __tr2qs_ctx("Error in inner alias command call '%Q', called from this context", "kvs"), &m_szCmdName);
@@ -26,6 +26,7 @@
 
 #include "KviAntiSpam.h"
 #include "KviCString.h"
+#include "KviKeywordMatcher.h"
 #include "KviOptions.h"
 
 // - A spam message is generally a single PRIVMSG <mynick> :<text>
@@ -66,21 +67,19 @@
 		[/example]
 */
 
-bool kvi_mayBeSpam(KviCString msg, KviCString & spamWord)
+// The spam words compiled in a single automaton: the message is scanned once.
+// It's recompiled only when the option changes.
+static KviKeywordMatcher g_spamWordMatcher;
+
+bool kvi_mayBeSpam(const KviCString & msg, KviCString & spamWord)
 {
-	for(auto & it : KVI_OPTION_STRINGLIST(KviOption_stringlistSpamWords))
-	{
-		// FIXME : This is SLOOOOOOOOW (QString -> ascii translation!!)
-		QByteArray szLatin1 = it.toLatin1();
-		const char * aux = szLatin1.data();
-		if(*aux)
-		{
-			if(msg.findFirstIdx(aux, false) != -1)
-			{
-				spamWord = aux;
-				return true;
-			}
-		}
-	}
-	return false;
+	g_spamWordMatcher.setKeywords(KVI_OPTION_STRINGLIST(KviOption_stringlistSpamWords), KviKeywordMatcher::Latin1CaseInsensitive);
+
+	// the first word of the list that is found, like a scan word by word would do
+	int iWord = g_spamWordMatcher.find(msg.ptr(), msg.len());
+	if(iWord < 0)
+		return false;
+
+	spamWord = g_spamWordMatcher.keywords().at(iWord).toLatin1();
+	return true;
 }
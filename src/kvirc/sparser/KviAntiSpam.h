@@ -28,6 +28,6 @@
 
 class KviCString;
 
-extern KVIRC_API bool kvi_mayBeSpam(KviCString msg, KviCString & spamWord);
+extern KVIRC_API bool kvi_mayBeSpam(const KviCString & msg, KviCString & spamWord);
 
 #endif // _KVI_ANTISPAM_H_
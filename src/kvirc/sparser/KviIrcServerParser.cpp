@@ -33,6 +33,7 @@
 #include "KviKvsEventManager.h"
 #include "KviKvsEventTriggers.h"
 #include "KviIrcConnectionStateData.h"
+#include "KviIrcConnectionNetsplitDetectorData.h"
 #include "KviIrcMessage.h"
 
 KviIrcServerParser * g_pServerParser = nullptr;
@@ -53,6 +54,12 @@ void KviIrcServerParser::parseMessage(const char * message, KviIrcConnection * p
 
 	KviIrcMessage msg(message, pConnection);
 
+	// the coalesced netsplit QUITs and JOINs must be applied before anything
+	// else looks at the user lists (the QUIT and JOIN handlers take care of themselves)
+	KviIrcConnectionNetsplitDetectorData * pNetsplitData = pConnection->netsplitDetectorData();
+	if(pNetsplitData->hasPending() && !kvi_strEqualCS(msg.command(), "QUIT") && !kvi_strEqualCS(msg.command(), "JOIN"))
+		pNetsplitData->flush();
+
 	if(msg.isNumeric())
 	{
 		if(KviKvsEventManager::instance()->hasRawHandlers(msg.numeric()))
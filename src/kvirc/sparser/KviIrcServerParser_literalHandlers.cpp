@@ -46,6 +46,7 @@
 #include "KviTimeUtils.h"
 #include "KviUserAction.h"
 #include "KviIrcConnection.h"
+#include "KviIrcConnectionStatistics.h"
 #include "KviIrcConnectionUserInfo.h"
 #include "KviIrcConnectionTarget.h"
 #include "KviIrcConnectionRequestQueue.h"
@@ -201,27 +202,24 @@ void KviIrcServerParser::parseLiteralChghost(KviIrcMessage * msg)
 	if(KVS_TRIGGER_EVENT_5_HALTED(KviEvent_OnHostChange, console, szNick, szUser, szHost, szNewUser, szNewHost))
 		msg->setHaltOutput();
 
-	for(auto & c : console->connection()->channelList())
+	if(!msg->haltOutput())
 	{
-		if(c->isOn(szNick))
+		for(auto & c : console->connection()->channelsOf(szNick))
 		{
-			if(!msg->haltOutput())
+			if(szHost == szNewHost)
 			{
-				if(szHost == szNewHost)
-				{
-					c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user %Q"),
-					    &szNick, &szUser, &szHost, &szNewUser);
-				}
-				else if(szUser == szNewUser)
-				{
-					c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has host \r!h\r%Q\r"),
-					    &szNick, &szUser, &szHost, &szNewHost);
-				}
-				else
-				{
-					c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user@host %Q@\r!h\r%Q\r"),
-					    &szNick, &szUser, &szHost, &szNewUser, &szNewHost);
-				}
+				c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user %Q"),
+				    &szNick, &szUser, &szHost, &szNewUser);
+			}
+			else if(szUser == szNewUser)
+			{
+				c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has host \r!h\r%Q\r"),
+				    &szNick, &szUser, &szHost, &szNewHost);
+			}
+			else
+			{
+				c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user@host %Q@\r!h\r%Q\r"),
+				    &szNick, &szUser, &szHost, &szNewUser, &szNewHost);
 			}
 		}
 	}
@@ -304,6 +302,17 @@ void KviIrcServerParser::parseLiteralJoin(KviIrcMessage * msg)
 
 	bool bIsMe = IS_ME(msg, szNick);
 
+	// the users that come back after a netsplit are joined in a batch
+	KviIrcConnectionNetsplitDetectorData * pNetsplitData = msg->connection()->netsplitDetectorData();
+	if(chan && !bIsMe && KVI_OPTION_BOOL(KviOption_boolCoalesceNetsplits) && pNetsplitData->isNetjoin(szNick))
+	{
+		pNetsplitData->queueJoin(channel, szNick, szUser, szHost,
+		    msg->connection()->serverInfo()->modeFlagFromModeChar(chExtMode), szAccount, szReal);
+		return;
+	}
+	// keep the order with the coalesced messages
+	pNetsplitData->flush();
+
 	if(!chan)
 	{
 		// This must be me...(or desync)
@@ -594,6 +603,16 @@ void KviIrcServerParser::parseLiteralQuit(KviIrcMessage * msg)
 		}
 	}
 
+	// the netsplit QUITs are applied in a batch
+	KviIrcConnectionNetsplitDetectorData * pNetsplitData = msg->connection()->netsplitDetectorData();
+	if(bWasSplit && KVI_OPTION_BOOL(KviOption_boolCoalesceNetsplits))
+	{
+		pNetsplitData->queueQuit(szNick, szUser, szHost, msg->connection()->decodeText(msg->safeTrailing()));
+		return;
+	}
+	// keep the order with the coalesced messages
+	pNetsplitData->flush();
+
 	// FIXME: #warning "Add a netsplit parameter ?"
 	if(KviKvsEventManager::instance()->hasAppHandlers(KviEvent_OnQuit))
 	{
@@ -603,17 +622,14 @@ void KviIrcServerParser::parseLiteralQuit(KviIrcMessage * msg)
 
 		if(console->connection())
 		{
-			for(auto & c : console->connection()->channelList())
+			for(auto & c : console->connection()->channelsOf(szNick))
 			{
-				if(c->isOn(szNick))
+				if(chanlist.isEmpty())
+					chanlist = c->windowName();
+				else
 				{
-					if(chanlist.isEmpty())
-						chanlist = c->windowName();
-					else
-					{
-						chanlist.append(',');
-						chanlist.append(c->windowName());
-					}
+					chanlist.append(',');
+					chanlist.append(c->windowName());
 				}
 			}
 		}
@@ -629,7 +645,8 @@ void KviIrcServerParser::parseLiteralQuit(KviIrcMessage * msg)
 			msg->setHaltOutput();
 	}
 
-	for(auto & c : console->connection()->channelList())
+	// only the channels of the user: during a netsplit there may be thousands of QUITs
+	for(auto & c : console->connection()->channelsOf(szNick))
 	{
 		if(c->part(szNick))
 		{
@@ -1007,7 +1024,9 @@ void KviIrcServerParser::parseLiteralPrivmsg(KviIrcMessage * msg)
 				if(!theMsg.isEmpty())
 				{
 					KviCString spamWord;
-					if(kvi_mayBeSpam(theMsg, spamWord))
+					bool bSpam = kvi_mayBeSpam(theMsg, spamWord);
+					msg->connection()->statistics()->fastPathChecked(KviIrcConnectionStatistics::FastPathAntiSpam, !bSpam);
+					if(bSpam)
 					{
 						// FIXME: OnSpam ?
 						if(!(msg->haltOutput() || KVI_OPTION_BOOL(KviOption_boolSilentAntiSpam)))
@@ -1144,14 +1163,9 @@ void KviIrcServerParser::parseLiteralPrivmsg(KviIrcMessage * msg)
 						pOut = aWin;
 					else
 					{
-						for(auto & c : pConnection->channelList())
-						{
-							if(c->isOn(szOtherNick))
-							{
-								pOut = c;
-								break;
-							}
-						}
+						std::vector<KviChannelWindow *> chans = pConnection->channelsOf(szOtherNick);
+						if(!chans.empty())
+							pOut = chans.front();
 					}
 				}
 
@@ -1450,7 +1464,9 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 				if(!theMsg.isEmpty())
 				{
 					KviCString spamWord;
-					if(kvi_mayBeSpam(theMsg, spamWord))
+					bool bSpam = kvi_mayBeSpam(theMsg, spamWord);
+					msg->connection()->statistics()->fastPathChecked(KviIrcConnectionStatistics::FastPathAntiSpam, !bSpam);
+					if(bSpam)
 					{
 						// FIXME: OnSpam ?
 
@@ -1564,12 +1580,9 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 						pOut = aWin;
 					else
 					{
-						for(auto & c : pConnection->channelList())
-							if(c->isOn(szNick))
-							{
-								pOut = c;
-								break;
-							}
+						std::vector<KviChannelWindow *> chans = pConnection->channelsOf(szNick);
+						if(!chans.empty())
+							pOut = chans.front();
 					}
 				}
 
@@ -1774,7 +1787,7 @@ void KviIrcServerParser::parseLiteralNick(KviIrcMessage * msg)
 	if(pUserEntry)
 		pUserEntry->setSmartNickColor(-1);
 
-	for(auto & c : console->connection()->channelList())
+	for(auto & c : console->connection()->channelsOf(szNick))
 	{
 		if(c->nickChange(szNick, szNewNick))
 		{
@@ -1783,7 +1796,11 @@ void KviIrcServerParser::parseLiteralNick(KviIrcMessage * msg)
 				    &szNick, &szUser, &szHost, &szNewNick);
 			// FIXME if(bIsMe)output(YOU ARE now known as.. ?)
 		}
-		if(bIsMe)
+	}
+
+	if(bIsMe)
+	{
+		for(auto & c : console->connection()->channelList())
 			c->updateCaption();
 	}
 
@@ -2664,7 +2681,17 @@ void KviIrcServerParser::parseLiteralAway(KviIrcMessage * msg)
 
 	if(e)
 	{
-		e->setAway(!awayMsg.isEmpty());
+		bool bAway = !awayMsg.isEmpty();
+		if(e->isAway() != bAway)
+		{
+			e->setAway(bAway);
+			// the away users may be painted with a different color
+			for(auto & w : e->windowList())
+			{
+				if(w->type() == KviWindow::Channel)
+					((KviChannelWindow *)w)->userListView()->updateArea();
+			}
+		}
 	}
 
 	if(KVS_TRIGGER_EVENT_4_HALTED(KviEvent_OnAway, console, szNick, szUser, szHost, awayMsg))
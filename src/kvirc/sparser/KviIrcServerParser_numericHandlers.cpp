@@ -246,7 +246,6 @@ void KviIrcServerParser::parseNumeric005(KviIrcMessage * msg)
 			 * MAXLIST -> Maximum number entries in the list per mode (e.g. MAXLIST=beI:30)
 			 * WALLCHOPS -> The server supports messaging channel operators (deprecated by STATUSMSG, e.g. usage: NOTICE @#channel)
 			 * WALLVOICES -> The server supports messaging channel voiced users (deprecated by STATUSMSG, e.g. usage: NOTICE +#channel)
-			 * CASEMAPPING -> Case mapping used for nick- and channel name comparing (e.g. CASEMAPPING=rfc1459)
 			 * ELIST -> search extensions to list modes, like mask search, topic search, creation time search (e.g. ELIST=MNUCT)
 			 * KICKLEN -> Maximum kick comment length (e.g. KICKLEN=80)
 			 * CHANNELLEN -> Maximum channel name length (e.g. CHANNELLEN=50)
@@ -369,6 +368,21 @@ void KviIrcServerParser::parseNumeric005(KviIrcMessage * msg)
 					msg->console()->outputNoFmt(KVI_OUT_SERVERINFO, __tr2qs("This server supports the CODEPAGE command, it will be used"));
 
 			}
+			else if(kvi_strEqualCIN("CASEMAPPING=", p, 12))
+			{
+				// Case mapping used for nick- and channel name comparing (e.g. CASEMAPPING=rfc1459)
+				p += 12;
+				KviIrcConnectionServerInfo::CaseMapping eCaseMapping = KviIrcConnectionServerInfo::CaseMappingRfc1459;
+				if(kvi_strEqualCI("ascii", p) || kvi_strEqualCI("rfc7613", p))
+					eCaseMapping = KviIrcConnectionServerInfo::CaseMappingAscii; // rfc7613 is ascii plus unicode lowercasing, that we do anyway
+				else if(kvi_strEqualCI("strict-rfc1459", p))
+					eCaseMapping = KviIrcConnectionServerInfo::CaseMappingStrictRfc1459;
+				if(eCaseMapping != msg->connection()->serverInfo()->caseMapping())
+				{
+					msg->connection()->serverInfo()->setCaseMapping(eCaseMapping);
+					msg->connection()->caseMappingChanged();
+				}
+			}
 			else if(kvi_strEqualCIN("WHOX", p, 4))
 			{
 				msg->connection()->serverInfo()->setSupportsWhox(true);
@@ -622,6 +622,30 @@ void KviConsoleWindow::removeHighlightedChannel(const QString & szChan)
 	m_pTmpHighLightedChannels->removeOne(szChan);
 }
 
+bool KviConsoleWindow::highlightKeywordsMayMatch(const QString & szText, Qt::CaseSensitivity cs)
+{
+	QString szNick = connection() ? connection()->userInfo()->nickName() : QString();
+	const QStringList & lWords = KVI_OPTION_STRINGLIST(KviOption_stringlistHighlightWords);
+	KviKeywordMatcher::CaseMode eCaseMode = (cs == Qt::CaseSensitive) ? KviKeywordMatcher::CaseSensitive : KviKeywordMatcher::CaseInsensitive;
+
+	// the option list is shared with m_lHighlightWords until it changes: comparing is cheap
+	if((szNick != m_szHighlightNick) || (lWords != m_lHighlightWords))
+	{
+		m_szHighlightNick = szNick;
+		m_lHighlightWords = lWords;
+
+		QStringList lKeywords = lWords;
+		lKeywords.append(szNick);
+		m_highlightMatcher.setKeywords(lKeywords, eCaseMode);
+	}
+	else
+	{
+		m_highlightMatcher.setKeywords(m_highlightMatcher.keywords(), eCaseMode);
+	}
+
+	return m_highlightMatcher.find(szText) != -1;
+}
+
 // if it returns -1 you should just return and not display the message
 int KviConsoleWindow::applyHighlighting(KviWindow * wnd, int type, const QString & nick, const QString & user, const QString & host, const QString & szMsg)
 {
@@ -631,7 +655,16 @@ int KviConsoleWindow::applyHighlighting(KviWindow * wnd, int type, const QString
 	QRegExp rgxHlite;
 	Qt::CaseSensitivity cs = KVI_OPTION_BOOL(KviOption_boolCaseSensitiveHighlighting) ? Qt::CaseSensitive : Qt::CaseInsensitive;
 
-	if(KVI_OPTION_BOOL(KviOption_boolAlwaysHighlightNick) && connection())
+	// all the checks on the text below need the nickname or one of the words as a substring
+	bool bMayMatch = true;
+	if((KVI_OPTION_BOOL(KviOption_boolAlwaysHighlightNick) && connection()) || KVI_OPTION_BOOL(KviOption_boolUseWordHighlighting))
+	{
+		bMayMatch = highlightKeywordsMayMatch(szStripMsg, cs);
+		if(connection())
+			connection()->statistics()->fastPathChecked(KviIrcConnectionStatistics::FastPathHighlight, !bMayMatch);
+	}
+
+	if(bMayMatch && KVI_OPTION_BOOL(KviOption_boolAlwaysHighlightNick) && connection())
 	{
 		if(KVI_OPTION_BOOL(KviOption_boolUseFullWordHighlighting))
 		{
@@ -652,7 +685,7 @@ int KviConsoleWindow::applyHighlighting(KviWindow * wnd, int type, const QString
 		}
 	}
 
-	if(KVI_OPTION_BOOL(KviOption_boolUseWordHighlighting))
+	if(bMayMatch && KVI_OPTION_BOOL(KviOption_boolUseWordHighlighting))
 	{
 		for(auto & it : KVI_OPTION_STRINGLIST(KviOption_stringlistHighlightWords))
 		{
@@ -926,7 +959,7 @@ void KviConsoleWindow::avatarChanged(KviAvatar * avatar, const QString & nick, c
 	{
 		// cache it
 		if(avatar)
-			KviAvatarCache::instance()->replace(avatar->identificationString(), KviIrcMask(nick, user, host), currentNetworkName().toUtf8().data());
+			KviAvatarCache::instance()->replace(avatar->identificationString(), KviIrcMask(nick, user, host), currentNetworkName().toUtf8().data(), avatar->localPath());
 		else
 			KviAvatarCache::instance()->remove(KviIrcMask(nick, user, host), currentNetworkName().toUtf8().data());
 	}
@@ -34,6 +34,7 @@
 #include "KviIrcContext.h"
 #include "KviUserListView.h"
 #include "KviThemedComboBox.h"
+#include "KviKeywordMatcher.h"
 
 #include <time.h>
 #include <vector>
@@ -95,6 +96,11 @@ protected:
 	QStringList * m_pTmpHighLightedChannels;
 	KviIrcContext * m_pContext;
 	QList<int> m_SplitterSizesList;
+	// the highlight words and the nickname: applyHighlighting() runs
+	// the exact checks only if one of them is in the message
+	KviKeywordMatcher m_highlightMatcher;
+	QStringList m_lHighlightWords;
+	QString m_szHighlightNick;
 
 protected:
 	// UI
@@ -118,6 +124,8 @@ protected:
 	void destroyConnection();
 	// internal helper for applyHighlighting
 	int triggerOnHighlight(KviWindow * wnd, int type, const QString & nick, const QString & user, const QString & host, const QString & szMsg, const QString & trigger);
+	// internal helper for applyHighlighting: false if neither the nickname nor a highlight word is in the text
+	bool highlightKeywordsMayMatch(const QString & szText, Qt::CaseSensitivity cs);
 
 	void showNotifyList(bool bShow, bool bIgnoreSizeChange = false);
 	static int getSmartColorHashForNick(QString * szNick);
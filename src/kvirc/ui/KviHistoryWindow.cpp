@@ -62,8 +62,22 @@ void KviHistoryWindow::fill()
 {
 	clear();
 
-	for(auto & szTmp : KviInputHistory::instance()->list())
-		addItem(szTmp);
+	// with some text in the input line, show only the entries containing it (like a reverse search)
+	m_szFilter = m_pOwner ? m_pOwner->text() : QString();
+
+	if(m_szFilter.isEmpty())
+	{
+		for(auto & szTmp : KviInputHistory::instance()->list())
+			addItem(szTmp);
+	}
+	else
+	{
+		std::vector<QString> entries;
+		KviInputHistory::instance()->search(m_szFilter, entries, KVI_HISTORY_WIN_MAX_MATCHES);
+		// newest last, like the full list
+		for(auto it = entries.rbegin(); it != entries.rend(); ++it)
+			addItem(*it);
+	}
 
 	if(count() > 0)
 		setCurrentItem(item(count() - 1));
@@ -114,7 +128,12 @@ void KviHistoryWindow::keyPressEvent(QKeyEvent * e)
 	}
 
 	if(m_pOwner)
+	{
 		g_pApp->sendEvent(m_pOwner, e);
+		// typing refines the search
+		if(m_pOwner && (m_pOwner->text() != m_szFilter))
+			fill();
+	}
 }
 
 void KviHistoryWindow::ownerDead()
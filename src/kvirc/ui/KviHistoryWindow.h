@@ -30,6 +30,7 @@
 * \brief History window management
 *
 * \def KVI_HISTORY_WIN_HEIGHT The height of the history window
+* \def KVI_HISTORY_WIN_MAX_MATCHES The maximum number of entries shown when searching
 */
 
 #include "kvi_settings.h"
@@ -39,6 +40,7 @@
 class KviInput;
 
 #define KVI_HISTORY_WIN_HEIGHT 130
+#define KVI_HISTORY_WIN_MAX_MATCHES 500
 
 /**
 * \class KviHistoryWindow
@@ -64,6 +66,7 @@ private:
 	KviInput * m_pOwner;
 	int m_iTimerId;
 	QWidget * m_pParent;
+	QString m_szFilter;
 
 public:
 	/**
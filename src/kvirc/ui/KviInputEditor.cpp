@@ -3380,6 +3380,11 @@ void KviInputEditor::addToHistory(const QString &szString)
 	if(!m_History.empty() && m_History.front() == szString)
 		return;
 
+	// keep each string once, like KviInputHistory
+	std::vector<QString>::iterator it = std::find(m_History.begin(), m_History.end(), szString);
+	if(it != m_History.end())
+		m_History.erase(it);
+
 	m_History.insert(m_History.begin(), szString);
 
 	if(m_History.size() > KVI_INPUT_MAX_LOCAL_HISTORY_ENTRIES)
@@ -30,11 +30,63 @@
 #include "KviConfigurationFile.h"
 #include "KviCString.h"
 
-#include <QString>
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <algorithm>
+
+// the first line of the journal
+#define KVI_INPUT_HISTORY_JOURNAL_HEADER "#kvirc-inputhistory 1"
 
 KviInputHistory * KviInputHistory::m_pSelf = nullptr;
 unsigned int KviInputHistory::m_uCount = 0;
 
+static QString journal_escape(const QString & szString)
+{
+	QString szRet = szString;
+	szRet.replace(QChar('\\'), QString("\\\\"));
+	szRet.replace(QChar('\n'), QString("\\n"));
+	szRet.replace(QChar('\r'), QString("\\r"));
+	return szRet;
+}
+
+static QString journal_unescape(const QString & szString)
+{
+	QString szRet;
+	szRet.reserve(szString.length());
+	for(int i = 0; i < szString.length(); i++)
+	{
+		QChar c = szString.at(i);
+		if((c == QChar('\\')) && (i + 1 < szString.length()))
+		{
+			i++;
+			switch(szString.at(i).unicode())
+			{
+				case 'n':
+					szRet.append(QChar('\n'));
+					break;
+				case 'r':
+					szRet.append(QChar('\r'));
+					break;
+				default:
+					szRet.append(szString.at(i));
+					break;
+			}
+		}
+		else
+		{
+			szRet.append(c);
+		}
+	}
+	return szRet;
+}
+
+KviInputHistory::KviInputHistory()
+    : m_uNextSerial(1), m_uBytes(0), m_uPostings(0), m_uDeadPostings(0), m_uSavedSerial(0), m_uJournalRecords(0)
+{
+}
+
 void KviInputHistory::init()
 {
 	if((!m_pSelf) && (m_pSelf->count() == 0))
@@ -61,17 +113,180 @@ void KviInputHistory::delRef()
 	m_uCount--;
 }
 
+void KviInputHistory::trigrams(const QString & szString, std::vector<quint64> & keys)
+{
+	QString szFolded = szString.left(KVI_INPUT_HISTORY_INDEXED_LENGTH).toCaseFolded();
+	const ushort * p = szFolded.utf16();
+
+	keys.clear();
+	for(int i = 0; i + 2 < szFolded.length(); i++)
+		keys.push_back((((quint64)p[i]) << 32) | (((quint64)p[i + 1]) << 16) | ((quint64)p[i + 2]));
+
+	std::sort(keys.begin(), keys.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+void KviInputHistory::indexEntry(unsigned int uSerial, const QString & szString)
+{
+	std::vector<quint64> keys;
+	trigrams(szString, keys);
+
+	// the serials grow: the lists stay sorted
+	for(auto k : keys)
+		m_Trigrams[k].push_back(uSerial);
+	m_uPostings += keys.size();
+
+	if(szString.length() > KVI_INPUT_HISTORY_INDEXED_LENGTH)
+		m_LongEntries.push_back(uSerial);
+}
+
+void KviInputHistory::removeEntry(unsigned int uSerial)
+{
+	std::map<unsigned int, QString>::iterator it = m_Entries.find(uSerial);
+	if(it == m_Entries.end())
+		return;
+
+	// the postings are dropped lazily, by rebuildIndex()
+	std::vector<quint64> keys;
+	trigrams(it->second, keys);
+	m_uDeadPostings += keys.size();
+
+	m_uBytes -= it->second.length() * sizeof(QChar);
+	m_Serials.remove(it->second);
+	m_Entries.erase(it);
+}
+
+void KviInputHistory::rebuildIndex()
+{
+	m_Trigrams.clear();
+	m_LongEntries.clear();
+	m_uPostings = 0;
+	m_uDeadPostings = 0;
+
+	for(auto & e : m_Entries)
+		indexEntry(e.first, e.second);
+}
+
 void KviInputHistory::add(const QString & szString)
 {
-	if(!m_StringList.empty() && m_StringList.back() == szString)
+	if(szString.isEmpty())
+		return;
+
+	if(!m_Entries.empty() && m_Entries.rbegin()->second == szString)
+		return;
+
+	QHash<QString, unsigned int>::iterator it = m_Serials.find(szString);
+	if(it != m_Serials.end())
+		removeEntry(it.value());
+
+	unsigned int uSerial = m_uNextSerial++;
+	m_Entries.emplace(uSerial, szString);
+	m_Serials.insert(szString, uSerial);
+	m_uBytes += szString.length() * sizeof(QChar);
+	indexEntry(uSerial, szString);
+
+	while((m_Entries.size() > 1) && ((m_Entries.size() > KVI_INPUT_MAX_GLOBAL_HISTORY_ENTRIES) || (m_uBytes > KVI_INPUT_MAX_GLOBAL_HISTORY_BYTES)))
+		removeEntry(m_Entries.begin()->first);
+
+	if((m_uDeadPostings > 1024) && (m_uDeadPostings > (m_uPostings / 2)))
+		rebuildIndex();
+}
+
+std::vector<QString> KviInputHistory::list()
+{
+	std::vector<QString> ret;
+	ret.reserve(m_Entries.size());
+	for(auto & e : m_Entries)
+		ret.push_back(e.second);
+	return ret;
+}
+
+void KviInputHistory::search(const QString & szText, std::vector<QString> & entries, unsigned int uMax)
+{
+	entries.clear();
+	if(szText.isEmpty() || (uMax == 0))
+		return;
+
+	if(szText.length() < 3)
+	{
+		// no trigrams to look up
+		for(std::map<unsigned int, QString>::reverse_iterator it = m_Entries.rbegin(); it != m_Entries.rend(); ++it)
+		{
+			if(it->second.contains(szText, Qt::CaseInsensitive))
+			{
+				entries.push_back(it->second);
+				if(entries.size() >= uMax)
+					return;
+			}
+		}
 		return;
+	}
+
+	std::vector<quint64> keys;
+	trigrams(szText, keys);
 
-	m_StringList.push_back(szString);
-	if(m_StringList.size() > KVI_INPUT_MAX_GLOBAL_HISTORY_ENTRIES)
-		m_StringList.erase(m_StringList.begin());
+	// the rarest trigram gives the shortest candidate list
+	const std::vector<unsigned int> * pBest = nullptr;
+	for(auto k : keys)
+	{
+		QHash<quint64, std::vector<unsigned int>>::const_iterator t = m_Trigrams.constFind(k);
+		if(t == m_Trigrams.constEnd())
+		{
+			pBest = nullptr;
+			break;
+		}
+		if(!pBest || (t.value().size() < pBest->size()))
+			pBest = &(t.value());
+	}
+
+	// the long entries might match past the indexed part
+	std::vector<unsigned int> candidates(m_LongEntries);
+	if(pBest)
+		candidates.insert(candidates.end(), pBest->begin(), pBest->end());
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	for(std::vector<unsigned int>::reverse_iterator c = candidates.rbegin(); c != candidates.rend(); ++c)
+	{
+		std::map<unsigned int, QString>::iterator it = m_Entries.find(*c);
+		if(it == m_Entries.end())
+			continue; // removed
+		if(it->second.contains(szText, Qt::CaseInsensitive))
+		{
+			entries.push_back(it->second);
+			if(entries.size() >= uMax)
+				return;
+		}
+	}
 }
 
 void KviInputHistory::load(const QString & szFileName)
+{
+	QFile f(szFileName);
+	if(!f.open(QIODevice::ReadOnly))
+		return;
+
+	QTextStream ts(&f);
+	ts.setCodec("UTF-8");
+
+	unsigned int uRecords = 0;
+	while(!ts.atEnd())
+	{
+		QString szLine = ts.readLine();
+		// anything else is a comment or comes from a newer version
+		if(!szLine.startsWith(QChar('+')))
+			continue;
+		add(journal_unescape(szLine.mid(1)));
+		uRecords++;
+	}
+
+	// what we have in memory is all in the journal
+	m_szJournalFile = szFileName;
+	m_uSavedSerial = m_uNextSerial - 1;
+	m_uJournalRecords = uRecords;
+}
+
+void KviInputHistory::loadLegacy(const QString & szFileName)
 {
 	KviConfigurationFile c(szFileName, KviConfigurationFile::Read);
 
@@ -91,23 +306,52 @@ void KviInputHistory::load(const QString & szFileName)
 	}
 }
 
+void KviInputHistory::rewriteJournal(const QString & szFileName)
+{
+	QSaveFile f(szFileName);
+	if(!f.open(QIODevice::WriteOnly))
+		return;
+
+	QTextStream ts(&f);
+	ts.setCodec("UTF-8");
+	ts << KVI_INPUT_HISTORY_JOURNAL_HEADER << "\n";
+	for(auto & e : m_Entries)
+		ts << "+" << journal_escape(e.second) << "\n";
+	ts.flush();
+
+	if(!f.commit())
+		return;
+
+	m_szJournalFile = szFileName;
+	m_uSavedSerial = m_uNextSerial - 1;
+	m_uJournalRecords = m_Entries.size();
+}
+
 void KviInputHistory::save(const QString & szFileName)
 {
-	KviConfigurationFile c(szFileName, KviConfigurationFile::Write);
-	c.clear();
+	// compact when most of the records are stale
+	if((szFileName != m_szJournalFile) || (m_uJournalRecords > (2 * m_Entries.size() + 64)))
+	{
+		rewriteJournal(szFileName);
+		return;
+	}
 
-	KviCString szTmp;
-	int iIdx = 0;
+	std::map<unsigned int, QString>::iterator it = m_Entries.upper_bound(m_uSavedSerial);
+	if(it == m_Entries.end())
+		return; // nothing new
+
+	QFile f(szFileName);
+	if(!f.open(QIODevice::WriteOnly | QIODevice::Append))
+		return;
 
-	for(auto & szString : m_StringList)
+	QTextStream ts(&f);
+	ts.setCodec("UTF-8");
+	for(; it != m_Entries.end(); ++it)
 	{
-		if(!szString.isEmpty())
-		{
-			szTmp.sprintf("S%d", iIdx);
-			c.writeEntry(szTmp.ptr(), szString);
-			iIdx++;
-		}
+		ts << "+" << journal_escape(it->second) << "\n";
+		m_uJournalRecords++;
 	}
+	ts.flush();
 
-	c.writeEntry("Count", iIdx);
+	m_uSavedSerial = m_uNextSerial - 1;
 }
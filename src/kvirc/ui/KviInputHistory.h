@@ -33,18 +33,33 @@
 * \author Elvio Basello
 * \brief Input history management
 *
+* Each string is stored once: adding it again moves it to the end.
+* The history is saved to an append-only journal: each save appends
+* the strings added since the previous one and the file is rewritten
+* only when it has grown well beyond the live entries.
+*
+* The case folded trigrams of the entries are indexed, so search()
+* doesn't need to look at every entry.
+*
 * \def KVI_INPUT_MAX_GLOBAL_HISTORY_ENTRIES
+* \def KVI_INPUT_MAX_GLOBAL_HISTORY_BYTES
 * \def KVI_INPUT_MAX_LOCAL_HISTORY_ENTRIES
+* \def KVI_INPUT_HISTORY_INDEXED_LENGTH
 */
 
 #include "kvi_settings.h"
 
-#include <vector>
+#include <QHash>
+#include <QString>
 
-class QString;
+#include <map>
+#include <vector>
 
-#define KVI_INPUT_MAX_GLOBAL_HISTORY_ENTRIES 500
+#define KVI_INPUT_MAX_GLOBAL_HISTORY_ENTRIES 10000
+#define KVI_INPUT_MAX_GLOBAL_HISTORY_BYTES (4 * 1024 * 1024)
 #define KVI_INPUT_MAX_LOCAL_HISTORY_ENTRIES 50
+// only the beginning of the entries is indexed: the longer ones are scanned
+#define KVI_INPUT_HISTORY_INDEXED_LENGTH 256
 
 /**
 * \class KviInputHistory
@@ -56,8 +71,28 @@ private:
 	static KviInputHistory * m_pSelf;
 	static unsigned int m_uCount;
 
+public:
+	KviInputHistory();
+
 protected:
-	std::vector<QString> m_StringList;
+	// the entries by serial, oldest first
+	std::map<unsigned int, QString> m_Entries;
+	// string -> serial, to keep each string once
+	QHash<QString, unsigned int> m_Serials;
+	unsigned int m_uNextSerial;
+	unsigned int m_uBytes;
+
+	// trigram -> serials of the entries containing it, ascending.
+	// The serials of the removed entries are dropped when the index is rebuilt.
+	QHash<quint64, std::vector<unsigned int>> m_Trigrams;
+	// serials of the entries longer than KVI_INPUT_HISTORY_INDEXED_LENGTH
+	std::vector<unsigned int> m_LongEntries;
+	unsigned int m_uPostings;
+	unsigned int m_uDeadPostings;
+
+	QString m_szJournalFile;
+	unsigned int m_uSavedSerial; // the entries above this are not in the journal yet
+	unsigned int m_uJournalRecords;
 
 public:
 	/**
@@ -98,30 +133,58 @@ public:
 
 	/**
 	* \brief Adds a string to the history
+	*
+	* If the string is already in the history it's moved to the end.
 	* \param szString The string to add
 	* \return void
 	*/
 	void add(const QString & szString);
 
 	/**
-	* \brief Returns the list of string in the history
-	* \return KviPointerList<QString> *
+	* \brief Returns the list of string in the history, oldest first
+	* \return std::vector<QString>
+	*/
+	std::vector<QString> list();
+
+	/**
+	* \brief Finds the entries containing a string (case insensitive)
+	* \param szText The string to look for
+	* \param entries The matching entries, newest first
+	* \param uMax The maximum number of entries to return
+	* \return void
 	*/
-	std::vector<QString> list() { return m_StringList; };
+	void search(const QString & szText, std::vector<QString> & entries, unsigned int uMax);
 
 	/**
 	* \brief Saves the history
-	* \param szFileName The name of the file where to save
+	*
+	* Only the entries added since the last save are appended, unless
+	* the journal is a different file or needs to be compacted.
+	* \param szFileName The name of the journal
 	* \return void
 	*/
 	void save(const QString & szFileName);
 
 	/**
-	* \brief Loads the history
-	* \param szFileName The name of the file to load
+	* \brief Loads the history from a journal
+	* \param szFileName The name of the journal
 	* \return void
 	*/
 	void load(const QString & szFileName);
+
+	/**
+	* \brief Loads the history saved by the previous versions as a configuration file
+	* \param szFileName The name of the file to load
+	* \return void
+	*/
+	void loadLegacy(const QString & szFileName);
+
+protected:
+	static void trigrams(const QString & szString, std::vector<quint64> & keys);
+	void indexEntry(unsigned int uSerial, const QString & szString);
+	void removeEntry(unsigned int uSerial);
+	void rebuildIndex();
+	void rewriteJournal(const QString & szFileName);
 };
 
 #endif //_KVI_INPUT_HISTORY_H_
@@ -70,6 +70,8 @@
 #include "KviIrcView.h"
 #include "KviIrcView_tools.h"
 #include "KviIrcView_private.h"
+#include "KviIrcView_heightindex.h"
+#include "KviIrcView_spill.h"
 #include "kvi_debug.h"
 #include "KviApplication.h"
 #include "kvi_settings.h"
@@ -108,6 +110,9 @@
 #include <QWindow>
 
 #include <ctime>
+#include <algorithm>
+#include <climits>
+#include <deque>
 
 #ifdef COMPILE_ON_WINDOWS
 #pragma warning(disable : 4102)
@@ -158,6 +163,9 @@ extern QPixmap * g_pShadedChildGlobalDesktopBackground;
 #define KVI_IRCVIEW_SIZEHINT_WIDTH 150
 #define KVI_IRCVIEW_SIZEHINT_HEIGHT 150
 
+// lines paged in from the disk at once when scrolling up
+#define KVI_IRCVIEW_SPILL_PAGE_LINES 256
+
 #define KVI_IRCVIEW_BLOCK_SELECTION_TOTAL 0
 #define KVI_IRCVIEW_BLOCK_SELECTION_LEFT 1
 #define KVI_IRCVIEW_BLOCK_SELECTION_RIGHT 2
@@ -213,6 +221,22 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 	m_bHaveUnreadedMessages = false;
 	m_iNumLines = 0;
 	m_iMaxLines = KVI_OPTION_UINT(KviOption_uintIrcViewMaxBufferSize);
+	m_pStoreView = nullptr;
+	m_pSplitView = nullptr;
+	m_bClassChain = false;
+	m_pStoreFirstLine = nullptr;
+	m_pStoreLastLine = nullptr;
+	for(int i = 0; i < 2; i++)
+	{
+		m_pClassFirstLine[i] = nullptr;
+		m_pClassLastLine[i] = nullptr;
+		m_pClassIndex[i] = new KviIrcViewHeightIndex(true);
+	}
+	m_pStoreIndex = new KviIrcViewHeightIndex(false);
+	m_pHeightIndex = m_pStoreIndex;
+	m_pSpillFile = nullptr;
+	m_bDiscardingLines = false;
+	m_bLoadingSpilledLines = false;
 
 	m_uNextLineIndex = 0;
 	m_pSelectionInitLine = nullptr;
@@ -238,7 +262,7 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 	m_bAcceptDrops = false;
 	m_pPrivateBackgroundPixmap = nullptr;
 	m_bSkipScrollBarRepaint = false;
-	m_pLogFile = nullptr;
+	m_iLogFile = -1;
 	m_pKviWindow = pWnd;
 
 	m_iUnprocessedPaintEventRequests = 0;
@@ -356,7 +380,25 @@ KviIrcView::~KviIrcView()
 		delete m_pPrivateBackgroundPixmap;
 
 	// and to remove all the text lines
-	emptyBuffer(false);
+	if(m_pStoreView)
+	{
+		// we're a split view: the lines belong to the master
+		m_pStoreView->splitViewDead();
+	}
+	else
+	{
+		if(m_pSplitView)
+			m_pSplitView->detachFromStore();
+		KviIrcViewLine * l = m_pStoreFirstLine;
+		while(l)
+		{
+			KviIrcViewLine * pNext = l->pNext;
+			delete_text_line(l, &m_hAnimatedSmiles);
+			l = pNext;
+		}
+		m_pStoreFirstLine = nullptr;
+		m_pStoreLastLine = nullptr;
+	}
 
 	// the pending ones too!
 	for(const auto & l : m_pMessagesStoppedWhileSelecting)
@@ -364,6 +406,12 @@ KviIrcView::~KviIrcView()
 
 	m_pMessagesStoppedWhileSelecting.clear();
 
+	delete m_pStoreIndex;
+	delete m_pClassIndex[0];
+	delete m_pClassIndex[1];
+	if(m_pSpillFile)
+		delete m_pSpillFile;
+
 	if(m_pFm)
 		delete m_pFm;
 
@@ -404,7 +452,7 @@ void KviIrcView::setFont(const QFont & f)
 	while(l)
 	{
 		l->iMaxLineWidth = -1;
-		l = l->pNext;
+		l = viewNext(l);
 	}
 
 	QFont newFont(f);
@@ -482,8 +530,14 @@ void KviIrcView::setPrivateBackgroundPixmap(const QPixmap & pixmap, bool bRepain
 
 void KviIrcView::emptyBuffer(bool bRepaint)
 {
+	KviIrcView * pStore = store();
+	pStore->m_bDiscardingLines = true;
 	while(m_pLastLine != nullptr)
 		removeHeadLine();
+	pStore->m_bDiscardingLines = false;
+	// the user wants a clean view: don't page the old history back in
+	if(pStore->m_pSpillFile)
+		pStore->m_pSpillFile->discard(spillClassMask());
 	if(bRepaint)
 		update();
 }
@@ -562,26 +616,21 @@ void KviIrcView::scrollBarPositionChanged(int newValue)
 {
 	if(!m_pCurLine)
 		return;
-	if(newValue > m_iLastScrollBarValue)
-	{
-		while(newValue > m_iLastScrollBarValue)
-		{
-			if(m_pCurLine->pNext)
-			{
-				m_pCurLine = m_pCurLine->pNext;
-			}
-			m_iLastScrollBarValue++;
-		}
-	}
-	else
-	{
-		while(newValue < m_iLastScrollBarValue)
-		{
-			if(m_pCurLine->pPrev)
-				m_pCurLine = m_pCurLine->pPrev;
-			m_iLastScrollBarValue--;
-		}
-	}
+	// jump directly to the target line instead of walking the list one step at a time
+	int iTarget = (int)m_pHeightIndex->ordinal(m_pCurLine) + (newValue - m_iLastScrollBarValue);
+	if(iTarget < 0)
+		iTarget = 0;
+	else if(iTarget >= (int)m_pHeightIndex->count())
+		iTarget = m_pHeightIndex->count() - 1;
+	m_pCurLine = m_pHeightIndex->lineAt(iTarget);
+	bool bScrolledUp = newValue < m_iLastScrollBarValue;
+	m_iLastScrollBarValue = newValue;
+
+	// the user is approaching the top of the buffer or a hole left by a search:
+	// page in the history spilled to disk
+	if(!m_bSkipScrollBarRepaint && store()->m_pSpillFile)
+		loadSpilledLinesNearView(bScrolledUp, iTarget);
+
 	if(!m_bSkipScrollBarRepaint)
 		repaint();
 }
@@ -629,7 +678,7 @@ void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool b
 
 	// First log the line and assign the index
 	// Don't use add2log here!...we must go as fast as possible, so we avoid some push and pop calls, and also a couple of branches
-	if(m_pLogFile && KVI_OPTION_BOOL(KviOption_boolStripControlCodesInLogs))
+	if(isLogging() && KVI_OPTION_BOOL(KviOption_boolStripControlCodesInLogs))
 	{
 		// a slave view has no log files!
 		if(KVI_OPTION_MSGTYPE(ptr->iMsgType).logEnabled())
@@ -654,7 +703,7 @@ void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool b
 		// no log: we could have master view!
 		if(m_pMasterView)
 		{
-			if(m_pMasterView->m_pLogFile && KVI_OPTION_BOOL(KviOption_boolStripControlCodesInLogs))
+			if(m_pMasterView->isLogging() && KVI_OPTION_BOOL(KviOption_boolStripControlCodesInLogs))
 			{
 				if(KVI_OPTION_MSGTYPE(ptr->iMsgType).logEnabled())
 					m_pMasterView->add2Log(ptr->szText, date, ptr->iMsgType, false);
@@ -669,26 +718,45 @@ void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool b
 		}
 	}
 
+	// Link the line in the store: when the store is split the line
+	// might be shown by the other view.
+	KviIrcView * pStore = store();
+	pStore->storeAppend(ptr);
+	pStore->viewShowingLine(ptr)->viewAppend(ptr, bRepaint);
+}
+
+void KviIrcView::viewAppend(KviIrcViewLine * ptr, bool bRepaint)
+{
+	// The line is already linked in the store: update the view state
 	if(m_pLastLine)
 	{
 		// There is at least one line in the view
-		m_pLastLine->pNext = ptr;
-		ptr->pPrev = m_pLastLine;
-		ptr->pNext = nullptr;
 		m_iNumLines++;
 
 		if(m_iNumLines > m_iMaxLines)
 		{
-			// Too many lines in the view...remove one
-			removeHeadLine();
 			if(m_pCurLine == m_pLastLine)
 			{
+				// Too many lines in the view...remove the oldest ones: this
+				// includes the history paged in from the disk, if any.
+				while(m_iNumLines > m_iMaxLines)
+					removeHeadLine();
 				m_pCurLine = ptr;
+				if(m_iLastScrollBarValue != m_iNumLines)
+				{
+					m_bSkipScrollBarRepaint = true;
+					m_iLastScrollBarValue = m_iNumLines;
+					m_pScrollBar->setRange(0, m_iNumLines);
+					m_pScrollBar->setValue(m_iNumLines);
+					m_bSkipScrollBarRepaint = false;
+				}
 				if(bRepaint)
 					postUpdateEvent();
 			}
 			else
 			{
+				// Too many lines in the view...remove one
+				removeHeadLine();
 				// the cur line remains the same
 				// the scroll bar must move up one place to be in sync
 				m_bSkipScrollBarRepaint = true;
@@ -722,8 +790,6 @@ void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool b
 		m_pLastLine = ptr;
 		m_pFirstLine = ptr;
 		m_pCurLine = ptr;
-		ptr->pPrev = nullptr;
-		ptr->pNext = nullptr;
 		m_iNumLines = 1;
 		m_pScrollBar->setRange(0, 1);
 		m_pScrollBar->triggerAction(QAbstractSlider::SliderSingleStepAdd);
@@ -744,24 +810,26 @@ void KviIrcView::removeHeadLine(bool bRepaint)
 	if(m_pFirstLine == m_pCursorLine)
 		m_pCursorLine = nullptr;
 
-	if(m_pFirstLine->pNext)
+	KviIrcViewLine * pHead = m_pFirstLine;
+
+	if(viewNext(pHead))
 	{
-		KviIrcViewLine * aux_ptr = m_pFirstLine->pNext; // get the next line
-		aux_ptr->pPrev = nullptr;                       // becomes the first
-		if(m_pFirstLine == m_pCurLine)
-			m_pCurLine = aux_ptr;                       // move the cur line if necessary
-		delete_text_line(m_pFirstLine, &m_hAnimatedSmiles); // delete the struct
-		m_pFirstLine = aux_ptr;                             // set the last
-		m_iNumLines--;                                      // and decrement the count
+		KviIrcViewLine * aux_ptr = viewNext(pHead); // get the next line: becomes the first
+		if(pHead == m_pCurLine)
+			m_pCurLine = aux_ptr; // move the cur line if necessary
+		m_pFirstLine = aux_ptr;   // set the last
+		m_iNumLines--;            // and decrement the count
 	}
 	else
 	{	// unique line
 		m_pCurLine = nullptr;
-		delete_text_line(m_pFirstLine, &m_hAnimatedSmiles);
 		m_pFirstLine = nullptr;
 		m_iNumLines = 0;
 		m_pLastLine = nullptr;
 	}
+
+	store()->storeRemove(pHead); // unlink and delete the struct
+
 	if(bRepaint)
 		repaint();
 }
@@ -790,102 +858,527 @@ bool KviIrcView::messageShouldGoToMessageView(int iMsgType)
 	return false;
 }
 
-void KviIrcView::splitMessagesTo(KviIrcView * v)
+//
+// The line store
+//
+
+void KviIrcView::storeAppend(KviIrcViewLine * pLine)
 {
-	v->emptyBuffer(false);
+	// Links the line at the end of the chain of all the lines and of the chain of its class
+	int iClass = messageShouldGoToMessageView(pLine->iMsgType) ? 1 : 0;
+	pLine->bMessageViewLine = (iClass == 1);
+
+	pLine->pPrev = m_pStoreLastLine;
+	pLine->pNext = nullptr;
+	if(m_pStoreLastLine)
+		m_pStoreLastLine->pNext = pLine;
+	else
+		m_pStoreFirstLine = pLine;
+	m_pStoreLastLine = pLine;
 
-	KviIrcViewLine * l = m_pFirstLine;
-	KviIrcViewLine * tmp;
-	while(l)
+	pLine->pPrevInClass = m_pClassLastLine[iClass];
+	pLine->pNextInClass = nullptr;
+	if(m_pClassLastLine[iClass])
+		m_pClassLastLine[iClass]->pNextInClass = pLine;
+	else
+		m_pClassFirstLine[iClass] = pLine;
+	m_pClassLastLine[iClass] = pLine;
+
+	m_pStoreIndex->append(pLine);
+	m_pClassIndex[iClass]->append(pLine);
+}
+
+void KviIrcView::storeRemove(KviIrcViewLine * pLine)
+{
+	// Unlinks the line from both its chains and deletes it.
+	// The view showing it must have already forgotten it.
+	int iClass = pLine->bMessageViewLine ? 1 : 0;
+
+	if(pLine->pPrev)
+		pLine->pPrev->pNext = pLine->pNext;
+	else
+		m_pStoreFirstLine = pLine->pNext;
+	if(pLine->pNext)
+		pLine->pNext->pPrev = pLine->pPrev;
+	else
+		m_pStoreLastLine = pLine->pPrev;
+
+	if(pLine->pPrevInClass)
+		pLine->pPrevInClass->pNextInClass = pLine->pNextInClass;
+	else
+		m_pClassFirstLine[iClass] = pLine->pNextInClass;
+	if(pLine->pNextInClass)
+		pLine->pNextInClass->pPrevInClass = pLine->pPrevInClass;
+	else
+		m_pClassLastLine[iClass] = pLine->pPrevInClass;
+
+	m_pStoreIndex->remove(pLine);
+	m_pClassIndex[iClass]->remove(pLine);
+
+	if(!m_bDiscardingLines && (KVI_OPTION_UINT(KviOption_uintIrcViewMaxSpilledLines) > 0))
+	{
+		if(!m_pSpillFile)
+			m_pSpillFile = new KviIrcViewSpillFile();
+		m_pSpillFile->spill(pLine, KVI_OPTION_UINT(KviOption_uintIrcViewMaxSpilledLines));
+	}
+
+	// the split view might have created it
+	if(m_pSplitView)
+		m_pSplitView->m_hAnimatedSmiles.remove(pLine);
+	delete_text_line(pLine, &m_hAnimatedSmiles);
+}
+
+void KviIrcView::storeLineRowsChanged(KviIrcViewLine * pLine)
+{
+	m_pStoreIndex->setRows(pLine, pLine->uLineWraps + 1);
+	m_pClassIndex[pLine->bMessageViewLine ? 1 : 0]->setRows(pLine, pLine->uLineWraps + 1);
+}
+
+void KviIrcView::rebuildStoreChains()
+{
+	// Relinks the class chains and reindexes everything after
+	// the chain of all the lines has been changed as a whole
+	for(int i = 0; i < 2; i++)
+	{
+		m_pClassFirstLine[i] = nullptr;
+		m_pClassLastLine[i] = nullptr;
+	}
+
+	for(KviIrcViewLine * l = m_pStoreFirstLine; l; l = l->pNext)
+	{
+		int iClass = messageShouldGoToMessageView(l->iMsgType) ? 1 : 0;
+		l->bMessageViewLine = (iClass == 1);
+		l->pPrevInClass = m_pClassLastLine[iClass];
+		l->pNextInClass = nullptr;
+		if(m_pClassLastLine[iClass])
+			m_pClassLastLine[iClass]->pNextInClass = l;
+		else
+			m_pClassFirstLine[iClass] = l;
+		m_pClassLastLine[iClass] = l;
+	}
+
+	m_pStoreIndex->rebuild(m_pStoreFirstLine);
+	m_pClassIndex[0]->rebuild(m_pClassFirstLine[0]);
+	m_pClassIndex[1]->rebuild(m_pClassFirstLine[1]);
+}
+
+KviIrcView * KviIrcView::viewShowingLine(KviIrcViewLine * pLine)
+{
+	if(m_pSplitView && pLine->bMessageViewLine)
+		return m_pSplitView;
+	return this;
+}
+
+void KviIrcView::resetViewChain()
+{
+	// Shows the chain we're set to, scrolled to the bottom
+	KviIrcView * pStore = store();
+	if(m_bClassChain)
+	{
+		// the master shows the lines that don't go to the message view
+		int iClass = m_pStoreView ? 1 : 0;
+		m_pFirstLine = pStore->m_pClassFirstLine[iClass];
+		m_pLastLine = pStore->m_pClassLastLine[iClass];
+		m_pHeightIndex = pStore->m_pClassIndex[iClass];
+	}
+	else
+	{
+		m_pFirstLine = pStore->m_pStoreFirstLine;
+		m_pLastLine = pStore->m_pStoreLastLine;
+		m_pHeightIndex = pStore->m_pStoreIndex;
+	}
+
+	m_pCurLine = m_pLastLine;
+	m_pCursorLine = nullptr;
+	m_iNumLines = m_pHeightIndex->count();
+
+	m_iLastScrollBarValue = m_iNumLines;
+	m_pScrollBar->setRange(0, m_iNumLines);
+	m_pScrollBar->setValue(m_iNumLines);
+}
+
+void KviIrcView::detachFromStore()
+{
+	// We're a split view and the master is taking back its lines
+	m_pStoreView = nullptr;
+	m_bClassChain = false;
+	m_pSelectionInitLine = nullptr;
+	m_pSelectionEndLine = nullptr;
+	m_hAnimatedSmiles.clear();
+	resetViewChain();
+}
+
+void KviIrcView::forgetStoredLines()
+{
+	// Our lines are being moved to another store: drop them without deleting
+	for(KviIrcViewLine * l = m_pStoreFirstLine; l; l = l->pNext)
 	{
-		if(messageShouldGoToMessageView(l->iMsgType))
+		// our spill file isn't theirs
+		l->uSpillId = 0;
+		l->bSpillGapAbove = false;
+	}
+
+	if(m_pSplitView)
+	{
+		m_pSplitView->detachFromStore();
+		m_pSplitView = nullptr;
+		m_bClassChain = false;
+	}
+
+	m_pStoreFirstLine = nullptr;
+	m_pStoreLastLine = nullptr;
+	for(int i = 0; i < 2; i++)
+	{
+		m_pClassFirstLine[i] = nullptr;
+		m_pClassLastLine[i] = nullptr;
+		m_pClassIndex[i]->clear();
+	}
+	m_pStoreIndex->clear();
+	resetViewChain();
+}
+
+void KviIrcView::splitViewDead()
+{
+	// The split view is being destroyed without a join: show all the lines again
+	m_pSplitView = nullptr;
+	if(!m_bClassChain)
+		return;
+	m_bClassChain = false;
+	resetViewChain();
+	update();
+}
+
+unsigned int KviIrcView::spillClassMask() const
+{
+	// the classes of the spilled lines that we show (see KviIrcViewSpillFile::candidates())
+	if(!m_bClassChain)
+		return 3;
+	return m_pStoreView ? 2 : 1;
+}
+
+void KviIrcView::loadSpilledLines(const std::vector<unsigned int> & ids, KviIrcViewLine * pBelow)
+{
+	KviIrcView * pStore = store();
+	if(!pStore->m_pSpillFile || pStore->m_bLoadingSpilledLines || ids.empty())
+		return;
+
+	std::vector<KviIrcViewLine *> lines;
+	lines.reserve(ids.size());
+	for(auto uId : ids)
+	{
+		KviIrcViewLine * l = pStore->m_pSpillFile->load(uId);
+		if(l)
+			lines.push_back(l);
+	}
+	if(lines.empty())
+		return;
+
+	std::sort(lines.begin(), lines.end(), [](const KviIrcViewLine * a, const KviIrcViewLine * b) { return a->uIndex < b->uIndex; });
+
+	pStore->m_bLoadingSpilledLines = true;
+	pStore->storeInsertLines(lines, pBelow);
+	pStore->m_bLoadingSpilledLines = false;
+}
+
+void KviIrcView::loadSpilledLinesNearView(bool bScrolledUp, int iTarget)
+{
+	int iPage = m_pScrollBar->pageStep();
+	if(bScrolledUp && (iTarget < (2 * iPage)))
+	{
+		loadSpilledRange(nullptr, m_pFirstLine, true);
+		return;
+	}
+
+	// Look for a hole a couple of pages ahead in the scrolling direction.
+	// Coming from below it's filled from the newest lines, from above from the oldest ones.
+	KviIrcViewLine * l = m_pCurLine;
+	int iSteps = 3 * iPage;
+	if(!bScrolledUp)
+	{
+		// start from the top of the view
+		for(int i = 0; (i < iPage) && viewPrev(l); i++)
+			l = viewPrev(l);
+	}
+
+	while(l && (iSteps-- > 0) && !l->bSpillGapAbove)
+		l = bScrolledUp ? viewPrev(l) : viewNext(l);
+	if(!l || (iSteps < 0))
+		return;
+
+	KviIrcViewLine * pAbove = viewPrev(l);
+	if(bScrolledUp)
+	{
+		// the hole moves up to the oldest line paged in, if it's not closed
+		l->bSpillGapAbove = false;
+		if(loadSpilledRange(pAbove, l, true) < KVI_IRCVIEW_SPILL_PAGE_LINES)
+			return;
+		if(pAbove)
+			viewNext(pAbove)->bSpillGapAbove = true;
+	}
+	else
+	{
+		if(loadSpilledRange(pAbove, l, false) < KVI_IRCVIEW_SPILL_PAGE_LINES)
+			l->bSpillGapAbove = false;
+	}
+}
+
+unsigned int KviIrcView::loadSpilledRange(KviIrcViewLine * pAbove, KviIrcViewLine * pBelow, bool bNewestFirst)
+{
+	// Pages in up to a page of the spilled lines that we show between pAbove
+	// and pBelow (nullptr: the top and the bottom of the buffer) starting from
+	// the newest or the oldest one. Returns the number of records found.
+	KviIrcViewSpillFile * pSpill = store()->m_pSpillFile;
+	if(!pSpill)
+		return 0;
+
+	unsigned int uFrom = pAbove ? pAbove->uIndex + 1 : 0;
+	unsigned int uBefore = pBelow ? pBelow->uIndex : UINT_MAX;
+	unsigned int uMask = spillClassMask();
+
+	// the records of the bounding lines (if they come from the disk) are good starting points
+	std::vector<unsigned int> ids;
+	unsigned int uId = bNewestFirst ? (pBelow ? pBelow->uSpillId : 0) : (pAbove ? pAbove->uSpillId : 0);
+	while(ids.size() < KVI_IRCVIEW_SPILL_PAGE_LINES)
+	{
+		uId = bNewestFirst ? pSpill->older(uId, uFrom, uBefore, uMask) : pSpill->newer(uId, uFrom, uBefore, uMask);
+		if(!uId)
+			break;
+		ids.push_back(uId);
+	}
+
+	loadSpilledLines(ids, pBelow);
+	return ids.size();
+}
+
+void KviIrcView::storeInsertLines(const std::vector<KviIrcViewLine *> & lines, KviIrcViewLine * pBelow)
+{
+	// Splices the lines (sorted by index) in the chains without walking the
+	// whole history: pBelow, if not nullptr, is a stored line newer than all
+	// of them. They're linked from the newest one, each right before the
+	// previous one or a few lines above: the walks are short and the index
+	// finds a free slot right before the following line.
+	if(lines.empty())
+		return;
+
+	KviIrcViewLine * pNext = pBelow;
+	if(!pNext)
+	{
+		pNext = m_pStoreFirstLine;
+		while(pNext && (pNext->uIndex < lines.back()->uIndex))
+			pNext = pNext->pNext;
+	}
+
+	// the class chain cursors are found on the first line of each class
+	KviIrcViewLine * pNextInClass[2] = { nullptr, nullptr };
+	bool bClassCursor[2] = { false, false };
+
+	for(auto it = lines.rbegin(); it != lines.rend(); ++it)
+	{
+		KviIrcViewLine * l = *it;
+		int iClass = messageShouldGoToMessageView(l->iMsgType) ? 1 : 0;
+		l->bMessageViewLine = (iClass == 1);
+
+		KviIrcViewLine * pPrev = pNext ? pNext->pPrev : m_pStoreLastLine;
+		while(pPrev && (pPrev->uIndex > l->uIndex))
 		{
-			m_iNumLines--;
-			v->m_iNumLines++;
-
-			if(l->pNext)
-				l->pNext->pPrev = l->pPrev;
-			if(l->pPrev)
-				l->pPrev->pNext = l->pNext;
-			if(l == m_pFirstLine)
-				m_pFirstLine = l->pNext;
-			if(l == m_pLastLine)
-				m_pLastLine = l->pPrev;
-			if(v->m_pLastLine)
-			{
-				v->m_pLastLine->pNext = l;
-				l->pPrev = v->m_pLastLine;
-				v->m_pLastLine = l;
-			}
-			else
+			pNext = pPrev;
+			pPrev = pPrev->pPrev;
+		}
+		l->pPrev = pPrev;
+		l->pNext = pNext;
+		if(pPrev)
+			pPrev->pNext = l;
+		else
+			m_pStoreFirstLine = l;
+		if(pNext)
+			pNext->pPrev = l;
+		else
+			m_pStoreLastLine = l;
+		m_pStoreIndex->insertBefore(l, pNext);
+
+		KviIrcViewLine *& pNextClass = pNextInClass[iClass];
+		if(bClassCursor[iClass])
+		{
+			pPrev = pNextClass ? pNextClass->pPrevInClass : m_pClassLastLine[iClass];
+			while(pPrev && (pPrev->uIndex > l->uIndex))
 			{
-				v->m_pFirstLine = l;
-				l->pPrev = nullptr;
-				v->m_pLastLine = l;
+				pNextClass = pPrev;
+				pPrev = pPrev->pPrevInClass;
 			}
-			tmp = l->pNext;
-			l->pNext = nullptr;
-			l = tmp;
 		}
 		else
 		{
-			l = l->pNext;
+			// the first line of the class that follows in the chain of all the lines
+			pNextClass = pNext;
+			while(pNextClass && (pNextClass->bMessageViewLine != l->bMessageViewLine))
+				pNextClass = pNextClass->pNext;
+			pPrev = pNextClass ? pNextClass->pPrevInClass : m_pClassLastLine[iClass];
+			bClassCursor[iClass] = true;
 		}
+		l->pPrevInClass = pPrev;
+		l->pNextInClass = pNextClass;
+		if(pPrev)
+			pPrev->pNextInClass = l;
+		else
+			m_pClassFirstLine[iClass] = l;
+		if(pNextClass)
+			pNextClass->pPrevInClass = l;
+		else
+			m_pClassLastLine[iClass] = l;
+		m_pClassIndex[iClass]->insertBefore(l, pNextClass);
+
+		pNext = l;
+		pNextClass = l;
 	}
 
-	v->m_pCurLine = v->m_pLastLine;
-	m_pCurLine = m_pLastLine;
+	viewChainGrown();
+	if(m_pSplitView)
+		m_pSplitView->viewChainGrown();
+}
 
-	v->m_pCursorLine = nullptr;
-	m_pCursorLine = nullptr;
+void KviIrcView::viewChainGrown()
+{
+	// Lines have been inserted in the store: keep showing the same lines
+	if(!m_pCurLine)
+	{
+		resetViewChain();
+		update();
+		return;
+	}
 
-	m_iLastScrollBarValue = m_iNumLines;
+	KviIrcView * pStore = store();
+	m_pFirstLine = m_bClassChain ? pStore->m_pClassFirstLine[m_pStoreView ? 1 : 0] : pStore->m_pStoreFirstLine;
+	m_iNumLines = m_pHeightIndex->count();
+
+	m_bSkipScrollBarRepaint = true;
+	m_iLastScrollBarValue = m_pHeightIndex->ordinal(m_pCurLine) + 1;
 	m_pScrollBar->setRange(0, m_iNumLines);
-	m_pScrollBar->setValue(m_iNumLines);
+	m_pScrollBar->setValue(m_iLastScrollBarValue);
+	m_bSkipScrollBarRepaint = false;
+	update();
+}
+
+bool KviIrcView::findInSpilledLines(const QString & szText, bool bCaseS, bool bRegExp, bool bExtended)
+{
+	// Searches the history spilled to disk from the newest line, reading just
+	// the text of the records. The match is paged in with a page of the lines
+	// that follow it: the ones between them and our first line stay on the disk
+	// until scrolling gets near the hole (see loadSpilledLinesNearView()).
+	KviIrcViewSpillFile * pSpill = store()->m_pSpillFile;
+	if(!pSpill)
+		return false;
+
+	KviIrcViewLine * pFirst = m_pFirstLine;
+	unsigned int uBefore = pFirst ? pFirst->uIndex : UINT_MAX;
+	unsigned int uMask = spillClassMask();
 
+	QRegExp re(szText, bCaseS ? Qt::CaseSensitive : Qt::CaseInsensitive, bExtended ? QRegExp::RegExp : QRegExp::Wildcard);
+	QString szLine;
+	int iMsgType;
+	std::deque<unsigned int> following; // the records walked last (oldest first)
+	bool bGap = false;
+
+	for(unsigned int uId = pSpill->older(pFirst ? pFirst->uSpillId : 0, 0, uBefore, uMask); uId; uId = pSpill->older(uId, 0, uBefore, uMask))
+	{
+		if(pSpill->text(uId, szLine, iMsgType) && !(m_pToolWidget && !(m_pToolWidget->messageEnabled(iMsgType))))
+		{
+			int idx = bRegExp ? re.indexIn(szLine, 0) : szLine.indexOf(szText, 0, bCaseS ? Qt::CaseSensitive : Qt::CaseInsensitive);
+			if(idx != -1)
+			{
+				// the matching line is the oldest one and becomes our first line
+				std::vector<unsigned int> ids(following.begin(), following.end());
+				ids.push_back(uId);
+				loadSpilledLines(ids, pFirst);
+				if(!m_pFirstLine || (m_pFirstLine->uSpillId != uId))
+					return false;
+				if(bGap && pFirst)
+					pFirst->bSpillGapAbove = true;
+
+				setCursorLine(m_pFirstLine);
+				if(m_pToolWidget)
+				{
+					QString szTmp = QString(__tr2qs("Pos %1")).arg(idx);
+					m_pToolWidget->setFindResult(szTmp);
+				}
+				return true;
+			}
+		}
+
+		following.push_front(uId);
+		if(following.size() >= KVI_IRCVIEW_SPILL_PAGE_LINES)
+		{
+			following.pop_back();
+			bGap = true;
+		}
+	}
+	return false;
+}
+
+void KviIrcView::splitMessagesTo(KviIrcView * v)
+{
+	// No line is moved: v just walks the chain of our message lines
+	v->emptyBuffer(false);
+
+	v->m_pStoreView = this;
+	v->m_bClassChain = true;
+	m_pSplitView = v;
+	m_bClassChain = true;
+
+	resetViewChain();
 	repaint();
 
-	v->m_iLastScrollBarValue = v->m_iNumLines;
-	v->m_pScrollBar->setRange(0, v->m_iNumLines);
-	v->m_pScrollBar->setValue(v->m_iNumLines);
+	v->resetViewChain();
 	v->repaint();
 }
 
 void KviIrcView::appendMessagesFrom(KviIrcView * v)
 {
-	if(!m_pLastLine)
+	if(v->m_pStoreView)
+		return; // a split view has no lines of its own
+
+	KviIrcViewLine * l = v->m_pStoreFirstLine;
+	v->forgetStoredLines();
+
+	while(l)
 	{
-		m_pFirstLine = v->m_pFirstLine;
+		KviIrcViewLine * pNext = l->pNext; // storeAppend() relinks it
+		storeAppend(l);
+		l = pNext;
 	}
-	else
+
+	resetViewChain();
+	if(m_pSplitView)
 	{
-		m_pLastLine->pNext = v->m_pFirstLine;
-		v->m_pFirstLine->pPrev = m_pLastLine;
+		m_pSplitView->resetViewChain();
+		m_pSplitView->repaint();
 	}
-	m_pLastLine = v->m_pLastLine;
-	m_pCurLine = m_pLastLine;
-	m_pCursorLine = nullptr;
-	v->m_pFirstLine = nullptr;
-	v->m_pLastLine = nullptr;
-	v->m_pCurLine = nullptr;
-	v->m_pCursorLine = nullptr;
-	m_iNumLines += v->m_iNumLines;
-	v->m_iNumLines = 0;
-	//	v->m_pScrollBar->setRange(0,0);
-	//	v->m_pScrollBar->setValue(0);
-	m_iLastScrollBarValue = m_iNumLines;
-	m_pScrollBar->setRange(0, m_iNumLines);
-	m_pScrollBar->setValue(m_iNumLines);
 
 	repaint();
 }
 
 void KviIrcView::joinMessagesFrom(KviIrcView * v)
 {
-	KviIrcViewLine * l1 = m_pFirstLine;
-	KviIrcViewLine * l2 = v->m_pFirstLine;
+	if(v->m_pStoreView == this)
+	{
+		// v was just showing our message lines
+		v->detachFromStore();
+		m_pSplitView = nullptr;
+		m_bClassChain = false;
+		resetViewChain();
+		repaint();
+		return;
+	}
+
+	if(v->m_pStoreView)
+		return; // a split view of somebody else
+
+	// v owns its lines: merge them with ours by line index
+	KviIrcViewLine * l1 = m_pStoreFirstLine;
+	KviIrcViewLine * l2 = v->m_pStoreFirstLine;
 	KviIrcViewLine * tmp;
 
+	v->forgetStoredLines();
+
 	while(l2)
 	{
 		if(l1)
@@ -897,7 +1390,7 @@ void KviIrcView::joinMessagesFrom(KviIrcView * v)
 				if(l1->pPrev)
 					l1->pPrev->pNext = l2;
 				else
-					m_pFirstLine = l2;
+					m_pStoreFirstLine = l2;
 				l1->pPrev = l2;
 				tmp = l2->pNext;
 				l2->pNext = l1;
@@ -913,36 +1406,31 @@ void KviIrcView::joinMessagesFrom(KviIrcView * v)
 		{
 			// There is no current internal message (ran over the end)
 			// merge at the end then
-			if(m_pFirstLine)
+			if(m_pStoreFirstLine)
 			{
-				m_pLastLine->pNext = l2;
-				l2->pPrev = m_pLastLine;
+				m_pStoreLastLine->pNext = l2;
+				l2->pPrev = m_pStoreLastLine;
 			}
 			else
 			{
-				m_pFirstLine = l2;
+				m_pStoreFirstLine = l2;
 				l2->pPrev = nullptr;
 			}
 			tmp = l2->pNext;
 			l2->pNext = nullptr;
-			m_pLastLine = l2;
+			m_pStoreLastLine = l2;
 			l2 = tmp;
 		}
 	}
 
-	m_pCurLine = m_pLastLine;
-	m_pCursorLine = nullptr;
-	v->m_pFirstLine = nullptr;
-	v->m_pLastLine = nullptr;
-	v->m_pCurLine = nullptr;
-	v->m_pCursorLine = nullptr;
-	m_iNumLines += v->m_iNumLines;
-	v->m_iNumLines = 0;
-	//	v->m_pScrollBar->setRange(0,0);
-	//	v->m_pScrollBar->setValue(0);
-	m_iLastScrollBarValue = m_iNumLines;
-	m_pScrollBar->setRange(0, m_iNumLines);
-	m_pScrollBar->setValue(m_iNumLines);
+	rebuildStoreChains();
+
+	resetViewChain();
+	if(m_pSplitView)
+	{
+		m_pSplitView->resetViewChain();
+		m_pSplitView->repaint();
+	}
 
 	repaint();
 }
@@ -1008,7 +1496,7 @@ void KviIrcView::fastScroll(int lines)
 			heightToPaint += l->uLineWraps * m_iFontLineSpacing;
 			heightToPaint += (m_iFontLineSpacing + m_iFontDescent);
 			lines--;
-			l = l->pPrev;
+			l = viewPrev(l);
 		}
 		else
 			lines = 0;
@@ -1173,7 +1661,7 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 		{
 			// not in update rect... skip
 			curBottomCoord -= (m_iFontLineSpacing + m_iFontDescent);
-			pCurTextLine = pCurTextLine->pPrev;
+			pCurTextLine = viewPrev(pCurTextLine);
 			continue;
 		}
 
@@ -1596,7 +2084,7 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 			}       // else was partially visible only
 		}
 
-		pCurTextLine = pCurTextLine->pPrev;
+		pCurTextLine = viewPrev(pCurTextLine);
 		iLinesPerPage++;
 	}
 
@@ -1623,16 +2111,16 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 			// for this view width
 			lineWrapsHeight = (pCurTextLine->uLineWraps) * m_iFontLineSpacing;
 			curBottomCoord -= lineWrapsHeight + m_iFontLineSpacing + m_iFontDescent;
-			pCurTextLine = pCurTextLine->pPrev;
+			pCurTextLine = viewPrev(pCurTextLine);
 		}
 
 		if(pCurTextLine)
 		{
 			// this is the first NOT visible
 			// so pCurTextLine->pNext is the last visible one
-			if(pCurTextLine->pNext)
+			if(viewNext(pCurTextLine))
 			{
-				if(pCurTextLine->pNext->uIndex >= m_uLineMarkLineIndex)
+				if(viewNext(pCurTextLine)->uIndex >= m_uLineMarkLineIndex)
 					bLineMarkPainted = true; // yes, its somewhere before or on this line
 			}
 			else
@@ -1845,15 +2333,20 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 			if(KVI_OPTION_BOOL(KviOption_boolIrcViewWrapMargin))
 				maxWidth -= m_iWrapMargin;
 			if(maxWidth <= m_iIconWidth)
+			{
+				store()->storeLineRowsChanged(ptr);
 				return;
+			}
 		}
 		else if(ptr->uLineWraps > 128)
 		{	// oops.. this is looping endlessly: it may happen in certain insane window width / font size configurations...
+			store()->storeLineRowsChanged(ptr);
 			return;
 		}
 	}
 
 	ptr->iBlockCount++;
+	store()->storeLineRowsChanged(ptr);
 }
 
 //
@@ -2336,18 +2829,13 @@ void KviIrcView::ensureLineVisible(KviIrcViewLine * pLineToShow)
 	if(pLineToShow->uIndex > m_pCurLine->uIndex)
 	{
 		// The cursor line is below the current line
-		// Go down counting scroll steps (and verify if the line is really there)
-		KviIrcViewLine * pLine = m_pCurLine;
-
-		while(pLine && (pLine != pLineToShow))
-		{
-			pLine = pLine->pNext;
-			sc++;
-		}
-
-		if(!pLine)
+		// The scroll steps are the distance between the two lines (and verify if the line is really there)
+		if(!m_pHeightIndex->contains(pLineToShow))
 			return; // oops.. line not found ?
 
+		KviIrcViewLine * pLine = pLineToShow;
+		sc += m_pHeightIndex->ordinal(pLineToShow) - m_pHeightIndex->ordinal(m_pCurLine);
+
 		if(sc != m_pScrollBar->value())
 		{
 			m_pCurLine = pLine;
@@ -2386,13 +2874,13 @@ void KviIrcView::ensureLineVisible(KviIrcViewLine * pLineToShow)
 			if(pCurLine->iMaxLineWidth != maxLineWidth)
 				calculateLineWraps(pCurLine, maxLineWidth);
 			curBottomCoord += ((pCurLine->uLineWraps + 1) * m_iFontLineSpacing) + m_iFontDescent;
-			pCurLine = pCurLine->pPrev;
+			pCurLine = viewPrev(pCurLine);
 			sc--;
 		}
 		if(pLine == pLineToShow)
 			break;
 		curBottomCoord -= m_iFontDescent;
-		pLine = pLine->pPrev;
+		pLine = viewPrev(pLine);
 	}
 
 	if(!pCurLine)
@@ -2423,7 +2911,7 @@ void KviIrcView::findNext(const QString & szText, bool bCaseS, bool bRegExp, boo
 		l = m_pCurLine;
 	if(l)
 	{
-		l = l->pNext;
+		l = viewNext(l);
 		if(!l)
 			l = m_pFirstLine;
 		KviIrcViewLine * start = l;
@@ -2462,7 +2950,7 @@ void KviIrcView::findNext(const QString & szText, bool bCaseS, bool bRegExp, boo
 
 		do_pNext:
 
-			l = l->pNext;
+			l = viewNext(l);
 			if(!l)
 				l = m_pFirstLine;
 
@@ -2481,7 +2969,7 @@ void KviIrcView::findPrev(const QString & szText, bool bCaseS, bool bRegExp, boo
 		l = m_pCurLine;
 	if(l)
 	{
-		l = l->pPrev;
+		l = viewPrev(l);
 		if(!l)
 			l = m_pLastLine;
 		KviIrcViewLine * start = l;
@@ -2521,12 +3009,16 @@ void KviIrcView::findPrev(const QString & szText, bool bCaseS, bool bRegExp, boo
 
 		do_pPrev:
 
-			l = l->pPrev;
+			l = viewPrev(l);
 			if(!l)
 				l = m_pLastLine;
 
 		} while(l != start);
 	}
+
+	if(findInSpilledLines(szText, bCaseS, bRegExp, bExtended))
+		return;
+
 	m_pCursorLine = nullptr;
 
 	repaint();
@@ -2534,25 +3026,30 @@ void KviIrcView::findPrev(const QString & szText, bool bCaseS, bool bRegExp, boo
 		m_pToolWidget->setFindResult(__tr2qs("Not found"));
 }
 
-KviIrcViewLine * KviIrcView::getVisibleLineAt(int yPos)
+KviIrcViewLine * KviIrcView::findVisibleLineAt(int yPos, int & iLineBottom)
 {
-	KviIrcViewLine * l = m_pCurLine;
+	// Returns the line that covers yPos and sets iLineBottom to its bottom coordinate.
+	// If there is no such line iLineBottom is set to the bottom of the view.
 	int toolWidgetHeight = (m_pToolWidget && m_pToolWidget->isVisible()) ? m_pToolWidget->sizeHint().height() : 0;
-	int iTop = height() + m_iFontDescent - KVI_IRCVIEW_VERTICAL_BORDER - toolWidgetHeight;
+	iLineBottom = height() + m_iFontDescent - KVI_IRCVIEW_VERTICAL_BORDER - toolWidgetHeight;
 
-	while(iTop > yPos)
-	{
-		if(l)
-		{
-			iTop -= ((l->uLineWraps + 1) * m_iFontLineSpacing) + m_iFontDescent;
-			if(iTop <= yPos)
-				return l;
-			l = l->pPrev;
-		}
-		else
-			return nullptr;
-	}
-	return nullptr;
+	if(!m_pCurLine || (iLineBottom <= yPos))
+		return nullptr;
+
+	// the heights index gives the line in logarithmic time instead of walking up from m_pCurLine
+	KviIrcViewLine * l = m_pHeightIndex->lineAbove(m_pCurLine, iLineBottom - yPos, m_iFontLineSpacing, m_iFontDescent);
+	if(!l)
+		return nullptr;
+
+	if(l != m_pCurLine)
+		iLineBottom -= (int)m_pHeightIndex->heightBetween(viewNext(l), m_pCurLine, m_iFontLineSpacing, m_iFontDescent);
+	return l;
+}
+
+KviIrcViewLine * KviIrcView::getVisibleLineAt(int yPos)
+{
+	int iLineBottom;
+	return findVisibleLineAt(yPos, iLineBottom);
 }
 
 int KviIrcView::getVisibleCharIndexAt(KviIrcViewLine *, int xPos, int yPos)
@@ -2565,9 +3062,9 @@ int KviIrcView::getVisibleCharIndexAt(KviIrcViewLine *, int xPos, int yPos)
 	 * as the beginning of the "next" line that have to come.
 	 */
 
-	KviIrcViewLine * l = m_pCurLine;
-	int toolWidgetHeight = (m_pToolWidget && m_pToolWidget->isVisible()) ? m_pToolWidget->sizeHint().height() : 0;
-	int iTop = height() + m_iFontDescent - KVI_IRCVIEW_VERTICAL_BORDER - toolWidgetHeight;
+	// start directly from the line under the mouse: iTop is its bottom coordinate
+	int iTop;
+	KviIrcViewLine * l = findVisibleLineAt(yPos, iTop);
 
 	// our current line begins after the mouse position... go on
 	while(iTop > yPos)
@@ -2583,7 +3080,7 @@ int KviIrcView::getVisibleCharIndexAt(KviIrcViewLine *, int xPos, int yPos)
 		if(iTop > yPos)
 		{
 			// next round, try with the previous line
-			l = l->pPrev;
+			l = viewPrev(l);
 			continue;
 		}
 
@@ -2699,9 +3196,9 @@ KviIrcViewWrappedBlock * KviIrcView::getLinkUnderMouse(int xPos, int yPos, QRect
 	 * as the beginning of the "next" line that have to come.
 	 */
 
-	KviIrcViewLine * l = m_pCurLine;
-	int toolWidgetHeight = (m_pToolWidget && m_pToolWidget->isVisible()) ? m_pToolWidget->sizeHint().height() : 0;
-	int iTop = height() + m_iFontDescent - KVI_IRCVIEW_VERTICAL_BORDER - toolWidgetHeight;
+	// start directly from the line under the mouse: iTop is its bottom coordinate
+	int iTop;
+	KviIrcViewLine * l = findVisibleLineAt(yPos, iTop);
 
 	// our current line begins after the mouse position... go on
 	while(iTop > yPos)
@@ -2717,7 +3214,7 @@ KviIrcViewWrappedBlock * KviIrcView::getLinkUnderMouse(int xPos, int yPos, QRect
 		if(iTop > yPos)
 		{
 			// next round, try with the previous line
-			l = l->pPrev;
+			l = viewPrev(l);
 			continue;
 		}
 
@@ -2985,7 +3482,7 @@ void KviIrcView::scrollToMarker()
 	KviIrcViewLine * pLine = m_pCurLine;
 
 	while(pLine && (pLine->uIndex != m_uLineMarkLineIndex))
-		pLine = pLine->pPrev;
+		pLine = viewPrev(pLine);
 
 	if(pLine == nullptr)
 	{	// The buffer has already cleaned the marker line
@@ -37,7 +37,6 @@
 
 class QScrollBar;
 class QLineEdit;
-class QFile;
 class QFontMetrics;
 class QMenu;
 class QScreen;
@@ -47,6 +46,8 @@ class KviMainWindow;
 class KviConsoleWindow;
 class KviIrcViewToolWidget;
 class KviIrcViewToolTip;
+class KviIrcViewHeightIndex;
+class KviIrcViewSpillFile;
 class KviAnimatedPixmap;
 
 struct KviIrcViewLineChunk;
@@ -92,6 +93,25 @@ private:
 	int m_iNumLines;
 	int m_iMaxLines;
 
+	// The line store: the chain of all the lines plus one chain for each
+	// message view class. A split message view doesn't own any line: it shows
+	// the message class chain of the store of its master (m_pStoreView).
+	KviIrcView * m_pStoreView;                 // the view that owns our lines (nullptr if it's this one)
+	KviIrcView * m_pSplitView;                 // the split message view showing part of our lines
+	bool m_bClassChain;                        // we show a class chain instead of the chain of all the lines
+	KviIrcViewLine * m_pStoreFirstLine;
+	KviIrcViewLine * m_pStoreLastLine;
+	KviIrcViewLine * m_pClassFirstLine[2];     // indexed by KviIrcViewLine::bMessageViewLine
+	KviIrcViewLine * m_pClassLastLine[2];
+	KviIrcViewHeightIndex * m_pStoreIndex;     // positions and heights of all the lines
+	KviIrcViewHeightIndex * m_pClassIndex[2];  // positions and heights of the lines of each class
+	KviIrcViewHeightIndex * m_pHeightIndex;    // the index of the chain that we show (not owned)
+
+	// The lines dropped from the head of the store go to the disk (if enabled)
+	KviIrcViewSpillFile * m_pSpillFile;        // created on the first spill
+	bool m_bDiscardingLines;                   // the buffer is being emptied: don't spill
+	bool m_bLoadingSpilledLines;
+
 	unsigned int m_uNextLineIndex;
 
 	QPixmap * m_pPrivateBackgroundPixmap;
@@ -131,7 +151,8 @@ private:
 	int m_iMouseTimer;
 	KviWindow * m_pKviWindow;
 	KviIrcViewWrappedBlockSelectionInfo * m_pWrappedBlockSelectionInfo;
-	QFile * m_pLogFile;
+	int m_iLogFile;           // KviLogWriter file id, -1 when not logging
+	QString m_szLogFileName;
 	KviMainWindow * m_pFrm;
 	bool m_bAcceptDrops;
 	int m_iUnprocessedPaintEventRequests;
@@ -184,7 +205,7 @@ public:
 	// Stops previous logging session too...
 	bool startLogging(const QString & fname = QString(), bool bPrependCurBuffer = false);
 	void stopLogging();
-	bool isLogging() { return (m_pLogFile != nullptr); };
+	bool isLogging() { return (m_iLogFile != -1); };
 	void getLogFileName(QString & buffer);
 	void add2Log(const QString & szBuffer, const QDateTime & date, int iMsgType, bool bPrependDate);
 
@@ -233,6 +254,28 @@ private:
 	void setCursorLine(KviIrcViewLine * l);
 	void ensureLineVisible(KviIrcViewLine * pLineToShow);
 	KviIrcViewLine * getVisibleLineAt(int yPos);
+	KviIrcViewLine * findVisibleLineAt(int yPos, int & iLineBottom);
+	// walk the chain of the lines shown in this view
+	inline KviIrcViewLine * viewPrev(const KviIrcViewLine * l) const;
+	inline KviIrcViewLine * viewNext(const KviIrcViewLine * l) const;
+	KviIrcView * store() { return m_pStoreView ? m_pStoreView : this; };
+	void storeAppend(KviIrcViewLine * pLine);
+	void storeRemove(KviIrcViewLine * pLine);
+	void storeLineRowsChanged(KviIrcViewLine * pLine);
+	void rebuildStoreChains();
+	KviIrcView * viewShowingLine(KviIrcViewLine * pLine);
+	void viewAppend(KviIrcViewLine * ptr, bool bRepaint);
+	void resetViewChain();
+	void detachFromStore();
+	void forgetStoredLines();
+	void splitViewDead();
+	unsigned int spillClassMask() const;
+	void loadSpilledLines(const std::vector<unsigned int> & ids, KviIrcViewLine * pBelow);
+	void loadSpilledLinesNearView(bool bScrolledUp, int iTarget);
+	unsigned int loadSpilledRange(KviIrcViewLine * pAbove, KviIrcViewLine * pBelow, bool bNewestFirst);
+	void storeInsertLines(const std::vector<KviIrcViewLine *> & lines, KviIrcViewLine * pBelow);
+	void viewChainGrown();
+	bool findInSpilledLines(const QString & szText, bool bCaseS, bool bRegExp, bool bExtended);
 	int getVisibleCharIndexAt(KviIrcViewLine * line, int xPos, int yPos);
 	void getLinkEscapeCommand(QString & buffer, const QString & escape_cmd, const QString & escape_label);
 	void appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool bRepaint);
@@ -671,7 +671,7 @@ void KviIrcView::mouseReleaseEvent(QMouseEvent * e)
 					szSelectionText.append("\n");
 				}
 			}
-			tempLine = tempLine->pNext;
+			tempLine = viewNext(tempLine);
 		}
 
 		QClipboard * c = QApplication::clipboard();
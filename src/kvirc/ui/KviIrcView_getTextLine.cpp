@@ -1283,7 +1283,7 @@ void KviIrcView::reapplyMessageColors()
 			}
 		}
 
-		pLine = pLine->pNext;
+		pLine = viewNext(pLine);
 	}
 }
 
@@ -1297,13 +1297,13 @@ void KviIrcView::appendText(int iMsgType, const kvi_wchar_t * data_ptr, int iFla
 	if(!KVI_OPTION_BOOL(KviOption_boolStripControlCodesInLogs))
 	{
 		// Looks like the user wants to keep the control codes in the log file: we just dump everything inside (including newlines...)
-		if(m_pLogFile && KVI_OPTION_MSGTYPE(iMsgType).logEnabled())
+		if(isLogging() && KVI_OPTION_MSGTYPE(iMsgType).logEnabled())
 		{
 			add2Log(QString::fromUtf16(data_ptr), datetime, iMsgType, true);
 		}
 		else if(m_pMasterView)
 		{
-			if(m_pMasterView->m_pLogFile && KVI_OPTION_MSGTYPE(iMsgType).logEnabled())
+			if(m_pMasterView->isLogging() && KVI_OPTION_MSGTYPE(iMsgType).logEnabled())
 				m_pMasterView->add2Log(QString::fromUtf16(data_ptr), datetime, iMsgType, true);
 		}
 	}
@@ -1318,6 +1318,8 @@ void KviIrcView::appendText(int iMsgType, const kvi_wchar_t * data_ptr, int iFla
 		line_ptr->iMaxLineWidth = -1;
 		line_ptr->iBlockCount = 0;
 		line_ptr->uLineWraps = 0;
+		line_ptr->uSpillId = 0;
+		line_ptr->bSpillGapAbove = false;
 
 		data_ptr = getTextLine(iMsgType, data_ptr, line_ptr, !(iFlags & NoTimestamp), datetime);
 
@@ -0,0 +1,402 @@
+//=============================================================================
+//
+//   File : KviIrcView_heightindex.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviIrcView_heightindex.h"
+#include "KviIrcView_private.h"
+
+#include <algorithm>
+
+// must be a power of two: the tree descents rely on it
+#define KVI_IRCVIEW_HEIGHTINDEX_MIN_CAPACITY 64
+// insertBefore() doesn't shift more lines than these to make room
+#define KVI_IRCVIEW_HEIGHTINDEX_MAX_SHIFT 32
+
+static unsigned int capacity_for(unsigned int uLines)
+{
+	// leave at least as many free slots as the live ones so the
+	// compaction cost is amortized over the following appends
+	unsigned int uCap = KVI_IRCVIEW_HEIGHTINDEX_MIN_CAPACITY;
+	while(uCap < (uLines * 2))
+		uCap <<= 1;
+	return uCap;
+}
+
+static inline unsigned int lowest_bit(unsigned int i)
+{
+	return i & (~i + 1);
+}
+
+KviIrcViewHeightIndex::KviIrcViewHeightIndex(bool bClassChain)
+{
+	m_bClassChain = bClassChain;
+	reset(KVI_IRCVIEW_HEIGHTINDEX_MIN_CAPACITY);
+}
+
+KviIrcViewHeightIndex::~KviIrcViewHeightIndex()
+{
+}
+
+unsigned int KviIrcViewHeightIndex::slot(const KviIrcViewLine * pLine) const
+{
+	return m_bClassChain ? pLine->uClassSlot : pLine->uSlot;
+}
+
+void KviIrcViewHeightIndex::setSlot(KviIrcViewLine * pLine, unsigned int uSlot)
+{
+	if(m_bClassChain)
+		pLine->uClassSlot = uSlot;
+	else
+		pLine->uSlot = uSlot;
+}
+
+void KviIrcViewHeightIndex::reset(unsigned int uCapacity)
+{
+	m_uTail = 0;
+	m_uLive = 0;
+	m_Lines.assign(uCapacity, nullptr);
+	m_Rows.assign(uCapacity, 0);
+	m_RowsTree.assign(uCapacity + 1, 0);
+	m_LiveTree.assign(uCapacity + 1, 0);
+}
+
+bool KviIrcViewHeightIndex::contains(const KviIrcViewLine * pLine) const
+{
+	if(!pLine)
+		return false;
+	unsigned int uSlot = slot(pLine);
+	return (uSlot < m_uTail) && (m_Lines[uSlot] == pLine);
+}
+
+void KviIrcViewHeightIndex::treeAdd(unsigned int uSlot, int iRowsDelta, int iLiveDelta)
+{
+	unsigned int uCap = m_Lines.size();
+	for(unsigned int i = uSlot + 1; i <= uCap; i += lowest_bit(i))
+	{
+		m_RowsTree[i] += iRowsDelta;
+		m_LiveTree[i] += iLiveDelta;
+	}
+}
+
+kvi_u64_t KviIrcViewHeightIndex::rowsPrefix(unsigned int uSlot) const
+{
+	kvi_u64_t uSum = 0;
+	for(unsigned int i = uSlot + 1; i > 0; i -= lowest_bit(i))
+		uSum += m_RowsTree[i];
+	return uSum;
+}
+
+unsigned int KviIrcViewHeightIndex::livePrefix(unsigned int uSlot) const
+{
+	unsigned int uSum = 0;
+	for(unsigned int i = uSlot + 1; i > 0; i -= lowest_bit(i))
+		uSum += m_LiveTree[i];
+	return uSum;
+}
+
+void KviIrcViewHeightIndex::buildTrees()
+{
+	// linear time construction
+	unsigned int uCap = m_Lines.size();
+	m_RowsTree.assign(uCap + 1, 0);
+	m_LiveTree.assign(uCap + 1, 0);
+	for(unsigned int i = 1; i <= uCap; i++)
+	{
+		m_RowsTree[i] += m_Rows[i - 1];
+		m_LiveTree[i] += m_Lines[i - 1] ? 1 : 0;
+		unsigned int j = i + lowest_bit(i);
+		if(j <= uCap)
+		{
+			m_RowsTree[j] += m_RowsTree[i];
+			m_LiveTree[j] += m_LiveTree[i];
+		}
+	}
+}
+
+void KviIrcViewHeightIndex::grow(const KviIrcViewLine * pGapBefore)
+{
+	// drop the holes moving the live slots together: half of the free slots
+	// go in front of pGapBefore (the first line if it's nullptr) for the
+	// insertions and the other half after the last line for the appends
+	unsigned int uCap = capacity_for(m_uLive);
+	unsigned int uGap = (uCap - m_uLive) / 2;
+
+	std::vector<KviIrcViewLine *> lines(uCap, nullptr);
+	std::vector<unsigned int> rows(uCap, 0);
+
+	unsigned int uSlot = 0;
+	bool bGapDone = false;
+	for(unsigned int i = 0; i < m_uTail; i++)
+	{
+		KviIrcViewLine * l = m_Lines[i];
+		if(!l)
+			continue;
+		if(!bGapDone && (!pGapBefore || (l == pGapBefore)))
+		{
+			uSlot += uGap;
+			bGapDone = true;
+		}
+		setSlot(l, uSlot);
+		lines[uSlot] = l;
+		rows[uSlot] = m_Rows[i];
+		uSlot++;
+	}
+
+	m_Lines.swap(lines);
+	m_Rows.swap(rows);
+	m_uTail = uSlot;
+	buildTrees();
+}
+
+void KviIrcViewHeightIndex::moveSlot(unsigned int uFrom, unsigned int uTo)
+{
+	KviIrcViewLine * l = m_Lines[uFrom];
+	unsigned int uRows = m_Rows[uFrom];
+	treeAdd(uFrom, -((int)uRows), -1);
+	treeAdd(uTo, uRows, 1);
+	m_Lines[uTo] = l;
+	m_Rows[uTo] = uRows;
+	m_Lines[uFrom] = nullptr;
+	m_Rows[uFrom] = 0;
+	setSlot(l, uTo);
+}
+
+void KviIrcViewHeightIndex::append(KviIrcViewLine * pLine)
+{
+	if(m_uTail >= m_Lines.size())
+		grow();
+
+	unsigned int uSlot = m_uTail++;
+	unsigned int uRows = pLine->uLineWraps + 1;
+	setSlot(pLine, uSlot);
+	m_Lines[uSlot] = pLine;
+	m_Rows[uSlot] = uRows;
+	m_uLive++;
+	treeAdd(uSlot, uRows, 1);
+}
+
+void KviIrcViewHeightIndex::insertBefore(KviIrcViewLine * pLine, KviIrcViewLine * pNext)
+{
+	if(!contains(pNext))
+	{
+		append(pLine);
+		return;
+	}
+
+	// The line needs a free slot between the one of pNext and the one of the
+	// previous live line. The lines are usually inserted from the newest
+	// one, each before the one inserted last: the hole right before pNext
+	// is then free. Otherwise shift the few lines between pNext and a
+	// nearby hole, and as the last resort compact opening a gap before pNext.
+	unsigned int uNext = slot(pNext);
+	unsigned int uSlot = 0;
+	bool bFound = false;
+
+	unsigned int uLow = (uNext > KVI_IRCVIEW_HEIGHTINDEX_MAX_SHIFT) ? (uNext - KVI_IRCVIEW_HEIGHTINDEX_MAX_SHIFT) : 0;
+	for(unsigned int i = uNext; i > uLow; i--)
+	{
+		if(m_Lines[i - 1])
+			continue;
+		// move the lines in (i - 1,uNext) one slot down
+		for(unsigned int j = i; j < uNext; j++)
+			moveSlot(j, j - 1);
+		uSlot = uNext - 1;
+		bFound = true;
+		break;
+	}
+
+	if(!bFound)
+	{
+		unsigned int uCap = m_Lines.size();
+		unsigned int uHigh = std::min(uCap, uNext + 1 + KVI_IRCVIEW_HEIGHTINDEX_MAX_SHIFT);
+		for(unsigned int i = uNext + 1; i < uHigh; i++)
+		{
+			if((i < m_uTail) && m_Lines[i])
+				continue;
+			// move the lines in [uNext,i) one slot up
+			if(i >= m_uTail)
+				m_uTail = i + 1;
+			for(unsigned int j = i; j > uNext; j--)
+				moveSlot(j - 1, j);
+			uSlot = uNext;
+			bFound = true;
+			break;
+		}
+	}
+
+	if(!bFound)
+	{
+		grow(pNext);
+		uSlot = slot(pNext) - 1;
+	}
+
+	unsigned int uRows = pLine->uLineWraps + 1;
+	setSlot(pLine, uSlot);
+	m_Lines[uSlot] = pLine;
+	m_Rows[uSlot] = uRows;
+	m_uLive++;
+	treeAdd(uSlot, uRows, 1);
+}
+
+void KviIrcViewHeightIndex::remove(KviIrcViewLine * pLine)
+{
+	if(!contains(pLine))
+		return;
+
+	unsigned int uSlot = slot(pLine);
+	treeAdd(uSlot, -((int)m_Rows[uSlot]), -1);
+	m_Rows[uSlot] = 0;
+	m_Lines[uSlot] = nullptr;
+	m_uLive--;
+
+	if(m_uLive == 0)
+	{
+		// empty: all the counts are zero now, just restart from the first slot
+		m_uTail = 0;
+	}
+	else if((uSlot + 1) == m_uTail)
+	{
+		m_uTail--;
+	}
+}
+
+void KviIrcViewHeightIndex::setRows(KviIrcViewLine * pLine, unsigned int uRows)
+{
+	if(!contains(pLine))
+		return;
+	unsigned int uSlot = slot(pLine);
+	int iDelta = (int)uRows - (int)m_Rows[uSlot];
+	if(iDelta == 0)
+		return;
+	m_Rows[uSlot] = uRows;
+	treeAdd(uSlot, iDelta, 0);
+}
+
+void KviIrcViewHeightIndex::clear()
+{
+	reset(KVI_IRCVIEW_HEIGHTINDEX_MIN_CAPACITY);
+}
+
+void KviIrcViewHeightIndex::rebuild(KviIrcViewLine * pFirst)
+{
+	unsigned int uCount = 0;
+	for(KviIrcViewLine * l = pFirst; l; l = m_bClassChain ? l->pNextInClass : l->pNext)
+		uCount++;
+
+	unsigned int uCap = capacity_for(uCount);
+	m_Lines.assign(uCap, nullptr);
+	m_Rows.assign(uCap, 0);
+
+	unsigned int uSlot = 0;
+	for(KviIrcViewLine * l = pFirst; l; l = m_bClassChain ? l->pNextInClass : l->pNext)
+	{
+		setSlot(l, uSlot);
+		m_Lines[uSlot] = l;
+		m_Rows[uSlot] = l->uLineWraps + 1;
+		uSlot++;
+	}
+
+	m_uTail = uCount;
+	m_uLive = uCount;
+	buildTrees();
+}
+
+unsigned int KviIrcViewHeightIndex::ordinal(const KviIrcViewLine * pLine) const
+{
+	return livePrefix(slot(pLine)) - 1;
+}
+
+KviIrcViewLine * KviIrcViewHeightIndex::lineAt(unsigned int uOrdinal) const
+{
+	if(uOrdinal >= m_uLive)
+		return nullptr;
+
+	// find the slot with exactly uOrdinal live slots before it
+	unsigned int uCap = m_Lines.size();
+	unsigned int uPos = 0;
+	unsigned int uRemaining = uOrdinal;
+	for(unsigned int uStep = uCap; uStep > 0; uStep >>= 1)
+	{
+		unsigned int uNext = uPos + uStep;
+		if(uNext > uCap)
+			continue;
+		if(m_LiveTree[uNext] <= uRemaining)
+		{
+			uPos = uNext;
+			uRemaining -= m_LiveTree[uNext];
+		}
+	}
+
+	return uPos < m_uTail ? m_Lines[uPos] : nullptr;
+}
+
+kvi_i64_t KviIrcViewHeightIndex::heightBetween(const KviIrcViewLine * pTop, const KviIrcViewLine * pBottom, int iLineSpacing, int iDescent) const
+{
+	unsigned int uTop = slot(pTop);
+	unsigned int uBottom = slot(pBottom);
+	if(uTop > uBottom)
+		return 0;
+	kvi_i64_t iRows = rowsPrefix(uBottom);
+	kvi_i64_t iLines = livePrefix(uBottom);
+	if(uTop > 0)
+	{
+		iRows -= rowsPrefix(uTop - 1);
+		iLines -= livePrefix(uTop - 1);
+	}
+	return (iRows * iLineSpacing) + (iLines * iDescent);
+}
+
+KviIrcViewLine * KviIrcViewHeightIndex::lineAbove(const KviIrcViewLine * pBottom, int iPixels, int iLineSpacing, int iDescent) const
+{
+	if(iPixels <= 0)
+		return const_cast<KviIrcViewLine *>(pBottom);
+
+	// pixel height of all the lines up to pBottom (included)
+	unsigned int uBottom = slot(pBottom);
+	kvi_i64_t iBottomPrefix = (((kvi_i64_t)rowsPrefix(uBottom)) * iLineSpacing) + (((kvi_i64_t)livePrefix(uBottom)) * iDescent);
+	kvi_i64_t iTarget = iBottomPrefix - iPixels;
+	if(iTarget < 0)
+		return nullptr; // not enough lines
+
+	// find the first slot whose pixel prefix exceeds iTarget:
+	// holes weight nothing so it is always a live one
+	unsigned int uCap = m_Lines.size();
+	unsigned int uPos = 0;
+	kvi_i64_t iAcc = 0;
+	for(unsigned int uStep = uCap; uStep > 0; uStep >>= 1)
+	{
+		unsigned int uNext = uPos + uStep;
+		if(uNext > uCap)
+			continue;
+		kvi_i64_t iWeight = (((kvi_i64_t)m_RowsTree[uNext]) * iLineSpacing) + (((kvi_i64_t)m_LiveTree[uNext]) * iDescent);
+		if(iAcc + iWeight <= iTarget)
+		{
+			uPos = uNext;
+			iAcc += iWeight;
+		}
+	}
+
+	if(uPos >= m_uTail)
+		return nullptr; // can't happen
+	return m_Lines[uPos];
+}
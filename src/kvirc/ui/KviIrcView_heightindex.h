@@ -0,0 +1,109 @@
+#ifndef _KVI_IRCVIEWHEIGHTINDEX_H_
+#define _KVI_IRCVIEWHEIGHTINDEX_H_
+//=============================================================================
+//
+//   File : KviIrcView_heightindex.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "kvi_settings.h"
+#include "kvi_inttypes.h"
+
+#include <vector>
+
+struct KviIrcViewLine;
+
+//
+// Positional index of a chain of KviIrcView lines.
+//
+// Each line gets a slot at append time: in the chain of all the buffered
+// lines the slot is stored in KviIrcViewLine::uSlot, in the chain of the
+// lines of the same message view class in KviIrcViewLine::uClassSlot.
+// Slots grow monotonically. Removed lines leave a hole that is dropped
+// when the tail hits the capacity and the live slots are compacted.
+// The compaction leaves half of the free slots in front of the first line
+// (or of the line that is being inserted before) so that the history paged
+// in from the disk takes the holes instead of reindexing the whole chain.
+//
+// Two Fenwick trees over the slots keep the number of painted rows
+// (uLineWraps + 1) and the number of live lines. Since the pixel height
+// of a line is rows * lineSpacing + descent this is enough to map
+// y coordinates to lines (and back) and ordinals to lines (and back)
+// in logarithmic time.
+//
+// The row counts are the ones computed by the last calculateLineWraps()
+// on each line: lines that have never been painted count as a single row.
+//
+
+class KviIrcViewHeightIndex
+{
+public:
+	KviIrcViewHeightIndex(bool bClassChain);
+	~KviIrcViewHeightIndex();
+
+protected:
+	bool m_bClassChain;
+	std::vector<KviIrcViewLine *> m_Lines;  // slot -> line
+	std::vector<unsigned int> m_Rows;       // slot -> row count (needed for rebuilds and updates)
+	std::vector<unsigned int> m_RowsTree;   // 1-based Fenwick tree of the row counts
+	std::vector<unsigned int> m_LiveTree;   // 1-based Fenwick tree of the live slots
+	unsigned int m_uTail;
+	unsigned int m_uLive;
+
+public:
+	unsigned int count() const { return m_uLive; };
+	bool contains(const KviIrcViewLine * pLine) const;
+
+	// keeps track of the buffer changes
+	void append(KviIrcViewLine * pLine);
+	// pNext must be in the index: nullptr appends
+	void insertBefore(KviIrcViewLine * pLine, KviIrcViewLine * pNext);
+	void remove(KviIrcViewLine * pLine);
+	void setRows(KviIrcViewLine * pLine, unsigned int uRows);
+	void clear();
+	// reindexes the whole chain starting at pFirst
+	void rebuild(KviIrcViewLine * pFirst);
+
+	// position of the line in the chain (0 is the first line)
+	unsigned int ordinal(const KviIrcViewLine * pLine) const;
+	KviIrcViewLine * lineAt(unsigned int uOrdinal) const;
+
+	// total height in pixels of the lines from pTop to pBottom (both included)
+	kvi_i64_t heightBetween(const KviIrcViewLine * pTop, const KviIrcViewLine * pBottom, int iLineSpacing, int iDescent) const;
+
+	// the line that contains the point found iPixels above the bottom of pBottom,
+	// that is the nearest line L above pBottom for which heightBetween(L,pBottom) >= iPixels.
+	// Returns nullptr if the lines above are not enough to cover iPixels.
+	KviIrcViewLine * lineAbove(const KviIrcViewLine * pBottom, int iPixels, int iLineSpacing, int iDescent) const;
+
+protected:
+	unsigned int slot(const KviIrcViewLine * pLine) const;
+	void setSlot(KviIrcViewLine * pLine, unsigned int uSlot);
+	void reset(unsigned int uCapacity);
+	void grow(const KviIrcViewLine * pGapBefore = nullptr);
+	void moveSlot(unsigned int uFrom, unsigned int uTo);
+	void buildTrees();
+	void treeAdd(unsigned int uSlot, int iRowsDelta, int iLiveDelta);
+	kvi_u64_t rowsPrefix(unsigned int uSlot) const; // rows in slots [0,uSlot]
+	unsigned int livePrefix(unsigned int uSlot) const; // live lines in slots [0,uSlot]
+};
+
+#endif //!_KVI_IRCVIEWHEIGHTINDEX_H_
@@ -29,62 +29,34 @@
 #include "KviIrcView.h"
 #include "KviIrcView_private.h"
 #include "KviLocale.h"
+#include "KviLogWriter.h"
 #include "KviOptions.h"
 #include "kvi_out.h"
 #include "KviQString.h"
 #include "KviWindow.h"
 
-#ifdef COMPILE_ZLIB_SUPPORT
-#include <zlib.h>
-#endif
-
-#include <QFileInfo>
-#include <QFile>
 #include <QDateTime>
-#include <QTextCodec>
 #include <QLocale>
 
 void KviIrcView::stopLogging()
 {
-	if(m_pLogFile)
+	if(isLogging())
 	{
 		QDateTime date = QDateTime::currentDateTime();
 		QString szLogEnd = QString(__tr2qs("### Log session terminated ###"));
 		add2Log(szLogEnd, date, KVI_OUT_LOG, true);
-		m_pLogFile->close();
-#ifdef COMPILE_ZLIB_SUPPORT
-		if(KVI_OPTION_BOOL(KviOption_boolGzipLogs))
-		{
-			if(m_pLogFile->open(QIODevice::ReadOnly))
-			{
-				QByteArray bytes;
-				bytes = m_pLogFile->readAll();
-				m_pLogFile->close();
-				QFileInfo fi(*m_pLogFile);
-				QString szFname = fi.absolutePath() + QString("/") + fi.completeBaseName();
-				gzFile file = gzopen(QTextCodec::codecForLocale()->fromUnicode(szFname).data(), "ab9");
-				if(file)
-				{
-					gzwrite(file, bytes.data(), bytes.size());
-					gzclose(file);
-					m_pLogFile->remove();
-				}
-				else
-				{
-					qDebug("Can't open compressed stream");
-				}
-			}
-		}
-#endif
-		delete m_pLogFile;
-		m_pLogFile = nullptr;
+		// the file is closed by the writer thread
+		if(KviLogWriter::instance())
+			KviLogWriter::instance()->close(m_iLogFile);
+		m_iLogFile = -1;
+		m_szLogFileName = QString();
 	}
 }
 
 void KviIrcView::getLogFileName(QString & buffer)
 {
-	if(m_pLogFile)
-		buffer = m_pLogFile->fileName();
+	if(isLogging())
+		buffer = m_szLogFileName;
 }
 
 void KviIrcView::getTextBuffer(QString & buffer)
@@ -93,7 +65,7 @@ void KviIrcView::getTextBuffer(QString & buffer)
 	buffer = "";
 	if(!m_pLastLine)
 		return;
-	for(KviIrcViewLine * l = m_pFirstLine; l; l = l->pNext)
+	for(KviIrcViewLine * l = m_pFirstLine; l; l = viewNext(l))
 	{
 		buffer.append(l->szText);
 		buffer.append("\n");
@@ -102,36 +74,10 @@ void KviIrcView::getTextBuffer(QString & buffer)
 
 void KviIrcView::flushLog()
 {
-	if(m_pLogFile)
+	if(isLogging())
 	{
-#ifdef COMPILE_ZLIB_SUPPORT
-		if(KVI_OPTION_BOOL(KviOption_boolGzipLogs))
-		{
-			m_pLogFile->close();
-			if(m_pLogFile->open(QIODevice::ReadOnly))
-			{
-				QByteArray bytes;
-				bytes = m_pLogFile->readAll();
-				m_pLogFile->close();
-				QFileInfo fi(*m_pLogFile);
-				QString szFname = fi.absolutePath() + QString("/") + fi.completeBaseName();
-				gzFile file = gzopen(QTextCodec::codecForLocale()->fromUnicode(szFname).data(), "ab9");
-				if(file)
-				{
-					gzwrite(file, bytes.data(), bytes.size());
-					gzclose(file);
-					m_pLogFile->remove();
-				}
-				else
-				{
-					qDebug("Can't open compressed stream");
-				}
-			}
-			m_pLogFile->open(QIODevice::Append | QIODevice::WriteOnly);
-		}
-		else
-#endif
-			m_pLogFile->flush();
+		if(KviLogWriter::instance())
+			KviLogWriter::instance()->flush(m_iLogFile);
 	}
 	else if(m_pMasterView)
 		m_pMasterView->flushLog();
@@ -157,7 +103,7 @@ const QString & KviIrcView::lastMessageText()
 			case KVI_OUT_HIGHLIGHT:
 				return pCur->szText;
 		}
-		pCur = pCur->pPrev;
+		pCur = viewPrev(pCur);
 	}
 	return KviQString::Empty;
 }
@@ -195,31 +141,21 @@ bool KviIrcView::startLogging(const QString & fname, bool bPrependCurBuffer)
 		m_pKviWindow->getDefaultLogFileName(szFname);
 	}
 
+	if(!KviLogWriter::instance())
+		return false;
+
+	// the compressed logs are written directly, there is no temporary file anymore
 #ifdef COMPILE_ZLIB_SUPPORT
-	if(KVI_OPTION_BOOL(KviOption_boolGzipLogs))
-		szFname += ".tmp";
+	bool bCompressed = KVI_OPTION_BOOL(KviOption_boolGzipLogs);
+#else
+	bool bCompressed = false;
 #endif
 
-	m_pLogFile = new QFile(szFname);
-
-	if(m_pLogFile->exists())
-	{
-		if(!m_pLogFile->open(QIODevice::Append | QIODevice::WriteOnly))
-		{
-			delete m_pLogFile;
-			m_pLogFile = nullptr;
-			return false;
-		}
-	}
-	else
-	{
-		if(!m_pLogFile->open(QIODevice::WriteOnly))
-		{
-			delete m_pLogFile;
-			m_pLogFile = nullptr;
-			return false;
-		}
-	}
+	// this waits for the writer: a previous session on the same file must be closed first
+	m_iLogFile = KviLogWriter::instance()->open(szFname, bCompressed);
+	if(m_iLogFile == -1)
+		return false;
+	m_szLogFileName = szFname;
 
 	QDateTime date = QDateTime::currentDateTime();
 	QString szLogStart = QString(__tr2qs("### Log session started ###"));
@@ -231,7 +167,6 @@ bool KviIrcView::startLogging(const QString & fname, bool bPrependCurBuffer)
 		getTextBuffer(buffer);
 		add2Log(buffer, date, -1, false);
 		add2Log(__tr2qs("### End of existing data buffer."), date, KVI_OUT_LOG, true);
-		m_pLogFile->flush();
 	}
 
 	return true;
@@ -239,22 +174,23 @@ bool KviIrcView::startLogging(const QString & fname, bool bPrependCurBuffer)
 
 void KviIrcView::add2Log(const QString & szBuffer, const QDateTime & aDate, int iMsgType, bool bPrependDate)
 {
+	if(!KviLogWriter::instance())
+		return;
+
+	// the whole line goes to the writer thread as a single record
 	QByteArray tmp;
+	QDateTime date = aDate.isValid() ? aDate : QDateTime::currentDateTime();
 
 	if(iMsgType >= 0 && !KVI_OPTION_BOOL(KviOption_boolStripMsgTypeInLogs))
 	{
 		QString szMessageType = QString("%1 ").arg(iMsgType);
 
 		tmp = szMessageType.toUtf8();
-
-		if(m_pLogFile->write(tmp.data(), tmp.length()) == -1)
-			qDebug("WARNING: can't write to the log file.");
 	}
 
 	if(bPrependDate)
 	{
 		QString szDate;
-		QDateTime date = aDate.isValid() ? aDate : QDateTime::currentDateTime();
 		switch(KVI_OPTION_UINT(KviOption_uintOutputDatetimeFormat))
 		{
 			case 0:
@@ -277,15 +213,12 @@ void KviIrcView::add2Log(const QString & szBuffer, const QDateTime & aDate, int
 				break;
 		}
 
-		tmp = szDate.toUtf8();
-
-		if(m_pLogFile->write(tmp.data(), tmp.length()) == -1)
-			qDebug("WARNING: can't write to the log file.");
+		tmp.append(szDate.toUtf8());
 	}
 
-	tmp = szBuffer.toUtf8();
+	tmp.append(szBuffer.toUtf8());
 	tmp.append('\n');
 
-	if(m_pLogFile->write(tmp.data(), tmp.length()) == -1)
-		qDebug("WARNING: can't write to the log file.");
+	// the time indexes the frames of the compressed logs
+	KviLogWriter::instance()->write(m_iLogFile, tmp, date.toMSecsSinceEpoch() / 1000);
 }
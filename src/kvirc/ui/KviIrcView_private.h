@@ -25,6 +25,7 @@
 //=============================================================================
 
 #include "kvi_settings.h"
+#include "KviIrcView.h"
 
 #include <QString>
 
@@ -126,11 +127,40 @@ struct KviIrcViewLine
 	int iBlockCount;                  // number of allocated paintable blocks
 	KviIrcViewWrappedBlock * pBlocks; // pointer to the re-split paintable blocks
 
+	// positions in the KviIrcViewHeightIndex objects of the owning view
+	unsigned int uSlot;      // in the chain of all the lines
+	unsigned int uClassSlot; // in the chain of the lines of the same class
+
+	// id of the copy of the line in the KviIrcViewSpillFile of the owning view (0 if none)
+	unsigned int uSpillId;
+	// a search paged in older lines leaving spilled ones between this line
+	// and the previous one of the view: they're paged in when scrolling gets near
+	bool bSpillGapAbove;
+
 	// next and previous line
 	KviIrcViewLine * pPrev;
 	KviIrcViewLine * pNext;
+
+	// Next and previous line of the same class: the lines that go to
+	// a split message view and the ones that stay in the main view
+	// (see KviIrcView::messageShouldGoToMessageView()).
+	// Split views walk these chains so splitting doesn't move any line.
+	bool bMessageViewLine;
+	KviIrcViewLine * pPrevInClass;
+	KviIrcViewLine * pNextInClass;
 };
 
+// KviIrcViewLine is incomplete in KviIrcView.h: the chain walkers are defined here
+inline KviIrcViewLine * KviIrcView::viewPrev(const KviIrcViewLine * l) const
+{
+	return m_bClassChain ? l->pPrevInClass : l->pPrev;
+}
+
+inline KviIrcViewLine * KviIrcView::viewNext(const KviIrcViewLine * l) const
+{
+	return m_bClassChain ? l->pNextInClass : l->pNext;
+}
+
 struct KviIrcViewWrappedBlockSelectionInfo
 {
 	int selection_type;
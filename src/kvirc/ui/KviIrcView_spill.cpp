@@ -0,0 +1,409 @@
+//=============================================================================
+//
+//   File : KviIrcView_spill.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviIrcView_spill.h"
+#include "KviIrcView_private.h"
+#include "KviApplication.h"
+#include "KviControlCodes.h"
+#include "KviMemory.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QFile>
+
+#include <cstring>
+
+// don't bother compacting files smaller than this
+#define KVI_IRCVIEW_SPILL_MIN_COMPACT_BYTES (4 * 1024 * 1024)
+
+#define KVI_IRCVIEW_SPILL_CHUNK_HAS_PAYLOAD 1
+#define KVI_IRCVIEW_SPILL_CHUNK_HAS_SMILEID 2
+#define KVI_IRCVIEW_SPILL_CHUNK_SHARED_SMILEID 4
+
+struct KviIrcViewSpillRecordHeader
+{
+	kvi_u32_t uSize; // whole record, header included
+	kvi_u32_t uIndex;
+	int iMsgType;
+	kvi_u32_t uTextLen; // in QChars
+	kvi_u32_t uChunkCount;
+};
+
+struct KviIrcViewSpillChunkHeader
+{
+	kvi_u8_t type;
+	kvi_u8_t back;
+	kvi_u8_t fore;
+	kvi_u8_t flags;
+	int iTextStart;
+	int iTextLen;
+	kvi_u32_t uPayloadLen; // in kvi_wchar_t, terminator excluded
+	kvi_u32_t uSmileIdLen;
+	// followed by the QColor, the payload and the smile id
+};
+
+static kvi_u32_t wchar_len(const kvi_wchar_t * p)
+{
+	const kvi_wchar_t * b = p;
+	while(*p)
+		p++;
+	return p - b;
+}
+
+static kvi_wchar_t * wchar_dup(const uchar * p, kvi_u32_t uLen)
+{
+	kvi_wchar_t * s = (kvi_wchar_t *)KviMemory::allocate((uLen + 1) * sizeof(kvi_wchar_t));
+	memcpy(s, p, uLen * sizeof(kvi_wchar_t));
+	s[uLen] = 0;
+	return s;
+}
+
+KviIrcViewSpillFile::KviIrcViewSpillFile()
+{
+	m_pFile = nullptr;
+	m_bFailed = false;
+	m_pMap = nullptr;
+	m_uMapSize = 0;
+	m_uFileSize = 0;
+	m_uDeadBytes = 0;
+	m_uFirstId = 1;
+}
+
+KviIrcViewSpillFile::~KviIrcViewSpillFile()
+{
+	if(m_pFile)
+	{
+		unmap();
+		m_pFile->close();
+		m_pFile->remove();
+		delete m_pFile;
+	}
+}
+
+bool KviIrcViewSpillFile::open()
+{
+	if(m_pFile)
+		return true;
+	if(m_bFailed)
+		return false;
+
+	g_pApp->getLocalKvircDirectory(m_szFileName, KviApplication::Tmp,
+	    QString("scrollback-%1-%2.bin").arg(QCoreApplication::applicationPid()).arg((quintptr)this, 0, 16));
+
+	m_pFile = new QFile(m_szFileName);
+	if(!m_pFile->open(QIODevice::ReadWrite | QIODevice::Truncate))
+	{
+		// no cold tier then: the lines will be simply dropped
+		delete m_pFile;
+		m_pFile = nullptr;
+		m_bFailed = true;
+		return false;
+	}
+	return true;
+}
+
+bool KviIrcViewSpillFile::map()
+{
+	if(m_pMap && (m_uMapSize == m_uFileSize))
+		return true;
+	unmap();
+	if(!m_pFile || (m_uFileSize == 0))
+		return false;
+	m_pFile->flush();
+	m_pMap = m_pFile->map(0, m_uFileSize);
+	if(!m_pMap)
+		return false;
+	m_uMapSize = m_uFileSize;
+	return true;
+}
+
+void KviIrcViewSpillFile::unmap()
+{
+	if(!m_pMap)
+		return;
+	m_pFile->unmap(m_pMap);
+	m_pMap = nullptr;
+	m_uMapSize = 0;
+}
+
+KviIrcViewSpillFile::Record * KviIrcViewSpillFile::record(unsigned int uId)
+{
+	if((uId < m_uFirstId) || ((uId - m_uFirstId) >= m_Records.size()))
+		return nullptr;
+	return &(m_Records[uId - m_uFirstId]);
+}
+
+void KviIrcViewSpillFile::spill(KviIrcViewLine * pLine, unsigned int uMaxRecords)
+{
+	Record * r = record(pLine->uSpillId);
+	if(r)
+	{
+		// already on disk
+		r->bLoaded = false;
+		return;
+	}
+
+	if(!open())
+		return;
+
+	QByteArray buffer;
+
+	KviIrcViewSpillRecordHeader hdr;
+	hdr.uSize = 0;
+	hdr.uIndex = pLine->uIndex;
+	hdr.iMsgType = pLine->iMsgType;
+	hdr.uTextLen = pLine->szText.length();
+	hdr.uChunkCount = pLine->uChunkCount;
+	buffer.append((const char *)&hdr, sizeof(hdr));
+	buffer.append((const char *)pLine->szText.unicode(), hdr.uTextLen * sizeof(QChar));
+
+	for(unsigned int u = 0; u < pLine->uChunkCount; u++)
+	{
+		KviIrcViewLineChunk * c = &(pLine->pChunks[u]);
+
+		KviIrcViewSpillChunkHeader ch;
+		ch.type = c->type;
+		ch.back = c->colors.back;
+		ch.fore = c->colors.fore;
+		ch.flags = 0;
+		ch.iTextStart = c->iTextStart;
+		ch.iTextLen = c->iTextLen;
+		ch.uPayloadLen = 0;
+		ch.uSmileIdLen = 0;
+
+		// the payload pointers are meaningful only for these types
+		if((c->type == KviControlCodes::Escape) || (c->type == KviControlCodes::Icon))
+		{
+			ch.flags |= KVI_IRCVIEW_SPILL_CHUNK_HAS_PAYLOAD;
+			ch.uPayloadLen = wchar_len(c->szPayload);
+			if(c->type == KviControlCodes::Icon)
+			{
+				if(c->szSmileId == c->szPayload)
+				{
+					ch.flags |= KVI_IRCVIEW_SPILL_CHUNK_SHARED_SMILEID;
+				}
+				else
+				{
+					ch.flags |= KVI_IRCVIEW_SPILL_CHUNK_HAS_SMILEID;
+					ch.uSmileIdLen = wchar_len(c->szSmileId);
+				}
+			}
+		}
+
+		buffer.append((const char *)&ch, sizeof(ch));
+		buffer.append((const char *)&(c->customFore), sizeof(QColor));
+		if(ch.flags & KVI_IRCVIEW_SPILL_CHUNK_HAS_PAYLOAD)
+			buffer.append((const char *)c->szPayload, ch.uPayloadLen * sizeof(kvi_wchar_t));
+		if(ch.flags & KVI_IRCVIEW_SPILL_CHUNK_HAS_SMILEID)
+			buffer.append((const char *)c->szSmileId, ch.uSmileIdLen * sizeof(kvi_wchar_t));
+	}
+
+	kvi_u32_t uSize = buffer.size();
+	memcpy(buffer.data(), &uSize, sizeof(kvi_u32_t));
+
+	m_pFile->seek(m_uFileSize);
+	if(m_pFile->write(buffer) != (qint64)buffer.size())
+	{
+		// disk full ? Stop here, keep what we have
+		m_bFailed = true;
+		return;
+	}
+
+	Record rec;
+	rec.uOffset = m_uFileSize;
+	rec.uSize = uSize;
+	rec.uIndex = pLine->uIndex;
+	rec.bMessageViewLine = pLine->bMessageViewLine;
+	rec.bLoaded = false;
+	m_Records.push_back(rec);
+	m_uFileSize += uSize;
+
+	// the oldest records fall off the cold tier too
+	while(m_Records.size() > uMaxRecords)
+	{
+		m_uDeadBytes += m_Records.front().uSize;
+		m_Records.pop_front();
+		m_uFirstId++;
+	}
+
+	if((m_uDeadBytes > KVI_IRCVIEW_SPILL_MIN_COMPACT_BYTES) && (m_uDeadBytes > (m_uFileSize - m_uDeadBytes)))
+		compact();
+}
+
+void KviIrcViewSpillFile::compact()
+{
+	// rewrite the live records at the beginning of the file
+	if(!map())
+		return;
+
+	QByteArray live;
+	live.reserve(m_uFileSize - m_uDeadBytes);
+	for(auto & r : m_Records)
+	{
+		kvi_u64_t uNewOffset = live.size();
+		live.append((const char *)(m_pMap + r.uOffset), r.uSize);
+		r.uOffset = uNewOffset;
+	}
+
+	unmap();
+	m_pFile->resize(0);
+	m_pFile->seek(0);
+	if(m_pFile->write(live) != (qint64)live.size())
+	{
+		m_Records.clear();
+		m_uFileSize = 0;
+		m_uDeadBytes = 0;
+		m_bFailed = true;
+		return;
+	}
+	m_uFileSize = live.size();
+	m_uDeadBytes = 0;
+}
+
+bool KviIrcViewSpillFile::isCandidate(const Record & r, unsigned int uFromIndex, unsigned int uBeforeIndex, unsigned int uClassMask) const
+{
+	if(r.bLoaded || (r.uIndex < uFromIndex) || (r.uIndex >= uBeforeIndex))
+		return false;
+	return (uClassMask & (r.bMessageViewLine ? 2 : 1)) != 0;
+}
+
+unsigned int KviIrcViewSpillFile::older(unsigned int uId, unsigned int uFromIndex, unsigned int uBeforeIndex, unsigned int uClassMask)
+{
+	// the records are appended roughly in line index order: starting from the
+	// record of a line in memory skips the ones that have been already paged in
+	unsigned int uEnd = m_uFirstId + m_Records.size();
+	if((uId == 0) || (uId > uEnd))
+		uId = uEnd;
+	while(uId > m_uFirstId)
+	{
+		uId--;
+		if(isCandidate(m_Records[uId - m_uFirstId], uFromIndex, uBeforeIndex, uClassMask))
+			return uId;
+	}
+	return 0;
+}
+
+unsigned int KviIrcViewSpillFile::newer(unsigned int uId, unsigned int uFromIndex, unsigned int uBeforeIndex, unsigned int uClassMask)
+{
+	unsigned int uEnd = m_uFirstId + m_Records.size();
+	uId = (uId < m_uFirstId) ? m_uFirstId : (uId + 1);
+	for(; uId < uEnd; uId++)
+	{
+		if(isCandidate(m_Records[uId - m_uFirstId], uFromIndex, uBeforeIndex, uClassMask))
+			return uId;
+	}
+	return 0;
+}
+
+bool KviIrcViewSpillFile::text(unsigned int uId, QString & szText, int & iMsgType)
+{
+	Record * r = record(uId);
+	if(!r || !map())
+		return false;
+
+	KviIrcViewSpillRecordHeader hdr;
+	memcpy(&hdr, m_pMap + r->uOffset, sizeof(hdr));
+	iMsgType = hdr.iMsgType;
+	szText.resize(hdr.uTextLen);
+	memcpy((void *)szText.data(), m_pMap + r->uOffset + sizeof(hdr), hdr.uTextLen * sizeof(QChar));
+	return true;
+}
+
+KviIrcViewLine * KviIrcViewSpillFile::load(unsigned int uId)
+{
+	Record * r = record(uId);
+	if(!r || !map())
+		return nullptr;
+
+	const uchar * p = m_pMap + r->uOffset;
+
+	KviIrcViewSpillRecordHeader hdr;
+	memcpy(&hdr, p, sizeof(hdr));
+	p += sizeof(hdr);
+
+	KviIrcViewLine * pLine = new KviIrcViewLine;
+	pLine->uIndex = hdr.uIndex;
+	pLine->iMsgType = hdr.iMsgType;
+	pLine->szText.resize(hdr.uTextLen);
+	memcpy((void *)pLine->szText.data(), p, hdr.uTextLen * sizeof(QChar));
+	p += hdr.uTextLen * sizeof(QChar);
+
+	pLine->uChunkCount = hdr.uChunkCount;
+	pLine->pChunks = (KviIrcViewLineChunk *)KviMemory::allocate(hdr.uChunkCount * sizeof(KviIrcViewLineChunk));
+	for(unsigned int u = 0; u < hdr.uChunkCount; u++)
+	{
+		KviIrcViewLineChunk * c = &(pLine->pChunks[u]);
+
+		KviIrcViewSpillChunkHeader ch;
+		memcpy(&ch, p, sizeof(ch));
+		p += sizeof(ch);
+
+		c->type = ch.type;
+		c->colors.back = ch.back;
+		c->colors.fore = ch.fore;
+		c->iTextStart = ch.iTextStart;
+		c->iTextLen = ch.iTextLen;
+		memcpy((void *)&(c->customFore), p, sizeof(QColor));
+		p += sizeof(QColor);
+
+		c->szPayload = nullptr;
+		c->szSmileId = nullptr;
+		if(ch.flags & KVI_IRCVIEW_SPILL_CHUNK_HAS_PAYLOAD)
+		{
+			c->szPayload = wchar_dup(p, ch.uPayloadLen);
+			p += ch.uPayloadLen * sizeof(kvi_wchar_t);
+		}
+		if(ch.flags & KVI_IRCVIEW_SPILL_CHUNK_HAS_SMILEID)
+		{
+			c->szSmileId = wchar_dup(p, ch.uSmileIdLen);
+			p += ch.uSmileIdLen * sizeof(kvi_wchar_t);
+		}
+		else if(ch.flags & KVI_IRCVIEW_SPILL_CHUNK_SHARED_SMILEID)
+		{
+			c->szSmileId = c->szPayload;
+		}
+	}
+
+	// wraps will be calculated at paint time
+	pLine->uLineWraps = 0;
+	pLine->iMaxLineWidth = -1;
+	pLine->iBlockCount = 0;
+	pLine->pBlocks = nullptr;
+	pLine->uSpillId = uId;
+	pLine->bSpillGapAbove = false;
+
+	r->bLoaded = true;
+	return pLine;
+}
+
+void KviIrcViewSpillFile::discard(unsigned int uClassMask)
+{
+	// we can't remove records from the middle of the deque (the ids would shift):
+	// mark them as loaded so they're never offered again
+	for(auto & r : m_Records)
+	{
+		if(uClassMask & (r.bMessageViewLine ? 2 : 1))
+			r.bLoaded = true;
+	}
+}
@@ -0,0 +1,112 @@
+#ifndef _KVI_IRCVIEWSPILL_H_
+#define _KVI_IRCVIEWSPILL_H_
+//=============================================================================
+//
+//   File : KviIrcView_spill.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "kvi_settings.h"
+#include "kvi_inttypes.h"
+
+#include <QString>
+
+#include <deque>
+
+class QFile;
+struct KviIrcViewLine;
+
+//
+// The cold tier of the KviIrcView scrollback.
+//
+// The lines dropped from the head of the buffer are appended to a
+// temporary file in a compact binary form (text plus chunk attributes)
+// and read back through a memory map when the user scrolls up or searches.
+// The file lives as long as the view, so the history survives reconnects.
+//
+// Each line that has a record on disk remembers its id in
+// KviIrcViewLine::uSpillId: dropping it again only marks the
+// record as not loaded, it is never written twice.
+//
+// The records are a session cache: they're written in the native
+// byte order and the file is removed when the view dies.
+//
+
+class KviIrcViewSpillFile
+{
+public:
+	KviIrcViewSpillFile();
+	~KviIrcViewSpillFile();
+
+protected:
+	struct Record
+	{
+		kvi_u64_t uOffset;
+		kvi_u32_t uSize;
+		unsigned int uIndex;   // KviIrcViewLine::uIndex
+		bool bMessageViewLine; // KviIrcViewLine::bMessageViewLine
+		bool bLoaded;          // currently in memory
+	};
+
+	QString m_szFileName;
+	QFile * m_pFile;
+	bool m_bFailed;
+	uchar * m_pMap;
+	kvi_u64_t m_uMapSize;
+	kvi_u64_t m_uFileSize;
+	kvi_u64_t m_uDeadBytes;
+	std::deque<Record> m_Records;
+	unsigned int m_uFirstId; // id of m_Records.front()
+
+public:
+	unsigned int count() const { return m_Records.size(); };
+
+	// writes the line record (or marks it as not loaded anymore)
+	void spill(KviIrcViewLine * pLine, unsigned int uMaxRecords);
+
+	// Walk the records of the lines that aren't in memory, with line index in
+	// [uFromIndex,uBeforeIndex) and of the given classes (uClassMask: bit 0 = main
+	// view lines, bit 1 = message view lines), starting after the record uId.
+	// older() returns the nearest older one, newer() the nearest newer one,
+	// 0 at the end of the walk. A uId of 0 starts from the newest (older())
+	// or the oldest (newer()) record.
+	unsigned int older(unsigned int uId, unsigned int uFromIndex, unsigned int uBeforeIndex, unsigned int uClassMask);
+	unsigned int newer(unsigned int uId, unsigned int uFromIndex, unsigned int uBeforeIndex, unsigned int uClassMask);
+
+	// the text and the message type of the record, for searches
+	bool text(unsigned int uId, QString & szText, int & iMsgType);
+
+	// rebuilds the line (marking the record as loaded)
+	KviIrcViewLine * load(unsigned int uId);
+
+	// forgets the records of the given classes (the buffer has been cleared)
+	void discard(unsigned int uClassMask);
+
+protected:
+	Record * record(unsigned int uId);
+	bool isCandidate(const Record & r, unsigned int uFromIndex, unsigned int uBeforeIndex, unsigned int uClassMask) const;
+	bool open();
+	bool map();
+	void unmap();
+	void compact();
+};
+
+#endif //!_KVI_IRCVIEWSPILL_H_
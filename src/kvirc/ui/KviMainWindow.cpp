@@ -53,6 +53,7 @@
 #include "KviIrcView.h"
 #include "KviKvsScript.h"
 #include "KviKvsEventTriggers.h"
+#include "KviKvsProfiler.h"
 #include "KviTextIconManager.h"
 #include "KviShortcut.h"
 
@@ -95,6 +96,7 @@ KviMainWindow::KviMainWindow(QWidget * pParent)
     : KviTalMainWindow(pParent, "kvirc_frame")
 {
 	g_pMainWindow = this;
+	m_bStartupPaintPending = KviKvsProfiler::isProfilingStartup();
 	setAttribute(Qt::WA_DeleteOnClose);
 	setAutoFillBackground(false);
 	setAttribute(Qt::WA_TranslucentBackground);
@@ -884,6 +886,16 @@ void KviMainWindow::resizeEvent(QResizeEvent * e)
 	KviTalMainWindow::resizeEvent(e);
 }
 
+void KviMainWindow::paintEvent(QPaintEvent * e)
+{
+	KviTalMainWindow::paintEvent(e);
+	if(!m_bStartupPaintPending)
+		return;
+	// close the startup profile of kvirc -p from the event loop, once
+	m_bStartupPaintPending = false;
+	QTimer::singleShot(0, &KviKvsProfiler::startupEnd);
+}
+
 void KviMainWindow::contextMenuEvent(QContextMenuEvent *)
 {
 	// do nothing! avoids builtin popup from qmainwindow
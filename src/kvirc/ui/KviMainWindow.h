@@ -87,6 +87,7 @@ protected:
 	// other
 	KviTrayIcon * m_pTrayIcon = nullptr;          // the frame's dock extension: this should be prolly moved ?
 	std::vector<QShortcut *> m_pAccellerators;    // global application accellerators
+	bool m_bStartupPaintPending = false;          // kvirc -p: the first paint ends the startup profile
 public:
 	// the mdi manager: handles mdi children
 	KviWindowStack * windowStack() const { return m_pWindowStack; }
@@ -187,6 +188,7 @@ protected:
 	void closeEvent(QCloseEvent * e) override;
 	void hideEvent(QHideEvent * e) override;
 	void resizeEvent(QResizeEvent * e) override;
+	void paintEvent(QPaintEvent * e) override;
 	void moveEvent(QMoveEvent * e) override;
 	bool focusNextPrevChild(bool next) override;
 	void changeEvent(QEvent * event) override;
@@ -336,7 +336,10 @@ KviUserListEntry * KviQueryWindow::setTarget(const QString & szNick, const QStri
 	if((!pEntry->globalData()->avatar()) && (!szUser.isEmpty()) && (szUser != "*"))
 		m_pConsole->checkDefaultAvatar(pEntry->globalData(), szNick, szUser, szHost);
 
+	QString szOldName = windowName();
 	setWindowName(szNick);
+	if(connection())
+		connection()->queryRenamed(this, szOldName);
 	updateCaption();
 
 	if(KVI_OPTION_BOOL(KviOption_boolEnableQueryTracing))
@@ -399,7 +402,10 @@ bool KviQueryWindow::nickChange(const QString & szOldNick, const QString & szNew
 	if(!bRet)
 		return false; // ugh!! ?
 
+	QString szOldName = windowName();
 	setWindowName(szNewNick);
+	if(connection())
+		connection()->queryRenamed(this, szOldName);
 	updateCaption();
 	updateLabelText();
 	return true;
@@ -119,7 +119,7 @@ void KviToolBar::mousePressEvent(QMouseEvent * e)
 
 		for(auto iconSize : valid_iconsizes)
 		{
-			QAction * pTmp = pIconSizeGroup->addAction(g_pToolBarIconSizesPopup->addAction(__tr2qs(iconSize.pcName)));
+			QAction * pTmp = pIconSizeGroup->addAction(g_pToolBarIconSizesPopup->addAction(__tr2qs_no_xgettext(iconSize.pcName)));
 			pTmp->setData(iconSize.uSize);
 			pTmp->setCheckable(true);
 			if(iconSize.uSize == KVI_OPTION_UINT(KviOption_uintToolBarIconSize))
@@ -133,7 +133,7 @@ void KviToolBar::mousePressEvent(QMouseEvent * e)
 
 		for(auto buttonStyle : valid_buttonstyles)
 		{
-			QAction * pTmp = pButtonStyleGroup->addAction(g_pToolBarButtonStylePopup->addAction(__tr2qs(buttonStyle.pcName)));
+			QAction * pTmp = pButtonStyleGroup->addAction(g_pToolBarButtonStylePopup->addAction(__tr2qs_no_xgettext(buttonStyle.pcName)));
 			pTmp->setData(buttonStyle.uStyle);
 			pTmp->setCheckable(true);
 			if(buttonStyle.uStyle == KVI_OPTION_UINT(KviOption_uintToolBarButtonStyle))
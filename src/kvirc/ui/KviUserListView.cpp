@@ -45,6 +45,7 @@
 #include "KviIrcConnection.h"
 #include "KviIrcConnectionServerInfo.h"
 #include "KviPixmapUtils.h"
+#include "KviAnimatedPixmapCache.h"
 
 #include <QLabel>
 #include <QScrollBar>
@@ -55,7 +56,8 @@
 #include <QEvent>
 #include <QPaintEvent>
 #include <QScrollBar>
-#include <QRegExp>
+
+#include <unordered_set>
 
 #ifdef COMPILE_PSEUDO_TRANSPARENCY
 extern QPixmap * g_pShadedChildGlobalDesktopBackground;
@@ -95,11 +97,17 @@ KviUserListEntry::KviUserListEntry(KviUserListView * pParent, const QString & sz
 	m_pGlobalData = pEntry;
 	m_iFlags = iFlags;
 	m_lastActionTime = (kvi_time_t)0;
+	m_uLastActionSerial = 0;
 	m_joinTime = bJoinTimeUnknown ? (kvi_time_t)0 : kvi_unixTime();
 	m_iTemperature = bJoinTimeUnknown ? 0 : KVI_USERACTION_JOIN;
 
 	m_bSelected = false;
 	m_pAvatarPixmap = nullptr;
+	m_bAvatarPending = false;
+	m_uPaintState = 0;
+	m_uPaintGeneration = 0;
+	m_NickText.setTextFormat(Qt::PlainText);
+	m_NickText.setPerformanceHint(QStaticText::AggressiveCaching);
 
 	updateAvatarData();
 	recalcSize();
@@ -107,12 +115,17 @@ KviUserListEntry::KviUserListEntry(KviUserListView * pParent, const QString & sz
 
 KviUserListEntry::~KviUserListEntry()
 {
-	if(m_pAvatarPixmap)
-		detachAvatarData();
+	detachAvatarData();
 }
 
 void KviUserListEntry::detachAvatarData()
 {
+	if(m_bAvatarPending)
+	{
+		m_bAvatarPending = false;
+		m_pListView->m_uPendingAvatars--;
+	}
+
 	if(!m_pAvatarPixmap)
 		return;
 
@@ -134,9 +147,16 @@ void KviUserListEntry::updateAvatarData()
 	if(
 	    KVI_OPTION_BOOL(KviOption_boolScaleAvatars) && ((!KVI_OPTION_BOOL(KviOption_boolDoNotUpscaleAvatars)) || ((unsigned int)pAv->size().width() > KVI_OPTION_UINT(KviOption_uintAvatarScaleWidth)) || ((unsigned int)pAv->size().height() > KVI_OPTION_UINT(KviOption_uintAvatarScaleHeight))))
 	{
-		m_pAvatarPixmap = pAv->forSize(
-		    KVI_OPTION_UINT(KviOption_uintAvatarScaleWidth),
-		    KVI_OPTION_UINT(KviOption_uintAvatarScaleHeight));
+		QSize size(KVI_OPTION_UINT(KviOption_uintAvatarScaleWidth), KVI_OPTION_UINT(KviOption_uintAvatarScaleHeight));
+		if(!pAv->isReadyForSize(size))
+		{
+			// don't stall the GUI while scaling: we'll be back in KviUserListView::avatarPreloaded()
+			pAv->preloadSize(size);
+			m_bAvatarPending = true;
+			m_pListView->m_uPendingAvatars++;
+			return;
+		}
+		m_pAvatarPixmap = pAv->forSize(size);
 	}
 	else
 	{
@@ -202,6 +222,48 @@ bool KviUserListEntry::color(QColor & color)
 	return true;
 }
 
+void KviUserListEntry::updatePaintCache(const QFont & font, bool bOwnNick, bool bShowIcons)
+{
+	bool bAway = m_pGlobalData->isAway();
+	bool bIrcOp = m_pGlobalData->isIrcOp();
+	unsigned int uState = ((unsigned short)m_iFlags) | (bAway ? 0x10000 : 0) | (bIrcOp ? 0x20000 : 0) | (bOwnNick ? 0x40000 : 0) | (bShowIcons ? 0x80000 : 0);
+
+	if((uState == m_uPaintState) && (m_uPaintGeneration == m_pListView->m_uPaintGeneration))
+		return;
+
+	m_uPaintState = uState;
+	m_uPaintGeneration = m_pListView->m_uPaintGeneration;
+
+	QColor * pClrFore = nullptr;
+
+	if(bOwnNick)
+		pClrFore = &(KVI_OPTION_COLOR(KviOption_colorUserListViewOwnForeground));
+
+	// this is a mask match: that's why we cache the result
+	if(!pClrFore && m_pListView->m_pKviWindow->connection()->userDataBase()->haveCustomColor(m_szNick))
+		pClrFore = m_pListView->m_pKviWindow->connection()->userDataBase()->customColor(m_szNick);
+
+	if(!pClrFore)
+	{
+		if(m_iFlags == 0 && !bIrcOp)
+			pClrFore = &(KVI_OPTION_COLOR(KviOption_colorUserListViewNormalForeground));
+		else
+			pClrFore = &(KVI_OPTION_COLOR(bIrcOp ? KviOption_colorUserListViewIrcOpForeground : ((m_iFlags & KviIrcUserEntry::ChanOwner) ? KviOption_colorUserListViewChanOwnerForeground : ((m_iFlags & KviIrcUserEntry::ChanAdmin) ? KviOption_colorUserListViewChanAdminForeground : ((m_iFlags & KviIrcUserEntry::Op) ? KviOption_colorUserListViewOpForeground : ((m_iFlags & KviIrcUserEntry::HalfOp) ? KviOption_colorUserListViewHalfOpForeground : ((m_iFlags & KviIrcUserEntry::Voice) ? KviOption_colorUserListViewVoiceForeground : KviOption_colorUserListViewUserOpForeground)))))));
+	}
+
+	m_NickColor = *pClrFore;
+
+	QString szText = m_szNick;
+	if(!bShowIcons)
+	{
+		char cFlag = m_pListView->getUserFlag(this);
+		if(cFlag)
+			szText.prepend(QChar(cFlag));
+	}
+	m_NickText.setText(szText);
+	m_NickText.prepare(QTransform(), font);
+}
+
 void KviUserListEntry::recalcSize()
 {
 	m_iHeight = m_pListView->m_iFontHeight;
@@ -245,6 +307,16 @@ KviUserListView::KviUserListView(QWidget * pParent, KviWindowToolPageButton * pB
 	m_ieEntries = 0;
 	m_iIEntries = 0;
 	m_iSelectedCount = 0;
+	m_uLastActionSerial = 0;
+	m_uPendingAvatars = 0;
+	m_uPaintGeneration = 1;
+
+	connect(KviAnimatedPixmapCache::instance(), SIGNAL(preloadFinished()), this, SLOT(avatarPreloaded()));
+	// the custom colors of the registered users
+	connect(g_pRegisteredUserDataBase, SIGNAL(userChanged(const QString &)), this, SLOT(invalidatePaintCache()));
+	connect(g_pRegisteredUserDataBase, SIGNAL(userAdded(const QString &)), this, SLOT(invalidatePaintCache()));
+	connect(g_pRegisteredUserDataBase, SIGNAL(userRemoved(const QString &)), this, SLOT(invalidatePaintCache()));
+	connect(g_pRegisteredUserDataBase, SIGNAL(databaseCleared()), this, SLOT(invalidatePaintCache()));
 
 	applyOptions();
 }
@@ -337,8 +409,17 @@ void KviUserListView::updateScrollBarRange()
 	m_pViewArea->m_pScrollBar->setVisible(iMax > 0);
 }
 
+void KviUserListView::invalidatePaintCache()
+{
+	m_uPaintGeneration++;
+	m_pViewArea->update();
+}
+
 void KviUserListView::applyOptions()
 {
+	// fonts and colors might have changed
+	m_uPaintGeneration++;
+
 	setFont(KVI_OPTION_FONT(KviOption_fontUserListView));
 	QFontMetrics fm(font());
 
@@ -406,6 +487,28 @@ void KviUserListView::setMaskEntries(char cType, int iNum)
 	updateUsersLabel();
 }
 
+void KviUserListView::avatarPreloaded()
+{
+	if(!m_uPendingAvatars)
+		return;
+
+	KviUserListEntry * pEntry = m_pHeadItem;
+	while(pEntry && m_uPendingAvatars)
+	{
+		if(pEntry->m_bAvatarPending)
+		{
+			m_iTotalHeight -= pEntry->m_iHeight;
+			pEntry->updateAvatarData();
+			pEntry->recalcSize();
+			m_iTotalHeight += pEntry->m_iHeight;
+		}
+		pEntry = pEntry->m_pNext;
+	}
+
+	updateScrollBarRange();
+	m_pViewArea->update();
+}
+
 void KviUserListView::animatedAvatarUpdated(KviUserListEntry * e)
 {
 	// FIXME: This sucks
@@ -463,81 +566,44 @@ void KviUserListView::animatedAvatarUpdated(KviUserListEntry * e)
 
 void KviUserListView::completeNickBashLike(const QString & szBegin, std::vector<QString> & pList, bool bAppendMask)
 {
-	KviUserListEntry * pEntry = m_pHeadItem;
-	while(pEntry)
-	{
-		bool bEqual = KviQString::equalCIN(szBegin, pEntry->m_szNick, szBegin.length());
-		if(!bEqual && KVI_OPTION_BOOL(KviOption_boolIgnoreSpecialCharactersInNickCompletion))
-		{
-			QString szTmp = pEntry->m_szNick;
-			szTmp.remove(QRegExp("[^a-zA-Z0-9]"));
-			bEqual = KviQString::equalCIN(szBegin, szTmp, szBegin.length());
-		}
+	std::vector<KviUserListEntry *> entries;
+	m_CompletionIndex.find(szBegin, KVI_OPTION_BOOL(KviOption_boolIgnoreSpecialCharactersInNickCompletion), entries);
 
-		if(bEqual)
-		{
-			if(bAppendMask)
-				pList.push_back(QString("%1!%2@%3").arg(pEntry->m_szNick, pEntry->m_pGlobalData->user(), pEntry->m_pGlobalData->host()));
-			else
-				pList.push_back(pEntry->m_szNick);
-		}
-		pEntry = pEntry->m_pNext;
+	for(auto & pEntry : entries)
+	{
+		if(bAppendMask)
+			pList.push_back(QString("%1!%2@%3").arg(pEntry->m_szNick, pEntry->m_pGlobalData->user(), pEntry->m_pGlobalData->host()));
+		else
+			pList.push_back(pEntry->m_szNick);
 	}
 }
 
 bool KviUserListView::completeNickLastAction(const QString & szBegin, const QString & szSkipAfter, QString & szBuffer, bool bAppendMask)
 {
+	std::vector<KviUserListEntry *> entries;
+	m_CompletionIndex.find(szBegin, KVI_OPTION_BOOL(KviOption_boolIgnoreSpecialCharactersInNickCompletion), entries);
+
+	// the order of the completion cycle: most recent action first,
+	// then the serial breaks the ties and finally the nickname for the ones that never acted
+	auto comesFirst = [](KviUserListEntry * pA, KviUserListEntry * pB) {
+		if(pA->m_lastActionTime != pB->m_lastActionTime)
+			return pA->m_lastActionTime > pB->m_lastActionTime;
+		if(pA->m_uLastActionSerial != pB->m_uLastActionSerial)
+			return pA->m_uLastActionSerial > pB->m_uLastActionSerial;
+		return pA->m_szNick < pB->m_szNick;
+	};
+
 	KviUserListEntry * pLastMatch = findEntry(szSkipAfter);
 	KviUserListEntry * pBestMatch = nullptr;
 
-	bool bUseNextEqual = false;
-	KviUserListEntry * pEntry = m_pHeadItem;
-	while(pEntry)
+	for(auto & pEntry : entries)
 	{
-		if(pLastMatch && pEntry == pLastMatch)
-			bUseNextEqual = true;
-		else if(pEntry->m_szNick.length() >= szBegin.length())
-		{
-			bool bEqual = KviQString::equalCIN(szBegin, pEntry->m_szNick, szBegin.length());
-			if(!bEqual && KVI_OPTION_BOOL(KviOption_boolIgnoreSpecialCharactersInNickCompletion))
-			{
-				QString szTmp = pEntry->m_szNick;
-				szTmp.remove(QRegExp("[^a-zA-Z0-9]"));
-				bEqual = KviQString::equalCIN(szBegin, szTmp, szBegin.length());
-			}
-
-			if(bEqual)
-			{
-				if(!pLastMatch && !pBestMatch)
-					pBestMatch = pEntry;
-				else if(!pLastMatch && pBestMatch)
-				{
-					if(pEntry->m_lastActionTime > pBestMatch->m_lastActionTime)
-						pBestMatch = pEntry;
-				}
-				else if(!pBestMatch)
-				{
-					if(pLastMatch->m_lastActionTime > pEntry->m_lastActionTime)
-						pBestMatch = pEntry;
-					else if(bUseNextEqual && pLastMatch->m_lastActionTime == pEntry->m_lastActionTime)
-					{
-						pBestMatch = pEntry;
-						bUseNextEqual = false;
-					}
-				}
-				else
-				{
-					if((pLastMatch->m_lastActionTime > pEntry->m_lastActionTime) && (pEntry->m_lastActionTime > pBestMatch->m_lastActionTime))
-						pBestMatch = pEntry;
-					else if(bUseNextEqual && pLastMatch->m_lastActionTime == pEntry->m_lastActionTime)
-					{
-						pBestMatch = pEntry;
-						bUseNextEqual = false;
-					}
-				}
-			}
-		}
-		pEntry = pEntry->m_pNext;
+		if(pEntry == pLastMatch)
+			continue;
+		if(pLastMatch && !comesFirst(pLastMatch, pEntry))
+			continue;
+		if(!pBestMatch || comesFirst(pEntry, pBestMatch))
+			pBestMatch = pEntry;
 	}
 
 	if(pBestMatch)
@@ -560,19 +626,19 @@ bool KviUserListView::completeNickStandard(const QString & szBegin, const QStrin
 	if(KVI_OPTION_BOOL(KviOption_boolPrioritizeLastActionTime))
 		return completeNickLastAction(szBegin, szSkipAfter, szBuffer, bAppendMask);
 
+	std::vector<KviUserListEntry *> entries;
+	m_CompletionIndex.find(szBegin, KVI_OPTION_BOOL(KviOption_boolIgnoreSpecialCharactersInNickCompletion), entries);
+	if(entries.empty())
+		return false;
+
 	KviUserListEntry * pEntry = m_pHeadItem;
 
 	if(!szSkipAfter.isEmpty())
 	{
-		while(pEntry)
-		{
-			if(KviQString::equalCI(szSkipAfter, pEntry->m_szNick))
-			{
-				pEntry = pEntry->m_pNext;
-				break;
-			}
-			pEntry = pEntry->m_pNext;
-		}
+		pEntry = findEntry(szSkipAfter);
+		if(!pEntry)
+			return false;
+		pEntry = pEntry->m_pNext;
 	}
 
 	// FIXME: completion should skip my own nick or place it as last entry in the chain (?)
@@ -582,43 +648,38 @@ bool KviUserListView::completeNickStandard(const QString & szBegin, const QStrin
 	//		if(kvi_strEqualCI(entry->m_szNick.ptr(),c->currentNickName())
 	//	}
 
-	// Ok...now the real completion
-	while(pEntry)
+	// Ok...now the real completion: the first match in the list order
+	if(entries.size() > 1)
 	{
-		if(pEntry->m_szNick.length() >= szBegin.length())
-		{
-			bool bEqual = KviQString::equalCIN(szBegin, pEntry->m_szNick, szBegin.length());
-			if(!bEqual && KVI_OPTION_BOOL(KviOption_boolIgnoreSpecialCharactersInNickCompletion))
-			{
-				QString szTmp = pEntry->m_szNick;
-				szTmp.remove(QRegExp("[^a-zA-Z0-9]"));
-				bEqual = KviQString::equalCIN(szBegin, szTmp, szBegin.length());
-			}
-
-			if(bEqual)
-			{
-				// This is ok.
-				szBuffer = pEntry->m_szNick;
-				if(bAppendMask)
-				{
-					szBuffer += "!";
-					szBuffer += pEntry->m_pGlobalData->user();
-					szBuffer += "@";
-					szBuffer += pEntry->m_pGlobalData->host();
-				}
-				return true;
-			}
-		}
-		pEntry = pEntry->m_pNext;
+		std::unordered_set<KviUserListEntry *> matches(entries.begin(), entries.end());
+		while(pEntry && (matches.find(pEntry) == matches.end()))
+			pEntry = pEntry->m_pNext;
+	}
+	else
+	{
+		while(pEntry && (pEntry != entries.front()))
+			pEntry = pEntry->m_pNext;
 	}
 
-	return false;
+	if(!pEntry)
+		return false;
+
+	szBuffer = pEntry->m_szNick;
+	if(bAppendMask)
+	{
+		szBuffer += "!";
+		szBuffer += pEntry->m_pGlobalData->user();
+		szBuffer += "@";
+		szBuffer += pEntry->m_pGlobalData->host();
+	}
+	return true;
 }
 
 void KviUserListView::insertUserEntry(const QString & szNnick, KviUserListEntry * pUserEntry)
 {
 	// Complex insertion task :)
 	m_pEntryDict->insert(szNnick, pUserEntry);
+	m_CompletionIndex.insert(pUserEntry->m_szNick, pUserEntry);
 	m_iTotalHeight += pUserEntry->m_iHeight;
 
 	bool bGotTopItem = false;
@@ -837,7 +898,7 @@ KviUserListEntry * KviUserListView::join(const QString & szNick, const QString &
 	if(!pEntry)
 	{
 		// add an entry to the global dict
-		KviIrcUserEntry * pGlobalData = m_pIrcUserDataBase->insertUser(szNick, szUser, szHost);
+		KviIrcUserEntry * pGlobalData = m_pIrcUserDataBase->insertUser(szNick, szUser, szHost, m_pKviWindow);
 		// calculate the flags and update the counters
 		pEntry = new KviUserListEntry(this, szNick, pGlobalData, iFlags, (szUser == QString()));
 		insertUserEntry(szNick, pEntry);
@@ -942,6 +1003,7 @@ bool KviUserListView::userActionVerifyMask(const QString & szNick, const QString
 	if(pEntry)
 	{
 		pEntry->m_lastActionTime = kvi_unixTime();
+		pEntry->m_uLastActionSerial = ++m_uLastActionSerial;
 		bool bChanged = false;
 
 		if(!(szHost.isEmpty() || (KviQString::equalCS(szHost, "*"))))
@@ -991,6 +1053,7 @@ void KviUserListView::userAction(const QString & szNick, const QString & szUser,
 	if(pEntry)
 	{
 		pEntry->m_lastActionTime = kvi_unixTime();
+		pEntry->m_uLastActionSerial = ++m_uLastActionSerial;
 		if(!(szHost.isEmpty() || (KviQString::equalCS(szHost, "*"))))
 			pEntry->m_pGlobalData->setHost(szHost);
 		if(!(szUser.isEmpty() || (KviQString::equalCS(szUser, "*"))))
@@ -1014,6 +1077,7 @@ void KviUserListView::userAction(KviIrcMask * pUser, int iActionTemperature)
 	if(pEntry)
 	{
 		pEntry->m_lastActionTime = kvi_unixTime();
+		pEntry->m_uLastActionSerial = ++m_uLastActionSerial;
 		if(pUser->hasUser())
 			pEntry->m_pGlobalData->setUser(pUser->user());
 		if(pUser->hasHost())
@@ -1037,6 +1101,7 @@ void KviUserListView::userAction(const QString & szNick, int iActionTemperature)
 	if(pEntry)
 	{
 		pEntry->m_lastActionTime = kvi_unixTime();
+		pEntry->m_uLastActionSerial = ++m_uLastActionSerial;
 		pEntry->m_iTemperature += iActionTemperature;
 
 		if(pEntry->m_iTemperature > 300)
@@ -1331,7 +1396,7 @@ bool KviUserListView::partInternal(const QString & szNick, bool bRemoveDefinitiv
 	if(bRemoveDefinitively)
 	{
 		pUserEntry->detachAvatarData();
-		m_pIrcUserDataBase->removeUser(szNick, pUserEntry->m_pGlobalData);
+		m_pIrcUserDataBase->removeUser(szNick, pUserEntry->m_pGlobalData, m_pKviWindow);
 	}
 
 	if(pUserEntry->m_bSelected)
@@ -1359,6 +1424,7 @@ bool KviUserListView::partInternal(const QString & szNick, bool bRemoveDefinitiv
 
 	int iHeight = pUserEntry->m_iHeight;
 
+	m_CompletionIndex.remove(pUserEntry->m_szNick, pUserEntry);
 	m_pEntryDict->remove(szNick);
 
 	if(bGotTopItem)
@@ -1415,6 +1481,7 @@ bool KviUserListView::nickChange(const QString & szOldNick, const QString & szNe
 		pEntry->m_pGlobalData->setHops(iHops);
 		pEntry->m_joinTime = joint;
 		pEntry->m_lastActionTime = kvi_unixTime();
+		pEntry->m_uLastActionSerial = ++m_uLastActionSerial;
 		pEntry->m_bSelected = bSelect;
 		pEntry->m_iTemperature += KVI_USERACTION_NICK;
 
@@ -1480,11 +1547,12 @@ void KviUserListView::removeAllEntries()
 	{
 		//it.current()->resetAvatarConnection();
 		m_pIrcUserDataBase->removeUser(it.currentKey(),
-		    ((KviUserListEntry *)it.current())->m_pGlobalData);
+		    ((KviUserListEntry *)it.current())->m_pGlobalData, m_pKviWindow);
 		++it;
 	}
 
 	m_pEntryDict->clear();
+	m_CompletionIndex.clear();
 	m_pHeadItem = nullptr;
 	m_pTopItem = nullptr;
 	m_iVoiceCount = 0;
@@ -1870,6 +1938,8 @@ void KviUserListViewArea::paintEvent(QPaintEvent * e)
 	bool bShowIcons = KVI_OPTION_BOOL(KviOption_boolShowUserChannelIcons);
 	bool bShowState = KVI_OPTION_BOOL(KviOption_boolShowUserChannelState);
 	bool bShowGender = KVI_OPTION_BOOL(KviOption_boolDrawGenderIcons);
+	bool bOwnNickColor = KVI_OPTION_BOOL(KviOption_boolUseDifferentColorForOwnNick) && m_pListView->m_pKviWindow->connection();
+	QString szOwnNick = bOwnNickColor ? m_pListView->m_pKviWindow->connection()->currentNickName() : QString();
 
 	while(pEntry && iTheY <= r.bottom())
 	{
@@ -1881,7 +1951,10 @@ void KviUserListViewArea::paintEvent(QPaintEvent * e)
 
 		if(iBottom >= r.top())
 		{
-			QColor * pClrFore = nullptr;
+			bool bOwnNick = bOwnNickColor && (pEntry->m_szNick == szOwnNick);
+			pEntry->updatePaintCache(p.font(), bOwnNick, bShowIcons);
+
+			QColor clrFore = pEntry->m_NickColor;
 			if(pEntry->m_bSelected)
 			{
 				QColor col(KVI_OPTION_COLOR(KviOption_colorUserListViewSelectionBackground));
@@ -1901,41 +1974,7 @@ void KviUserListViewArea::paintEvent(QPaintEvent * e)
 					opt.palette.setColor(QPalette::Highlight, col);
 					style()->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, &p, this);
 				}
-				pClrFore = &(KVI_OPTION_COLOR(KviOption_colorUserListViewSelectionForeground));
-			}
-			else if(KVI_OPTION_BOOL(KviOption_boolUseDifferentColorForOwnNick) && m_pListView->m_pKviWindow->connection())
-			{
-				if(pEntry->m_szNick == m_pListView->m_pKviWindow->connection()->currentNickName())
-				{
-					pClrFore = &(KVI_OPTION_COLOR(KviOption_colorUserListViewOwnForeground));
-				}
-			}
-
-			if(!pClrFore)
-			{
-				// FIXME:
-				//
-				// this is slow... VERY slow when one has a lot of registered users.
-				//   (this is NOT a simple lookup in the user db... it is a mask match)
-				// if we REALLY need to use custom colors for regged users then
-				// they should be updated ONCE and stored (cached) in the KviUserListEntry structure
-				//
-				if(m_pListView->m_pKviWindow->connection()->userDataBase()->haveCustomColor(pEntry->m_szNick))
-				{
-					pClrFore = m_pListView->m_pKviWindow->connection()->userDataBase()->customColor(pEntry->m_szNick);
-				}
-
-				if(!pClrFore)
-				{
-					if(pEntry->m_iFlags == 0 && !pEntry->globalData()->isIrcOp())
-					{
-						pClrFore = &(KVI_OPTION_COLOR(KviOption_colorUserListViewNormalForeground));
-					}
-					else
-					{
-						pClrFore = &(KVI_OPTION_COLOR((pEntry->globalData()->isIrcOp()) ? KviOption_colorUserListViewIrcOpForeground : ((pEntry->m_iFlags & KviIrcUserEntry::ChanOwner) ? KviOption_colorUserListViewChanOwnerForeground : ((pEntry->m_iFlags & KviIrcUserEntry::ChanAdmin) ? KviOption_colorUserListViewChanAdminForeground : ((pEntry->m_iFlags & KviIrcUserEntry::Op) ? KviOption_colorUserListViewOpForeground : ((pEntry->m_iFlags & KviIrcUserEntry::HalfOp) ? KviOption_colorUserListViewHalfOpForeground : ((pEntry->m_iFlags & KviIrcUserEntry::Voice) ? KviOption_colorUserListViewVoiceForeground : KviOption_colorUserListViewUserOpForeground)))))));
-					}
-				}
+				clrFore = KVI_OPTION_COLOR(KviOption_colorUserListViewSelectionForeground);
 			}
 
 			int iTheX = KVI_USERLIST_BORDER_WIDTH + KVI_USERLIST_ICON_MARGIN + 1;
@@ -1982,7 +2021,7 @@ void KviUserListViewArea::paintEvent(QPaintEvent * e)
 
 			if(pEntry->globalData()->isAway() && KVI_OPTION_BOOL(KviOption_boolUserListViewUseAwayColor))
 			{
-				QRgb rgb2 = pClrFore->rgb();
+				QRgb rgb2 = clrFore.rgb();
 				QRgb rgb1 = KVI_OPTION_COLOR(KviOption_colorUserListViewAwayForeground).rgb();
 				p.setPen(QColor(
 				    ((qRed(rgb1) * 2) + qRed(rgb2)) / 3,
@@ -1991,7 +2030,7 @@ void KviUserListViewArea::paintEvent(QPaintEvent * e)
 			}
 			else
 			{
-				p.setPen(*pClrFore);
+				p.setPen(clrFore);
 			}
 			iTheY += 2;
 
@@ -2114,23 +2153,10 @@ void KviUserListViewArea::paintEvent(QPaintEvent * e)
 					p.drawPixmap(iTheX, iTheY + (fm.lineSpacing() - 16 /*size of small icon*/) / 2, *pIco);
 				}
 				iTheX += KVI_USERLIST_ICON_WIDTH + KVI_USERLIST_ICON_MARGIN;
-				p.drawText(iAvatarAndTextX, iTheY + fm.lineSpacing() - 1, pEntry->m_szNick);
 			}
-			else
-			{
 
-				char cFlag = m_pListView->getUserFlag(pEntry);
-				if(cFlag)
-				{
-					QString szTmp = QChar(cFlag);
-					szTmp += pEntry->m_szNick;
-					p.drawText(iAvatarAndTextX, iTheY + fm.lineSpacing() - 1, szTmp);
-				}
-				else
-				{
-					p.drawText(iAvatarAndTextX, iTheY + fm.lineSpacing() - 1, pEntry->m_szNick);
-				}
-			}
+			// the static text is positioned by its top, not by the baseline
+			p.drawStaticText(iAvatarAndTextX, iTheY + fm.lineSpacing() - 1 - fm.ascent(), pEntry->m_NickText);
 		}
 
 		iTheY = iBottom;
@@ -45,10 +45,13 @@
 #include "KviIrcMask.h"
 #include "KviTimeUtils.h"
 #include "KviTalToolTip.h"
+#include "KviUserListView_completion.h"
 
 #include <time.h>
 #include <vector>
 
+#include <QColor>
+#include <QStaticText>
 #include <QWidget>
 
 class QLabel;
@@ -159,6 +162,7 @@ protected:
 	short int m_iFlags;
 	short int m_iTemperature; // user temperature : 0 = neutral
 	kvi_time_t m_lastActionTime;
+	unsigned int m_uLastActionSerial; // orders the actions happening in the same second
 	kvi_time_t m_joinTime;
 
 	int m_iHeight;
@@ -166,6 +170,13 @@ protected:
 	KviUserListEntry * m_pNext;
 	KviUserListEntry * m_pPrev;
 	KviAnimatedPixmap * m_pAvatarPixmap;
+	bool m_bAvatarPending; // waiting for the scaled avatar (see KviUserListView::avatarPreloaded())
+
+	// what paintEvent() needs to draw the nick, rebuilt only when the state below changes
+	QStaticText m_NickText;
+	QColor m_NickColor;
+	unsigned int m_uPaintState;      // flags, away, ircop... see updatePaintCache()
+	unsigned int m_uPaintGeneration; // KviUserListView::m_uPaintGeneration
 
 public:
 	/**
@@ -213,6 +224,15 @@ protected:
 	*/
 	void recalcSize();
 
+	/**
+	* \brief Rebuilds the nick text and color if the entry state changed since the last paint
+	* \param font The font of the list
+	* \param bOwnNick Whether the entry is the user's own nick
+	* \param bShowIcons Whether the mode is shown as an icon (instead of a prefix)
+	* \return void
+	*/
+	void updatePaintCache(const QFont & font, bool bOwnNick, bool bShowIcons);
+
 private slots:
 	void avatarFrameChanged();
 	void avatarDestroyed();
@@ -256,6 +276,10 @@ protected:
 	KviUserListEntry * m_pHeadItem;
 	KviUserListEntry * m_pTailItem;
 	KviUserListEntry * m_pIterator;
+	KviUserListCompletionIndex m_CompletionIndex;
+	unsigned int m_uLastActionSerial;
+	unsigned int m_uPendingAvatars;
+	unsigned int m_uPaintGeneration; // invalidates the paint cache of all the entries
 	QLabel * m_pUsersLabel;
 	KviUserListViewArea * m_pViewArea;
 	KviIrcUserDataBase * m_pIrcUserDataBase;
@@ -813,6 +837,18 @@ public slots:
 	* \return void
 	*/
 	void animatedAvatarUpdated(KviUserListEntry * e);
+
+	/**
+	* \brief Called when an avatar has been scaled in background
+	* \return void
+	*/
+	void avatarPreloaded();
+
+	/**
+	* \brief Forces all the entries to recompute their text and color at the next paint
+	* \return void
+	*/
+	void invalidatePaintCache();
 };
 
 /**
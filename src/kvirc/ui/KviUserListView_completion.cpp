@@ -0,0 +1,132 @@
+//=============================================================================
+//
+//   File : KviUserListView_completion.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include "KviUserListView_completion.h"
+#include "KviUserListView.h"
+#include "KviQString.h"
+
+#include <algorithm>
+
+QString KviUserListCompletionIndex::fold(const QString & szNick)
+{
+	QString szKey(szNick.length(), Qt::Uninitialized);
+	QChar * pKey = szKey.data();
+	const QChar * pC = szNick.unicode();
+	const QChar * pE = pC + szNick.length();
+	while(pC < pE)
+		*pKey++ = (pC++)->toLower();
+	return szKey;
+}
+
+QString KviUserListCompletionIndex::foldStripped(const QString & szNick)
+{
+	// same as removing QRegExp("[^a-zA-Z0-9]") and folding
+	QString szKey;
+	szKey.reserve(szNick.length());
+	const QChar * pC = szNick.unicode();
+	const QChar * pE = pC + szNick.length();
+	while(pC < pE)
+	{
+		ushort c = pC->unicode();
+		if((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+			szKey.append(*pC);
+		else if(c >= 'A' && c <= 'Z')
+			szKey.append(QChar(c + ('a' - 'A')));
+		pC++;
+	}
+	return szKey;
+}
+
+void KviUserListCompletionIndex::insertKey(std::vector<Key> & keys, const QString & szKey, KviUserListEntry * pEntry)
+{
+	auto it = std::upper_bound(keys.begin(), keys.end(), szKey,
+	    [](const QString & szValue, const Key & k) { return szValue < k.szKey; });
+	keys.insert(it, { szKey, pEntry });
+}
+
+void KviUserListCompletionIndex::removeKey(std::vector<Key> & keys, const QString & szKey, KviUserListEntry * pEntry)
+{
+	auto it = std::lower_bound(keys.begin(), keys.end(), szKey,
+	    [](const Key & k, const QString & szValue) { return k.szKey < szValue; });
+	while((it != keys.end()) && (it->szKey == szKey))
+	{
+		if(it->pEntry == pEntry)
+		{
+			keys.erase(it);
+			return;
+		}
+		++it;
+	}
+}
+
+void KviUserListCompletionIndex::findKeys(const std::vector<Key> & keys, const QString & szBegin, std::vector<KviUserListEntry *> & entries)
+{
+	auto it = std::lower_bound(keys.begin(), keys.end(), szBegin,
+	    [](const Key & k, const QString & szValue) { return k.szKey < szValue; });
+	while((it != keys.end()) && it->szKey.startsWith(szBegin))
+	{
+		entries.push_back(it->pEntry);
+		++it;
+	}
+}
+
+void KviUserListCompletionIndex::insert(const QString & szNick, KviUserListEntry * pEntry)
+{
+	QString szKey = fold(szNick);
+	QString szStripped = foldStripped(szNick);
+	insertKey(m_Nicks, szKey, pEntry);
+	if(szStripped != szKey)
+		insertKey(m_StrippedNicks, szStripped, pEntry);
+}
+
+void KviUserListCompletionIndex::remove(const QString & szNick, KviUserListEntry * pEntry)
+{
+	QString szKey = fold(szNick);
+	QString szStripped = foldStripped(szNick);
+	removeKey(m_Nicks, szKey, pEntry);
+	if(szStripped != szKey)
+		removeKey(m_StrippedNicks, szStripped, pEntry);
+}
+
+void KviUserListCompletionIndex::clear()
+{
+	m_Nicks.clear();
+	m_StrippedNicks.clear();
+}
+
+void KviUserListCompletionIndex::find(const QString & szBegin, bool bStripped, std::vector<KviUserListEntry *> & entries) const
+{
+	QString szKey = fold(szBegin);
+	findKeys(m_Nicks, szKey, entries);
+	if(!bStripped)
+		return;
+
+	std::size_t uFound = entries.size();
+	findKeys(m_StrippedNicks, szKey, entries);
+	// drop the ones that matched with the whole nickname too
+	auto it = std::remove_if(entries.begin() + uFound, entries.end(),
+	    [&szBegin](KviUserListEntry * pEntry) { return KviQString::equalCIN(szBegin, pEntry->nick(), szBegin.length()); });
+	entries.erase(it, entries.end());
+}
@@ -0,0 +1,86 @@
+#ifndef _KVI_USERLISTVIEWCOMPLETION_H_
+#define _KVI_USERLISTVIEWCOMPLETION_H_
+//=============================================================================
+//
+//   File : KviUserListView_completion.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include "kvi_settings.h"
+
+#include <QString>
+
+#include <vector>
+
+class KviUserListEntry;
+
+//
+// Prefix index of the nicknames in a KviUserListView, used by the completion.
+//
+// The keys are the nicknames folded to lowercase one character at a time
+// (exactly what KviQString::equalCIN() compares) and kept in sorted arrays:
+// the entries matching a prefix are a contiguous range found by a binary search.
+// A second array holds the nicknames stripped of the characters
+// other than [a-zA-Z0-9] for KviOption_boolIgnoreSpecialCharactersInNickCompletion,
+// but only for the nicknames that actually contain some of them.
+//
+// The index follows the view: insertUserEntry() adds the entry and
+// partInternal() removes it, so joins, parts, nick and mode changes
+// are all incremental.
+//
+
+class KviUserListCompletionIndex
+{
+protected:
+	struct Key
+	{
+		QString szKey;
+		KviUserListEntry * pEntry;
+	};
+
+	std::vector<Key> m_Nicks;
+	std::vector<Key> m_StrippedNicks;
+
+public:
+	unsigned int count() const { return m_Nicks.size(); };
+
+	void insert(const QString & szNick, KviUserListEntry * pEntry);
+	void remove(const QString & szNick, KviUserListEntry * pEntry);
+	void clear();
+
+	// the entries whose nickname starts with szBegin (case insensitive),
+	// with bStripped also the ones whose nickname without special characters does.
+	// Each entry is reported once, in no particular order.
+	void find(const QString & szBegin, bool bStripped, std::vector<KviUserListEntry *> & entries) const;
+
+	static QString fold(const QString & szNick);
+	// folds and strips the characters other than [a-zA-Z0-9]
+	static QString foldStripped(const QString & szNick);
+
+protected:
+	static void insertKey(std::vector<Key> & keys, const QString & szKey, KviUserListEntry * pEntry);
+	static void removeKey(std::vector<Key> & keys, const QString & szKey, KviUserListEntry * pEntry);
+	// appends the entries with keys starting with szBegin
+	static void findKeys(const std::vector<Key> & keys, const QString & szBegin, std::vector<KviUserListEntry *> & entries);
+};
+
+#endif //!_KVI_USERLISTVIEWCOMPLETION_H_
@@ -54,6 +54,7 @@
 #include "KviKvsScript.h"
 #include "KviTalToolTip.h"
 #include "KviKvsEventTriggers.h"
+#include "KviLogFrames.h"
 
 #include <QPixmap>
 #include <QCursor>
@@ -78,10 +79,6 @@
 #include <tuple>
 #include <vector>
 
-#ifdef COMPILE_ZLIB_SUPPORT
-#include <zlib.h>
-#endif
-
 #ifdef COMPILE_CRYPT_SUPPORT
 #include "KviCryptEngine.h"
 #include "KviCryptController.h"
@@ -1417,8 +1414,8 @@ void KviWindow::pasteLastLog()
 				if (!fi.exists() || !fi.isFile())
 					continue;
 
-				// Load the log
-				QByteArray log = loadLogFile(szFileName, bGzip);
+				// Load the log (the trailing newline makes an extra empty line)
+				QByteArray log = loadLogFile(szFileName, bGzip, uMaxLines - vLines.size() + 1);
 
 				if(log.size() == 0)
 					continue;
@@ -1510,28 +1507,21 @@ enough:
 	output(KVI_OUT_LOG, szDummy);
 }
 
-QByteArray KviWindow::loadLogFile(const QString & szFileName, bool bGzip)
+QByteArray KviWindow::loadLogFile(const QString & szFileName, bool bGzip, unsigned int uLines)
 {
 	QByteArray data;
 
 #ifdef COMPILE_ZLIB_SUPPORT
 	if(bGzip)
 	{
-		gzFile logFile = gzopen(szFileName.toLocal8Bit().data(), "rb");
-		if(logFile)
+		// only the last frames of a big log are decompressed
+		KviLogFrameReader reader(szFileName);
+		if(reader.open())
 		{
-			char cBuff[1025];
-			int iLen;
-
-			iLen = gzread(logFile, cBuff, 1024);
-			while(iLen > 0)
-			{
-				cBuff[iLen] = 0;
-				data.append(cBuff);
-				iLen = gzread(logFile, cBuff, 1024);
-			}
-
-			gzclose(logFile);
+			if(uLines)
+				reader.readLastLines(data, uLines);
+			else
+				reader.readAll(data);
 		}
 		else
 		{
@@ -455,9 +455,11 @@ private:
 	* It opens a logfile, gzipped or not, and returns the content in a buffer
 	* \param szFileName The filename of the log file
 	* \param bGzip Whether the log file is gzipped
+	* \param uLines The number of lines needed from the end of the log, 0 for the whole log.
+	* The indexed compressed logs are decoded only as far as needed, so the buffer may contain more lines
 	* \return QByteArray
 	*/
-	QByteArray loadLogFile(const QString & szFileName, bool bGzip);
+	QByteArray loadLogFile(const QString & szFileName, bool bGzip, unsigned int uLines = 0);
 
 protected:
 	// Loading and saving of properties
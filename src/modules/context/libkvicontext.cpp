@@ -41,6 +41,7 @@
 #include "KviIrcConnectionStatistics.h"
 #include "KviIrcLink.h"
 #include "KviIrcSocket.h"
+#include "KviKvsHash.h"
 
 #ifdef COMPILE_SSL_SUPPORT
 #include "KviSSLMaster.h"
@@ -533,6 +534,165 @@ STANDARD_IRC_CONNECTION_TARGET_PARAMETER(
     context_kvs_fnc_lastMessageTime,
     c->returnValue()->setInteger((kvs_int_t)(pConnection->statistics()->lastMessageTime()));)
 
+static KviKvsHash * context_histogram_to_hash(KviHistogram & h)
+{
+	KviKvsHash * pHash = new KviKvsHash();
+	pHash->set("count", new KviKvsVariant((kvs_int_t)h.count()));
+	pHash->set("mean", new KviKvsVariant((kvs_real_t)h.mean()));
+	pHash->set("max", new KviKvsVariant((kvs_int_t)h.max()));
+	pHash->set("p50", new KviKvsVariant((kvs_int_t)h.percentile(50.0)));
+	pHash->set("p90", new KviKvsVariant((kvs_int_t)h.percentile(90.0)));
+	pHash->set("p99", new KviKvsVariant((kvs_int_t)h.percentile(99.0)));
+	pHash->set("p999", new KviKvsVariant((kvs_int_t)h.percentile(99.9)));
+	return pHash;
+}
+
+/*
+	@doc: context.telemetry
+	@type:
+		function
+	@title:
+		$context.telemetry
+	@short:
+		Returns the telemetry of an IRC context
+	@syntax:
+		<hash> $context.telemetry
+		<hash> $context.telemetry(<irc_context_id:uint>)
+	@description:
+		Returns the telemetry collected for the connection of the
+		specified IRC context as a hash. If no irc_context_id is specified
+		then the current irc_context is used. If the IRC context is not
+		connected then this function returns nothing.[br]
+		The telemetry is collected only when the boolEnableConnectionTelemetry
+		option is set.[br]
+		The keys [i]readsize[/i] (bytes per socket read), [i]dispatch[/i]
+		(microseconds spent parsing and handling a server message), [i]sendqueue[/i]
+		(microseconds spent by an outgoing message in the queue) and [i]lag[/i]
+		(milliseconds) contain hashes with the keys count, mean, max,
+		p50, p90, p99 and p999 (the percentiles).
+		The [i]commands[/i] key contains a hash with the number of
+		received messages by command and [i]elapsed[/i] the number of
+		seconds the telemetry has been collected for.[br]
+		The [i]fastpath[/i] key is always filled: it contains the hashes
+		[i]ignore[/i] (the registered user lookups), [i]antispam[/i] and
+		[i]highlight[/i] with the keys checks and rejects: the number
+		of checks and how many of them have been rejected by the filters
+		without running the full (and slower) matching.
+	@examples:
+		[example]
+			option boolEnableConnectionTelemetry 1
+			%t = $context.telemetry
+			echo "Dispatch p99:" %t{"dispatch"}{"p99"} "usecs"
+		[/example]
+	@seealso:
+		[fnc]$context.telemetryJson[/fnc], [cmd]context.resetTelemetry[/cmd]
+*/
+
+static bool context_kvs_fnc_telemetry(KviKvsModuleFunctionCall * c)
+{
+	GET_CONNECTION_FROM_STANDARD_PARAMS
+
+	if(!pConnection)
+	{
+		c->returnValue()->setNothing();
+		return true;
+	}
+
+	KviIrcConnectionStatistics * pStats = pConnection->statistics();
+	KviKvsHash * pHash = new KviKvsHash();
+	pHash->set("elapsed", new KviKvsVariant((kvs_real_t)pStats->telemetryTime() / 1000000.0));
+	pHash->set("readsize", new KviKvsVariant(context_histogram_to_hash(pStats->readSize())));
+	pHash->set("dispatch", new KviKvsVariant(context_histogram_to_hash(pStats->dispatchLatency())));
+	pHash->set("sendqueue", new KviKvsVariant(context_histogram_to_hash(pStats->sendQueueWait())));
+	pHash->set("lag", new KviKvsVariant(context_histogram_to_hash(pStats->lag())));
+
+	KviKvsHash * pCommands = new KviKvsHash();
+	for(auto & it : pStats->commands())
+		pCommands->set(QString::fromLatin1(it.first.c_str()), new KviKvsVariant((kvs_int_t)it.second.uCount));
+	pHash->set("commands", new KviKvsVariant(pCommands));
+
+	KviKvsHash * pFastPath = new KviKvsHash();
+	KviKvsHash * pIgnore = new KviKvsHash();
+	pIgnore->set("checks", new KviKvsVariant((kvs_int_t)pStats->ignoreChecks()));
+	pIgnore->set("rejects", new KviKvsVariant((kvs_int_t)pStats->ignoreRejects()));
+	pFastPath->set("ignore", new KviKvsVariant(pIgnore));
+	KviKvsHash * pAntiSpam = new KviKvsHash();
+	pAntiSpam->set("checks", new KviKvsVariant((kvs_int_t)pStats->fastPathChecks(KviIrcConnectionStatistics::FastPathAntiSpam)));
+	pAntiSpam->set("rejects", new KviKvsVariant((kvs_int_t)pStats->fastPathRejects(KviIrcConnectionStatistics::FastPathAntiSpam)));
+	pFastPath->set("antispam", new KviKvsVariant(pAntiSpam));
+	KviKvsHash * pHighlight = new KviKvsHash();
+	pHighlight->set("checks", new KviKvsVariant((kvs_int_t)pStats->fastPathChecks(KviIrcConnectionStatistics::FastPathHighlight)));
+	pHighlight->set("rejects", new KviKvsVariant((kvs_int_t)pStats->fastPathRejects(KviIrcConnectionStatistics::FastPathHighlight)));
+	pFastPath->set("highlight", new KviKvsVariant(pHighlight));
+	pHash->set("fastpath", new KviKvsVariant(pFastPath));
+
+	c->returnValue()->setHash(pHash);
+	return true;
+}
+
+/*
+	@doc: context.telemetryJson
+	@type:
+		function
+	@title:
+		$context.telemetryJson
+	@short:
+		Returns the telemetry of an IRC context as JSON
+	@syntax:
+		<string> $context.telemetryJson
+		<string> $context.telemetryJson(<irc_context_id:uint>)
+	@description:
+		Returns the telemetry collected for the connection of the
+		specified IRC context as a compact JSON document, suitable
+		to be written to a file with [cmd]file.write[/cmd].
+		Unlike [fnc]$context.telemetry[/fnc] it includes the
+		histogram buckets (as [low, high, count] triplets) and, for each
+		command, the message rate and the total and maximum time spent
+		dispatching the messages.
+		If the IRC context is not connected then this function returns nothing.
+	@seealso:
+		[fnc]$context.telemetry[/fnc]
+*/
+
+static bool context_kvs_fnc_telemetryJson(KviKvsModuleFunctionCall * c)
+{
+	GET_CONNECTION_FROM_STANDARD_PARAMS
+
+	if(!pConnection)
+	{
+		c->returnValue()->setNothing();
+		return true;
+	}
+
+	c->returnValue()->setString(QString::fromUtf8(pConnection->statistics()->telemetryJson()));
+	return true;
+}
+
+/*
+	@doc: context.resetTelemetry
+	@type:
+		command
+	@title:
+		context.resetTelemetry
+	@syntax:
+		context.resetTelemetry
+	@short:
+		Resets the telemetry of the current IRC context
+	@description:
+		Forgets the telemetry collected so far for the connection
+		of the current IRC context.
+	@seealso:
+		[fnc]$context.telemetry[/fnc]
+*/
+
+static bool context_kvs_cmd_resetTelemetry(KviKvsModuleCommandCall * c)
+{
+	KVSM_REQUIRE_CONNECTION(c)
+
+	c->window()->connection()->statistics()->resetTelemetry();
+	return true;
+}
+
 /*
 	@doc: context.clearqueue
 	@type:
@@ -773,9 +933,12 @@ static bool context_module_init(KviModule * m)
 	KVSM_REGISTER_FUNCTION(m, "connectionStartTime", context_kvs_fnc_connectionStartTime);
 	KVSM_REGISTER_FUNCTION(m, "lastMessageTime", context_kvs_fnc_lastMessageTime);
 	KVSM_REGISTER_FUNCTION(m, "queueSize", context_kvs_fnc_queueSize);
+	KVSM_REGISTER_FUNCTION(m, "telemetry", context_kvs_fnc_telemetry);
+	KVSM_REGISTER_FUNCTION(m, "telemetryJson", context_kvs_fnc_telemetryJson);
 	KVSM_REGISTER_FUNCTION(m, "getSSLCertInfo", context_kvs_fnc_getSSLCertInfo);
 
 	KVSM_REGISTER_SIMPLE_COMMAND(m, "clearQueue", context_kvs_cmd_clearQueue);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "resetTelemetry", context_kvs_cmd_resetTelemetry);
 
 	return true;
 }
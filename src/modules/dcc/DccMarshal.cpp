@@ -565,7 +565,8 @@ void DccMarshal::snActivated(int)
 	// SSL Handshake needed ?
 	if(m_bUseSSL)
 	{
-		m_pSSL = KviSSLMaster::allocSSL(m_pOutputContext->dccMarshalOutputWindow(), m_fd, m_bOutgoing ? KviSSL::Client : KviSSL::Server, m_pOutputContext->dccMarshalOutputContextString());
+		// the listening port changes on each DCC: resume the sessions by peer address
+		m_pSSL = KviSSLMaster::allocSSL(m_pOutputContext->dccMarshalOutputWindow(), m_fd, m_bOutgoing ? KviSSL::Client : KviSSL::Server, m_pOutputContext->dccMarshalOutputContextString(), m_bOutgoing ? QString("dcc:%1").arg(m_szIp) : QString());
 
 		if(m_pSSL)
 		{
@@ -32,16 +32,25 @@
 #include "KviModule.h"
 #include "KviOptions.h"
 #include "kvi_socket.h"
+#include "KviApplication.h"
+#include "KviConsoleWindow.h"
+#include "KviIrcContext.h"
+#include "KviIrcConnection.h"
+#include "KviIrcConnectionStatistics.h"
+#include "KviHistogram.h"
 
 #include <QPainter>
 #include <QPaintEvent>
 #include <QPainterPath>
 
+#include <vector>
+
 #ifdef COMPILE_PSEUDO_TRANSPARENCY
 extern KVIRC_API QPixmap * g_pShadedChildGlobalDesktopBackground;
 #endif
 
 KviIOGraphWindow * g_pIOGraphWindow = nullptr;
+std::unordered_set<KviTelemetryWindow *> g_pTelemetryWindowList;
 
 KviIOGraphWindow::KviIOGraphWindow(const char * name)
     : KviWindow(KviWindow::IOGraph, name)
@@ -253,6 +262,118 @@ void KviIOGraphWidget::paintEvent(QPaintEvent *)
 	p.drawPath(sP);
 }
 
+KviTelemetryWindow::KviTelemetryWindow(unsigned int uContextId)
+    : KviWindow(KviWindow::IOGraph, "telemetry_window"), m_uContextId(uContextId)
+{
+	g_pTelemetryWindowList.insert(this);
+	m_pWidget = new KviTelemetryWidget(this, uContextId);
+}
+
+KviTelemetryWindow::~KviTelemetryWindow()
+{
+	g_pTelemetryWindowList.erase(this);
+}
+
+QPixmap * KviTelemetryWindow::myIconPtr()
+{
+	return g_pIconManager->getSmallIcon(KviIconManager::SysMonitor);
+}
+
+void KviTelemetryWindow::resizeEvent(QResizeEvent *)
+{
+	m_pWidget->setGeometry(0, 0, width(), height());
+}
+
+void KviTelemetryWindow::fillCaptionBuffers()
+{
+	m_szPlainTextCaption = QString(__tr2qs("Connection Telemetry [IRC Context %1]")).arg(m_uContextId);
+}
+
+KviTelemetryWidget::KviTelemetryWidget(QWidget * par, unsigned int uContextId)
+    : QWidget(par), m_uContextId(uContextId)
+{
+	startTimer(1000);
+}
+
+void KviTelemetryWidget::timerEvent(QTimerEvent *)
+{
+	update();
+}
+
+void KviTelemetryWidget::paintHistogram(QPainter & p, const QRect & r, const QString & szTitle, const QString & szUnit, KviHistogram & h)
+{
+	p.setPen(QColor("#c0c0c0"));
+	p.setBrush(Qt::NoBrush);
+	p.drawRect(r.adjusted(0, 0, -1, -1));
+
+	int iLineHeight = p.fontMetrics().height();
+	QString szText = QString("%1: n=%2").arg(szTitle).arg(h.count());
+	p.setPen(palette().color(QPalette::WindowText));
+	p.drawText(r.left() + 4, r.top() + iLineHeight, szText);
+	szText = QString("p50 %1%5  p90 %2%5  p99 %3%5  max %4%5")
+	             .arg(h.percentile(50.0))
+	             .arg(h.percentile(90.0))
+	             .arg(h.percentile(99.0))
+	             .arg(h.max())
+	             .arg(szUnit);
+	p.drawText(r.left() + 4, r.top() + 2 * iLineHeight, szText);
+
+	std::vector<KviHistogram::Bucket> lBuckets;
+	h.buckets(lBuckets);
+	if(lBuckets.empty())
+		return;
+
+	QRect rBars(r.left() + 4, r.top() + 2 * iLineHeight + 6, r.width() - 8, r.height() - 3 * iLineHeight - 12);
+	if((rBars.width() < 4) || (rBars.height() < 4))
+		return;
+
+	kvi_u64_t uMaxCount = 1;
+	for(auto & b : lBuckets)
+		uMaxCount = qMax(uMaxCount, b.uCount);
+
+	double dBarWidth = (double)rBars.width() / lBuckets.size();
+	p.setPen(QColor(0, 0, 255));
+	p.setBrush(QColor(0, 0, 255, 128));
+	for(unsigned int i = 0; i < lBuckets.size(); i++)
+	{
+		int iHeight = (int)(((double)rBars.height() * lBuckets[i].uCount) / uMaxCount);
+		if(iHeight < 1)
+			iHeight = 1;
+		QRectF bar(rBars.left() + i * dBarWidth, rBars.bottom() - iHeight, qMax(dBarWidth - 1.0, 1.0), iHeight);
+		p.drawRect(bar);
+	}
+
+	p.setPen(palette().color(QPalette::WindowText));
+	p.drawText(rBars.left(), r.bottom() - 4, QString("%1%2").arg(lBuckets.front().uLow).arg(szUnit));
+	QString szHigh = QString("%1%2").arg(lBuckets.back().uHigh).arg(szUnit);
+	p.drawText(rBars.right() - p.fontMetrics().width(szHigh), r.bottom() - 4, szHigh);
+}
+
+void KviTelemetryWidget::paintEvent(QPaintEvent *)
+{
+	QPainter p(this);
+
+	KviConsoleWindow * pConsole = g_pApp->findConsole(m_uContextId);
+	KviIrcConnection * pConnection = pConsole ? pConsole->context()->connection() : nullptr;
+	if(!pConnection)
+	{
+		p.drawText(rect(), Qt::AlignCenter, __tr2qs("Not connected"));
+		return;
+	}
+
+	if(!KVI_OPTION_BOOL(KviOption_boolEnableConnectionTelemetry))
+		p.drawText(rect(), Qt::AlignTop | Qt::AlignHCenter, __tr2qs("The telemetry is disabled (option boolEnableConnectionTelemetry)"));
+
+	KviIrcConnectionStatistics * pStats = pConnection->statistics();
+	int iTop = p.fontMetrics().height() + 4;
+	int iW = width() / 2;
+	int iH = (height() - iTop) / 2;
+	paintHistogram(p, QRect(0, iTop, iW, iH), __tr2qs("Socket read size"), "B", pStats->readSize());
+	paintHistogram(p, QRect(iW, iTop, width() - iW, iH), __tr2qs("Parse and dispatch"), "us", pStats->dispatchLatency());
+	paintHistogram(p, QRect(0, iTop + iH, iW, height() - iTop - iH), __tr2qs("Send queue wait"), "us", pStats->sendQueueWait());
+	paintHistogram(p, QRect(iW, iTop + iH, width() - iW, height() - iTop - iH), __tr2qs("Lag"), "ms", pStats->lag());
+}
+
 /*
 	@doc: iograph.open
 	@type:
@@ -284,11 +405,52 @@ static bool iograph_module_cmd_open(KviKvsModuleCommandCall * c)
 	return true;
 }
 
+/*
+	@doc: iograph.telemetry
+	@type:
+		command
+	@title:
+		iograph.telemetry
+	@short:
+		Opens the telemetry window of the current IRC context
+	@syntax:
+		iograph.telemetry
+	@description:
+		Opens a window with the telemetry histograms of the connection in the
+		current IRC context: the socket read sizes, the time spent parsing and
+		dispatching the server messages, the time spent by the outgoing messages
+		in the send queue and the lag. The window is refreshed every second.[br]
+		The telemetry is collected only when the boolEnableConnectionTelemetry
+		option is set.
+	@seealso:
+		[fnc]$context.telemetry[/fnc]
+*/
+
+static bool iograph_module_cmd_telemetry(KviKvsModuleCommandCall * c)
+{
+	if(!c->window()->console())
+		return c->context()->errorNoIrcContext();
+
+	unsigned int uContextId = c->window()->console()->context()->id();
+	for(auto & w : g_pTelemetryWindowList)
+	{
+		if(w->contextId() == uContextId)
+		{
+			w->delayedAutoRaise();
+			return true;
+		}
+	}
+
+	g_pMainWindow->addWindow(new KviTelemetryWindow(uContextId));
+	return true;
+}
+
 static bool iograph_module_init(KviModule * m)
 {
 	g_pIOGraphWindow = nullptr;
 
 	KVSM_REGISTER_SIMPLE_COMMAND(m, "open", iograph_module_cmd_open);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "telemetry", iograph_module_cmd_telemetry);
 	return true;
 }
 
@@ -297,12 +459,18 @@ static bool iograph_module_cleanup(KviModule *)
 	if(g_pIOGraphWindow && g_pMainWindow)
 		g_pMainWindow->closeWindow(g_pIOGraphWindow);
 	g_pIOGraphWindow = nullptr;
+	if(g_pMainWindow)
+	{
+		std::vector<KviTelemetryWindow *> lWindows(g_pTelemetryWindowList.begin(), g_pTelemetryWindowList.end());
+		for(auto & w : lWindows)
+			g_pMainWindow->closeWindow(w);
+	}
 	return true;
 }
 
 static bool iograph_module_can_unload(KviModule *)
 {
-	return (!g_pIOGraphWindow);
+	return (!g_pIOGraphWindow) && g_pTelemetryWindowList.empty();
 }
 
 KVIRC_MODULE(
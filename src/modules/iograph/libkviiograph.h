@@ -31,6 +31,10 @@
 
 #include <QQueue>
 
+#include <unordered_set>
+
+class KviHistogram;
+
 #define KVI_IOGRAPH_NUMBER_POINTS 60
 #define KVI_IOGRAPH_HORIZ_SEGMENTS 10
 #define KVI_IOGRAPH_VERT_SEGMENTS 10
@@ -75,4 +79,42 @@ protected:
 	void paintEvent(QPaintEvent * e) override;
 };
 
+// Shows the telemetry histograms of an IRC connection
+// (see KviIrcConnectionStatistics)
+class KviTelemetryWidget : public QWidget
+{
+	Q_OBJECT
+public:
+	KviTelemetryWidget(QWidget * parent, unsigned int uContextId);
+	~KviTelemetryWidget(){};
+
+protected:
+	unsigned int m_uContextId;
+
+protected:
+	void timerEvent(QTimerEvent * e) override;
+	void paintEvent(QPaintEvent * e) override;
+	void paintHistogram(QPainter & p, const QRect & r, const QString & szTitle, const QString & szUnit, KviHistogram & h);
+};
+
+class KviTelemetryWindow : public KviWindow
+{
+	Q_OBJECT
+public:
+	KviTelemetryWindow(unsigned int uContextId);
+	~KviTelemetryWindow();
+
+private:
+	KviTelemetryWidget * m_pWidget;
+	unsigned int m_uContextId;
+
+public:
+	unsigned int contextId() const { return m_uContextId; }
+
+protected:
+	QPixmap * myIconPtr() override;
+	void fillCaptionBuffers() override;
+	void resizeEvent(QResizeEvent * e) override;
+};
+
 #endif
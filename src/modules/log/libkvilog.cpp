@@ -27,7 +27,9 @@
 
 #include "KviWindow.h"
 #include "KviLocale.h"
+#include "KviLogWriter.h"
 #include "KviIrcView.h"
+#include "KviKvsHash.h"
 #include "KviModule.h"
 #include "KviModuleManager.h"
 
@@ -189,10 +191,12 @@ static bool log_kvs_cmd_stop(KviKvsModuleCommandCall * c)
 	@description:
 		Flushes the log file the current window or in the window specified by the -w switch.[br]
 		If logging is not enabled in the specified window, this command does nothing.[br]
-		If this command is never used, the log file is flushed at regular file-size intervals,
-		depending on the underlying I/O subsystem. This is usually 4KiB.[br]
-		The [i]block flushing[/i] is used to achieve a fast I/O on files, but may cause
-		the last data block to be lost in case of a program crash.[br]
+		The log lines are written by a background thread as soon as possible:
+		this command (and the periodic automatic flush) ends the current compressed
+		frame if the boolGzipLogs option is set and, depending on the uintLogSyncPolicy option,
+		forces the data to be physically stored on disk.[br]
+		The compressed logs are always readable by gunzip, even while they're being written.[br]
+		Lines that are still queued for the writer may be lost in case of a program crash.[br]
 	@seealso:
 		[fnc]$window[/fnc],
 		[cmd]log.start[/cmd],
@@ -337,6 +341,71 @@ static bool log_kvs_fnc_export(KviKvsModuleFunctionCall * c)
 	return true;
 }
 
+/*
+	@doc: log.writerStats
+	@type:
+		function
+	@title:
+		$log.writerStats
+	@short:
+		Returns the statistics of the log writer
+	@syntax:
+		<hash> $log.writerStats
+	@description:
+		The log files are written by a background thread that collects
+		the lines of all the windows and writes them in batches.
+		This function returns its statistics as a hash with the following keys:[br]
+		[i]records[/i]: the number of lines written,[br]
+		[i]bytes[/i]: the number of bytes written,[br]
+		[i]batches[/i]: the number of batches processed,[br]
+		[i]writes[/i]: the number of write system calls,[br]
+		[i]syncs[/i]: the number of times the data has been forced to disk,[br]
+		[i]maxbatch[/i]: the largest batch, in lines,[br]
+		[i]maxqueued[/i]: the largest amount of data waiting for the writer, in bytes,[br]
+		[i]stalls[/i]: the number of times a window had to wait for the writer to catch up,[br]
+		[i]stalltime[/i]: the total waiting time, in microseconds,[br]
+		[i]dropped[/i]: the number of lines dropped because the writer could not keep up,[br]
+		[i]droppedbytes[/i]: the size of the dropped lines,[br]
+		[i]errors[/i]: the number of failed writes,[br]
+		[i]files[/i]: the number of log files currently open.
+	@examples:
+		[example]
+		%s = $log.writerStats
+		[cmd]echo[/cmd] %s{"records"} lines in %s{"writes"} writes
+		[/example]
+	@seealso:
+		[cmd]log.flush[/cmd]
+*/
+static bool log_kvs_fnc_writerStats(KviKvsModuleFunctionCall * c)
+{
+	if(!KviLogWriter::instance())
+	{
+		c->returnValue()->setNothing();
+		return true;
+	}
+
+	KviLogWriter::Statistics s;
+	KviLogWriter::instance()->statistics(s);
+
+	KviKvsHash * pHash = new KviKvsHash();
+	pHash->set("records", new KviKvsVariant((kvs_int_t)s.uRecords));
+	pHash->set("bytes", new KviKvsVariant((kvs_int_t)s.uBytes));
+	pHash->set("batches", new KviKvsVariant((kvs_int_t)s.uBatches));
+	pHash->set("writes", new KviKvsVariant((kvs_int_t)s.uWriteCalls));
+	pHash->set("syncs", new KviKvsVariant((kvs_int_t)s.uSyncs));
+	pHash->set("maxbatch", new KviKvsVariant((kvs_int_t)s.uMaxBatchRecords));
+	pHash->set("maxqueued", new KviKvsVariant((kvs_int_t)s.uMaxQueuedBytes));
+	pHash->set("stalls", new KviKvsVariant((kvs_int_t)s.uStalls));
+	pHash->set("stalltime", new KviKvsVariant((kvs_int_t)s.uStallTime));
+	pHash->set("dropped", new KviKvsVariant((kvs_int_t)s.uDroppedRecords));
+	pHash->set("droppedbytes", new KviKvsVariant((kvs_int_t)s.uDroppedBytes));
+	pHash->set("errors", new KviKvsVariant((kvs_int_t)s.uWriteErrors));
+	pHash->set("files", new KviKvsVariant((kvs_int_t)s.uOpenFiles));
+
+	c->returnValue()->setHash(pHash);
+	return true;
+}
+
 static bool log_module_init(KviModule * m)
 {
 	KVSM_REGISTER_SIMPLE_COMMAND(m, "start", log_kvs_cmd_start);
@@ -345,6 +414,7 @@ static bool log_module_init(KviModule * m)
 
 	KVSM_REGISTER_FUNCTION(m, "file", log_kvs_fnc_file);
 	KVSM_REGISTER_FUNCTION(m, "export", log_kvs_fnc_export);
+	KVSM_REGISTER_FUNCTION(m, "writerStats", log_kvs_fnc_writerStats);
 	return true;
 }
 
@@ -28,13 +28,11 @@
 #include "KviCString.h"
 #include "KviOptions.h"
 #include "KviFileUtils.h"
+#include "KviLogFrames.h"
 
+#include <QDateTime>
 #include <QFileInfo>
 
-#ifdef COMPILE_ZLIB_SUPPORT
-#include <zlib.h>
-#endif
-
 LogFile::LogFile(const QString & szName)
 {
 	m_szFilename = szName;
@@ -143,28 +141,70 @@ LogFile::LogFile(const QString & szName)
 	}
 }
 
+static QDate log_line_date(const QString & szLine)
+{
+	// the optional message type, then the ISO date if the log has it
+	int i = 0;
+	while((i < szLine.length()) && szLine.at(i).isDigit())
+		i++;
+	int iStart = ((i > 0) && (i < szLine.length()) && (szLine.at(i) == QChar(' '))) ? i + 1 : 0;
+	if((szLine.length() - iStart) < 10)
+		return QDate();
+	return QDate::fromString(szLine.mid(iStart, 10), Qt::ISODate);
+}
+
+static void trim_log_to_dates(QString & szText, const QDate & fromDate, const QDate & toDate)
+{
+	// Keeps the lines written in [fromDate,toDate]. Only the lines with an
+	// ISO date tell their day: the others (multi line messages, the logs
+	// written with the time only) share the day of the last dated line.
+	QString szOut;
+	szOut.reserve(szText.length());
+	bool bKeep = true;
+	int iPos = 0;
+	while(iPos < szText.length())
+	{
+		int iEnd = szText.indexOf(QChar('\n'), iPos);
+		iEnd = (iEnd < 0) ? szText.length() : iEnd + 1;
+		QDate date = log_line_date(szText.mid(iPos, qMin(24, iEnd - iPos)));
+		if(date.isValid())
+			bKeep = !((fromDate.isValid() && (date < fromDate)) || (toDate.isValid() && (date > toDate)));
+		if(bKeep)
+			szOut.append(szText.midRef(iPos, iEnd - iPos));
+		iPos = iEnd;
+	}
+	szText = szOut;
+}
+
 void LogFile::getText(QString & szText)
+{
+	getText(szText, QDate(), QDate());
+}
+
+void LogFile::getText(QString & szText, const QDate & fromDate, const QDate & toDate)
 {
 	QString szLogName = fileName();
 	QFile logFile;
 #ifdef COMPILE_ZLIB_SUPPORT
 	if(m_bCompressed)
 	{
-		gzFile file = gzopen(szLogName.toLocal8Bit().data(), "rb");
-		if(file)
+		// handles both the framed logs and the plain gzip ones
+		KviLogFrameReader reader(szLogName);
+		if(reader.open())
 		{
-			char cBuff[1025];
-			int iLen;
 			QByteArray data;
-			//QCString data;
-			iLen = gzread(file, cBuff, 1024);
-			while(iLen > 0)
+			if(reader.isIndexed() && (fromDate.isValid() || toDate.isValid()))
+			{
+				// inflate only the frames that cover the requested days
+				kvi_u32_t uFrom = fromDate.isValid() ? (kvi_u32_t)QDateTime(fromDate).toTime_t() : 0;
+				kvi_u32_t uTo = toDate.isValid() ? (kvi_u32_t)QDateTime(toDate.addDays(1)).toTime_t() - 1 : 0xffffffff;
+				reader.readRange(data, uFrom, uTo);
+			}
+			else
 			{
-				cBuff[iLen] = 0;
-				data.append(cBuff);
-				iLen = gzread(file, cBuff, 1024);
+				// unindexed legacy gzip file
+				reader.readAll(data);
 			}
-			gzclose(file);
 			szText = QString::fromUtf8(data);
 		}
 		else
@@ -187,4 +227,8 @@ void LogFile::getText(QString & szText)
 #ifdef COMPILE_ZLIB_SUPPORT
 	}
 #endif
+
+	// the frames hold whole blocks of lines and the other logs are read as a whole
+	if(fromDate.isValid() || toDate.isValid())
+		trim_log_to_dates(szText, fromDate, toDate);
 }
@@ -144,6 +144,19 @@ public:
 	* \return void
 	*/
 	void getText(QString & szText);
+
+	/**
+	* \brief Returns the text of the log file written between two dates
+	*
+	* The indexed compressed logs are read only in the frames that cover the
+	* range, the other logs are read as a whole. The text is then cut down to
+	* the lines of the range, as far as the dates written in the lines tell.
+	* \param szText The buffer where to save the contents of the log
+	* \param fromDate The first day of the range, unbounded if invalid
+	* \param toDate The last day of the range, unbounded if invalid
+	* \return void
+	*/
+	void getText(QString & szText, const QDate & fromDate, const QDate & toDate);
 };
 
 #endif // _LOGFILE_H_
@@ -292,6 +292,14 @@ void LogViewWindow::setupItemList()
 	m_pTimer->start(); //singleshot
 }
 
+void LogViewWindow::getFilteredText(LogFile * pFile, QString & szText)
+{
+	// the date filter also bounds the part of the log that gets read
+	pFile->getText(szText,
+	    m_pEnableFromFilter->isChecked() ? m_pFromDateEdit->date() : QDate(),
+	    m_pEnableToFilter->isChecked() ? m_pToDateEdit->date() : QDate());
+}
+
 void LogViewWindow::applyFilter()
 {
 	setupItemList();
@@ -335,7 +343,7 @@ void LogViewWindow::filterNext()
 	if(!m_pContentsMask->text().isEmpty())
 	{
 		QString szBuffer;
-		pFile->getText(szBuffer);
+		getFilteredText(pFile, szBuffer);
 		if(!KviQString::matchString(m_pContentsMask->text(), szBuffer))
 			goto filter_next;
 	}
@@ -423,7 +431,7 @@ void LogViewWindow::itemSelected(QTreeWidgetItem * it, QTreeWidgetItem *)
 		return;
 
 	QString szText;
-	((LogListViewItem *)it)->m_pFileData->getText(szText);
+	getFilteredText(((LogListViewItem *)it)->m_pFileData, szText);
 
 	QStringList lines = szText.split('\n');
 	bool bOk;
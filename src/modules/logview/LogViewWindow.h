@@ -118,6 +118,7 @@ protected:
 	void exportLog(int iId);
 	void recurseDirectory(const QString & szDir);
 	void setupItemList();
+	void getFilteredText(LogFile * pFile, QString & szText);
 
 	QPixmap * myIconPtr() override;
 	void resizeEvent(QResizeEvent * pEvent) override;
@@ -185,7 +185,12 @@ OptionsWidget_connectionSocket::OptionsWidget_connectionSocket(QWidget * parent)
 	b = addBoolSelector(0, 5, 0, 5, __tr2qs_ctx("Drop connection on SASL authentication failure", "options"), KviOption_boolDropConnectionOnSaslFailure);
 	mergeTip(b, __tr2qs_ctx("This option will close the socket if no SASL authentication or any SASL fallback had succeeded.", "options"));
 
-	addRowSpacer(0, 6, 0, 6);
+	b = addBoolSelector(0, 6, 0, 6, __tr2qs_ctx("Collect connection telemetry", "options"), KviOption_boolEnableConnectionTelemetry);
+	mergeTip(b, __tr2qs_ctx("This option makes KVIrc collect histograms of the socket reads, of the time spent "
+	                        "handling the server messages, of the send queue wait and of the lag. "
+	                        "They can be seen with /iograph.telemetry or queried with $context.telemetry.", "options"));
+
+	addRowSpacer(0, 7, 0, 7);
 }
 
 OptionsWidget_connectionSocket::~OptionsWidget_connectionSocket()
@@ -88,7 +88,16 @@ OptionsWidget_ircOutput::OptionsWidget_ircOutput(QWidget * pParent)
 
 	addBoolSelector(0, 6, 1, 6, __tr2qs_ctx("Show compact mode changes", "options"), KviOption_boolShowCompactModeChanges);
 
-	addRowSpacer(0, 7, 1, 7);
+	b = addBoolSelector(0, 7, 1, 7, __tr2qs_ctx("Coalesce netsplit quits and joins", "options"), KviOption_boolCoalesceNetsplits);
+	mergeTip(b, __tr2qs_ctx("When enabled, the quit and join messages of a netsplit and of the following netjoin "
+	                        "are collected for a moment and shown as one line per channel.", "options"));
+
+	KviBoolSelector * c = addBoolSelector(0, 8, 1, 8, __tr2qs_ctx("Trigger per-user events for coalesced netsplits", "options"), KviOption_boolNetsplitPerUserEvents, KVI_OPTION_BOOL(KviOption_boolCoalesceNetsplits));
+	mergeTip(c, __tr2qs_ctx("When enabled, OnQuit and OnJoin are triggered for each user of a coalesced netsplit or netjoin.<br>"
+	                        "This can be slow on large networks.", "options"));
+	connect(b, SIGNAL(toggled(bool)), c, SLOT(setEnabled(bool)));
+
+	addRowSpacer(0, 9, 1, 9);
 }
 
 OptionsWidget_ircOutput::~OptionsWidget_ircOutput()
@@ -145,13 +145,17 @@ OptionsWidget_ircViewFeatures::OptionsWidget_ircViewFeatures(QWidget * parent)
 	addBoolSelector(0, 8, 0, 8, __tr2qs_ctx("Use line wrap margin", "options"), KviOption_boolIrcViewWrapMargin);
 	KviUIntSelector * s = addUIntSelector(0, 9, 0, 9, __tr2qs_ctx("Maximum buffer size:", "options"), KviOption_uintIrcViewMaxBufferSize, 32, 32767, 2048);
 	s->setSuffix(__tr2qs_ctx(" lines", "options"));
-	s = addUIntSelector(0, 10, 0, 10, __tr2qs_ctx("Link tooltip show delay:", "options"), KviOption_uintIrcViewToolTipTimeoutInMsec, 256, 10000, 1800);
+	s = addUIntSelector(0, 10, 0, 10, __tr2qs_ctx("Scrollback kept on disk:", "options"), KviOption_uintIrcViewMaxSpilledLines, 0, 1000000, 0);
+	s->setSuffix(__tr2qs_ctx(" lines", "options"));
+	mergeTip(s, __tr2qs_ctx("The lines dropped from a full buffer are moved to a temporary file "
+	                        "and loaded back when you scroll up or search. 0 disables this.", "options"));
+	s = addUIntSelector(0, 11, 0, 11, __tr2qs_ctx("Link tooltip show delay:", "options"), KviOption_uintIrcViewToolTipTimeoutInMsec, 256, 10000, 1800);
 	s->setSuffix(__tr2qs_ctx(" msec", "options"));
-	s = addUIntSelector(0, 11, 0, 11, __tr2qs_ctx("Link tooltip hide delay:", "options"), KviOption_uintIrcViewToolTipHideTimeoutInMsec, 256, 10000, 12000);
+	s = addUIntSelector(0, 12, 0, 12, __tr2qs_ctx("Link tooltip hide delay:", "options"), KviOption_uintIrcViewToolTipHideTimeoutInMsec, 256, 10000, 12000);
 	s->setSuffix(__tr2qs_ctx(" msec", "options"));
-	addBoolSelector(0, 12, 0, 12, __tr2qs_ctx("Enable animated smiles", "options"), KviOption_boolEnableAnimatedSmiles);
+	addBoolSelector(0, 13, 0, 13, __tr2qs_ctx("Enable animated smiles", "options"), KviOption_boolEnableAnimatedSmiles);
 
-	KviTalGroupBox * pGroup = addGroupBox(0, 13, 0, 13, Qt::Horizontal, __tr2qs_ctx("Enable Tooltips for", "options"));
+	KviTalGroupBox * pGroup = addGroupBox(0, 14, 0, 14, Qt::Horizontal, __tr2qs_ctx("Enable Tooltips for", "options"));
 	addBoolSelector(pGroup, __tr2qs_ctx("URL links", "options"), KviOption_boolEnableUrlLinkToolTip);
 	addBoolSelector(pGroup, __tr2qs_ctx("Host links", "options"), KviOption_boolEnableHostLinkToolTip);
 	addBoolSelector(pGroup, __tr2qs_ctx("Server links", "options"), KviOption_boolEnableServerLinkToolTip);
@@ -160,7 +164,7 @@ OptionsWidget_ircViewFeatures::OptionsWidget_ircViewFeatures(QWidget * parent)
 	addBoolSelector(pGroup, __tr2qs_ctx("Channel links", "options"), KviOption_boolEnableChannelLinkToolTip);
 	addBoolSelector(pGroup, __tr2qs_ctx("Escape sequences", "options"), KviOption_boolEnableEscapeLinkToolTip);
 
-	addRowSpacer(0, 14, 0, 14);
+	addRowSpacer(0, 15, 0, 15);
 }
 
 OptionsWidget_ircViewFeatures::~OptionsWidget_ircViewFeatures()
@@ -26,7 +26,10 @@
 
 #include "KviOptions.h"
 #include "KviLocale.h"
+#include "KviTalHBox.h"
 
+#include <QComboBox>
+#include <QLabel>
 #include <QLayout>
 
 OptionsWidget_logging::OptionsWidget_logging(QWidget * parent)
@@ -63,8 +66,33 @@ OptionsWidget_logging::OptionsWidget_logging(QWidget * parent)
 	addBoolSelector(0, 6, 0, 6, __tr2qs_ctx("Compress logs", "options"), KviOption_boolGzipLogs);
 #endif
 
-	addRowSpacer(0, 7, 0, 7);
+	KviTalHBox * hb = new KviTalHBox(this);
+	addWidgetToLayout(hb, 0, 7, 0, 7);
+	new QLabel(__tr2qs_ctx("Force logs to disk:", "options"), hb);
+	m_pSyncPolicyCombo = new QComboBox(hb);
+	m_pSyncPolicyCombo->addItem(__tr2qs_ctx("Never (let the system decide)", "options"));
+	m_pSyncPolicyCombo->addItem(__tr2qs_ctx("When flushed and closed", "options"));
+	m_pSyncPolicyCombo->addItem(__tr2qs_ctx("After every write", "options"));
+	if(KVI_OPTION_UINT(KviOption_uintLogSyncPolicy) > 2)
+		KVI_OPTION_UINT(KviOption_uintLogSyncPolicy) = 0;
+	m_pSyncPolicyCombo->setCurrentIndex(KVI_OPTION_UINT(KviOption_uintLogSyncPolicy));
+	hb->setStretchFactor(m_pSyncPolicyCombo, 1);
+
+	mergeTip(m_pSyncPolicyCombo, __tr2qs_ctx("Waiting for the data to be physically written protects "
+	                                         "the last lines from system crashes and power failures, "
+	                                         "at the cost of more disk activity.<br>"
+	                                         "The logs are always written by a background thread.", "options"));
+	mergeResetFlag(KviOption_resetUpdateLogWriter);
+
+	addRowSpacer(0, 8, 0, 8);
 }
 
 OptionsWidget_logging::~OptionsWidget_logging()
     = default;
+
+void OptionsWidget_logging::commit()
+{
+	KVI_OPTION_UINT(KviOption_uintLogSyncPolicy) = m_pSyncPolicyCombo->currentIndex();
+
+	KviOptionsWidget::commit();
+}
@@ -26,6 +26,8 @@
 
 #include "KviOptionsWidget.h"
 
+class QComboBox;
+
 #define KVI_OPTIONS_WIDGET_ICON_OptionsWidget_logging KviIconManager::Log
 #define KVI_OPTIONS_WIDGET_NAME_OptionsWidget_logging __tr2qs_no_lookup("Logging")
 #define KVI_OPTIONS_WIDGET_KEYWORDS_OptionsWidget_logging __tr2qs_no_lookup("save,output")
@@ -39,6 +41,12 @@ class OptionsWidget_logging : public KviOptionsWidget
 public:
 	OptionsWidget_logging(QWidget * parent);
 	~OptionsWidget_logging();
+
+protected:
+	QComboBox * m_pSyncPolicyCombo;
+
+public:
+	void commit() override;
 };
 
 #endif //_OPTW_LOGGING_H_
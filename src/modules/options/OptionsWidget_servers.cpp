@@ -1850,7 +1850,7 @@ void OptionsWidget_servers::customContextMenuRequested(const QPoint & pnt)
 
 	m_pContextPopup->addAction(*(g_pIconManager->getSmallIcon(KviIconManager::NewServer)), __tr2qs_ctx("&New Server", "options"), this, SLOT(newServer()));
 	m_pContextPopup->addAction(*(g_pIconManager->getSmallIcon(KviIconManager::ServerFavorite)),
-	    __tr2qs_ctx(bFavorite ? "Unfavorite Server" : "Favorite Server", "options"), this, SLOT(favoriteServer()));
+	    bFavorite ? __tr2qs_ctx("Unfavorite Server", "options") : __tr2qs_ctx("Favorite Server", "options"), this, SLOT(favoriteServer()));
 	m_pContextPopup->setEnabled(bServer);
 	m_pContextPopup->addAction(*(g_pIconManager->getSmallIcon(KviIconManager::Remove)), __tr2qs_ctx("Re&move Server", "options"), this, SLOT(removeCurrent()))
 	    ->setEnabled(bServer);
@@ -105,7 +105,7 @@ void addAlertLevels(KviOptionsWidget * widget, KviTalGroupBox * g)
 		QString alert_level_qstr = "Alert level " + QString::number(alert_level) + ":";
 		QByteArray alert_level_ba = alert_level_qstr.toUtf8();
 		const int highlight_enum = alert_levels[alert_level - 1];
-		KviColorSelector * sel = widget->addColorSelector(g, __tr2qs_ctx(alert_level_ba.constData(), "options"), highlight_enum);
+		KviColorSelector * sel = widget->addColorSelector(g, __tr2qs_ctx_no_xgettext(alert_level_ba.constData(), "options"), highlight_enum);
 
 		// Accumulate all message types for this alert level
 		std::vector<QString> alert_list;
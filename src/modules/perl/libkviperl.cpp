@@ -30,6 +30,7 @@
 #include "KviOptions.h"
 #include "KviModuleManager.h"
 #include "kvi_out.h"
+#include "KviKvsHash.h"
 
 #ifdef COMPILE_PERL_SUPPORT
 #include "../perlcore/perlcoreinterface.h"
@@ -378,6 +379,17 @@ static KviModule * g_pPerlCoreModule = nullptr;
 		the -n switch is used.[br]
 		The -q switch prevents from the command from printing any
 		warning.[br]
+		A code snippet is compiled once per context and kept as an
+		anonymous subroutine that is called at each execution:
+		the [i]my[/i] variables are fresh at each run and [i]return[/i]
+		ends the snippet.
+		Snippets that declare named subroutines, contain BEGIN, CHECK, INIT
+		or END blocks, [i]use[/i] or [i]no[/i] statements, __END__ or __DATA__
+		are instead evaluated from scratch at each execution, exactly like
+		older KVIrc versions did, since compiling them once would
+		change their meaning (the named subroutines would keep
+		the variables of the first run and the BEGIN and [i]use[/i]
+		side effects would happen only once).[br]
 		See the [doc:perl_and_kvs]Perl scripting documentation[/doc]
 		for more information.
 	@examples:
@@ -549,6 +561,56 @@ static bool perl_kvs_fnc_isAvailable(KviKvsModuleFunctionCall * c)
 	return true;
 }
 
+/*
+	@doc: perl.cacheStats
+	@type:
+		function
+	@title:
+		$perl.cacheStats
+	@short:
+		Returns the compiled code cache statistics of a Perl context
+	@syntax:
+		<hash> $perl.cacheStats(<context_name:string>)
+	@description:
+		Each persistent Perl context compiles every distinct [cmd]perl.begin[/cmd]
+		code block only once and reuses it on the following executions.[br]
+		This function returns a hash with the [i]subs[/i] (code blocks currently compiled),
+		[i]hits[/i] and [i]misses[/i] keys for the context <context_name>.
+		An empty hash is returned if the context does not exist.
+	@seealso:
+		[cmd]perl.begin[/cmd], [cmd]perl.destroy[/cmd]
+*/
+
+static bool perl_kvs_fnc_cacheStats(KviKvsModuleFunctionCall * c)
+{
+	QString szContext;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("context", KVS_PT_NONEMPTYSTRING, 0, szContext)
+	KVSM_PARAMETERS_END(c)
+
+	KviKvsHash * pHash = new KviKvsHash();
+	c->returnValue()->setHash(pHash);
+
+#ifdef COMPILE_PERL_SUPPORT
+	g_pPerlCoreModule = g_pModuleManager->getModule("perlcore");
+	if(!g_pPerlCoreModule)
+		return true;
+
+	KviPerlCoreCtrlCommand_stats st;
+	st.uSize = sizeof(KviPerlCoreCtrlCommand_stats);
+	st.szContext = szContext;
+
+	if(!g_pPerlCoreModule->ctrl(KVI_PERLCORECTRLCOMMAND_STATS, &st) || !st.bFound)
+		return true;
+
+	pHash->set("subs", new KviKvsVariant((kvs_int_t)st.uCachedSubs));
+	pHash->set("hits", new KviKvsVariant((kvs_int_t)st.uHits));
+	pHash->set("misses", new KviKvsVariant((kvs_int_t)st.uMisses));
+#endif // COMPILE_PERL_SUPPORT
+
+	return true;
+}
+
 static bool perl_module_init(KviModule * m)
 {
 	// register the command anyway
@@ -556,6 +618,7 @@ static bool perl_module_init(KviModule * m)
 	KVSM_REGISTER_SIMPLE_COMMAND(m, "destroy", perl_kvs_cmd_destroy);
 
 	KVSM_REGISTER_FUNCTION(m, "isAvailable", perl_kvs_fnc_isAvailable);
+	KVSM_REGISTER_FUNCTION(m, "cacheStats", perl_kvs_fnc_cacheStats);
 
 // FIXME: perl.isSupported()
 #ifdef COMPILE_PERL_SUPPORT
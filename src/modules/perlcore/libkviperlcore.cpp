@@ -34,6 +34,9 @@
 #include "KviPointerHashTable.h"
 
 #include <QByteArray>
+#include <QHash>
+#include <QRegularExpression>
+#include <QSet>
 
 #ifdef DEBUG
 #undef DEBUG
@@ -112,20 +115,39 @@ public:
 protected:
 	QString m_szContextName;
 	PerlInterpreter * m_pInterpreter;
+	// the code blocks compiled to anonymous subs (we own a reference to each CV)
+	QHash<QString, SV *> m_hCodeCache;
+	// the code blocks that must be evaluated as they are at each run (see isCacheable())
+	QSet<QString> m_hUncacheableCode;
+	kvi_u64_t m_uCacheHits;
+	kvi_u64_t m_uCacheMisses;
 
 public:
 	bool init(); // if this fails then well.. :D
 	void done();
 	bool execute(const QString & szCode, QStringList & args, QString & szRetVal, QString & szError, QStringList & lWarnings);
 	const QString & contextName() const { return m_szContextName; };
+	unsigned int cachedCodeCount() const { return m_hCodeCache.count(); };
+	kvi_u64_t cacheHits() const { return m_uCacheHits; };
+	kvi_u64_t cacheMisses() const { return m_uCacheMisses; };
 protected:
 	QString svToQString(SV * sv);
+	bool lastError(QString & szError);
+	SV * compile(const QString & szCode, QString & szError);
+	bool isCacheable(const QString & szCode);
+	bool executeEval(const QString & szCode, QStringList & args, QString & szRetVal, QString & szError, QStringList & lWarnings);
+	void clearCodeCache();
 };
 
+// the compiled subs kept by each interpreter
+#define KVI_PERL_MAX_CACHED_SUBS 128
+
 KviPerlInterpreter::KviPerlInterpreter(const QString & szContextName)
 {
 	m_szContextName = szContextName;
 	m_pInterpreter = nullptr;
+	m_uCacheHits = 0;
+	m_uCacheMisses = 0;
 }
 
 KviPerlInterpreter::~KviPerlInterpreter()
@@ -218,6 +240,7 @@ void KviPerlInterpreter::done()
 	if(!m_pInterpreter)
 		return;
 	PERL_SET_CONTEXT(m_pInterpreter);
+	clearCodeCache();
 	PL_perl_destruct_level = 1;
 	perl_destruct(m_pInterpreter);
 	perl_free(m_pInterpreter);
@@ -236,23 +259,91 @@ QString KviPerlInterpreter::svToQString(SV * sv)
 	return ret;
 }
 
-bool KviPerlInterpreter::execute(
+bool KviPerlInterpreter::lastError(QString & szError)
+{
+	SV * pErr = get_sv("@", false);
+	if(!pErr || !SvOK(pErr))
+		return false;
+	szError = svToQString(pErr);
+	return !szError.isEmpty();
+}
+
+void KviPerlInterpreter::clearCodeCache()
+{
+	for(auto pCode : m_hCodeCache)
+		SvREFCNT_dec(pCode);
+	m_hCodeCache.clear();
+	m_hUncacheableCode.clear();
+}
+
+// A block compiled once to an anonymous sub behaves differently from a block
+// evaluated at each run when it contains:
+// - named subs: they are compiled once and bind to the lexicals of the first run
+// - BEGIN (and friends) blocks, use and no: their side effects happen only once
+// - __END__ or __DATA__: they would cut away the end of the wrapping sub
+// Such blocks keep going through eval_pv(). The check is conservative:
+// a false positive (e.g. "use" in a string) costs only the speed.
+bool KviPerlInterpreter::isCacheable(const QString & szCode)
+{
+	static QRegularExpression rx(
+	    "(^|[^\\w$@%&:'])(sub\\s+[A-Za-z_]|BEGIN\\b|UNITCHECK\\b|CHECK\\s*\\{|INIT\\s*\\{|END\\s*\\{|use\\s|no\\s+[A-Za-z]|__END__|__DATA__)");
+
+	if(m_hUncacheableCode.contains(szCode))
+		return false;
+	if(!rx.match(szCode).hasMatch())
+		return true;
+
+	if(m_hUncacheableCode.count() >= KVI_PERL_MAX_CACHED_SUBS)
+		m_hUncacheableCode.clear();
+	m_hUncacheableCode.insert(szCode);
+	return false;
+}
+
+// the context must be already set
+SV * KviPerlInterpreter::compile(const QString & szCode, QString & szError)
+{
+	QHash<QString, SV *>::iterator it = m_hCodeCache.find(szCode);
+	if(it != m_hCodeCache.end())
+	{
+		m_uCacheHits++;
+		return it.value();
+	}
+
+	m_uCacheMisses++;
+
+	// Wrap the block in an anonymous sub: @_ becomes its argument list
+	// and the value of the last statement (or a return) is its return value.
+	// The #line directive keeps the line numbers of the warnings right.
+	QString szSub = "sub {\n#line 1\n";
+	szSub += szCode;
+	szSub += "\n}";
+
+	SV * pSub = eval_pv(szSub.toUtf8().data(), false);
+	if(lastError(szError))
+		return nullptr;
+	if(!pSub || !SvROK(pSub) || (SvTYPE(SvRV(pSub)) != SVt_PVCV))
+	{
+		szError = __tr2qs_ctx("Internal error: the Perl code did not compile to a subroutine", "perl");
+		return nullptr;
+	}
+
+	if(m_hCodeCache.count() >= KVI_PERL_MAX_CACHED_SUBS)
+		clearCodeCache();
+
+	// the value returned by eval_pv() is temporary: keep our own reference
+	SV * pCode = newSVsv(pSub);
+	m_hCodeCache.insert(szCode, pCode);
+	return pCode;
+}
+
+bool KviPerlInterpreter::executeEval(
     const QString & szCode,
     QStringList & args,
     QString & szRetVal,
     QString & szError,
     QStringList & lWarnings)
 {
-	if(!m_pInterpreter)
-	{
-		szError = __tr2qs_ctx("Internal error: Perl interpreter not initialized", "perl");
-		return false;
-	}
-
-	g_lWarningList.clear();
-
 	QByteArray szUtf8 = szCode.toUtf8();
-	PERL_SET_CONTEXT(m_pInterpreter);
 
 	// clear the _ array
 	AV * pArgs = get_av("_", 1);
@@ -268,10 +359,10 @@ bool KviPerlInterpreter::execute(
 		// set the args in the _ arry
 		av_unshift(pArgs, (I32)args.count());
 		int idx = 0;
-		for(auto tmp : args)
+		for(auto & tmp : args)
 		{
 			QByteArray szVal = tmp.toUtf8();
-			pArg = newSVpv(szVal.data(), tmp.length());
+			pArg = newSVpvn(szVal.data(), szVal.length());
 			if(!av_store(pArgs, idx, pArg))
 				SvREFCNT_dec(pArg);
 			idx++;
@@ -302,17 +393,78 @@ bool KviPerlInterpreter::execute(
 		lWarnings = g_lWarningList;
 
 	// and the eventual error string
-	pRet = get_sv("@", false);
-	if(pRet)
+	if(lastError(szError))
+		return false;
+
+	return true;
+}
+
+bool KviPerlInterpreter::execute(
+    const QString & szCode,
+    QStringList & args,
+    QString & szRetVal,
+    QString & szError,
+    QStringList & lWarnings)
+{
+	if(!m_pInterpreter)
 	{
-		if(SvOK(pRet))
-		{
-			szError = svToQString(pRet);
-			if(!szError.isEmpty())
-				return false;
-		}
+		szError = __tr2qs_ctx("Internal error: Perl interpreter not initialized", "perl");
+		return false;
+	}
+
+	g_lWarningList.clear();
+
+	PERL_SET_CONTEXT(m_pInterpreter);
+
+	if(!isCacheable(szCode))
+		return executeEval(szCode, args, szRetVal, szError, lWarnings);
+
+	SV * pCode = compile(szCode, szError);
+	if(!pCode)
+	{
+		if(!g_lWarningList.isEmpty())
+			lWarnings = g_lWarningList;
+		if(szError.isEmpty())
+			szError = __tr2qs_ctx("Internal error: Perl interpreter not initialized", "perl");
+		return false;
 	}
 
+	// call the sub with the args on the stack
+	dSP;
+	ENTER;
+	SAVETMPS;
+
+	PUSHMARK(SP);
+	for(auto & tmp : args)
+	{
+		QByteArray szVal = tmp.toUtf8();
+		XPUSHs(sv_2mortal(newSVpvn(szVal.data(), szVal.length())));
+	}
+	PUTBACK;
+
+	int iCount = call_sv(pCode, G_SCALAR | G_EVAL);
+
+	SPAGAIN;
+
+	// get the ret value
+	if(iCount > 0)
+	{
+		SV * pRet = POPs;
+		if(pRet && SvOK(pRet))
+			szRetVal = svToQString(pRet);
+	}
+
+	PUTBACK;
+	FREETMPS;
+	LEAVE;
+
+	if(!g_lWarningList.isEmpty())
+		lWarnings = g_lWarningList;
+
+	// and the eventual error string
+	if(lastError(szError))
+		return false;
+
 	return true;
 }
 
@@ -343,6 +495,11 @@ static void perlcore_destroy_interpreter(const QString & szContextName)
 	delete i;
 }
 
+static KviPerlInterpreter * perlcore_find_interpreter(const QString & szContextName)
+{
+	return g_pInterpreters->find(szContextName);
+}
+
 static void perlcore_destroy_all_interpreters()
 {
 	KviPointerHashTableIterator<QString, KviPerlInterpreter> it(*g_pInterpreters);
@@ -396,6 +553,18 @@ static bool perlcore_module_ctrl(KviModule *, const char * cmd, void * param)
 		perlcore_destroy_interpreter(de->szContext);
 		return true;
 	}
+	if(kvi_strEqualCS(cmd, KVI_PERLCORECTRLCOMMAND_STATS))
+	{
+		KviPerlCoreCtrlCommand_stats * st = (KviPerlCoreCtrlCommand_stats *)param;
+		if(st->uSize != sizeof(KviPerlCoreCtrlCommand_stats))
+			return false;
+		KviPerlInterpreter * m = perlcore_find_interpreter(st->szContext);
+		st->bFound = (m != nullptr);
+		st->uCachedSubs = m ? m->cachedCodeCount() : 0;
+		st->uHits = m ? m->cacheHits() : 0;
+		st->uMisses = m ? m->cacheMisses() : 0;
+		return true;
+	}
 #endif // COMPILE_PERL_SUPPORT
 	return false;
 }
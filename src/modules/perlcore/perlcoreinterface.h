@@ -25,6 +25,7 @@
 //=============================================================================
 
 #include "kvi_settings.h"
+#include "kvi_inttypes.h"
 #include "KviQString.h"
 #include "KviKvsRunTimeContext.h"
 
@@ -54,4 +55,16 @@ struct KviPerlCoreCtrlCommand_destroy
 	QString szContext;
 };
 
+#define KVI_PERLCORECTRLCOMMAND_STATS "stats"
+
+struct KviPerlCoreCtrlCommand_stats
+{
+	unsigned int uSize;
+	QString szContext;
+	bool bFound;
+	unsigned int uCachedSubs;
+	kvi_u64_t uHits;
+	kvi_u64_t uMisses;
+};
+
 #endif // !_PERLCOREINTERFACE_H_
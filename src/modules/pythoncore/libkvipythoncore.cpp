@@ -65,11 +65,27 @@ struct KviPythonInterpreterDeleter
 	}
 };
 
+struct KviQStringHash
+{
+	std::size_t operator()(const QString & s) const
+	{
+		return static_cast<std::size_t>(qHash(s));
+	}
+};
+
+// compiled code objects kept by each interpreter
+#define KVI_PYTHON_MAX_CACHED_CODE_OBJECTS 128
+
 struct KviPythonInterpreter
 {
 	KviPythonInterpreter();
+	~KviPythonInterpreter();
 	bool execute(QString, QStringList &, QString &, QString &, QStringList &);
+	PyObject * compile(const QString & szCode);
+	void clearCodeCache();
 	std::unique_ptr<PyThreadState, KviPythonInterpreterDeleter> m_uptrThreadState;
+	// the source text -> the code object (owned reference)
+	std::unordered_map<QString, PyObject *, KviQStringHash> m_CodeCache;
 };
 
 struct KviCaseInsensitiveQStringHash
@@ -105,6 +121,53 @@ KviPythonInterpreter::KviPythonInterpreter()
 	PyRun_SimpleString(szPreCode.toUtf8().data());
 }
 
+KviPythonInterpreter::~KviPythonInterpreter()
+{
+	// the code objects belong to our interpreter
+	if(m_uptrThreadState && !m_CodeCache.empty())
+	{
+		KviPythonLock lock{ m_uptrThreadState.get() };
+		clearCodeCache();
+	}
+}
+
+void KviPythonInterpreter::clearCodeCache()
+{
+	for(auto & i : m_CodeCache)
+		Py_DECREF(i.second);
+	m_CodeCache.clear();
+}
+
+// must be called with the interpreter lock held: returns a borrowed reference
+PyObject * KviPythonInterpreter::compile(const QString & szCode)
+{
+	const auto i = m_CodeCache.find(szCode);
+	if(i != m_CodeCache.end())
+		return i->second;
+
+	// clean "cr" from the python code (ticket #1028)
+	QString szCleanCode = szCode;
+	szCleanCode.replace(QRegExp("\r\n?"), "\n");
+
+	PyObject * pCode = Py_CompileString(szCleanCode.toUtf8().data(), "<string>", Py_file_input);
+	if(!pCode)
+		return nullptr;
+
+	if(m_CodeCache.size() >= KVI_PYTHON_MAX_CACHED_CODE_OBJECTS)
+		clearCodeCache();
+	m_CodeCache.emplace(szCode, pCode);
+	return pCode;
+}
+
+static PyObject * pythoncore_string(const QString & szString)
+{
+#if PY_MAJOR_VERSION >= 3
+	return PyUnicode_FromString(szString.toUtf8().data());
+#else
+	return PyString_FromString(szString.toUtf8().data());
+#endif
+}
+
 bool KviPythonInterpreter::execute(QString szCode, QStringList & lArgs,
     QString & szRetVal, QString & szError, QStringList &)
 {
@@ -118,31 +181,57 @@ bool KviPythonInterpreter::execute(QString szCode, QStringList & lArgs,
 
 	KviPythonLock lock{ m_uptrThreadState.get() };
 
-	QString szVarCode = "aArgs = [";
-
-	bool bFirst = true;
-	foreach(QString szArg, lArgs)
+	PyObject * pMainModule = PyImport_AddModule("__main__"); // borrowed
+	if(!pMainModule)
 	{
-		if(!bFirst)
-			szVarCode += ",";
-		else
-			bFirst = false;
-
-		szVarCode += QString::fromLatin1("\"%1\"").arg(szArg);
+		PyErr_Clear();
+		szError = __tr2qs_ctx("Internal error: Python interpreter not initialized", "python");
+		return false;
 	}
+	PyObject * pGlobals = PyModule_GetDict(pMainModule); // borrowed
 
-	szVarCode += "]";
+	// pass the arguments as a real list: no quoting issues
+	PyObject * pArgs = PyList_New(lArgs.size());
+	if(pArgs)
+	{
+		for(int i = 0; i < lArgs.size(); i++)
+		{
+			PyObject * pArg = pythoncore_string(lArgs.at(i));
+			if(!pArg)
+			{
+				PyErr_Clear();
+				pArg = pythoncore_string(QString());
+			}
+			PyList_SET_ITEM(pArgs, i, pArg); // steals the reference
+		}
+		PyDict_SetItemString(pGlobals, "aArgs", pArgs);
+		Py_DECREF(pArgs);
+	}
 
-	PyRun_SimpleString(szVarCode.toUtf8().data());
+	int retVal = -1;
 
-	// clean "cr" from the python code (ticket #1028)
-	szCode.replace(QRegExp("\r\n?"), "\n");
+	PyObject * pCode = compile(szCode);
+	if(pCode)
+	{
+#if PY_MAJOR_VERSION >= 3
+		PyObject * pResult = PyEval_EvalCode(pCode, pGlobals, pGlobals);
+#else
+		PyObject * pResult = PyEval_EvalCode((PyCodeObject *)pCode, pGlobals, pGlobals);
+#endif
+		if(pResult)
+		{
+			retVal = 0;
+			Py_DECREF(pResult);
+		}
+	}
 
-	int retVal = PyRun_SimpleString(szCode.toUtf8().data());
+	// like PyRun_SimpleString(): the traceback goes to sys.stderr and thus to g_lError
+	if(retVal)
+		PyErr_Print();
 
 	szRetVal.setNum(retVal);
 
-	if(PyErr_Occurred() || retVal)
+	if(retVal)
 		szError = g_lError;
 
 	return !retVal;
@@ -0,0 +1,76 @@
+//=============================================================================
+//
+//   File : ReplayCapture.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include "ReplayCapture.h"
+
+#include <unordered_set>
+
+extern std::unordered_set<ReplayCapture *> g_pReplayCaptureList;
+
+ReplayCapture::ReplayCapture(KviIrcContext * pContext, const QString & szFileName)
+    : KviIrcDataStreamMonitor(pContext), m_file(szFileName), m_uLines(0)
+{
+	g_pReplayCaptureList.insert(this);
+
+	if(!m_file.open(QFile::WriteOnly | QFile::Truncate))
+		return;
+	m_file.write(REPLAY_CAPTURE_HEADER "\n");
+	m_clock.start();
+}
+
+ReplayCapture::~ReplayCapture()
+{
+	g_pReplayCaptureList.erase(this);
+	if(m_file.isOpen())
+		m_file.close();
+}
+
+bool ReplayCapture::incomingMessage(const char * pcMessage)
+{
+	if(!m_file.isOpen())
+		return false;
+
+	// QFile buffers the writes
+	m_file.write(QByteArray::number(m_clock.elapsed()));
+	m_file.write(" ", 1);
+	m_file.write(pcMessage);
+	m_file.write("\n", 1);
+	m_uLines++;
+	return false;
+}
+
+void ReplayCapture::connectionInitiated()
+{
+	if(m_file.isOpen())
+		m_file.write("# connection initiated\n");
+}
+
+void ReplayCapture::connectionTerminated()
+{
+	if(!m_file.isOpen())
+		return;
+	m_file.write("# connection terminated\n");
+	m_file.flush();
+}
@@ -0,0 +1,66 @@
+#ifndef _REPLAYCAPTURE_H_
+#define _REPLAYCAPTURE_H_
+//=============================================================================
+//
+//   File : ReplayCapture.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include "KviIrcDataStreamMonitor.h"
+#include "kvi_inttypes.h"
+#include "ReplayServer.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+
+//
+// Writes the raw server stream of an IRC context to a capture file
+// that can be replayed later by a ReplayServer (see ReplayServer.h
+// for the file format).
+//
+
+class ReplayCapture final : public KviIrcDataStreamMonitor
+{
+public:
+	ReplayCapture(KviIrcContext * pContext, const QString & szFileName);
+	~ReplayCapture();
+
+protected:
+	QFile m_file;
+	QElapsedTimer m_clock;
+	kvi_u64_t m_uLines;
+
+public:
+	// false if the file couldn't be created
+	bool isOpen() const { return m_file.isOpen(); }
+	QString fileName() const { return m_file.fileName(); }
+	KviIrcContext * context() const { return m_pMyContext; }
+	kvi_u64_t lines() const { return m_uLines; }
+
+	bool incomingMessage(const char * pcMessage) override;
+	bool outgoingMessage(const char *) override { return false; }
+	void connectionInitiated() override;
+	void connectionTerminated() override;
+};
+
+#endif //!_REPLAYCAPTURE_H_
@@ -0,0 +1,187 @@
+//=============================================================================
+//
+//   File : ReplayServer.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include "ReplayServer.h"
+
+#include <QFile>
+#include <QHostAddress>
+#include <QTcpSocket>
+
+// the amount of data kept in the socket buffer while playing at full speed
+#define REPLAY_MAX_PENDING_BYTES (256 * 1024)
+
+ReplaySession::ReplaySession(ReplayServer * pServer, QTcpSocket * pSocket)
+    : QObject(pServer), m_pServer(pServer), m_pSocket(pSocket), m_uNext(0), m_bStarted(false)
+{
+	m_pSocket->setParent(this);
+	m_timer.setSingleShot(true);
+	connect(&m_timer, SIGNAL(timeout()), this, SLOT(timerShot()));
+	connect(m_pSocket, SIGNAL(readyRead()), this, SLOT(readyRead()));
+	connect(m_pSocket, SIGNAL(bytesWritten(qint64)), this, SLOT(bytesWritten(qint64)));
+	connect(m_pSocket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+}
+
+ReplaySession::~ReplaySession()
+    = default;
+
+void ReplaySession::readyRead()
+{
+	m_szIncoming.append(m_pSocket->readAll());
+
+	int iIdx;
+	while((iIdx = m_szIncoming.indexOf('\n')) >= 0)
+	{
+		QByteArray szLine = m_szIncoming.left(iIdx).trimmed();
+		m_szIncoming.remove(0, iIdx + 1);
+
+		if(szLine.startsWith("PING "))
+		{
+			QByteArray szArg = szLine.mid(5);
+			if(szArg.startsWith(':'))
+				szArg.remove(0, 1);
+			m_pSocket->write(":replay.kvirc PONG replay.kvirc :" + szArg + "\r\n");
+		}
+		else if(szLine.startsWith("QUIT"))
+		{
+			m_pSocket->disconnectFromHost();
+			return;
+		}
+
+		if(!m_bStarted)
+			start();
+	}
+}
+
+void ReplaySession::start()
+{
+	m_bStarted = true;
+	m_clock.start();
+	feed();
+}
+
+void ReplaySession::feed()
+{
+	const std::vector<ReplayLine> & lines = m_pServer->m_Lines;
+
+	if(m_pServer->m_bRealTime)
+	{
+		while(m_uNext < lines.size())
+		{
+			quint64 uNow = m_clock.elapsed();
+			if(lines[m_uNext].uTime > uNow)
+			{
+				m_timer.start(lines[m_uNext].uTime - uNow);
+				return;
+			}
+			m_pSocket->write(lines[m_uNext].szData);
+			m_uNext++;
+		}
+	}
+	else
+	{
+		while((m_uNext < lines.size()) && (m_pSocket->bytesToWrite() < REPLAY_MAX_PENDING_BYTES))
+		{
+			m_pSocket->write(lines[m_uNext].szData);
+			m_uNext++;
+		}
+		if(m_uNext < lines.size())
+			return; // wait for bytesWritten()
+	}
+
+	m_pServer->sessionFinished(this, m_clock.elapsed());
+}
+
+void ReplaySession::bytesWritten(qint64)
+{
+	if(m_bStarted && !m_pServer->m_bRealTime && (m_uNext < m_pServer->m_Lines.size()))
+		feed();
+}
+
+void ReplaySession::timerShot()
+{
+	feed();
+}
+
+void ReplaySession::disconnected()
+{
+	m_timer.stop();
+	deleteLater();
+}
+
+ReplayServer::ReplayServer(bool bRealTime)
+    : QObject(), m_bRealTime(bRealTime)
+{
+	connect(&m_server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+}
+
+ReplayServer::~ReplayServer()
+{
+	m_server.close();
+}
+
+ReplayServer::Error ReplayServer::start(const QString & szFileName, quint16 uPort)
+{
+	QFile f(szFileName);
+	if(!f.open(QFile::ReadOnly))
+		return CantOpenFile;
+
+	QByteArray szHeader = f.readLine().trimmed();
+	if(szHeader != REPLAY_CAPTURE_HEADER)
+		return NotACapture;
+
+	m_Lines.clear();
+	while(!f.atEnd())
+	{
+		QByteArray szLine = f.readLine();
+		if(szLine.endsWith('\n'))
+			szLine.chop(1);
+		if(szLine.isEmpty() || szLine.startsWith('#'))
+			continue;
+		int iSpace = szLine.indexOf(' ');
+		if(iSpace < 1)
+			continue;
+		bool bOk;
+		quint64 uTime = szLine.left(iSpace).toULongLong(&bOk);
+		if(!bOk)
+			continue;
+		m_Lines.push_back({ uTime, szLine.mid(iSpace + 1) + "\r\n" });
+	}
+	m_szFileName = szFileName;
+
+	if(!m_server.listen(QHostAddress::LocalHost, uPort))
+		return CantListen;
+	return NoError;
+}
+
+void ReplayServer::newConnection()
+{
+	while(QTcpSocket * pSocket = m_server.nextPendingConnection())
+		new ReplaySession(this, pSocket);
+}
+
+void ReplayServer::sessionFinished(ReplaySession *, quint64 uMSecs)
+{
+	emit replayFinished(m_Lines.size(), uMSecs);
+}
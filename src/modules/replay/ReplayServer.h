@@ -0,0 +1,133 @@
+#ifndef _REPLAYSERVER_H_
+#define _REPLAYSERVER_H_
+//=============================================================================
+//
+//   File : ReplayServer.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+#include <QTimer>
+
+#include <vector>
+
+class QTcpSocket;
+class ReplayServer;
+
+//
+// A tiny IRC server listening on the loopback interface that plays
+// a capture written by ReplayCapture to each client that connects.
+//
+// The capture starts as soon as the client sends its first line
+// (usually CAP LS or NICK) and is played either at full speed, as fast
+// as the client reads it, or with the original timing. The server
+// answers the PINGs of the client and ignores anything else.
+//
+// It depends only on QtNetwork so it's also built in the standalone
+// kvirc-replaytest program (see ReplayTest.cpp).
+//
+// The capture is a text file: the lines starting with '#' are comments
+// and every other line is "<msecs> <raw message>", where <msecs> is the
+// time since the start of the capture. The raw messages are stored
+// exactly as received, without the CRLF terminator.
+//
+
+#define REPLAY_CAPTURE_HEADER "# KVIrc stream capture 1"
+
+struct ReplayLine
+{
+	quint64 uTime; // msecs since the start of the capture
+	QByteArray szData; // with the CRLF terminator
+};
+
+class ReplaySession : public QObject
+{
+	Q_OBJECT
+public:
+	ReplaySession(ReplayServer * pServer, QTcpSocket * pSocket);
+	~ReplaySession();
+
+protected:
+	ReplayServer * m_pServer;
+	QTcpSocket * m_pSocket;
+	QByteArray m_szIncoming;
+	size_t m_uNext;
+	bool m_bStarted;
+	QElapsedTimer m_clock;
+	QTimer m_timer;
+
+protected:
+	void start();
+	void feed();
+protected slots:
+	void readyRead();
+	void bytesWritten(qint64);
+	void timerShot();
+	void disconnected();
+};
+
+class ReplayServer : public QObject
+{
+	Q_OBJECT
+	friend class ReplaySession;
+
+public:
+	enum Error
+	{
+		NoError,
+		CantOpenFile,
+		NotACapture,
+		CantListen // see listenErrorString()
+	};
+
+	ReplayServer(bool bRealTime);
+	~ReplayServer();
+
+protected:
+	QTcpServer m_server;
+	std::vector<ReplayLine> m_Lines;
+	bool m_bRealTime;
+	QString m_szFileName;
+
+public:
+	// loads the capture and starts listening on 127.0.0.1
+	Error start(const QString & szFileName, quint16 uPort);
+	QString listenErrorString() const { return m_server.errorString(); }
+	quint16 port() const { return m_server.serverPort(); }
+	const QString & fileName() const { return m_szFileName; }
+	size_t lineCount() const { return m_Lines.size(); }
+	bool realTime() const { return m_bRealTime; }
+
+protected:
+	void sessionFinished(ReplaySession * pSession, quint64 uMSecs);
+signals:
+	// the whole capture has been written to a client
+	void replayFinished(quint64 uLines, quint64 uMSecs);
+protected slots:
+	void newConnection();
+};
+
+#endif //!_REPLAYSERVER_H_
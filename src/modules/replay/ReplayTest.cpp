@@ -0,0 +1,316 @@
+//=============================================================================
+//
+//   File : ReplayTest.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+//
+// kvirc-replaytest: the loopback replay test (run by ctest).
+//
+// It writes a synthetic capture (a registration, a netjoin, a large NAMES
+// reply and some chatter), plays it through a ReplayServer on 127.0.0.1
+// and checks that a client receives exactly the captured stream, at full
+// speed and with the original timing. It also prints the full speed
+// throughput.
+//
+// Usage: kvirc-replaytest [capture file]
+//
+// With a capture written by replay.capture it only plays that capture
+// at full speed and prints the throughput, as a benchmark of the server
+// side: measure the client with replay.serve and replay.report.
+//
+
+#include "ReplayServer.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHostAddress>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include <cstdio>
+#include <vector>
+
+// generous: the full capture takes a few tens of msecs
+#define REPLAY_TEST_TIMEOUT 30000
+
+struct TestLine
+{
+	quint64 uTime;
+	QByteArray szData; // without the CRLF terminator
+};
+
+// what a client received from the server
+struct TestRun
+{
+	std::vector<QByteArray> lines; // without the CRLF terminator
+	quint64 uFinishedLines = 0;    // as reported by ReplayServer::replayFinished()
+	qint64 iMSecs = 0;             // from the connection to the last expected line
+	quint64 uBytes = 0;
+	bool bTimedOut = false;
+};
+
+static int g_iFailures = 0;
+
+static void check(bool bOk, const char * pcWhat)
+{
+	if(bOk)
+		return;
+	fprintf(stderr, "FAIL: %s\n", pcWhat);
+	g_iFailures++;
+}
+
+static bool write_capture(const QString & szFileName, const std::vector<TestLine> & lines)
+{
+	QFile f(szFileName);
+	if(!f.open(QFile::WriteOnly | QFile::Truncate))
+		return false;
+	f.write(REPLAY_CAPTURE_HEADER "\n");
+	f.write("# written by kvirc-replaytest\n");
+	for(auto & l : lines)
+		f.write(QByteArray::number(l.uTime) + ' ' + l.szData + '\n');
+	f.close();
+	return f.error() == QFile::NoError;
+}
+
+static std::vector<TestLine> synthetic_capture()
+{
+	std::vector<TestLine> lines;
+	quint64 uTime = 0;
+
+	lines.push_back({ uTime, ":replay.kvirc 001 replaytest :Welcome to the replay network replaytest" });
+	lines.push_back({ uTime, ":replay.kvirc 005 replaytest CHANTYPES=# PREFIX=(ov)@+ CASEMAPPING=rfc1459 :are supported by this server" });
+	lines.push_back({ uTime, ":replaytest!user@localhost JOIN #replay" });
+
+	// a netjoin
+	for(int i = 0; i < 2000; i++)
+		lines.push_back({ uTime, QByteArray(":nick") + QByteArray::number(i) + "!user" + QByteArray::number(i) + "@host" + QByteArray::number(i % 97) + ".example JOIN #replay" });
+
+	// a large NAMES reply, in lines of about 400 bytes
+	QByteArray szNames;
+	for(int i = 0; i < 5000; i++)
+	{
+		if(!szNames.isEmpty())
+			szNames.append(' ');
+		szNames.append((i % 10) ? "" : "@");
+		szNames.append("user" + QByteArray::number(i));
+		if(szNames.size() > 400)
+		{
+			lines.push_back({ uTime, ":replay.kvirc 353 replaytest = #replay :" + szNames });
+			szNames.clear();
+		}
+	}
+	if(!szNames.isEmpty())
+		lines.push_back({ uTime, ":replay.kvirc 353 replaytest = #replay :" + szNames });
+	lines.push_back({ uTime, ":replay.kvirc 366 replaytest #replay :End of /NAMES list." });
+
+	// some chatter, with message tags too
+	for(int i = 0; i < 5000; i++)
+	{
+		uTime += 3;
+		QByteArray szNick = "nick" + QByteArray::number(i % 2000);
+		if(i % 3)
+			lines.push_back({ uTime, ":" + szNick + "!user@host.example PRIVMSG #replay :message number " + QByteArray::number(i) });
+		else
+			lines.push_back({ uTime, "@time=2026-10-19T10:12:31.000Z :" + szNick + "!user@host.example PRIVMSG #replay :\x01" "ACTION waves\x01" });
+	}
+
+	return lines;
+}
+
+// connects to the server, sends a PING and reads the PONG and uExpected more lines
+static TestRun replay_run(ReplayServer & server, size_t uExpected)
+{
+	TestRun run;
+	QEventLoop loop;
+	QTcpSocket socket;
+	QByteArray szBuffer;
+	QElapsedTimer clock;
+
+	QMetaObject::Connection finished = QObject::connect(&server, &ReplayServer::replayFinished, [&](quint64 uLines, quint64) {
+		run.uFinishedLines = uLines;
+	});
+
+	QObject::connect(&socket, &QTcpSocket::connected, [&]() {
+		// the first line starts the replay
+		socket.write("PING :replaytest\r\n");
+	});
+
+	QObject::connect(&socket, &QTcpSocket::readyRead, [&]() {
+		QByteArray szData = socket.readAll();
+		run.uBytes += szData.size();
+		szBuffer.append(szData);
+		int iStart = 0;
+		int iIdx;
+		while((iIdx = szBuffer.indexOf("\r\n", iStart)) >= 0)
+		{
+			run.lines.push_back(szBuffer.mid(iStart, iIdx - iStart));
+			iStart = iIdx + 2;
+		}
+		szBuffer.remove(0, iStart);
+
+		if(run.lines.size() >= (uExpected + 1))
+		{
+			run.iMSecs = clock.elapsed();
+			loop.quit();
+		}
+	});
+
+	QTimer::singleShot(REPLAY_TEST_TIMEOUT, &loop, [&]() {
+		run.bTimedOut = true;
+		loop.quit();
+	});
+
+	clock.start();
+	socket.connectToHost(QHostAddress::LocalHost, server.port());
+	loop.exec();
+
+	// the notification follows the last write, deliver it if still queued
+	QCoreApplication::processEvents();
+	QObject::disconnect(finished);
+	socket.disconnectFromHost();
+	return run;
+}
+
+static void print_throughput(const char * pcWhat, const TestRun & run)
+{
+	double dSecs = run.iMSecs ? run.iMSecs / 1000.0 : 0.001;
+	printf("%s: %u lines, %u bytes in %u msecs (%.0f lines/sec, %.1f MiB/sec)\n",
+	    pcWhat, (unsigned int)run.lines.size(), (unsigned int)run.uBytes, (unsigned int)run.iMSecs,
+	    run.lines.size() / dSecs, (run.uBytes / (1024.0 * 1024.0)) / dSecs);
+}
+
+static bool check_stream(const TestRun & run, const std::vector<TestLine> & lines)
+{
+	if(run.bTimedOut || (run.lines.size() != (lines.size() + 1)))
+		return false;
+	if(run.lines[0] != ":replay.kvirc PONG replay.kvirc :replaytest")
+		return false;
+	for(size_t i = 0; i < lines.size(); i++)
+	{
+		if(run.lines[i + 1] != lines[i].szData)
+			return false;
+	}
+	return true;
+}
+
+static int replay_benchmark(const QString & szFileName)
+{
+	ReplayServer server(false);
+	if(server.start(szFileName, 0) != ReplayServer::NoError)
+	{
+		fprintf(stderr, "Can't play %s\n", szFileName.toLocal8Bit().data());
+		return 1;
+	}
+
+	TestRun run = replay_run(server, server.lineCount());
+	check(!run.bTimedOut, "the capture is played within the timeout");
+	check(run.lines.size() == (server.lineCount() + 1), "the client receives all the captured lines");
+	print_throughput("full speed", run);
+	return g_iFailures ? 1 : 0;
+}
+
+int main(int argc, char ** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	if(argc > 2)
+	{
+		fprintf(stderr, "Usage: %s [capture file]\n", argv[0]);
+		return 1;
+	}
+
+	if(argc == 2)
+		return replay_benchmark(QString::fromLocal8Bit(argv[1]));
+
+	QTemporaryDir dir;
+	if(!dir.isValid())
+	{
+		fprintf(stderr, "Can't create a temporary directory\n");
+		return 1;
+	}
+
+	// the file checks
+	{
+		ReplayServer server(false);
+		check(server.start(dir.filePath("missing.cap"), 0) == ReplayServer::CantOpenFile, "a missing capture is rejected");
+
+		QFile f(dir.filePath("invalid.cap"));
+		if(f.open(QFile::WriteOnly))
+		{
+			f.write("0 PING :not a capture\n");
+			f.close();
+		}
+		check(server.start(f.fileName(), 0) == ReplayServer::NotACapture, "a file without the capture header is rejected");
+	}
+
+	// full speed
+	{
+		std::vector<TestLine> lines = synthetic_capture();
+		QString szFileName = dir.filePath("synthetic.cap");
+		check(write_capture(szFileName, lines), "the synthetic capture is written");
+
+		ReplayServer server(false);
+		check(server.start(szFileName, 0) == ReplayServer::NoError, "the server starts on a free port");
+		check(server.lineCount() == lines.size(), "the server loads all the captured lines");
+
+		TestRun run = replay_run(server, lines.size());
+		check(!run.bTimedOut, "the full speed replay completes within the timeout");
+		check(check_stream(run, lines), "the full speed replay is identical to the capture");
+		check(run.uFinishedLines == lines.size(), "the server reports the completed replay");
+		print_throughput("full speed", run);
+
+		// a second client gets the whole capture again
+		TestRun again = replay_run(server, lines.size());
+		check(check_stream(again, lines), "a second client gets the whole capture");
+	}
+
+	// original timing
+	{
+		std::vector<TestLine> lines = {
+			{ 0, ":replay.kvirc 001 replaytest :Welcome" },
+			{ 150, ":nick!user@host JOIN #replay" },
+			{ 300, ":nick!user@host PRIVMSG #replay :hello" }
+		};
+		QString szFileName = dir.filePath("timed.cap");
+		check(write_capture(szFileName, lines), "the timed capture is written");
+
+		ReplayServer server(true);
+		check(server.start(szFileName, 0) == ReplayServer::NoError, "the real time server starts");
+
+		TestRun run = replay_run(server, lines.size());
+		check(check_stream(run, lines), "the real time replay is identical to the capture");
+		// the timers may fire a little early on some platforms
+		check(run.iMSecs >= 280, "the real time replay keeps the original timing");
+		printf("real time: %u lines in %u msecs (captured in 300 msecs)\n", (unsigned int)run.lines.size(), (unsigned int)run.iMSecs);
+	}
+
+	if(g_iFailures)
+	{
+		fprintf(stderr, "%d checks failed\n", g_iFailures);
+		return 1;
+	}
+	printf("All the checks passed\n");
+	return 0;
+}
@@ -0,0 +1,440 @@
+//=============================================================================
+//
+//   File : libkvireplay.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+
+#include "ReplayCapture.h"
+#include "ReplayServer.h"
+
+#include "KviModule.h"
+#include "KviApplication.h"
+#include "KviLocale.h"
+#include "KviFileUtils.h"
+#include "KviWindow.h"
+#include "KviConsoleWindow.h"
+#include "KviIrcContext.h"
+#include "KviIrcConnection.h"
+#include "KviIrcConnectionStatistics.h"
+#include "KviOptions.h"
+#include "kvi_out.h"
+
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+std::unordered_set<ReplayCapture *> g_pReplayCaptureList;
+static ReplayServer * g_pReplayServer = nullptr;
+
+// the peak resident set size of the process in bytes, 0 if not known
+static kvi_u64_t replay_peak_rss()
+{
+#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
+	return 0;
+#else
+	struct rusage ru;
+	if(getrusage(RUSAGE_SELF, &ru) != 0)
+		return 0;
+#ifdef COMPILE_ON_MAC
+	return (kvi_u64_t)ru.ru_maxrss; // bytes
+#else
+	return ((kvi_u64_t)ru.ru_maxrss) * 1024; // kilobytes
+#endif
+#endif
+}
+
+static void replay_finished(quint64 uLines, quint64 uMSecs)
+{
+	KviConsoleWindow * pConsole = g_pApp->activeConsole();
+	if(!pConsole || !g_pReplayServer)
+		return;
+	QString szFileName = g_pReplayServer->fileName();
+	pConsole->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Replay of %Q completed: %u lines sent in %u msecs", "replay"),
+	    &szFileName, (unsigned int)uLines, (unsigned int)uMSecs);
+}
+
+static ReplayCapture * replay_find_capture(KviIrcContext * pContext)
+{
+	for(auto & c : g_pReplayCaptureList)
+	{
+		if(c->context() == pContext)
+			return c;
+	}
+	return nullptr;
+}
+
+/*
+	@doc: replay.capture
+	@type:
+		command
+	@title:
+		replay.capture
+	@short:
+		Captures the server stream of the current IRC context
+	@syntax:
+		replay.capture <filename:string>
+	@description:
+		Starts writing the raw messages received from the server
+		in the current IRC context to <filename>, with their timing.
+		The capture goes on across reconnections until
+		[cmd]replay.stopcapture[/cmd] is called or the context is closed.[br]
+		The file can be played back by [cmd]replay.serve[/cmd] to
+		measure the client on a real workload: start the capture before
+		connecting so the registration is captured too.
+	@seealso:
+		[cmd]replay.stopcapture[/cmd], [cmd]replay.serve[/cmd]
+*/
+
+static bool replay_kvs_cmd_capture(KviKvsModuleCommandCall * c)
+{
+	QString szFileName;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("filename", KVS_PT_NONEMPTYSTRING, 0, szFileName)
+	KVSM_PARAMETERS_END(c)
+
+	if(!c->window()->console())
+		return c->context()->errorNoIrcContext();
+
+	KviIrcContext * pContext = c->window()->console()->context();
+	if(replay_find_capture(pContext))
+	{
+		c->warning(__tr2qs_ctx("A capture is already running in this IRC context", "replay"));
+		return true;
+	}
+
+	KviFileUtils::adjustFilePath(szFileName);
+	ReplayCapture * pCapture = new ReplayCapture(pContext, szFileName);
+	if(!pCapture->isOpen())
+	{
+		c->warning(__tr2qs_ctx("Can't open the file %Q for writing", "replay"), &szFileName);
+		pCapture->die();
+		return true;
+	}
+
+	c->window()->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Capturing the server stream to %Q", "replay"), &szFileName);
+	return true;
+}
+
+/*
+	@doc: replay.stopcapture
+	@type:
+		command
+	@title:
+		replay.stopcapture
+	@short:
+		Stops the capture of the current IRC context
+	@syntax:
+		replay.stopcapture
+	@description:
+		Stops the capture started by [cmd]replay.capture[/cmd]
+		in the current IRC context and closes the file.
+	@seealso:
+		[cmd]replay.capture[/cmd]
+*/
+
+static bool replay_kvs_cmd_stopcapture(KviKvsModuleCommandCall * c)
+{
+	if(!c->window()->console())
+		return c->context()->errorNoIrcContext();
+
+	ReplayCapture * pCapture = replay_find_capture(c->window()->console()->context());
+	if(!pCapture)
+	{
+		c->warning(__tr2qs_ctx("No capture is running in this IRC context", "replay"));
+		return true;
+	}
+
+	QString szFileName = pCapture->fileName();
+	unsigned int uLines = (unsigned int)pCapture->lines();
+	pCapture->die();
+	c->window()->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Capture stopped: %u messages written to %Q", "replay"), uLines, &szFileName);
+	return true;
+}
+
+/*
+	@doc: replay.serve
+	@type:
+		command
+	@title:
+		replay.serve
+	@short:
+		Plays a capture to the clients that connect on the loopback interface
+	@syntax:
+		replay.serve [-t] <filename:string> [port:uint]
+	@switches:
+		!sw: -t | --real-time
+		Plays the capture with the original timing instead of at full speed
+	@description:
+		Starts a tiny IRC server on 127.0.0.1:<port> (6677 by default)
+		that plays the capture written by [cmd]replay.capture[/cmd] to
+		each client that connects. The capture starts when the client
+		sends its first line and, unless -t is given, is sent as fast
+		as the client can read it.[br]
+		The server can run in the same KVIrc instance as the client or,
+		for cleaner numbers, in a second instance.
+		Only one server can be running at a time: a new call
+		replaces the previous server.[br]
+		Enable the profiling with [cmd]replay.profile[/cmd] before
+		connecting and print the results with [cmd]replay.report[/cmd].
+	@examples:
+		[example]
+			replay.serve ~/netjoin.cap
+			replay.profile
+			server -n 127.0.0.1 6677
+			[comment]# ...wait for the "Replay completed" message...[/comment]
+			replay.report
+		[/example]
+	@seealso:
+		[cmd]replay.stopserve[/cmd], [cmd]replay.capture[/cmd]
+*/
+
+static bool replay_kvs_cmd_serve(KviKvsModuleCommandCall * c)
+{
+	QString szFileName;
+	kvs_uint_t uPort;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("filename", KVS_PT_NONEMPTYSTRING, 0, szFileName)
+	KVSM_PARAMETER("port", KVS_PT_UINT, KVS_PF_OPTIONAL, uPort)
+	KVSM_PARAMETERS_END(c)
+
+	if(uPort == 0)
+		uPort = 6677;
+	if(uPort > 65535)
+	{
+		c->warning(__tr2qs_ctx("Invalid port number", "replay"));
+		return true;
+	}
+
+	if(g_pReplayServer)
+	{
+		delete g_pReplayServer;
+		g_pReplayServer = nullptr;
+	}
+
+	KviFileUtils::adjustFilePath(szFileName);
+	ReplayServer * pServer = new ReplayServer(c->switches()->find('t', "real-time"));
+	switch(pServer->start(szFileName, (quint16)uPort))
+	{
+		case ReplayServer::NoError:
+			break;
+		case ReplayServer::CantOpenFile:
+			c->warning(__tr2qs_ctx("Can't open the capture file %Q", "replay"), &szFileName);
+			delete pServer;
+			return true;
+		case ReplayServer::NotACapture:
+			c->warning(__tr2qs_ctx("The file %Q is not a stream capture", "replay"), &szFileName);
+			delete pServer;
+			return true;
+		case ReplayServer::CantListen:
+		{
+			QString szError = pServer->listenErrorString();
+			c->warning(__tr2qs_ctx("Can't listen on 127.0.0.1:%u: %Q", "replay"), (unsigned int)uPort, &szError);
+			delete pServer;
+			return true;
+		}
+	}
+	QObject::connect(pServer, &ReplayServer::replayFinished, replay_finished);
+	g_pReplayServer = pServer;
+
+	unsigned int uLines = (unsigned int)pServer->lineCount();
+	c->window()->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Replay server listening on 127.0.0.1:%u with %u messages from %Q", "replay"),
+	    (unsigned int)pServer->port(), uLines, &szFileName);
+	return true;
+}
+
+/*
+	@doc: replay.stopserve
+	@type:
+		command
+	@title:
+		replay.stopserve
+	@short:
+		Stops the replay server
+	@syntax:
+		replay.stopserve
+	@description:
+		Stops the server started by [cmd]replay.serve[/cmd]
+		and drops its clients.
+	@seealso:
+		[cmd]replay.serve[/cmd]
+*/
+
+static bool replay_kvs_cmd_stopserve(KviKvsModuleCommandCall * c)
+{
+	if(!g_pReplayServer)
+	{
+		c->warning(__tr2qs_ctx("No replay server is running", "replay"));
+		return true;
+	}
+	delete g_pReplayServer;
+	g_pReplayServer = nullptr;
+	return true;
+}
+
+/*
+	@doc: replay.profile
+	@type:
+		command
+	@title:
+		replay.profile
+	@short:
+		Enables the connection telemetry
+	@syntax:
+		replay.profile [-d]
+	@switches:
+		!sw: -d | --disable
+		Disables the telemetry
+	@description:
+		Sets the boolEnableConnectionTelemetry option and resets the
+		telemetry of the current IRC context, if connected: from now on
+		the time spent handling each message is collected per command,
+		in all the IRC contexts. The telemetry has a small cost,
+		disable it when done.
+	@seealso:
+		[cmd]replay.report[/cmd], [fnc]$context.telemetry[/fnc]
+*/
+
+static bool replay_kvs_cmd_profile(KviKvsModuleCommandCall * c)
+{
+	bool bEnable = !c->switches()->find('d', "disable");
+	KVI_OPTION_BOOL(KviOption_boolEnableConnectionTelemetry) = bEnable;
+	if(bEnable && c->window()->connection())
+		c->window()->connection()->statistics()->resetTelemetry();
+	return true;
+}
+
+/*
+	@doc: replay.report
+	@type:
+		command
+	@title:
+		replay.report
+	@short:
+		Prints the message handling profile of the current IRC context
+	@syntax:
+		replay.report [count:uint]
+	@description:
+		Prints the number of messages handled by the connection of the
+		current IRC context since the telemetry was enabled or reset
+		(see [cmd]replay.profile[/cmd]) and their rate, the <count>
+		(20 by default) most expensive commands with their total,
+		average and maximum time and the peak memory usage of KVIrc.[br]
+		The time of a command includes everything done while handling
+		the message: the user list updates, the output and the events.
+	@seealso:
+		[cmd]replay.profile[/cmd], [fnc]$context.telemetryJson[/fnc]
+*/
+
+static bool replay_kvs_cmd_report(KviKvsModuleCommandCall * c)
+{
+	kvs_uint_t uCount;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("count", KVS_PT_UINT, KVS_PF_OPTIONAL, uCount)
+	KVSM_PARAMETERS_END(c)
+
+	KVSM_REQUIRE_CONNECTION(c)
+
+	if(uCount == 0)
+		uCount = 20;
+
+	KviIrcConnectionStatistics * pStats = c->window()->connection()->statistics();
+
+	std::vector<std::pair<std::string, KviIrcConnectionStatistics::CommandTelemetry>> lCommands(pStats->commands().begin(), pStats->commands().end());
+	std::sort(lCommands.begin(), lCommands.end(), [](const std::pair<std::string, KviIrcConnectionStatistics::CommandTelemetry> & a, const std::pair<std::string, KviIrcConnectionStatistics::CommandTelemetry> & b) {
+		return a.second.uTotalUSecs > b.second.uTotalUSecs;
+	});
+
+	KviWindow * pOut = c->window();
+	if(!KVI_OPTION_BOOL(KviOption_boolEnableConnectionTelemetry))
+		pOut->outputNoFmt(KVI_OUT_SYSTEMWARNING, __tr2qs_ctx("The telemetry is disabled: use replay.profile to enable it", "replay"));
+
+	kvi_u64_t uMessages = pStats->dispatchLatency().count();
+	kvi_u64_t uElapsed = pStats->telemetryTime();
+	double dRate = uElapsed ? ((double)uMessages * 1000000.0) / (double)uElapsed : 0.0;
+	QString szRate = QString::number(dRate, 'f', 1);
+	pOut->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Messages: %u in %u msecs (%Q messages/sec)", "replay"),
+	    (unsigned int)uMessages, (unsigned int)(uElapsed / 1000), &szRate);
+
+	kvs_uint_t uShown = 0;
+	for(auto & it : lCommands)
+	{
+		if(uShown == uCount)
+			break;
+		const KviIrcConnectionStatistics::CommandTelemetry & t = it.second;
+		QString szCommand = QString::fromLatin1(it.first.c_str());
+		QString szTotal = QString::number((double)t.uTotalUSecs / 1000.0, 'f', 2);
+		QString szAvg = QString::number((double)t.uTotalUSecs / (double)t.uCount, 'f', 1);
+		pOut->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("%Q: %u calls, %Q msecs (avg %Q usecs, max %u usecs)", "replay"),
+		    &szCommand, (unsigned int)t.uCount, &szTotal, &szAvg, (unsigned int)t.uMaxUSecs);
+		uShown++;
+	}
+
+	kvi_u64_t uRss = replay_peak_rss();
+	if(uRss)
+	{
+		QString szRss = QString::number((double)uRss / (1024.0 * 1024.0), 'f', 1);
+		pOut->output(KVI_OUT_SYSTEMMESSAGE, __tr2qs_ctx("Peak RSS: %Q MiB", "replay"), &szRss);
+	}
+	return true;
+}
+
+static bool replay_module_init(KviModule * m)
+{
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "capture", replay_kvs_cmd_capture);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "stopcapture", replay_kvs_cmd_stopcapture);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "serve", replay_kvs_cmd_serve);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "stopserve", replay_kvs_cmd_stopserve);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "profile", replay_kvs_cmd_profile);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "report", replay_kvs_cmd_report);
+	return true;
+}
+
+static bool replay_module_cleanup(KviModule *)
+{
+	while(!g_pReplayCaptureList.empty())
+		(*g_pReplayCaptureList.begin())->die();
+	delete g_pReplayServer;
+	g_pReplayServer = nullptr;
+	return true;
+}
+
+static bool replay_module_can_unload(KviModule *)
+{
+	return g_pReplayCaptureList.empty() && !g_pReplayServer;
+}
+
+KVIRC_MODULE(
+    "Replay",                                             // module name
+    "4.0.0",                                              // module version
+    "Copyright (C) 2026 The KVIrc Development Team",      // author & (C)
+    "Server stream capture, replay and profiling",
+    replay_module_init,
+    replay_module_can_unload,
+    0,
+    replay_module_cleanup,
+    0)
@@ -126,7 +126,7 @@ public:
 	};
 
 	Rijndael();
-	~Rijndael();
+	virtual ~Rijndael();
 
 protected:
 	enum State
@@ -145,7 +145,7 @@ protected:
 public:
 	// Initializes the crypt session
 	// Returns RIJNDAEL_SUCCESS or an error code
-	int init(Mode mode, Direction dir, const UINT8 * key, KeyLength keyLen, UINT8 * initVector = nullptr);
+	virtual int init(Mode mode, Direction dir, const UINT8 * key, KeyLength keyLen, UINT8 * initVector = nullptr);
 	// Input len is in BITS!
 	// Encrypts inputLen / 128 blocks of input and puts it in outBuffer
 	// outBuffer must be at least inputLen / 8 bytes long.
@@ -154,7 +154,7 @@ public:
 	// Input len is in BYTES!
 	// outBuffer must be at least inputLen + 16 bytes long
 	// Returns the encrypted buffer length in BYTES or an error code < 0 in case of error
-	int padEncrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer, UINT8 * initVector = nullptr);
+	virtual int padEncrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer, UINT8 * initVector = nullptr);
 	// Input len is in BITS!
 	// outBuffer must be at least inputLen / 8 bytes long
 	// Returns the decrypted buffer length in BITS and an error code < 0 in case of error
@@ -162,7 +162,7 @@ public:
 	// Input len is in BYTES!
 	// outBuffer must be at least inputLen bytes long
 	// Returns the decrypted buffer length in BYTES and an error code < 0 in case of error
-	int padDecrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer, UINT8 * initVector = nullptr);
+	virtual int padDecrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer, UINT8 * initVector = nullptr);
 
 protected:
 	void keySched(UINT8 key[_MAX_KEY_COLUMNS][4]);
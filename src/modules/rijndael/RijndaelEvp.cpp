@@ -0,0 +1,238 @@
+//=============================================================================
+//
+//   File : RijndaelEvp.cpp
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "RijndaelEvp.h"
+
+#if defined(COMPILE_CRYPT_SUPPORT) || defined(Q_MOC_RUN)
+
+#include "KviMemory.h"
+
+#ifdef COMPILE_SSL_SUPPORT
+
+RijndaelEvp::RijndaelEvp()
+    : Rijndael()
+{
+	m_pCtx = EVP_CIPHER_CTX_new();
+}
+
+RijndaelEvp::~RijndaelEvp()
+{
+	if(m_pCtx)
+		EVP_CIPHER_CTX_free(m_pCtx);
+}
+
+int RijndaelEvp::init(Mode mode, Direction dir, const UINT8 * key, KeyLength keyLen, UINT8 * initVector)
+{
+	m_state = Invalid;
+
+	if(!m_pCtx)
+		return RIJNDAEL_NOT_INITIALIZED;
+
+	if((mode != CBC) && (mode != ECB))
+		return RIJNDAEL_UNSUPPORTED_MODE;
+	m_mode = mode;
+
+	if((dir != Encrypt) && (dir != Decrypt))
+		return RIJNDAEL_UNSUPPORTED_DIRECTION;
+	m_direction = dir;
+
+	updateInitVector(initVector);
+
+	const EVP_CIPHER * pCipher = nullptr;
+	switch(keyLen)
+	{
+		case Key16Bytes:
+			pCipher = (mode == ECB) ? EVP_aes_128_ecb() : EVP_aes_128_cbc();
+			m_uRounds = 10;
+			break;
+		case Key24Bytes:
+			pCipher = (mode == ECB) ? EVP_aes_192_ecb() : EVP_aes_192_cbc();
+			m_uRounds = 12;
+			break;
+		case Key32Bytes:
+			pCipher = (mode == ECB) ? EVP_aes_256_ecb() : EVP_aes_256_cbc();
+			m_uRounds = 14;
+			break;
+		default:
+			return RIJNDAEL_UNSUPPORTED_KEY_LENGTH;
+			break;
+	}
+
+	if(!key)
+		return RIJNDAEL_BAD_KEY;
+
+	// the key schedule is computed once here: restart() only resets the init vector
+	if(!EVP_CipherInit_ex(m_pCtx, pCipher, nullptr, key, m_initVector, (dir == Encrypt) ? 1 : 0))
+		return RIJNDAEL_BAD_KEY;
+	// we pad by ourselves
+	EVP_CIPHER_CTX_set_padding(m_pCtx, 0);
+
+	m_state = Valid;
+
+	return RIJNDAEL_SUCCESS;
+}
+
+bool RijndaelEvp::restart()
+{
+	return EVP_CipherInit_ex(m_pCtx, nullptr, nullptr, nullptr, (m_mode == CBC) ? m_initVector : nullptr, -1);
+}
+
+bool RijndaelEvp::process(const UINT8 * input, int inputOctets, UINT8 * outBuffer)
+{
+	if(inputOctets <= 0)
+		return true;
+	int iOut = 0;
+	if(!EVP_CipherUpdate(m_pCtx, outBuffer, &iOut, input, inputOctets))
+		return false;
+	return iOut == inputOctets;
+}
+
+int RijndaelEvp::padEncrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer, UINT8 * initVector)
+{
+	int numBlocks, padLen;
+	UINT8 block[16];
+
+	// update the init vector only if a new one has been specified
+	if(initVector)
+		updateInitVector(initVector);
+
+	if(m_state != Valid)
+		return RIJNDAEL_NOT_INITIALIZED;
+	if(m_direction != Encrypt)
+		return RIJNDAEL_NOT_INITIALIZED;
+
+	if(input == nullptr || inputOctets <= 0)
+		return 0;
+
+	numBlocks = inputOctets / 16;
+
+	// PKCS#7 padding: always a whole block when the input is block aligned
+	padLen = 16 - (inputOctets - 16 * numBlocks);
+	KviMemory::move(block, input + 16 * numBlocks, 16 - padLen);
+	KviMemory::set(block + 16 - padLen, padLen, padLen);
+
+	if(!restart())
+		return RIJNDAEL_NOT_INITIALIZED;
+	if(!process(input, 16 * numBlocks, outBuffer))
+		return RIJNDAEL_NOT_INITIALIZED;
+	if(!process(block, 16, outBuffer + 16 * numBlocks))
+		return RIJNDAEL_NOT_INITIALIZED;
+
+	return 16 * (numBlocks + 1);
+}
+
+int RijndaelEvp::padDecrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer, UINT8 * initVector)
+{
+	int i, numBlocks, padLen;
+	UINT8 block[16];
+
+	// update the init vector only if a new one has been specified
+	if(initVector)
+		updateInitVector(initVector);
+
+	if(m_state != Valid)
+		return RIJNDAEL_NOT_INITIALIZED;
+	if(m_direction != Decrypt)
+		return RIJNDAEL_BAD_DIRECTION;
+
+	if(input == nullptr || inputOctets <= 0)
+		return 0;
+
+	if((inputOctets % 16) != 0)
+		return RIJNDAEL_CORRUPTED_DATA;
+
+	numBlocks = inputOctets / 16;
+
+	if(!restart())
+		return RIJNDAEL_NOT_INITIALIZED;
+	// all blocks but last
+	if(!process(input, 16 * (numBlocks - 1), outBuffer))
+		return RIJNDAEL_NOT_INITIALIZED;
+	// last block
+	if(!process(input + 16 * (numBlocks - 1), 16, block))
+		return RIJNDAEL_NOT_INITIALIZED;
+
+	// the same checks as Rijndael::padDecrypt()
+	padLen = block[15];
+	if(m_mode == ECB)
+	{
+		if(padLen >= 16)
+			return RIJNDAEL_CORRUPTED_DATA;
+	}
+	else
+	{
+		if(padLen <= 0 || padLen > 16)
+			return RIJNDAEL_CORRUPTED_DATA;
+	}
+	for(i = 16 - padLen; i < 16; i++)
+	{
+		if(block[i] != padLen)
+			return RIJNDAEL_CORRUPTED_DATA;
+	}
+	KviMemory::move(outBuffer + 16 * (numBlocks - 1), block, 16 - padLen);
+
+	return 16 * numBlocks - padLen;
+}
+
+#endif // COMPILE_SSL_SUPPORT
+
+namespace RijndaelBackend
+{
+	bool isAvailable(Type eType)
+	{
+		switch(eType)
+		{
+			case Builtin:
+				return true;
+			case OpenSSL:
+#ifdef COMPILE_SSL_SUPPORT
+				return true;
+#else
+				return false;
+#endif
+		}
+		return false;
+	}
+
+	Type preferred()
+	{
+		return isAvailable(OpenSSL) ? OpenSSL : Builtin;
+	}
+
+	const char * name(Type eType)
+	{
+		return (eType == OpenSSL) ? "OpenSSL" : "builtin";
+	}
+
+	Rijndael * alloc(Type eType)
+	{
+#ifdef COMPILE_SSL_SUPPORT
+		if(eType == OpenSSL)
+			return new RijndaelEvp();
+#endif
+		return new Rijndael();
+	}
+};
+
+#endif // COMPILE_CRYPT_SUPPORT
@@ -0,0 +1,86 @@
+#ifndef _RIJNDAELEVP_H_
+#define _RIJNDAELEVP_H_
+//=============================================================================
+//
+//   File : RijndaelEvp.h
+//   Creation date : Mon 19 Oct 2026 10:12:31 by the KVIrc Development Team
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+//
+// The Rijndael cipher implemented on top of the OpenSSL EVP interface.
+// OpenSSL picks the AES-NI (or other hardware assisted) code path
+// when the CPU supports it.
+//
+// The padding is done here, exactly like in the bundled implementation,
+// so the ciphertext is bit-identical and the corrupted data checks match.
+// Only the ECB and CBC modes are supported.
+//
+
+#include "kvi_settings.h"
+
+#if defined(COMPILE_CRYPT_SUPPORT) || defined(Q_MOC_RUN)
+
+#include "Rijndael.h"
+
+#ifdef COMPILE_SSL_SUPPORT
+
+#include <openssl/evp.h>
+
+class RijndaelEvp : public Rijndael
+{
+public:
+	RijndaelEvp();
+	~RijndaelEvp();
+
+protected:
+	EVP_CIPHER_CTX * m_pCtx;
+
+public:
+	int init(Mode mode, Direction dir, const UINT8 * key, KeyLength keyLen, UINT8 * initVector = nullptr) override;
+	int padEncrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer, UINT8 * initVector = nullptr) override;
+	int padDecrypt(const UINT8 * input, int inputOctets, UINT8 * outBuffer, UINT8 * initVector = nullptr) override;
+
+protected:
+	bool restart();
+	bool process(const UINT8 * input, int inputOctets, UINT8 * outBuffer);
+};
+
+#endif // COMPILE_SSL_SUPPORT
+
+namespace RijndaelBackend
+{
+	enum Type
+	{
+		Builtin,
+		OpenSSL
+	};
+
+	// true if the backend has been compiled in
+	bool isAvailable(Type eType);
+	// the fastest available backend
+	Type preferred();
+	const char * name(Type eType);
+	Rijndael * alloc(Type eType);
+};
+
+#endif // COMPILE_CRYPT_SUPPORT
+
+#endif // _RIJNDAELEVP_H_
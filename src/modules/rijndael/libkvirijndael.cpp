@@ -57,13 +57,21 @@
 		on 128 bit data blocks. The encrypted binary data buffer is then converted
 		into an ASCII-string by using the base64 conversion or hex-digit-string representation.[br][br]
 		The six engines are the six possible combinations of the key lengths and ASCII-string
-		conversions.
+		conversions.[br][br]
+		When KVIrc is built with OpenSSL the cipher itself is computed by OpenSSL,
+		which uses the AES hardware instructions of the CPU if available.
+		The result is identical to the one of the bundled implementation:
+		see [cmd]rijndael.benchmark[/cmd].
 */
 
 #if defined(COMPILE_CRYPT_SUPPORT) || defined(Q_MOC_RUN)
 #include "KviMemory.h"
 #include "KviPointerList.h"
 #include "KviCryptEngineDescription.h"
+#include "KviWindow.h"
+#include "kvi_out.h"
+
+#include <QElapsedTimer>
 
 static KviPointerList<KviCryptEngine> * g_pEngineList = nullptr;
 
@@ -73,6 +81,7 @@ KviRijndaelEngine::KviRijndaelEngine()
 	g_pEngineList->append(this);
 	m_pEncryptCipher = nullptr;
 	m_pDecryptCipher = nullptr;
+	m_eBackend = RijndaelBackend::preferred();
 }
 
 KviRijndaelEngine::~KviRijndaelEngine()
@@ -162,33 +171,24 @@ bool KviRijndaelEngine::init(const char * encKey, int encKeyLen, const char * de
 	szTmpEncryptKey.padRight(defLen);
 	szTmpDecryptKey.padRight(defLen);
 
-	m_pEncryptCipher = new Rijndael();
-
-	int retVal = m_pEncryptCipher->init(
+	int retVal = initCipher(&m_pEncryptCipher,
 	    (m_bEncryptMode == ECB) ? Rijndael::ECB : Rijndael::CBC,
 	    Rijndael::Encrypt,
-	    (unsigned char *)szTmpEncryptKey.ptr(),
-	    getKeyLenId());
+	    szTmpEncryptKey.ptr());
 	if(retVal != RIJNDAEL_SUCCESS)
 	{
-		delete m_pEncryptCipher;
-		m_pEncryptCipher = nullptr;
 		setLastErrorFromRijndaelErrorCode(retVal);
 		return false;
 	}
 
-	m_pDecryptCipher = new Rijndael();
-	retVal = m_pDecryptCipher->init(
+	retVal = initCipher(&m_pDecryptCipher,
 	    (m_bEncryptMode == ECB) ? Rijndael::ECB : Rijndael::CBC,
 	    Rijndael::Decrypt,
-	    (unsigned char *)szTmpDecryptKey.ptr(),
-	    getKeyLenId());
+	    szTmpDecryptKey.ptr());
 	if(retVal != RIJNDAEL_SUCCESS)
 	{
 		delete m_pEncryptCipher;
 		m_pEncryptCipher = nullptr;
-		delete m_pDecryptCipher;
-		m_pDecryptCipher = nullptr;
 		setLastErrorFromRijndaelErrorCode(retVal);
 		return false;
 	}
@@ -196,6 +196,25 @@ bool KviRijndaelEngine::init(const char * encKey, int encKeyLen, const char * de
 	return true;
 }
 
+int KviRijndaelEngine::initCipher(Rijndael ** ppCipher, Rijndael::Mode mode, Rijndael::Direction dir, const char * key)
+{
+	*ppCipher = RijndaelBackend::alloc(m_eBackend);
+	int retVal = (*ppCipher)->init(mode, dir, (unsigned char *)key, getKeyLenId());
+	if((retVal != RIJNDAEL_SUCCESS) && (m_eBackend != RijndaelBackend::Builtin))
+	{
+		// the OpenSSL build might lack the cipher: the bundled one always works
+		delete *ppCipher;
+		*ppCipher = RijndaelBackend::alloc(RijndaelBackend::Builtin);
+		retVal = (*ppCipher)->init(mode, dir, (unsigned char *)key, getKeyLenId());
+	}
+	if(retVal != RIJNDAEL_SUCCESS)
+	{
+		delete *ppCipher;
+		*ppCipher = nullptr;
+	}
+	return retVal;
+}
+
 void KviRijndaelEngine::setLastErrorFromRijndaelErrorCode(int errCode)
 {
 	switch(errCode)
@@ -675,6 +694,116 @@ static KviCryptEngine * allocMircryptionEngine()
 	return new KviMircryptionEngine();
 }
 
+/*
+	@doc: rijndael.benchmark
+	@type:
+		command
+	@title:
+		rijndael.benchmark
+	@short:
+		Measures the throughput of the Rijndael engines
+	@syntax:
+		rijndael.benchmark [<lines:uint>]
+	@description:
+		Encrypts and decrypts <lines> test messages (10000 by default)
+		with the 256 bit hexadecimal and base64 engines, once for each cipher
+		backend compiled in, and prints the throughput in the current window.[br]
+		The backends are the bundled Rijndael implementation and OpenSSL,
+		which uses the AES hardware instructions when the CPU supports them.
+		The engines use the fastest one available.[br]
+		The ciphertext produced by the backends is compared too: the command
+		warns if it differs.
+*/
+
+static bool rijndael_benchmark_engine(KviKvsModuleCommandCall * c, KviRijndaelEngine * pEngine, const char * szEncoding, RijndaelBackend::Type eBackend, const KviCString & szPlain, kvs_uint_t uLines)
+{
+	KviCString szKey = "benchmark";
+	pEngine->setBackend(eBackend);
+	if(!pEngine->init(szKey.ptr(), szKey.len(), nullptr, 0))
+	{
+		c->warning(__tr2qs("Failed to initialize the %s engine: %Q"), szEncoding, &(pEngine->lastError()));
+		return false;
+	}
+
+	KviCString szEncrypted, szDecrypted;
+	QElapsedTimer timer;
+	timer.start();
+	for(kvs_uint_t u = 0; u < uLines; u++)
+	{
+		if((pEngine->encrypt(szPlain.ptr(), szEncrypted) != KviCryptEngine::Encrypted) || (pEngine->decrypt(szEncrypted.ptr(), szDecrypted) != KviCryptEngine::DecryptOkWasEncrypted))
+		{
+			c->warning(__tr2qs("The %s engine failed: %Q"), szEncoding, &(pEngine->lastError()));
+			return false;
+		}
+	}
+	qint64 iMSecs = timer.elapsed();
+
+	if(!kvi_strEqualCS(szDecrypted.ptr(), szPlain.ptr()))
+		c->warning(__tr2qs("The %s engine decrypted a different text"), szEncoding);
+
+	// both ways
+	qint64 iKiB = ((qint64)uLines * szPlain.len() * 2) / 1024;
+	QString szMsg = __tr2qs("%1 backend, %2 encoding: %3 lines in %4 msecs (%5 KiB/s)")
+	                    .arg(RijndaelBackend::name(eBackend), szEncoding)
+	                    .arg(uLines)
+	                    .arg(iMSecs)
+	                    .arg(iMSecs > 0 ? (iKiB * 1000) / iMSecs : iKiB * 1000);
+	c->window()->outputNoFmt(KVI_OUT_SYSTEMMESSAGE, szMsg);
+	return true;
+}
+
+static bool rijndael_kvs_cmd_benchmark(KviKvsModuleCommandCall * c)
+{
+	kvs_uint_t uLines;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("lines", KVS_PT_UINT, KVS_PF_OPTIONAL, uLines)
+	KVSM_PARAMETERS_END(c)
+
+	if(uLines == 0)
+		uLines = 10000;
+
+	// about the longest message that fits in an IRC line once encrypted
+	KviCString szPlain('x', 300);
+
+	RijndaelBackend::Type backends[] = { RijndaelBackend::Builtin, RijndaelBackend::OpenSSL };
+	KviCString szReference[2];
+	bool bHaveReference = false;
+
+	for(auto eBackend : backends)
+	{
+		if(!RijndaelBackend::isAvailable(eBackend))
+			continue;
+
+		KviRijndael256HexEngine hex;
+		if(!rijndael_benchmark_engine(c, &hex, "hex", eBackend, szPlain, uLines))
+			return true;
+		KviRijndael256Base64Engine base64;
+		if(!rijndael_benchmark_engine(c, &base64, "base64", eBackend, szPlain, uLines))
+			return true;
+
+		// CBC uses random init vectors: compare the ECB output
+		KviCString szKey = "ecb:benchmark";
+		KviCString szOut[2];
+		hex.init(szKey.ptr(), szKey.len(), nullptr, 0);
+		hex.encrypt(szPlain.ptr(), szOut[0]);
+		base64.init(szKey.ptr(), szKey.len(), nullptr, 0);
+		base64.encrypt(szPlain.ptr(), szOut[1]);
+		if(bHaveReference)
+		{
+			if(!kvi_strEqualCS(szOut[0].ptr(), szReference[0].ptr()) || !kvi_strEqualCS(szOut[1].ptr(), szReference[1].ptr()))
+				c->warning(__tr2qs("The %s backend produced a different ciphertext"), RijndaelBackend::name(eBackend));
+		}
+		else
+		{
+			szReference[0] = szOut[0];
+			szReference[1] = szOut[1];
+			bHaveReference = true;
+		}
+	}
+
+	return true;
+}
+
 #endif
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -687,6 +816,8 @@ static bool rijndael_module_init(KviModule * m)
 	g_pEngineList = new KviPointerList<KviCryptEngine>;
 	g_pEngineList->setAutoDelete(false);
 
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "benchmark", rijndael_kvs_cmd_benchmark);
+
 	QString szFormat = __tr2qs("Cryptographic engine based on the Advanced Encryption Standard (AES) algorithm called Rijndael. "
 	                           "<br/>The text is first encrypted with Rijndael and then converted to %1 notation. "
 	                           "The keys used are %2 bit long and will be padded with zeros if you provide shorter ones. "
@@ -32,6 +32,7 @@
 
 #include "KviCryptEngine.h"
 #include "Rijndael.h"
+#include "RijndaelEvp.h"
 
 class KviRijndaelEngine : public KviCryptEngine
 {
@@ -51,8 +52,12 @@ private:
 	Rijndael * m_pDecryptCipher;
 	OperationalMode m_bEncryptMode;
 	OperationalMode m_bDecryptMode;
+	RijndaelBackend::Type m_eBackend;
 
 public:
+	// must be called before init(): the default is the fastest one available
+	void setBackend(RijndaelBackend::Type eBackend) { m_eBackend = eBackend; };
+	RijndaelBackend::Type backend() const { return m_eBackend; };
 	bool init(const char * encKey, int encKeyLen, const char * decKey, int decKeyLen) override;
 	KviCryptEngine::EncryptResult encrypt(const char * plainText, KviCString & outBuffer) override;
 	KviCryptEngine::DecryptResult decrypt(const char * inBuffer, KviCString & plainText) override;
@@ -64,6 +69,7 @@ protected:
 	virtual Rijndael::KeyLength getKeyLenId() const { return Rijndael::Key32Bytes; }
 private:
 	void setLastErrorFromRijndaelErrorCode(int errCode);
+	int initCipher(Rijndael ** ppCipher, Rijndael::Mode mode, Rijndael::Direction dir, const char * key);
 };
 
 class KviRijndaelHexEngine : public KviRijndaelEngine
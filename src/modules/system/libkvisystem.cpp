@@ -35,6 +35,8 @@
 #include "KviRuntimeInfo.h"
 #include "KviModuleManager.h"
 #include "KviByteOrder.h"
+#include "KviDnsResolver.h"
+#include "KviKvsHash.h"
 
 #include <QClipboard>
 #include <QByteArray>
@@ -392,6 +394,61 @@ static bool system_kvs_fnc_hostname(KviKvsModuleFunctionCall * c)
 	return true;
 }
 
+/*
+	@doc: system.dnsStatistics
+	@keyterms:
+		System information
+	@type:
+		function
+	@title:
+		$system.dnsStatistics
+	@short:
+		Returns the statistics of the DNS lookups
+	@syntax:
+		<hash> $system.dnsStatistics()
+	@description:
+		Returns a hash with the statistics of the host name lookups made
+		since KVIrc was started (by the connections, DCC and [cmd]dns[/cmd]).[br]
+		[i]lookups[/i] is the number of requested lookups, [i]cachehits[/i] the
+		number of them that were answered by the cache ([i]negativehits[/i] of
+		these were cached failures) and [i]shared[/i] the number of them that
+		joined an identical lookup already in progress.
+		[i]hitrate[/i] is the percentage of the lookups answered by the cache.[br]
+		[i]resolvercalls[/i] is the number of calls to the system resolver,
+		[i]meanlatency[/i] and [i]maxlatency[/i] the average and maximum duration
+		of the completed ones in milliseconds.[br]
+		[i]cachesize[/i] is the number of entries currently cached.
+	@examples:
+		[example]
+			%s = $system.dnsStatistics
+			echo "DNS cache hit rate:" %s{"hitrate"} "%, resolver latency:" %s{"meanlatency"} "msecs"
+		[/example]
+*/
+
+static bool system_kvs_fnc_dnsStatistics(KviKvsModuleFunctionCall * c)
+{
+	KviDnsResolverPool * pPool = KviDnsResolverPool::instance();
+	if(!pPool)
+	{
+		c->returnValue()->setNothing();
+		return true;
+	}
+
+	const KviDnsResolverPool::Statistics & stats = pPool->statistics();
+	KviKvsHash * pHash = new KviKvsHash();
+	pHash->set("lookups", new KviKvsVariant((kvs_int_t)stats.uLookups));
+	pHash->set("cachehits", new KviKvsVariant((kvs_int_t)stats.uCacheHits));
+	pHash->set("negativehits", new KviKvsVariant((kvs_int_t)stats.uNegativeHits));
+	pHash->set("shared", new KviKvsVariant((kvs_int_t)stats.uSharedLookups));
+	pHash->set("hitrate", new KviKvsVariant((kvs_real_t)(stats.uLookups ? (100.0 * stats.uCacheHits) / stats.uLookups : 0.0)));
+	pHash->set("resolvercalls", new KviKvsVariant((kvs_int_t)stats.uResolverCalls));
+	pHash->set("meanlatency", new KviKvsVariant((kvs_real_t)(stats.uCompletedCalls ? (double)stats.uTotalLatency / stats.uCompletedCalls : 0.0)));
+	pHash->set("maxlatency", new KviKvsVariant((kvs_int_t)stats.uMaxLatency));
+	pHash->set("cachesize", new KviKvsVariant((kvs_int_t)pPool->cacheSize()));
+	c->returnValue()->setHash(pHash);
+	return true;
+}
+
 /*
 	@doc: system.dbus
 	@keyterms:
@@ -912,6 +969,7 @@ static bool system_module_init(KviModule * m)
 	KVSM_REGISTER_FUNCTION(m, "getenv", system_kvs_fnc_getenv);
 	KVSM_REGISTER_FUNCTION(m, "hostname", system_kvs_fnc_hostname);
 	KVSM_REGISTER_FUNCTION(m, "dbus", system_kvs_fnc_dbus);
+	KVSM_REGISTER_FUNCTION(m, "dnsStatistics", system_kvs_fnc_dnsStatistics);
 	KVSM_REGISTER_FUNCTION(m, "htoni", system_kvs_fnc_htoni);
 	KVSM_REGISTER_FUNCTION(m, "ntohi", system_kvs_fnc_ntohi);
 	KVSM_REGISTER_FUNCTION(m, "clipboard", system_kvs_fnc_clipboard);